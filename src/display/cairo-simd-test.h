@@ -0,0 +1,256 @@
+#include <cxxtest/TestSuite.h>
+
+#include "display/cairo-simd.h"
+#include <cstdlib>
+#include <vector>
+
+// Copies of the scalar filter functors the kernels have to match.
+namespace {
+
+guint32 ref_premultiply(guint32 in)
+{
+    guint32 a = in >> 24, r = (in >> 16) & 0xff, g = (in >> 8) & 0xff, b = in & 0xff;
+    if (a == 0) return in;
+    guint32 t;
+    t = a * r + 128; r = (t + (t >> 8)) >> 8;
+    t = a * g + 128; g = (t + (t >> 8)) >> 8;
+    t = a * b + 128; b = (t + (t >> 8)) >> 8;
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+guint32 ref_unpremultiply(guint32 in)
+{
+    guint32 a = in >> 24, r = (in >> 16) & 0xff, g = (in >> 8) & 0xff, b = in & 0xff;
+    if (a == 0) return in;
+    r = (255 * r + a/2) / a;
+    g = (255 * g + a/2) / a;
+    b = (255 * b + a/2) / a;
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+gint32 ref_clamp(gint32 v, gint32 low, gint32 high)
+{
+    return v < low ? low : (v > high ? high : v);
+}
+
+guint32 ref_premul(guint32 c, guint32 a)
+{
+    guint32 t = a * c + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+guint32 ref_color_matrix(guint32 in, gint32 const *v)
+{
+    guint32 a = in >> 24, r = (in >> 16) & 0xff, g = (in >> 8) & 0xff, b = in & 0xff;
+    if (a != 0) {
+        r = (255 * r + a/2) / a;
+        g = (255 * g + a/2) / a;
+        b = (255 * b + a/2) / a;
+    }
+    gint32 ro = r*v[0]  + g*v[1]  + b*v[2]  + a*v[3]  + v[4];
+    gint32 go = r*v[5]  + g*v[6]  + b*v[7]  + a*v[8]  + v[9];
+    gint32 bo = r*v[10] + g*v[11] + b*v[12] + a*v[13] + v[14];
+    gint32 ao = r*v[15] + g*v[16] + b*v[17] + a*v[18] + v[19];
+    ro = (ref_clamp(ro, 0, 255*255) + 127) / 255;
+    go = (ref_clamp(go, 0, 255*255) + 127) / 255;
+    bo = (ref_clamp(bo, 0, 255*255) + 127) / 255;
+    ao = (ref_clamp(ao, 0, 255*255) + 127) / 255;
+    ro = ref_premul(ro, ao);
+    go = ref_premul(go, ao);
+    bo = ref_premul(bo, ao);
+    return (ao << 24) | (ro << 16) | (go << 8) | bo;
+}
+
+guint32 ref_arithmetic(guint32 in1, guint32 in2, gint32 const *k)
+{
+    guint32 aa = in1 >> 24, ra = (in1 >> 16) & 0xff, ga = (in1 >> 8) & 0xff, ba = in1 & 0xff;
+    guint32 ab = in2 >> 24, rb = (in2 >> 16) & 0xff, gb = (in2 >> 8) & 0xff, bb = in2 & 0xff;
+    gint32 ao = k[0]*aa*ab + k[1]*aa + k[2]*ab + k[3];
+    gint32 ro = k[0]*ra*rb + k[1]*ra + k[2]*rb + k[3];
+    gint32 go = k[0]*ga*gb + k[1]*ga + k[2]*gb + k[3];
+    gint32 bo = k[0]*ba*bb + k[1]*ba + k[2]*bb + k[3];
+    ao = ref_clamp(ao, 0, 255*255*255);
+    ro = (ref_clamp(ro, 0, ao) + (255*255/2)) / (255*255);
+    go = (ref_clamp(go, 0, ao) + (255*255/2)) / (255*255);
+    bo = (ref_clamp(bo, 0, ao) + (255*255/2)) / (255*255);
+    ao = (ao + (255*255/2)) / (255*255);
+    return (ao << 24) | (ro << 16) | (go << 8) | bo;
+}
+
+} // end anonymous namespace
+
+class CairoSimdTest : public CxxTest::TestSuite {
+private:
+    std::vector<guint32> _valid;   ///< premultiplied pixels
+    std::vector<guint32> _any;     ///< arbitrary pixels, including invalid premultiplied ones
+
+    static guint32 randomPixel() {
+        return (guint32(std::rand() & 0xffff) << 16) | (std::rand() & 0xffff);
+    }
+
+public:
+    CairoSimdTest()
+    {
+        std::srand(1);
+        // all alpha values with the extreme color components, then random pixels
+        for (guint32 a = 0; a < 256; ++a) {
+            _valid.push_back(a << 24);
+            _valid.push_back((a << 24) | (a << 16) | (a << 8) | a);
+            _valid.push_back((a << 24) | (a << 16) | (a / 2));
+            _any.push_back((a << 24) | 0xffffff);
+        }
+        for (unsigned i = 0; i < 10000; ++i) {
+            guint32 px = randomPixel();
+            guint32 a = px >> 24;
+            guint32 r = ((px >> 16) & 0xff) * a / 255;
+            guint32 g = ((px >> 8) & 0xff) * a / 255;
+            guint32 b = (px & 0xff) * a / 255;
+            _valid.push_back((a << 24) | (r << 16) | (g << 8) | b);
+            _any.push_back(randomPixel());
+        }
+        _any.insert(_any.end(), _valid.begin(), _valid.end());
+    }
+    virtual ~CairoSimdTest() {}
+
+    static CairoSimdTest *createSuite() { return new CairoSimdTest(); }
+    static void destroySuite( CairoSimdTest *suite ) { delete suite; }
+
+    void tearDown()
+    {
+        ink_simd_set_level(INK_SIMD_AVX2);
+    }
+
+    // Run the kernels the same way the filter templates do: kernel first, then
+    // one scalar pixel at a time wherever it stops.
+    template <typename Kernel, typename Reference>
+    void checkFilter(std::vector<guint32> const &pixels, Kernel kernel, Reference reference)
+    {
+        for (int level = INK_SIMD_NONE; level <= INK_SIMD_AVX2; ++level) {
+            ink_simd_set_level(static_cast<InkSimdLevel>(level));
+            std::vector<guint32> out(pixels.size());
+            int n = pixels.size();
+            for (int i = 0; i < n; ) {
+                i += kernel(&pixels[i], &out[i], n - i);
+                if (i < n) {
+                    out[i] = reference(pixels[i]);
+                    ++i;
+                }
+            }
+            for (int i = 0; i < n; ++i) {
+                TSM_ASSERT_EQUALS(pixels[i], out[i], reference(pixels[i]));
+            }
+        }
+    }
+
+    static int premultiply(guint32 const *in, guint32 *out, int n) { return ink_simd_premultiply(in, out, n); }
+    static int unpremultiply(guint32 const *in, guint32 *out, int n) { return ink_simd_unpremultiply(in, out, n); }
+
+    void testPremultiply()
+    {
+        checkFilter(_any, premultiply, ref_premultiply);
+    }
+
+    void testUnpremultiply()
+    {
+        checkFilter(_any, unpremultiply, ref_unpremultiply);
+    }
+
+    void testInPlace()
+    {
+        std::vector<guint32> pixels(_any);
+        int n = pixels.size();
+        for (int i = 0; i < n; ) {
+            i += ink_simd_unpremultiply(&pixels[i], &pixels[i], n - i);
+            if (i < n) {
+                pixels[i] = ref_unpremultiply(pixels[i]);
+                ++i;
+            }
+        }
+        for (int i = 0; i < n; ++i) {
+            TS_ASSERT_EQUALS(pixels[i], ref_unpremultiply(_any[i]));
+        }
+    }
+
+    void testColorMatrix()
+    {
+        // identity, luminance to alpha, a saturation matrix with offsets and one
+        // with large negative and positive coefficients
+        gint32 const matrices[4][20] = {
+            { 255, 0, 0, 0, 0,  0, 255, 0, 0, 0,  0, 0, 255, 0, 0,  0, 0, 0, 255, 0 },
+            { 0, 0, 0, 0, 0,  0, 0, 0, 0, 0,  0, 0, 0, 0, 0,  54, 183, 18, 0, 0 },
+            { 130, 107, 18, 0, 3251,  38, 199, 18, 0, -6502,  38, 107, 110, 0, 0,  0, 0, 0, 255, 0 },
+            { -2550, 1020, 3000, -400, 65025,  0, 255, 0, 0, 0,  765, -765, 255, 0, -130050,
+              0, 0, 128, 200, -32512 }
+        };
+        for (unsigned m = 0; m < 4; ++m) {
+            TS_ASSERT(ink_simd_color_matrix_supported(matrices[m]));
+            for (int level = INK_SIMD_NONE; level <= INK_SIMD_AVX2; ++level) {
+                ink_simd_set_level(static_cast<InkSimdLevel>(level));
+                std::vector<guint32> out(_any.size());
+                int n = _any.size();
+                for (int i = 0; i < n; ) {
+                    i += ink_simd_color_matrix(&_any[i], &out[i], n - i, matrices[m]);
+                    if (i < n) {
+                        out[i] = ref_color_matrix(_any[i], matrices[m]);
+                        ++i;
+                    }
+                }
+                for (int i = 0; i < n; ++i) {
+                    TSM_ASSERT_EQUALS(_any[i], out[i], ref_color_matrix(_any[i], matrices[m]));
+                }
+            }
+        }
+    }
+
+    void testColorMatrixUnsupported()
+    {
+        gint32 huge[20] = { 0 };
+        huge[0] = 70000;
+        TS_ASSERT(!ink_simd_color_matrix_supported(huge));
+        std::vector<guint32> out(_valid.size());
+        TS_ASSERT_EQUALS(ink_simd_color_matrix(&_valid[0], &out[0], _valid.size(), huge), 0);
+    }
+
+    void testComposeArithmetic()
+    {
+        // from typical values to ones which overflow 32-bit arithmetic
+        gint32 const ks[5][4] = {
+            { 0, 65025, 65025, 0 },
+            { 255, 0, 0, 0 },
+            { -128, 32512, 48769, -4144959 },
+            { 2550, -650250, 650250, 165813750 },
+            { 255000, 65025000, -65025000, 2000000000 }
+        };
+        std::vector<guint32> other(_any.rbegin(), _any.rend());
+        for (unsigned c = 0; c < 5; ++c) {
+            gint32 const *k = ks[c];
+            for (int level = INK_SIMD_NONE; level <= INK_SIMD_AVX2; ++level) {
+                ink_simd_set_level(static_cast<InkSimdLevel>(level));
+                std::vector<guint32> out(_any.size());
+                int n = _any.size();
+                for (int i = 0; i < n; ) {
+                    i += ink_simd_compose_arithmetic(&_any[i], &other[i], &out[i], n - i,
+                                                     k[0], k[1], k[2], k[3]);
+                    if (i < n) {
+                        out[i] = ref_arithmetic(_any[i], other[i], k);
+                        ++i;
+                    }
+                }
+                for (int i = 0; i < n; ++i) {
+                    TSM_ASSERT_EQUALS(_any[i], out[i], ref_arithmetic(_any[i], other[i], k));
+                }
+            }
+        }
+    }
+};
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
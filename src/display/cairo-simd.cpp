@@ -0,0 +1,468 @@
+/**
+ * @file
+ * Vectorized pixel kernels for the Cairo software blending templates.
+ *//*
+ * Authors:
+ *   see git history
+ *
+ * Copyright (C) 2016 Authors
+ * Released under GNU GPL, read the file 'COPYING' for more information
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "display/cairo-simd.h"
+#include <cmath>
+#include <cstdlib>
+
+// The kernels need intrinsics for instruction sets which are not enabled for the whole
+// build, which only works with function level target attributes.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+# define INK_SIMD_X86 1
+# include <immintrin.h>
+# define INK_TARGET_SSE2 __attribute__((target("sse2")))
+# define INK_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+int simd_level = -1;
+
+InkSimdLevel detect_level()
+{
+    if (std::getenv("_INKSCAPE_DISABLE_SIMD")) {
+        return INK_SIMD_NONE;
+    }
+    return ink_simd_supported_level();
+}
+
+#ifdef INK_SIMD_X86
+
+/*
+ * All kernels split the pixels into one vector per channel with a 32-bit lane per pixel
+ * and then repeat the integer arithmetic of the scalar code. Divisions are done
+ * in single precision: for integers 0 <= n, 0 < d and n + d < 2^24, the correctly rounded
+ * quotient n / d truncates to exactly the same value as the integer division.
+ */
+
+// SSE2, 4 pixels per step
+
+INK_TARGET_SSE2 inline void unpack_sse2(__m128i px, __m128i &a, __m128i &r, __m128i &g, __m128i &b)
+{
+    __m128i const mask = _mm_set1_epi32(0xff);
+    a = _mm_srli_epi32(px, 24);
+    r = _mm_and_si128(_mm_srli_epi32(px, 16), mask);
+    g = _mm_and_si128(_mm_srli_epi32(px, 8), mask);
+    b = _mm_and_si128(px, mask);
+}
+
+INK_TARGET_SSE2 inline __m128i pack_sse2(__m128i a, __m128i r, __m128i g, __m128i b)
+{
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(a, 24), _mm_slli_epi32(r, 16)),
+                        _mm_or_si128(_mm_slli_epi32(g, 8), b));
+}
+
+INK_TARGET_SSE2 inline __m128i select_sse2(__m128i mask, __m128i x, __m128i y)
+{
+    return _mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, y));
+}
+
+INK_TARGET_SSE2 inline __m128i div_sse2(__m128i n, __m128i d)
+{
+    return _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(n), _mm_cvtepi32_ps(d)));
+}
+
+/// Low 32 bits of the product, which SSE2 only has for unsigned pairs of lanes.
+INK_TARGET_SSE2 inline __m128i mullo_sse2(__m128i x, __m128i y)
+{
+    __m128i even = _mm_mul_epu32(x, y);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), _mm_srli_epi64(y, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+INK_TARGET_SSE2 inline __m128i clamp_sse2(__m128i x, __m128i low, __m128i high)
+{
+    x = select_sse2(_mm_cmplt_epi32(x, low), low, x);
+    return select_sse2(_mm_cmpgt_epi32(x, high), high, x);
+}
+
+/// premul_alpha(); both products fit into 16 bits
+INK_TARGET_SSE2 inline __m128i premul_sse2(__m128i c, __m128i a)
+{
+    __m128i t = _mm_add_epi32(_mm_mullo_epi16(c, a), _mm_set1_epi32(128));
+    return _mm_srli_epi32(_mm_add_epi32(t, _mm_srli_epi32(t, 8)), 8);
+}
+
+/// unpremul_alpha(); d is a with the zero lanes replaced by one
+INK_TARGET_SSE2 inline __m128i unpremul_sse2(__m128i c, __m128i a, __m128i d)
+{
+    __m128i n = _mm_add_epi32(_mm_mullo_epi16(c, _mm_set1_epi32(255)), _mm_srli_epi32(a, 1));
+    return div_sse2(n, d);
+}
+
+INK_TARGET_SSE2 int premultiply_sse2(guint32 const *in, guint32 *out, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i));
+        __m128i a, r, g, b;
+        unpack_sse2(px, a, r, g, b);
+        __m128i transparent = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+        __m128i result = pack_sse2(a, premul_sse2(r, a), premul_sse2(g, a), premul_sse2(b, a));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), select_sse2(transparent, px, result));
+    }
+    return i;
+}
+
+INK_TARGET_SSE2 int unpremultiply_sse2(guint32 const *in, guint32 *out, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i));
+        __m128i a, r, g, b;
+        unpack_sse2(px, a, r, g, b);
+        __m128i transparent = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+        __m128i d = _mm_or_si128(a, _mm_and_si128(transparent, _mm_set1_epi32(1)));
+        __m128i result = pack_sse2(a, unpremul_sse2(r, a, d), unpremul_sse2(g, a, d),
+                                   unpremul_sse2(b, a, d));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), select_sse2(transparent, px, result));
+    }
+    return i;
+}
+
+INK_TARGET_SSE2 inline __m128i matrix_row_sse2(float const *m, __m128 r, __m128 g, __m128 b, __m128 a)
+{
+    __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(m[0])), _mm_mul_ps(g, _mm_set1_ps(m[1]))),
+                          _mm_add_ps(_mm_mul_ps(b, _mm_set1_ps(m[2])), _mm_mul_ps(a, _mm_set1_ps(m[3]))));
+    x = _mm_add_ps(x, _mm_set1_ps(m[4]));
+    x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(255*255));
+    return div_sse2(_mm_add_epi32(_mm_cvttps_epi32(x), _mm_set1_epi32(127)), _mm_set1_epi32(255));
+}
+
+INK_TARGET_SSE2 int color_matrix_sse2(guint32 const *in, guint32 *out, int n, float const *m)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i));
+        __m128i a, r, g, b;
+        unpack_sse2(px, a, r, g, b);
+        __m128i invalid = _mm_or_si128(_mm_cmpgt_epi32(r, a),
+                                       _mm_or_si128(_mm_cmpgt_epi32(g, a), _mm_cmpgt_epi32(b, a)));
+        if (_mm_movemask_epi8(invalid)) break;
+
+        // transparent pixels are black, so dividing them by one leaves them alone
+        __m128i transparent = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+        __m128i d = _mm_or_si128(a, _mm_and_si128(transparent, _mm_set1_epi32(1)));
+        __m128 rf = _mm_cvtepi32_ps(unpremul_sse2(r, a, d));
+        __m128 gf = _mm_cvtepi32_ps(unpremul_sse2(g, a, d));
+        __m128 bf = _mm_cvtepi32_ps(unpremul_sse2(b, a, d));
+        __m128 af = _mm_cvtepi32_ps(a);
+
+        __m128i ao = matrix_row_sse2(m + 15, rf, gf, bf, af);
+        __m128i ro = premul_sse2(matrix_row_sse2(m, rf, gf, bf, af), ao);
+        __m128i go = premul_sse2(matrix_row_sse2(m + 5, rf, gf, bf, af), ao);
+        __m128i bo = premul_sse2(matrix_row_sse2(m + 10, rf, gf, bf, af), ao);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), pack_sse2(ao, ro, go, bo));
+    }
+    return i;
+}
+
+INK_TARGET_SSE2 inline __m128i arithmetic_sse2(__m128i x, __m128i y, __m128i const *k)
+{
+    __m128i t = _mm_add_epi32(mullo_sse2(k[0], _mm_mullo_epi16(x, y)), mullo_sse2(k[1], x));
+    return _mm_add_epi32(_mm_add_epi32(t, mullo_sse2(k[2], y)), k[3]);
+}
+
+INK_TARGET_SSE2 int compose_arithmetic_sse2(guint32 const *in1, guint32 const *in2, guint32 *out, int n,
+                                            gint32 const *kv)
+{
+    __m128i const k[4] = { _mm_set1_epi32(kv[0]), _mm_set1_epi32(kv[1]),
+                           _mm_set1_epi32(kv[2]), _mm_set1_epi32(kv[3]) };
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const half = _mm_set1_epi32(255*255/2);
+    __m128i const unit = _mm_set1_epi32(255*255);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i aa, ra, ga, ba, ab, rb, gb, bb;
+        unpack_sse2(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in1 + i)), aa, ra, ga, ba);
+        unpack_sse2(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in2 + i)), ab, rb, gb, bb);
+
+        __m128i ao = clamp_sse2(arithmetic_sse2(aa, ab, k), zero, _mm_set1_epi32(255*255*255));
+        __m128i ro = div_sse2(_mm_add_epi32(clamp_sse2(arithmetic_sse2(ra, rb, k), zero, ao), half), unit);
+        __m128i go = div_sse2(_mm_add_epi32(clamp_sse2(arithmetic_sse2(ga, gb, k), zero, ao), half), unit);
+        __m128i bo = div_sse2(_mm_add_epi32(clamp_sse2(arithmetic_sse2(ba, bb, k), zero, ao), half), unit);
+        ao = div_sse2(_mm_add_epi32(ao, half), unit);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), pack_sse2(ao, ro, go, bo));
+    }
+    return i;
+}
+
+// AVX2, 8 pixels per step
+
+INK_TARGET_AVX2 inline void unpack_avx2(__m256i px, __m256i &a, __m256i &r, __m256i &g, __m256i &b)
+{
+    __m256i const mask = _mm256_set1_epi32(0xff);
+    a = _mm256_srli_epi32(px, 24);
+    r = _mm256_and_si256(_mm256_srli_epi32(px, 16), mask);
+    g = _mm256_and_si256(_mm256_srli_epi32(px, 8), mask);
+    b = _mm256_and_si256(px, mask);
+}
+
+INK_TARGET_AVX2 inline __m256i pack_avx2(__m256i a, __m256i r, __m256i g, __m256i b)
+{
+    return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(a, 24), _mm256_slli_epi32(r, 16)),
+                           _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+}
+
+INK_TARGET_AVX2 inline __m256i div_avx2(__m256i n, __m256i d)
+{
+    return _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(n), _mm256_cvtepi32_ps(d)));
+}
+
+INK_TARGET_AVX2 inline __m256i premul_avx2(__m256i c, __m256i a)
+{
+    __m256i t = _mm256_add_epi32(_mm256_mullo_epi16(c, a), _mm256_set1_epi32(128));
+    return _mm256_srli_epi32(_mm256_add_epi32(t, _mm256_srli_epi32(t, 8)), 8);
+}
+
+INK_TARGET_AVX2 inline __m256i unpremul_avx2(__m256i c, __m256i a, __m256i d)
+{
+    __m256i n = _mm256_add_epi32(_mm256_mullo_epi16(c, _mm256_set1_epi32(255)), _mm256_srli_epi32(a, 1));
+    return div_avx2(n, d);
+}
+
+INK_TARGET_AVX2 int premultiply_avx2(guint32 const *in, guint32 *out, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i));
+        __m256i a, r, g, b;
+        unpack_avx2(px, a, r, g, b);
+        __m256i transparent = _mm256_cmpeq_epi32(a, _mm256_setzero_si256());
+        __m256i result = pack_avx2(a, premul_avx2(r, a), premul_avx2(g, a), premul_avx2(b, a));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_blendv_epi8(result, px, transparent));
+    }
+    return i;
+}
+
+INK_TARGET_AVX2 int unpremultiply_avx2(guint32 const *in, guint32 *out, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i));
+        __m256i a, r, g, b;
+        unpack_avx2(px, a, r, g, b);
+        __m256i transparent = _mm256_cmpeq_epi32(a, _mm256_setzero_si256());
+        __m256i d = _mm256_max_epi32(a, _mm256_set1_epi32(1));
+        __m256i result = pack_avx2(a, unpremul_avx2(r, a, d), unpremul_avx2(g, a, d),
+                                   unpremul_avx2(b, a, d));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_blendv_epi8(result, px, transparent));
+    }
+    return i;
+}
+
+INK_TARGET_AVX2 inline __m256i matrix_row_avx2(float const *m, __m256 r, __m256 g, __m256 b, __m256 a)
+{
+    __m256 x = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, _mm256_set1_ps(m[0])),
+                                           _mm256_mul_ps(g, _mm256_set1_ps(m[1]))),
+                             _mm256_add_ps(_mm256_mul_ps(b, _mm256_set1_ps(m[2])),
+                                           _mm256_mul_ps(a, _mm256_set1_ps(m[3]))));
+    x = _mm256_add_ps(x, _mm256_set1_ps(m[4]));
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(255*255));
+    return div_avx2(_mm256_add_epi32(_mm256_cvttps_epi32(x), _mm256_set1_epi32(127)), _mm256_set1_epi32(255));
+}
+
+INK_TARGET_AVX2 int color_matrix_avx2(guint32 const *in, guint32 *out, int n, float const *m)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i));
+        __m256i a, r, g, b;
+        unpack_avx2(px, a, r, g, b);
+        __m256i invalid = _mm256_or_si256(_mm256_cmpgt_epi32(r, a),
+                                          _mm256_or_si256(_mm256_cmpgt_epi32(g, a), _mm256_cmpgt_epi32(b, a)));
+        if (!_mm256_testz_si256(invalid, invalid)) break;
+
+        __m256i d = _mm256_max_epi32(a, _mm256_set1_epi32(1));
+        __m256 rf = _mm256_cvtepi32_ps(unpremul_avx2(r, a, d));
+        __m256 gf = _mm256_cvtepi32_ps(unpremul_avx2(g, a, d));
+        __m256 bf = _mm256_cvtepi32_ps(unpremul_avx2(b, a, d));
+        __m256 af = _mm256_cvtepi32_ps(a);
+
+        __m256i ao = matrix_row_avx2(m + 15, rf, gf, bf, af);
+        __m256i ro = premul_avx2(matrix_row_avx2(m, rf, gf, bf, af), ao);
+        __m256i go = premul_avx2(matrix_row_avx2(m + 5, rf, gf, bf, af), ao);
+        __m256i bo = premul_avx2(matrix_row_avx2(m + 10, rf, gf, bf, af), ao);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), pack_avx2(ao, ro, go, bo));
+    }
+    return i;
+}
+
+INK_TARGET_AVX2 inline __m256i arithmetic_avx2(__m256i x, __m256i y, __m256i const *k)
+{
+    __m256i t = _mm256_add_epi32(_mm256_mullo_epi32(k[0], _mm256_mullo_epi16(x, y)),
+                                 _mm256_mullo_epi32(k[1], x));
+    return _mm256_add_epi32(_mm256_add_epi32(t, _mm256_mullo_epi32(k[2], y)), k[3]);
+}
+
+INK_TARGET_AVX2 inline __m256i clamp_avx2(__m256i x, __m256i low, __m256i high)
+{
+    return _mm256_min_epi32(_mm256_max_epi32(x, low), high);
+}
+
+INK_TARGET_AVX2 int compose_arithmetic_avx2(guint32 const *in1, guint32 const *in2, guint32 *out, int n,
+                                            gint32 const *kv)
+{
+    __m256i const k[4] = { _mm256_set1_epi32(kv[0]), _mm256_set1_epi32(kv[1]),
+                           _mm256_set1_epi32(kv[2]), _mm256_set1_epi32(kv[3]) };
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const half = _mm256_set1_epi32(255*255/2);
+    __m256i const unit = _mm256_set1_epi32(255*255);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i aa, ra, ga, ba, ab, rb, gb, bb;
+        unpack_avx2(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(in1 + i)), aa, ra, ga, ba);
+        unpack_avx2(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(in2 + i)), ab, rb, gb, bb);
+
+        __m256i ao = clamp_avx2(arithmetic_avx2(aa, ab, k), zero, _mm256_set1_epi32(255*255*255));
+        __m256i ro = div_avx2(_mm256_add_epi32(clamp_avx2(arithmetic_avx2(ra, rb, k), zero, ao), half), unit);
+        __m256i go = div_avx2(_mm256_add_epi32(clamp_avx2(arithmetic_avx2(ga, gb, k), zero, ao), half), unit);
+        __m256i bo = div_avx2(_mm256_add_epi32(clamp_avx2(arithmetic_avx2(ba, bb, k), zero, ao), half), unit);
+        ao = div_avx2(_mm256_add_epi32(ao, half), unit);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), pack_avx2(ao, ro, go, bo));
+    }
+    return i;
+}
+
+#endif // INK_SIMD_X86
+
+} // end anonymous namespace
+
+InkSimdLevel ink_simd_supported_level()
+{
+#ifdef INK_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return INK_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return INK_SIMD_SSE2;
+    }
+#endif
+    return INK_SIMD_NONE;
+}
+
+InkSimdLevel ink_simd_level()
+{
+    if (simd_level < 0) {
+        simd_level = detect_level();
+    }
+    return static_cast<InkSimdLevel>(simd_level);
+}
+
+/**
+ * Override the instruction set used by the kernels, e.g. to compare them in tests.
+ * Levels which the processor does not support are lowered to the best supported one.
+ */
+void ink_simd_set_level(InkSimdLevel level)
+{
+    InkSimdLevel supported = ink_simd_supported_level();
+    simd_level = level > supported ? supported : level;
+}
+
+int ink_simd_premultiply(guint32 const *in, guint32 *out, int n)
+{
+    switch (ink_simd_level()) {
+#ifdef INK_SIMD_X86
+    case INK_SIMD_AVX2:
+        return premultiply_avx2(in, out, n);
+    case INK_SIMD_SSE2:
+        return premultiply_sse2(in, out, n);
+#endif
+    default:
+        return 0;
+    }
+}
+
+int ink_simd_unpremultiply(guint32 const *in, guint32 *out, int n)
+{
+    switch (ink_simd_level()) {
+#ifdef INK_SIMD_X86
+    case INK_SIMD_AVX2:
+        return unpremultiply_avx2(in, out, n);
+    case INK_SIMD_SSE2:
+        return unpremultiply_sse2(in, out, n);
+#endif
+    default:
+        return 0;
+    }
+}
+
+bool ink_simd_color_matrix_supported(gint32 const v[20])
+{
+    // Every partial sum of a row has to be exactly representable as a float. The
+    // unpremultiplied components of valid pixels are at most 255.
+    for (unsigned row = 0; row < 20; row += 5) {
+        double limit = std::abs(static_cast<double>(v[row + 4]));
+        for (unsigned i = 0; i < 4; ++i) {
+            limit += 255.0 * std::abs(static_cast<double>(v[row + i]));
+        }
+        if (limit >= 16777216.0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int ink_simd_color_matrix(guint32 const *in, guint32 *out, int n, gint32 const v[20])
+{
+    InkSimdLevel level = ink_simd_level();
+    if (level == INK_SIMD_NONE || n < 4 || !ink_simd_color_matrix_supported(v)) {
+        return 0;
+    }
+    float m[20];
+    for (unsigned i = 0; i < 20; ++i) {
+        m[i] = v[i];
+    }
+    switch (level) {
+#ifdef INK_SIMD_X86
+    case INK_SIMD_AVX2:
+        return color_matrix_avx2(in, out, n, m);
+    case INK_SIMD_SSE2:
+        return color_matrix_sse2(in, out, n, m);
+#endif
+    default:
+        return 0;
+    }
+}
+
+int ink_simd_compose_arithmetic(guint32 const *in1, guint32 const *in2, guint32 *out, int n,
+                                gint32 k1, gint32 k2, gint32 k3, gint32 k4)
+{
+    gint32 const k[4] = { k1, k2, k3, k4 };
+    switch (ink_simd_level()) {
+#ifdef INK_SIMD_X86
+    case INK_SIMD_AVX2:
+        return compose_arithmetic_avx2(in1, in2, out, n, k);
+    case INK_SIMD_SSE2:
+        return compose_arithmetic_sse2(in1, in2, out, n, k);
+#endif
+    default:
+        return 0;
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
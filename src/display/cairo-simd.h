@@ -0,0 +1,68 @@
+/**
+ * @file
+ * Vectorized pixel kernels for the Cairo software blending templates.
+ *//*
+ * Authors:
+ *   see git history
+ *
+ * Copyright (C) 2016 Authors
+ * Released under GNU GPL, read the file 'COPYING' for more information
+ */
+
+#ifndef SEEN_INKSCAPE_DISPLAY_CAIRO_SIMD_H
+#define SEEN_INKSCAPE_DISPLAY_CAIRO_SIMD_H
+
+#include <glib.h>
+
+/**
+ * Instruction sets which can be used by the pixel kernels. The best one supported
+ * by the processor is selected at runtime; setting the environment variable
+ * _INKSCAPE_DISABLE_SIMD disables the vectorized kernels.
+ */
+enum InkSimdLevel {
+    INK_SIMD_NONE,
+    INK_SIMD_SSE2,
+    INK_SIMD_AVX2
+};
+
+InkSimdLevel ink_simd_level();
+InkSimdLevel ink_simd_supported_level();
+void ink_simd_set_level(InkSimdLevel level);
+
+/*
+ * The kernels below work on runs of premultiplied ARGB32 pixels and give bit-exact results
+ * compared to the scalar functors they stand in for. Each of them returns the number of
+ * leading pixels it has processed, which is zero if no vector instructions are available.
+ * The caller processes the next pixel with the scalar code and calls the kernel again
+ * for the rest. The input and output may be the same array.
+ */
+
+/// Same as MultiplyAlpha in nr-filter-component-transfer.cpp.
+int ink_simd_premultiply(guint32 const *in, guint32 *out, int n);
+/// Same as UnmultiplyAlpha in nr-filter-component-transfer.cpp.
+int ink_simd_unpremultiply(guint32 const *in, guint32 *out, int n);
+
+/// Whether ink_simd_color_matrix() can handle the given fixed point matrix exactly.
+bool ink_simd_color_matrix_supported(gint32 const v[20]);
+/**
+ * Same as FilterColorMatrix::ColorMatrixMatrix. Stops at pixels whose color components
+ * exceed their alpha, since they are not valid premultiplied colors.
+ */
+int ink_simd_color_matrix(guint32 const *in, guint32 *out, int n, gint32 const v[20]);
+
+/// Same as ComposeArithmetic in nr-filter-composite.cpp, with k1..k4 in fixed point.
+int ink_simd_compose_arithmetic(guint32 const *in1, guint32 const *in2, guint32 *out, int n,
+                                gint32 k1, gint32 k2, gint32 k3, gint32 k4);
+
+#endif // !SEEN_INKSCAPE_DISPLAY_CAIRO_SIMD_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
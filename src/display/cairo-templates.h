@@ -31,6 +31,35 @@ static const int OPENMP_THRESHOLD = 2048;
 #include "display/nr-3dutils.h"
 #include "display/cairo-utils.h"
 
+// number of pixels the ARGB32 fast paths hand to the span functions at once
+static const int PIXEL_SPAN_SIZE = 256;
+
+/**
+ * Blend a run of ARGB32 pixels using the supplied functor.
+ * Functors which have a vectorized implementation (see display/cairo-simd.h) provide
+ * a non-template overload of this function, which is found through argument-dependent lookup.
+ */
+template <typename Blend>
+inline void ink_cairo_blend_span(Blend &blend, guint32 const *in1, guint32 const *in2, guint32 *out, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        out[i] = blend(in1[i], in2[i]);
+    }
+}
+
+/**
+ * Filter a run of ARGB32 pixels using the supplied functor.
+ * The input and output may be the same. Overloads for vectorized functors are found
+ * the same way as for ink_cairo_blend_span().
+ */
+template <typename Filter>
+inline void ink_cairo_filter_span(Filter &filter, guint32 const *in, guint32 *out, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        out[i] = filter(in[i]);
+    }
+}
+
 /**
  * Blend two surfaces using the supplied functor.
  * This template blends two Cairo image surfaces using a blending functor that takes
@@ -87,21 +116,17 @@ void ink_cairo_surface_blend(cairo_surface_t *in1, cairo_surface_t *in2, cairo_s
                 #if HAVE_OPENMP
                 #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
                 #endif
-                for (int i = 0; i < limit; ++i) {
-                    *(out_data + i) = blend(*(in1_data + i), *(in2_data + i));
+                for (int i = 0; i < limit; i += PIXEL_SPAN_SIZE) {
+                    ink_cairo_blend_span(blend, in1_data + i, in2_data + i, out_data + i,
+                                         std::min(PIXEL_SPAN_SIZE, limit - i));
                 }
             } else {
                 #if HAVE_OPENMP
                 #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
                 #endif
                 for (int i = 0; i < h; ++i) {
-                    guint32 *in1_p = in1_data + i * stride1/4;
-                    guint32 *in2_p = in2_data + i * stride2/4;
-                    guint32 *out_p = out_data + i * strideout/4;
-                    for (int j = 0; j < w; ++j) {
-                        *out_p = blend(*in1_p, *in2_p);
-                        ++in1_p; ++in2_p; ++out_p;
-                    }
+                    ink_cairo_blend_span(blend, in1_data + i * stride1/4, in2_data + i * stride2/4,
+                                         out_data + i * strideout/4, w);
                 }
             }
         } else {
@@ -215,8 +240,8 @@ void ink_cairo_surface_filter(cairo_surface_t *in, cairo_surface_t *out, Filter
             #if HAVE_OPENMP
             #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
             #endif
-            for (int i = 0; i < limit; ++i) {
-                *(in_data + i) = filter(*(in_data + i));
+            for (int i = 0; i < limit; i += PIXEL_SPAN_SIZE) {
+                ink_cairo_filter_span(filter, in_data + i, in_data + i, std::min(PIXEL_SPAN_SIZE, limit - i));
             }
         } else {
             #if HAVE_OPENMP
@@ -240,20 +265,15 @@ void ink_cairo_surface_filter(cairo_surface_t *in, cairo_surface_t *out, Filter
                 #if HAVE_OPENMP
                 #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
                 #endif
-                for (int i = 0; i < limit; ++i) {
-                    *(out_data + i) = filter(*(in_data + i));
+                for (int i = 0; i < limit; i += PIXEL_SPAN_SIZE) {
+                    ink_cairo_filter_span(filter, in_data + i, out_data + i, std::min(PIXEL_SPAN_SIZE, limit - i));
                 }
             } else {
                 #if HAVE_OPENMP
                 #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
                 #endif
                 for (int i = 0; i < h; ++i) {
-                    guint32 *in_p = in_data + i * stridein/4;
-                    guint32 *out_p = out_data + i * strideout/4;
-                    for (int j = 0; j < w; ++j) {
-                        *out_p = filter(*in_p);
-                        ++in_p; ++out_p;
-                    }
+                    ink_cairo_filter_span(filter, in_data + i * stridein/4, out_data + i * strideout/4, w);
                 }
             }
         } else {
@@ -21,6 +21,7 @@
 #include "display/drawing-item.h"
 #include "display/drawing-group.h"
 #include "display/drawing-surface.h"
+#include "display/glyph-cache.h"
 #include "preferences.h"
 
 using namespace Inkscape;
@@ -62,6 +63,8 @@ struct CachePrefObserver : public Inkscape::Preferences::Observer {
         Glib::ustring name = v.getEntryName();
         if (name == "size") {
             _arena->drawing.setCacheBudget((1 << 20) * v.getIntLimited(64, 0, 4096));
+        } else if (name == "glyphs") {
+            Inkscape::GlyphCache::get().setBudget((1 << 20) * v.getIntLimited(16, 0, 1024));
         }
     }
     SPCanvasArena *_arena;
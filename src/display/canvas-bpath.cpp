@@ -11,6 +11,7 @@
  *
  */
 
+#include <algorithm>
 #include <sstream>
 #include <string.h>
 #include "desktop.h"
@@ -53,6 +54,9 @@ sp_canvas_bpath_init (SPCanvasBPath * bpath)
     bpath->stroke_linejoin = SP_STROKE_LINEJOIN_MITER;
     bpath->stroke_linecap = SP_STROKE_LINECAP_BUTT;
     bpath->stroke_miterlimit = 11.0;
+
+    bpath->partial = false;
+    bpath->changed = Geom::OptRect();
 }
 
 static void sp_canvas_bpath_destroy(SPCanvasItem *object)
@@ -71,12 +75,43 @@ static void sp_canvas_bpath_update(SPCanvasItem *item, Geom::Affine const &affin
 {
     SPCanvasBPath *cbp = SP_CANVAS_BPATH(item);
 
-    item->canvas->requestRedraw((int)item->x1, (int)item->y1, (int)item->x2, (int)item->y2);
+    bool partial = cbp->partial && cbp->curve && affine == cbp->affine;
+    cbp->partial = false;
+
+    if (!partial) {
+        item->canvas->requestRedraw((int)item->x1, (int)item->y1, (int)item->x2, (int)item->y2);
+    }
 
     if (reinterpret_cast<SPCanvasItemClass *>(sp_canvas_bpath_parent_class)->update) {
         reinterpret_cast<SPCanvasItemClass *>(sp_canvas_bpath_parent_class)->update(item, affine, flags);
     }
 
+    if (partial) {
+        // only redraw where the curve changed, and grow the bounds to include it
+        if (cbp->changed) {
+            Geom::Rect area = *cbp->changed * affine;
+            int x1 = (int)area.min()[Geom::X] - 1;
+            int y1 = (int)area.min()[Geom::Y] - 1;
+            int x2 = (int)area.max()[Geom::X] + 1;
+            int y2 = (int)area.max()[Geom::Y] + 1;
+            item->canvas->requestRedraw(x1, y1, x2, y2);
+            if (item->x2 > item->x1 || item->y2 > item->y1) {
+                item->x1 = std::min<double>(item->x1, x1);
+                item->y1 = std::min<double>(item->y1, y1);
+                item->x2 = std::max<double>(item->x2, x2);
+                item->y2 = std::max<double>(item->y2, y2);
+            } else {
+                item->x1 = x1;
+                item->y1 = y1;
+                item->x2 = x2;
+                item->y2 = y2;
+            }
+        }
+        cbp->changed = Geom::OptRect();
+        return;
+    }
+    cbp->changed = Geom::OptRect();
+
     sp_canvas_item_reset_bounds (item);
 
     if (!cbp->curve) return;
@@ -192,6 +227,35 @@ sp_canvas_bpath_set_bpath (SPCanvasBPath *cbp, SPCurve *curve)
     if (curve) {
         cbp->curve = curve->ref();
     }
+    cbp->partial = false;
+    cbp->changed = Geom::OptRect();
+
+    sp_canvas_item_request_update (SP_CANVAS_ITEM (cbp));
+}
+
+/**
+ * Replaces the curve with one that differs from the current one only within
+ * the changed rectangle, in curve coordinates, or not at all if it is empty.
+ * Only that area is redrawn.
+ */
+void
+sp_canvas_bpath_set_bpath_partial (SPCanvasBPath *cbp, SPCurve *curve, Geom::OptRect const &changed)
+{
+    g_return_if_fail (cbp != NULL);
+    g_return_if_fail (SP_IS_CANVAS_BPATH (cbp));
+
+    // the bounds must be up to date for the previous curve
+    bool partial = curve && cbp->curve && (cbp->partial || !SP_CANVAS_ITEM(cbp)->need_update);
+    if (!partial) {
+        sp_canvas_bpath_set_bpath (cbp, curve);
+        return;
+    }
+
+    curve->ref();
+    cbp->curve->unref();
+    cbp->curve = curve;
+    cbp->partial = true;
+    cbp->changed.unionWith(changed);
 
     sp_canvas_item_request_update (SP_CANVAS_ITEM (cbp));
 }
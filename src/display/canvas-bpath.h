@@ -16,6 +16,7 @@
  */
 
 #include <glib.h>
+#include <2geom/rect.h>
 
 #include "sp-canvas-item.h"
 
@@ -84,6 +85,10 @@ struct SPCanvasBPath {
     /* State */
     Shape  *fill_shp;
     Shape  *stroke_shp;
+
+    /* Where the curve changed since the last update, if not everywhere */
+    bool partial;
+    Geom::OptRect changed;
 };
 
 struct SPCanvasBPathClass {
@@ -95,6 +100,7 @@ GType sp_canvas_bpath_get_type (void);
 SPCanvasItem *sp_canvas_bpath_new (SPCanvasGroup *parent, SPCurve *curve);
 
 void sp_canvas_bpath_set_bpath (SPCanvasBPath *cbp, SPCurve *curve);
+void sp_canvas_bpath_set_bpath_partial (SPCanvasBPath *cbp, SPCurve *curve, Geom::OptRect const &changed);
 void sp_canvas_bpath_set_fill (SPCanvasBPath *cbp, guint32 rgba, SPWindRule rule);
 void sp_canvas_bpath_set_stroke (SPCanvasBPath *cbp, guint32 rgba, gdouble width, SPStrokeJoinType join, SPStrokeCapType cap, double dash=0, double gap=0);
 
@@ -0,0 +1,116 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cstdlib>
+#include <vector>
+#include "display/canvas-item-index.h"
+
+class CanvasItemIndexTest : public CxxTest::TestSuite {
+private:
+    /// Mostly knot sized boxes, some long ones like handle lines, a few huge ones.
+    static Geom::Rect randomBox() {
+        Geom::Point p(std::rand() % 4000 - 2000, std::rand() % 4000 - 2000);
+        int kind = std::rand() % 20;
+        double w = kind < 17 ? std::rand() % 14 : kind < 19 ? std::rand() % 600 : 1e7;
+        double h = kind < 17 ? std::rand() % 14 : std::rand() % 40;
+        return Geom::Rect(p, p + Geom::Point(w, h));
+    }
+
+    static SPCanvasItem *fakeItem(unsigned i) {
+        return reinterpret_cast<SPCanvasItem *>(i + 1);
+    }
+
+    static bool touches(Geom::Rect const &box, Geom::IntRect const &area) {
+        return box.left() <= area.right() && box.right() >= area.left()
+            && box.top() <= area.bottom() && box.bottom() >= area.top();
+    }
+
+    // Every item touching the area is found, once, in stacking order.
+    static void checkQueries(Inkscape::CanvasItemIndex const &index, std::vector<Geom::Rect> const &boxes)
+    {
+        std::vector<unsigned> result;
+        for (int q = 0; q < 200; ++q) {
+            Geom::IntPoint p(std::rand() % 4400 - 2200, std::rand() % 4400 - 2200);
+            int size = q % 10 ? std::rand() % 300 : std::rand() % 5000;
+            Geom::IntRect area(p, p + Geom::IntPoint(size, std::rand() % 300));
+            index.query(area, result);
+            for (unsigned k = 1; k < result.size(); ++k) {
+                TS_ASSERT_LESS_THAN(result[k - 1], result[k]);
+            }
+            unsigned k = 0;
+            for (unsigned i = 0; i < boxes.size(); ++i) {
+                while (k < result.size() && result[k] < i) {
+                    ++k;
+                }
+                if (touches(boxes[i], area)) {
+                    TS_ASSERT(k < result.size() && result[k] == i);
+                }
+            }
+        }
+    }
+
+public:
+    CanvasItemIndexTest() {}
+    virtual ~CanvasItemIndexTest() {}
+
+    static CanvasItemIndexTest *createSuite() { return new CanvasItemIndexTest(); }
+    static void destroySuite( CanvasItemIndexTest *suite ) { delete suite; }
+
+    void testValidity()
+    {
+        Inkscape::CanvasItemIndex index;
+        TS_ASSERT(!index.isValid());
+        index.clear();
+        TS_ASSERT(index.isValid());
+        index.add(fakeItem(0), Geom::Rect(0, 0, 10, 10));
+        TS_ASSERT_EQUALS(index.size(), 1u);
+        TS_ASSERT_EQUALS(index.item(0), fakeItem(0));
+        index.invalidate();
+        TS_ASSERT(!index.isValid());
+    }
+
+    void testQuery()
+    {
+        std::srand(1);
+        Inkscape::CanvasItemIndex index;
+        std::vector<Geom::Rect> boxes;
+        index.clear();
+        for (unsigned i = 0; i < 3000; ++i) {
+            boxes.push_back(randomBox());
+            index.add(fakeItem(i), boxes.back());
+        }
+        checkQueries(index, boxes);
+
+        // move a third of the items around, like a drag of many selected nodes
+        for (unsigned i = 0; i < boxes.size(); i += 3) {
+            boxes[i] = randomBox();
+            index.setBox(i, boxes[i]);
+            TS_ASSERT_EQUALS(index.box(i), boxes[i]);
+        }
+        checkQueries(index, boxes);
+    }
+
+    // A box on a cell boundary is found from both sides.
+    void testBounds()
+    {
+        Inkscape::CanvasItemIndex index;
+        index.clear();
+        index.add(fakeItem(0), Geom::Rect(60, 60, 64, 64));
+        index.add(fakeItem(1), Geom::Rect(-1, -1, -1, -1));
+        std::vector<unsigned> result;
+        index.query(Geom::IntRect(64, 64, 70, 70), result);
+        TS_ASSERT_EQUALS(result.size(), 1u);
+        index.query(Geom::IntRect(-10, -10, 60, 60), result);
+        TS_ASSERT_EQUALS(result.size(), 2u);
+    }
+};
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,163 @@
+/**
+ * @file
+ * Grid index of the children of a canvas group.
+ *//*
+ * Authors:
+ *   see git history
+ *
+ * Copyright (C) 2016 Authors
+ * Released under GNU GPL, read the file 'COPYING' for more information
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "display/canvas-item-index.h"
+
+namespace Inkscape {
+
+/// Width and height of the grid cells, in canvas pixels; a few knots fit in one.
+static const double CELL_SIZE = 64.0;
+
+/// Items spanning more cells than this are kept aside and returned by every query.
+static const double MAX_CELLS = 64.0;
+
+/// Cells further from the origin than this are not indexed, to stay clear of int overflow.
+static const double MAX_CELL_COORD = 1e6;
+
+CanvasItemIndex::CanvasItemIndex()
+    : _valid(false)
+{}
+
+void
+CanvasItemIndex::clear()
+{
+    _items.clear();
+    _boxes.clear();
+    _grid.clear();
+    _large.clear();
+    _valid = true;
+}
+
+void
+CanvasItemIndex::add(SPCanvasItem *item, Geom::Rect const &box)
+{
+    _items.push_back(item);
+    _boxes.push_back(box);
+    _insert(_items.size() - 1);
+}
+
+void
+CanvasItemIndex::setBox(unsigned i, Geom::Rect const &box)
+{
+    _erase(i);
+    _boxes[i] = box;
+    _insert(i);
+}
+
+void
+CanvasItemIndex::query(Geom::IntRect const &area, std::vector<unsigned> &result) const
+{
+    result.clear();
+
+    Geom::IntRect cells;
+    if (!_cells(area, cells)) {
+        // too large to walk cell by cell: every item is a candidate
+        for (unsigned i = 0; i < _items.size(); ++i) {
+            result.push_back(i);
+        }
+        return;
+    }
+
+    double const ncells = double(cells.width() + 1) * double(cells.height() + 1);
+    if (ncells > _grid.size()) {
+        for (CellMap::const_iterator i = _grid.begin(); i != _grid.end(); ++i) {
+            if (cells.contains(Geom::IntPoint(i->first.first, i->first.second))) {
+                result.insert(result.end(), i->second.begin(), i->second.end());
+            }
+        }
+    } else {
+        for (int y = cells.top(); y <= cells.bottom(); ++y) {
+            for (int x = cells.left(); x <= cells.right(); ++x) {
+                CellMap::const_iterator i = _grid.find(Cell(x, y));
+                if (i != _grid.end()) {
+                    result.insert(result.end(), i->second.begin(), i->second.end());
+                }
+            }
+        }
+    }
+    result.insert(result.end(), _large.begin(), _large.end());
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+/**
+ * Finds the cells touched by a box, bounds included. The corners of the returned rectangle are
+ * both inclusive. Returns false if the box spans too many cells to be put in the grid.
+ */
+bool
+CanvasItemIndex::_cells(Geom::Rect const &box, Geom::IntRect &cells) const
+{
+    double const x0 = floor(box.left() / CELL_SIZE);
+    double const y0 = floor(box.top() / CELL_SIZE);
+    double const x1 = floor(box.right() / CELL_SIZE);
+    double const y1 = floor(box.bottom() / CELL_SIZE);
+
+    // written so that NaNs fail the tests
+    if (!(x0 >= -MAX_CELL_COORD && y0 >= -MAX_CELL_COORD &&
+          x1 <= MAX_CELL_COORD && y1 <= MAX_CELL_COORD &&
+          (x1 - x0 + 1) * (y1 - y0 + 1) <= MAX_CELLS)) {
+        return false;
+    }
+    cells = Geom::IntRect((int) x0, (int) y0, (int) x1, (int) y1);
+    return true;
+}
+
+void
+CanvasItemIndex::_insert(unsigned i)
+{
+    Geom::IntRect cells;
+    if (!_cells(_boxes[i], cells)) {
+        _large.push_back(i);
+        return;
+    }
+    for (int y = cells.top(); y <= cells.bottom(); ++y) {
+        for (int x = cells.left(); x <= cells.right(); ++x) {
+            _grid[Cell(x, y)].push_back(i);
+        }
+    }
+}
+
+void
+CanvasItemIndex::_erase(unsigned i)
+{
+    Geom::IntRect cells;
+    if (!_cells(_boxes[i], cells)) {
+        _large.erase(std::find(_large.begin(), _large.end(), i));
+        return;
+    }
+    for (int y = cells.top(); y <= cells.bottom(); ++y) {
+        for (int x = cells.left(); x <= cells.right(); ++x) {
+            CellMap::iterator cell = _grid.find(Cell(x, y));
+            std::vector<unsigned> &items = cell->second;
+            items.erase(std::find(items.begin(), items.end(), i));
+            if (items.empty()) {
+                _grid.erase(cell);
+            }
+        }
+    }
+}
+
+} // end namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
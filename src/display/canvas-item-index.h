@@ -0,0 +1,93 @@
+/**
+ * @file
+ * Grid index of the children of a canvas group.
+ *//*
+ * Authors:
+ *   see git history
+ *
+ * Copyright (C) 2016 Authors
+ * Released under GNU GPL, read the file 'COPYING' for more information
+ */
+
+#ifndef SEEN_INKSCAPE_DISPLAY_CANVAS_ITEM_INDEX_H
+#define SEEN_INKSCAPE_DISPLAY_CANVAS_ITEM_INDEX_H
+
+#include <map>
+#include <utility>
+#include <vector>
+#include <boost/utility.hpp>
+#include <2geom/int-rect.h>
+#include <2geom/rect.h>
+
+struct SPCanvasItem;
+
+namespace Inkscape {
+
+/**
+ * Bounding boxes of the children of a canvas group, kept in flat arrays in stacking order and
+ * bucketed in a uniform grid of canvas pixels. Drawing a tile or picking the item under the
+ * pointer then only visits the children near it, which keeps groups holding the knots of
+ * thousands of nodes as cheap as small ones.
+ *
+ * Items are known by their position in the stacking order, so adding, removing or restacking
+ * children requires rebuilding the index. Between such a change and the rebuild the index is
+ * invalid and must not be queried.
+ */
+class CanvasItemIndex
+    : boost::noncopyable
+{
+public:
+    CanvasItemIndex();
+
+    bool isValid() const { return _valid; }
+    void invalidate() { _valid = false; }
+
+    /// Empties the index and marks it valid, to be filled again with add().
+    void clear();
+
+    /// Appends an item above all others, with its bounding box in canvas pixels.
+    void add(SPCanvasItem *item, Geom::Rect const &box);
+
+    /// Changes the bounding box of the item at position i.
+    void setBox(unsigned i, Geom::Rect const &box);
+
+    SPCanvasItem *item(unsigned i) const { return _items[i]; }
+    Geom::Rect const &box(unsigned i) const { return _boxes[i]; }
+    unsigned size() const { return _items.size(); }
+
+    /**
+     * Stores in result the positions of the items whose boxes may touch area, bounds included,
+     * in stacking order and without duplicates. Some of them may not touch it; the caller
+     * checks the boxes exactly.
+     */
+    void query(Geom::IntRect const &area, std::vector<unsigned> &result) const;
+
+private:
+    typedef std::pair<int, int> Cell;
+    typedef std::map<Cell, std::vector<unsigned> > CellMap;
+
+    bool _cells(Geom::Rect const &box, Geom::IntRect &cells) const;
+    void _insert(unsigned i);
+    void _erase(unsigned i);
+
+    std::vector<SPCanvasItem *> _items;
+    std::vector<Geom::Rect> _boxes;
+    CellMap _grid;
+    std::vector<unsigned> _large; ///< items spanning too many cells, returned by every query
+    bool _valid;
+};
+
+} // end namespace Inkscape
+
+#endif // !SEEN_INKSCAPE_DISPLAY_CANVAS_ITEM_INDEX_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
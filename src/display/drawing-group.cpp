@@ -19,14 +19,19 @@
 
 namespace Inkscape {
 
+/// Groups with fewer children are searched linearly.
+static const unsigned CHILD_INDEX_THRESHOLD = 64;
+
 DrawingGroup::DrawingGroup(Drawing &drawing)
     : DrawingItem(drawing)
     , _child_transform(NULL)
+    , _child_index(NULL)
 {}
 
 DrawingGroup::~DrawingGroup()
 {
     delete _child_transform; // delete NULL; is safe
+    delete _child_index;
 }
 
 /**
@@ -85,10 +90,89 @@ DrawingGroup::_updateItem(Geom::IntRect const &area, UpdateContext const &ctx, u
                 _bbox.unionWith(outline ? i->geometricBounds() : i->visualBounds());
             }
         }
+        _updateChildIndex();
     }
     return beststate;
 }
 
+/**
+ * Bring the spatial index of children in sync with their current bounds.
+ * Changed bounds are refit in place; the index is only rebuilt when children
+ * were added, removed or reordered.
+ */
+void
+DrawingGroup::_updateChildIndex()
+{
+    if (_children.size() < CHILD_INDEX_THRESHOLD) {
+        delete _child_index;
+        _child_index = NULL;
+        return;
+    }
+
+    bool rebuild = !_child_index || _child_index->size() != _children.size();
+    if (!rebuild) {
+        unsigned n = 0;
+        for (ChildrenList::iterator i = _children.begin(); i != _children.end(); ++i, ++n) {
+            if (_child_index->value(n) != &*i) {
+                rebuild = true;
+                break;
+            }
+        }
+    }
+
+    if (rebuild) {
+        if (!_child_index) {
+            _child_index = new ChildIndex();
+        }
+        _child_index->clear();
+        for (ChildrenList::iterator i = _children.begin(); i != _children.end(); ++i) {
+            // pick() uses either of the two boxes depending on mode and flags
+            Geom::OptRect box = i->geometricBounds();
+            box.unionWith(i->visualBounds());
+            _child_index->add(&*i, box);
+        }
+        _child_index->build();
+        return;
+    }
+
+    unsigned n = 0;
+    for (ChildrenList::iterator i = _children.begin(); i != _children.end(); ++i, ++n) {
+        Geom::OptRect box = i->geometricBounds();
+        box.unionWith(i->visualBounds());
+        if (box != _child_index->bounds(n)) {
+            _child_index->setBounds(n, box);
+        }
+    }
+}
+
+/**
+ * Find the children whose bounding boxes intersect the given area (in drawing pixels).
+ * Children are returned in z-order. Returns false if the group does not have
+ * up to date bounding boxes, in which case @a items is left unchanged.
+ */
+bool
+DrawingGroup::childrenInArea(Geom::Rect const &area, std::vector<DrawingItem *> &items)
+{
+    if (!(_state & STATE_BBOX)) return false;
+
+    if (_child_index) {
+        std::vector<unsigned> found;
+        _child_index->intersecting(area, found);
+        for (unsigned k = 0; k < found.size(); ++k) {
+            items.push_back(_child_index->value(found[k]));
+        }
+    } else {
+        for (ChildrenList::iterator i = _children.begin(); i != _children.end(); ++i) {
+            Geom::OptRect box = i->geometricBounds();
+            box.unionWith(i->visualBounds());
+            if (box && box->intersects(area)) {
+                items.push_back(&*i);
+            }
+        }
+    }
+    return true;
+}
+
 unsigned
 DrawingGroup::_renderItem(DrawingContext &dc, Geom::IntRect const &area, unsigned flags, DrawingItem *stop_at)
 {
@@ -125,6 +209,20 @@ DrawingGroup::_clipItem(DrawingContext &dc, Geom::IntRect const &area)
 DrawingItem *
 DrawingGroup::_pickItem(Geom::Point const &p, double delta, unsigned flags)
 {
+    if (_child_index) {
+        Geom::Rect area(p, p);
+        area.expandBy(delta);
+        std::vector<unsigned> found;
+        _child_index->intersecting(area, found);
+        for (unsigned k = 0; k < found.size(); ++k) {
+            DrawingItem *picked = _child_index->value(found[k])->pick(p, delta, flags);
+            if (picked) {
+                return _pick_children ? picked : this;
+            }
+        }
+        return NULL;
+    }
+
     for (ChildrenList::iterator i = _children.begin(); i != _children.end(); ++i) {
         DrawingItem *picked = i->pick(p, delta, flags);
         if (picked) {
@@ -12,7 +12,9 @@
 #ifndef SEEN_INKSCAPE_DISPLAY_DRAWING_GROUP_H
 #define SEEN_INKSCAPE_DISPLAY_DRAWING_GROUP_H
 
+#include <vector>
 #include "display/drawing-item.h"
+#include "util/bounding-box-tree.h"
 
 namespace Inkscape {
 
@@ -28,6 +30,8 @@ public:
 
     void setChildTransform(Geom::Affine const &new_trans);
 
+    bool childrenInArea(Geom::Rect const &area, std::vector<DrawingItem *> &items);
+
 protected:
     virtual unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx,
                                  unsigned flags, unsigned reset);
@@ -37,7 +41,14 @@ protected:
     virtual DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags);
     virtual bool _canClip();
 
+    void _updateChildIndex();
+
     Geom::Affine *_child_transform;
+
+    /// Spatial index of children, only kept for groups with many children.
+    /// Entries are in the same order as _children.
+    typedef Util::BoundingBoxTree<DrawingItem *> ChildIndex;
+    ChildIndex *_child_index;
 };
 
 bool is_drawing_group(DrawingItem *item);
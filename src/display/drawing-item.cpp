@@ -120,6 +120,7 @@ DrawingItem::DrawingItem(Drawing &drawing)
     , _filter(NULL)
     , _user_data(NULL)
     , _cache(NULL)
+    , _filter_source(NULL)
     , _state(0)
     , _child_type(CHILD_ORPHAN)
     , _background_new(0)
@@ -352,6 +353,8 @@ DrawingItem::setCached(bool cached, bool persistent)
         _drawing._cached_items.erase(this);
         delete _cache;
         _cache = NULL;
+        delete _filter_source;
+        _filter_source = NULL;
     }
 }
 
@@ -382,6 +385,8 @@ DrawingItem::setStyle(SPStyle *style, SPStyle *context_style)
         // no filter set for this group
         delete _filter;
         _filter = NULL;
+        delete _filter_source;
+        _filter_source = NULL;
     }
 
     if (style && style->enable_background.set) {
@@ -491,6 +496,8 @@ DrawingItem::setZOrder(unsigned z)
     std::advance(i, std::min(z, unsigned(_parent->_children.size())));
     _parent->_children.insert(i, *this);
     _markForRendering();
+    // the parent's child index is kept in z-order
+    _parent->_markForUpdate(STATE_PICK, false);
 }
 
 void
@@ -555,6 +562,11 @@ DrawingItem::update(Geom::IntRect const &area, UpdateContext const &ctx, unsigne
     if (_transform) {
         child_ctx.ctm = *_transform * ctx.ctm;
     }
+    // a partial redraw is only known to be enough if nothing moved and nothing is forced
+    if (reset || _ctm != child_ctx.ctm) {
+        _partial_dirty = Geom::OptIntRect();
+    }
+
     /* Remember the transformation matrix */
     Geom::Affine ctm_change = _ctm.inverse() * child_ctx.ctm;
     _ctm = child_ctx.ctm;
@@ -611,6 +623,9 @@ DrawingItem::update(Geom::IntRect const &area, UpdateContext const &ctx, unsigne
             // if _cacheRect() is empty, a negative score will be returned from _cacheScore(),
             // so this will not execute (cache score threshold must be positive)
             cr.cache_size = _cacheRect()->area() * 4;
+            if (_filter && render_filters) {
+                cr.cache_size *= 2; // the unfiltered rendering is cached as well
+            }
             cr.item = this;
             _drawing._candidate_items.push_front(cr);
             _cache_iterator = _drawing._candidate_items.begin();
@@ -628,12 +643,17 @@ DrawingItem::update(Geom::IntRect const &area, UpdateContext const &ctx, unsigne
             if (_visible && cl) { // never create cache for invisible items
                 // this takes care of invalidation on transform
                 _cache->scheduleTransform(*cl, ctm_change);
+                if (_filter_source) {
+                    _filter_source->scheduleTransform(*cl, ctm_change);
+                }
             } else {
                 // Destroy cache for this item - outside of canvas or invisible.
                 // The opposite transition (invisible -> visible or object
                 // entering the canvas) is handled during the render phase
                 delete _cache;
                 _cache = NULL;
+                delete _filter_source;
+                _filter_source = NULL;
             }
         }
     }
@@ -647,9 +667,16 @@ DrawingItem::update(Geom::IntRect const &area, UpdateContext const &ctx, unsigne
         if (_stroke_pattern) {
             _stroke_pattern->update(area, child_ctx, flags, reset);
         }
-        if (!is_drawing_group(this) || (_filter && render_filters)) {
+        if (_filter && render_filters) {
             _markForRendering();
+        } else if (!is_drawing_group(this)) {
+            if (_partial_dirty) {
+                _markForRendering(*_partial_dirty);
+            } else {
+                _markForRendering();
+            }
         }
+        _partial_dirty = Geom::OptIntRect();
     }
 }
 
@@ -707,12 +734,30 @@ DrawingItem::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flag
 
     // render from cache if possible
     if (_cached) {
+        Drawing::RenderGuard guard(_drawing);
         if (_cache) {
             _cache->prepare();
+            _cache->setLastUse(_drawing._render_count);
             set_cairo_blend_operator( dc, _mix_blend_mode );
 
+            Geom::OptIntRect requested = carea;
             _cache->paintFromCache(dc, carea);
-            if (!carea) return RENDER_OK;
+            if (!carea) {
+                ++_drawing._cache_stats.hits;
+                return RENDER_OK;
+            }
+            if (_drawing._usePlaceholder(this, flags) && _cache->paintPlaceholder(dc, *carea)) {
+                // show the contents from the previous zoom level for now,
+                // the exact rendering is done on the next redraw of this area
+                ++_drawing._cache_stats.placeholder_hits;
+                _drawing._requestExactRender(*carea);
+                return RENDER_OK;
+            }
+            if (carea == requested) {
+                ++_drawing._cache_stats.misses;
+            } else {
+                ++_drawing._cache_stats.partial_hits;
+            }
         } else {
             // There is no cache. This could be because caching of this item
             // was just turned on after the last update phase, or because
@@ -721,7 +766,9 @@ DrawingItem::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flag
             cl.intersectWith(_drawbox);
             if (cl) {
                 _cache = new DrawingCache(*cl);
+                _cache->setLastUse(_drawing._render_count);
             }
+            ++_drawing._cache_stats.misses;
         }
     } else {
         // if our caching was turned off after the last update, it was already
@@ -810,10 +857,22 @@ DrawingItem::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flag
 
     // 3. Render object itself
     ict.pushGroup();
-    render_result = _renderItem(ict, *iarea, flags, stop_at);
+    if (_cache && _filter && render_filters && !stop_at) {
+        Geom::OptIntRect cl = _cacheRect();
+        Drawing::RenderGuard guard(_drawing);
+        if (!_filter_source && cl) {
+            _filter_source = new DrawingCache(*cl);
+        }
+    }
+    if (_filter_source && render_filters && !stop_at) {
+        render_result = _renderFilterSource(ict, *iarea, flags);
+    } else {
+        render_result = _renderItem(ict, *iarea, flags, stop_at);
+    }
 
     // 4. Apply filter.
     if (_filter && render_filters) {
+        Drawing::RenderGuard guard(_drawing);
         bool rendered = false;
         if (_filter->uses_background() && _background_accumulate) {
             DrawingItem *bg_root = this;
@@ -843,6 +902,7 @@ DrawingItem::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flag
 
     // 6. Paint the completed rendering onto the base context (or into cache)
     if (_cached && _cache) {
+        Drawing::RenderGuard guard(_drawing);
         DrawingContext cachect(*_cache);
         cachect.rectangle(*carea);
         cachect.setOperator(CAIRO_OPERATOR_SOURCE);
@@ -860,6 +920,46 @@ DrawingItem::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flag
     return render_result;
 }
 
+/**
+ * Renders the item without its filter, taking the parts which did not change
+ * since the last render from the cache of the unfiltered rendering.
+ * A small change under a large filtered group then only re-renders the changed
+ * pixels of the group, instead of everything the filter depends on.
+ */
+unsigned
+DrawingItem::_renderFilterSource(DrawingContext &dc, Geom::IntRect const &area, unsigned flags)
+{
+    Geom::OptIntRect dirty = area;
+    {
+        Drawing::RenderGuard guard(_drawing);
+        _filter_source->prepare();
+        // the scaled contents from another zoom level must not be filtered
+        _filter_source->dropPlaceholder();
+        _filter_source->paintFromCache(dc, dirty);
+    }
+    if (!dirty) return RENDER_OK;
+
+    DrawingSurface source(*dirty);
+    DrawingContext sct(source);
+    unsigned render_result = _renderItem(sct, *dirty, flags, NULL);
+
+    {
+        Drawing::RenderGuard guard(_drawing);
+        DrawingContext cachect(*_filter_source);
+        cachect.rectangle(*dirty);
+        cachect.setOperator(CAIRO_OPERATOR_SOURCE);
+        cachect.setSource(&source);
+        cachect.fill();
+        _filter_source->markClean(*dirty);
+    }
+    dc.rectangle(*dirty);
+    dc.setSource(&source);
+    dc.fill();
+    dc.setSource(0,0,0,0);
+
+    return render_result;
+}
+
 void
 DrawingItem::_renderOutline(DrawingContext &dc, Geom::IntRect const &area, unsigned flags)
 {
@@ -1026,11 +1126,29 @@ DrawingItem::_markForRendering()
     bool outline = _drawing.outline();
     Geom::OptIntRect dirty = outline ? _bbox : _drawbox;
     if (!dirty) return;
+    _markForRendering(*dirty);
+}
+
+/**
+ * Marks a part of the current rendering of the item as needing a redraw.
+ * Used when a change is known to affect only that area, e.g. when a few segments
+ * of a path are edited.
+ */
+void
+DrawingItem::_markForRendering(Geom::IntRect const &area)
+{
+    bool outline = _drawing.outline();
+    Geom::OptIntRect dirty = Geom::intersect(area, outline ? _bbox : _drawbox);
+    if (!dirty) return;
 
     // dirty the caches of all parents
     DrawingItem *bkg_root = NULL;
 
     for (DrawingItem *i = this; i; i = i->_parent) {
+        if (i->_filter_source) {
+            // the unfiltered rendering changes only where the descendant did
+            i->_filter_source->markDirty(*dirty);
+        }
         if (i != this && i->_filter) {
             i->_filter->area_enlarge(*dirty, i);
         }
@@ -1080,6 +1198,8 @@ DrawingItem::_invalidateFilterBackground(Geom::IntRect const &area)
 void
 DrawingItem::_markForUpdate(unsigned flags, bool propagate)
 {
+    _partial_dirty = Geom::OptIntRect();
+
     if (propagate) {
         _propagate_state |= flags;
     }
@@ -157,9 +157,11 @@ protected:
     void _renderOutline(DrawingContext &dc, Geom::IntRect const &area, unsigned flags);
     void _markForUpdate(unsigned state, bool propagate);
     void _markForRendering();
+    void _markForRendering(Geom::IntRect const &area);
     void _invalidateFilterBackground(Geom::IntRect const &area);
     double _cacheScore();
     Geom::OptIntRect _cacheRect();
+    unsigned _renderFilterSource(DrawingContext &dc, Geom::IntRect const &area, unsigned flags);
     virtual unsigned _updateItem(Geom::IntRect const &/*area*/, UpdateContext const &/*ctx*/,
                                  unsigned /*flags*/, unsigned /*reset*/) { return 0; }
     virtual unsigned _renderItem(DrawingContext &/*dc*/, Geom::IntRect const &/*area*/, unsigned /*flags*/,
@@ -196,6 +198,8 @@ protected:
     Geom::OptRect _item_bbox; ///< Geometric bounding box in item's user space.
                               ///  This is used to compute the filter effect region and render in
                               ///  objectBoundingBox units.
+    Geom::OptIntRect _partial_dirty; ///< If set, the only area to redraw after the next update.
+                                     ///  Subclasses set it after _markForUpdate(), which clears it.
 
     DrawingItem *_clip;
     DrawingItem *_mask;
@@ -204,6 +208,8 @@ protected:
     Inkscape::Filters::Filter *_filter;
     void *_user_data; ///< Used to associate DrawingItems with SPItems that created them
     DrawingCache *_cache;
+    DrawingCache *_filter_source; ///< Unfiltered rendering of a cached filtered item,
+                                  ///  only invalidated where its descendants change
 
     CacheList::iterator _cache_iterator;
 
@@ -58,9 +58,47 @@ DrawingShape::setPath(SPCurve *curve)
         curve->ref();
     }
 
+    _path_changed = Geom::OptRect();
     _markForUpdate(STATE_ALL, false);
 }
 
+/**
+ * Replaces the path with one that differs from the current one only within
+ * the changed rectangle, given in item coordinates. Only that part of the
+ * shape is redrawn, and the bounding box is extended instead of recomputed,
+ * so it can be larger than needed until the next full update.
+ */
+void
+DrawingShape::setPath(SPCurve *curve, Geom::OptRect const &changed)
+{
+    // the rest of the shape must be up to date, and the change must not spread
+    // further than the stroke: dashes run along the whole path, and gradients and
+    // patterns can depend on the bounding box
+    bool up_to_date = _state == STATE_ALL || _partial_dirty;
+    bool local_paint = _nrstyle.n_dash == 0
+        && _nrstyle.fill.type != NRStyle::PAINT_SERVER && _nrstyle.stroke.type != NRStyle::PAINT_SERVER;
+    if (!curve || !_curve || !_path_bbox || !up_to_date || !local_paint
+        || (_filter && _drawing.renderFilters()))
+    {
+        setPath(curve);
+        return;
+    }
+
+    curve->ref();
+    _curve->unref();
+    _curve = curve;
+    if (!changed) return;
+
+    Geom::Rect area = *changed * _ctm;
+    Geom::OptIntRect dirty = _strokeBounds(area, _ctm).roundOutwards();
+    _markForRendering(*dirty);
+
+    _path_changed.unionWith(area);
+    dirty.unionWith(_partial_dirty);
+    _markForUpdate(STATE_ALL, false);
+    _partial_dirty = dirty;
+}
+
 void
 DrawingShape::setStyle(SPStyle *style, SPStyle *context_style)
 {
@@ -89,6 +127,7 @@ DrawingShape::_updateItem(Geom::IntRect const &area, UpdateContext const &ctx, u
 
     if (!(flags & STATE_RENDER)) {
         /* We do not have to create rendering structures */
+        _path_bbox = Geom::OptRect();
         if (flags & STATE_BBOX) {
             if (_curve) {
                 boundingbox = bounds_exact_transformed(_curve->get_pathvector(), ctx.ctm);
@@ -114,24 +153,21 @@ DrawingShape::_updateItem(Geom::IntRect const &area, UpdateContext const &ctx, u
     _nrstyle.update();
 
     if (_curve) {
-        boundingbox = bounds_exact_transformed(_curve->get_pathvector(), ctx.ctm);
-
-        if (boundingbox && (_nrstyle.stroke.type != NRStyle::PAINT_NONE || outline)) {
-            float width, scale;
-            scale = ctx.ctm.descrim();
-            width = std::max(0.125f, _nrstyle.stroke_width * scale);
-            if ( fabs(_nrstyle.stroke_width * scale) > 0.01 ) { // FIXME: this is always true
-                boundingbox->expandBy(width);
-            }
-            // those pesky miters, now
-            float miterMax = width * _nrstyle.miter_limit;
-            if ( miterMax > 0.01 ) {
-                // grunt mode. we should compute the various miters instead
-                // (one for each point on the curve)
-                boundingbox->expandBy(miterMax);
-            }
+        if (_partial_dirty && _path_bbox) {
+            // only some segments changed since the last update, see setPath()
+            boundingbox = _path_bbox;
+            boundingbox.unionWith(_path_changed);
+        } else {
+            boundingbox = bounds_exact_transformed(_curve->get_pathvector(), ctx.ctm);
         }
+        _path_bbox = boundingbox;
+        if (boundingbox) {
+            boundingbox = _strokeBounds(*boundingbox, ctx.ctm);
+        }
+    } else {
+        _path_bbox = Geom::OptRect();
     }
+    _path_changed = Geom::OptRect();
 
     _bbox = boundingbox ? boundingbox->roundOutwards() : Geom::OptIntRect();
 
@@ -152,13 +188,39 @@ DrawingShape::_updateItem(Geom::IntRect const &area, UpdateContext const &ctx, u
     return STATE_ALL;
 }
 
+/** The area covered by the stroke of a path with the given bounds, in display coordinates. */
+Geom::Rect
+DrawingShape::_strokeBounds(Geom::Rect const &path_bounds, Geom::Affine const &ctm)
+{
+    Geom::Rect bounds = path_bounds;
+    if (_nrstyle.stroke.type != NRStyle::PAINT_NONE || _drawing.outline()) {
+        float width, scale;
+        scale = ctm.descrim();
+        width = std::max(0.125f, _nrstyle.stroke_width * scale);
+        if ( fabs(_nrstyle.stroke_width * scale) > 0.01 ) { // FIXME: this is always true
+            bounds.expandBy(width);
+        }
+        // those pesky miters, now
+        float miterMax = width * _nrstyle.miter_limit;
+        if ( miterMax > 0.01 ) {
+            // grunt mode. we should compute the various miters instead
+            // (one for each point on the curve)
+            bounds.expandBy(miterMax);
+        }
+    }
+    return bounds;
+}
+
 void
 DrawingShape::_renderFill(DrawingContext &dc)
 {
     Inkscape::DrawingContext::Save save(dc);
     dc.transform(_ctm);
 
-    bool has_fill =  _nrstyle.prepareFill(dc, _item_bbox, _fill_pattern);
+    bool has_fill;
+    {   Drawing::RenderGuard guard(_drawing);
+        has_fill = _nrstyle.prepareFill(dc, _item_bbox, _fill_pattern);
+    }
 
     if( has_fill ) {
         dc.path(_curve->get_pathvector());
@@ -174,7 +236,10 @@ DrawingShape::_renderStroke(DrawingContext &dc)
     Inkscape::DrawingContext::Save save(dc);
     dc.transform(_ctm);
 
-    bool has_stroke = _nrstyle.prepareStroke(dc, _item_bbox, _stroke_pattern);
+    bool has_stroke;
+    {   Drawing::RenderGuard guard(_drawing);
+        has_stroke = _nrstyle.prepareStroke(dc, _item_bbox, _stroke_pattern);
+    }
     has_stroke &= (_nrstyle.stroke_width != 0);
 
     if( has_stroke ) {
@@ -234,8 +299,11 @@ DrawingShape::_renderItem(DrawingContext &dc, Geom::IntRect const &area, unsigne
             // update fill and stroke paints.
             // this cannot be done during nr_arena_shape_update, because we need a Cairo context
             // to render svg:pattern
-            bool has_fill   = _nrstyle.prepareFill(dc, _item_bbox, _fill_pattern);
-            bool has_stroke = _nrstyle.prepareStroke(dc, _item_bbox, _stroke_pattern);
+            bool has_fill, has_stroke;
+            {   Drawing::RenderGuard guard(_drawing);
+                has_fill   = _nrstyle.prepareFill(dc, _item_bbox, _fill_pattern);
+                has_stroke = _nrstyle.prepareStroke(dc, _item_bbox, _stroke_pattern);
+            }
             has_stroke &= (_nrstyle.stroke_width != 0);
 
             if (has_fill || has_stroke) {
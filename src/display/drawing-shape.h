@@ -28,6 +28,7 @@ public:
     ~DrawingShape();
 
     void setPath(SPCurve *curve);
+    void setPath(SPCurve *curve, Geom::OptRect const &changed);
     virtual void setStyle(SPStyle *style, SPStyle *context_style = NULL);
     virtual void setChildrenStyle(SPStyle *context_style);
 
@@ -40,6 +41,7 @@ protected:
     virtual DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags);
     virtual bool _canClip();
 
+    Geom::Rect _strokeBounds(Geom::Rect const &path_bounds, Geom::Affine const &ctm);
     void _renderFill(DrawingContext &dc);
     void _renderStroke(DrawingContext &dc);
     void _renderMarkers(DrawingContext &dc, Geom::IntRect const &area, unsigned flags,
@@ -47,6 +49,8 @@ protected:
 
     SPCurve *_curve;
     NRStyle _nrstyle;
+    Geom::OptRect _path_bbox; ///< bounds of the path in display coordinates, without stroke
+    Geom::OptRect _path_changed; ///< display area where the path changed since the last update
 
     DrawingItem *_last_pick;
     unsigned _repick_after;
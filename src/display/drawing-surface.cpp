@@ -172,14 +172,28 @@ DrawingSurface::pixelArea() const
 
 //////////////////////////////////////////////////////////////////////////////
 
+/**
+ * @class DrawingCache
+ * Surface that stores the rendering of an item between redraws.
+ *
+ * The cache keeps track of which of its pixels are up to date. When the item is scaled
+ * or rotated, the cached pixels cannot be reused exactly, but the previous contents
+ * are kept as a placeholder: they can be painted transformed in place of the exact
+ * rendering until it is redone, e.g. while zooming.
+ */
+
 DrawingCache::DrawingCache(Geom::IntRect const &area)
     : DrawingSurface(area)
     , _clean_region(cairo_region_create())
     , _pending_area(area)
+    , _placeholder(NULL)
+    , _placeholder_region(NULL)
+    , _last_use(0)
 {}
 
 DrawingCache::~DrawingCache()
 {
+    dropPlaceholder();
     cairo_region_destroy(_clean_region);
 }
 
@@ -227,6 +241,7 @@ DrawingCache::prepare()
                 // we can exit early
                 cairo_rectangle_int_t limit = _convertRect(_pending_area);
                 cairo_region_intersect_rectangle(_clean_region, &limit);
+                _transformPlaceholder(_pending_transform, _pending_area);
                 _origin += t;
                 _pending_transform.setIdentity();
                 return;
@@ -255,17 +270,121 @@ DrawingCache::prepare()
 
         cairo_rectangle_int_t limit = _convertRect(_pending_area);
         cairo_region_intersect_rectangle(_clean_region, &limit);
+        _transformPlaceholder(_pending_transform, _pending_area);
     } else {
+        if (old_surface && !cairo_region_is_empty(_clean_region)) {
+            // keep the old contents, so that they can stand in for the new rendering;
+            // only the largest clean rectangle is kept to make transforming it simple
+            cairo_rectangle_int_t clean, tmp;
+            cairo_region_get_rectangle(_clean_region, 0, &clean);
+            int nr = cairo_region_num_rectangles(_clean_region);
+            for (int i = 1; i < nr; ++i) {
+                cairo_region_get_rectangle(_clean_region, i, &tmp);
+                if (tmp.width * tmp.height > clean.width * clean.height) {
+                    clean = tmp;
+                }
+            }
+            dropPlaceholder();
+            _placeholder = old_surface;
+            _placeholder_origin = old_origin;
+            _placeholder_region = cairo_region_create_rectangle(&clean);
+            old_surface = NULL;
+        }
+        _transformPlaceholder(_pending_transform, _pending_area);
+
         // dirty everything
         cairo_region_destroy(_clean_region);
         _clean_region = cairo_region_create();
     }
 
     //std::cout << _pending_transform << old_area << _pending_area << std::endl;
-    cairo_surface_destroy(old_surface);
+    if (old_surface) {
+        cairo_surface_destroy(old_surface);
+    }
     _pending_transform.setIdentity();
 }
 
+/**
+ * Paints an area from the placeholder, i.e. the transformed contents from before the last
+ * change of scale. Returns false and paints nothing if the placeholder does not cover
+ * the whole area. Each part of the placeholder is used only once, so that the next paint
+ * of the same area renders it exactly.
+ */
+bool
+DrawingCache::paintPlaceholder(DrawingContext &dc, Geom::IntRect const &area)
+{
+    if (!_placeholder) return false;
+
+    cairo_rectangle_int_t area_c = _convertRect(area);
+    if (cairo_region_contains_rectangle(_placeholder_region, &area_c) != CAIRO_REGION_OVERLAP_IN) {
+        return false;
+    }
+
+    {
+        Inkscape::DrawingContext::Save save(dc);
+        dc.rectangle(area);
+        dc.transform(_placeholder_transform);
+        dc.setSource(_placeholder, _placeholder_origin[X], _placeholder_origin[Y]);
+        dc.fill();
+    }
+
+    cairo_region_subtract_rectangle(_placeholder_region, &area_c);
+    if (cairo_region_is_empty(_placeholder_region)) {
+        dropPlaceholder();
+    }
+    return true;
+}
+
+void
+DrawingCache::dropPlaceholder()
+{
+    if (_placeholder) {
+        cairo_surface_destroy(_placeholder);
+        cairo_region_destroy(_placeholder_region);
+        _placeholder = NULL;
+        _placeholder_region = NULL;
+        _placeholder_transform.setIdentity();
+    }
+}
+
+/// Number of bytes used by the cache surface and the placeholder.
+size_t
+DrawingCache::memoryUsage() const
+{
+    size_t size = 0;
+    if (_surface) {
+        size += size_t(_pixels[X]) * _pixels[Y] * 4;
+    }
+    if (_placeholder) {
+        size += size_t(cairo_image_surface_get_stride(_placeholder)) * cairo_image_surface_get_height(_placeholder);
+    }
+    return size;
+}
+
+/// Moves the placeholder along with the cache, keeping only its part within the new area.
+void
+DrawingCache::_transformPlaceholder(Geom::Affine const &trans, Geom::IntRect const &new_area)
+{
+    if (!_placeholder) return;
+
+    cairo_rectangle_int_t extents;
+    cairo_region_get_extents(_placeholder_region, &extents);
+    Geom::Rect usable = _convertRect(extents);
+    usable *= trans;
+    // only pixels completely covered by the placeholder can be painted from it
+    Geom::OptIntRect inner = usable.roundInwards();
+    inner.intersectWith(new_area);
+    if (!inner) {
+        dropPlaceholder();
+        return;
+    }
+
+    _placeholder_transform *= trans;
+    cairo_region_destroy(_placeholder_region);
+    cairo_rectangle_int_t r = _convertRect(*inner);
+    _placeholder_region = cairo_region_create_rectangle(&r);
+}
+
 /**
  * Paints the clean area from cache and modifies the @a area
  * parameter to the bounds of the region that must be repainted.
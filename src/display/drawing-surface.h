@@ -71,12 +71,25 @@ public:
     void scheduleTransform(Geom::IntRect const &new_area, Geom::Affine const &trans);
     void prepare();
     void paintFromCache(DrawingContext &dc, Geom::OptIntRect &area);
+    bool paintPlaceholder(DrawingContext &dc, Geom::IntRect const &area);
+    bool hasPlaceholder() const { return _placeholder != NULL; }
+    void dropPlaceholder();
+    size_t memoryUsage() const;
+
+    unsigned lastUse() const { return _last_use; }
+    void setLastUse(unsigned stamp) { _last_use = stamp; }
 
 protected:
     cairo_region_t *_clean_region;
     Geom::IntRect _pending_area;
     Geom::Affine _pending_transform;
+    cairo_surface_t *_placeholder; ///< contents from before the last non-translation transform
+    Geom::IntPoint _placeholder_origin;
+    Geom::Affine _placeholder_transform; ///< maps placeholder pixels to current pixels
+    cairo_region_t *_placeholder_region; ///< where the placeholder may still stand in
+    unsigned _last_use;
 private:
+    void _transformPlaceholder(Geom::Affine const &trans, Geom::IntRect const &new_area);
     void _dumpCache(Geom::OptIntRect const &area);
     static cairo_rectangle_int_t _convertRect(Geom::IntRect const &r);
     static Geom::IntRect _convertRect(cairo_rectangle_int_t const &r);
@@ -15,6 +15,7 @@
 #include "display/drawing-context.h"
 #include "display/drawing-surface.h"
 #include "display/drawing-text.h"
+#include "display/glyph-cache.h"
 #include "helper/geom.h"
 #include "libnrtype/font-instance.h"
 #include "style.h"
@@ -25,6 +26,19 @@
 
 namespace Inkscape {
 
+/// Adds the outline of a glyph to the current path, from the glyph cache when it can.
+static void
+glyph_path(DrawingContext &dc, Drawing &drawing, font_instance *font, int glyph)
+{
+    Drawing::RenderGuard guard(drawing);
+    cairo_path_t const *path = GlyphCache::get().outline(font, glyph);
+    if (path) {
+        cairo_append_path(dc.raw(), path);
+    } else {
+        dc.path(*font->PathVector(glyph));
+    }
+}
+
 
 DrawingGlyphs::DrawingGlyphs(Drawing &drawing)
     : DrawingItem(drawing)
@@ -436,7 +450,77 @@ void DrawingText::decorateItem(DrawingContext &dc, double phase_length, bool und
     }
 }
 
-unsigned DrawingText::_renderItem(DrawingContext &dc, Geom::IntRect const &/*area*/, unsigned /*flags*/, DrawingItem * /*stop_at*/)
+/**
+ * Fills the glyphs by painting their cached coverage masks through the fill. Only used on screen,
+ * where positioning glyphs to a quarter of a pixel is good enough, and when every glyph is small
+ * and drawn with a uniform scale. Returns false if the glyphs have to be drawn as paths.
+ */
+bool DrawingText::renderGlyphMasks(DrawingContext &dc, Geom::IntRect const &area)
+{
+    if (!_drawing.arena() || _drawing.exact() || _nrstyle.fill_rule != CAIRO_FILL_RULE_WINDING) {
+        return false;
+    }
+
+    // the masks are placed in whole device pixels
+    cairo_matrix_t device;
+    cairo_get_matrix(dc.raw(), &device);
+    if (device.xx != 1 || device.yy != 1 || device.xy != 0 || device.yx != 0 ||
+        device.x0 != floor(device.x0) || device.y0 != floor(device.y0)) {
+        return false;
+    }
+
+    GlyphCache &cache = GlyphCache::get();
+    for (ChildrenList::iterator i = _children.begin(); i != _children.end(); ++i) {
+        DrawingGlyphs *g = dynamic_cast<DrawingGlyphs *>(&*i);
+        if (!g) throw InvalidItemException();
+        if (g->_drawable && !g->_ctm.isSingular() && !cache.canMask(g->_ctm)) {
+            return false;
+        }
+    }
+
+    Geom::OptIntRect box = _bbox;
+    box.intersectWith(area);
+    if (!box) {
+        return true;
+    }
+
+    // Add up the coverage of all glyphs, so that where they overlap the fill is applied once,
+    // as it is when filling their outlines together.
+    cairo_surface_t *coverage = cairo_image_surface_create(CAIRO_FORMAT_A8, box->width(), box->height());
+    cairo_t *ct = cairo_create(coverage);
+    cairo_set_operator(ct, CAIRO_OPERATOR_ADD);
+    {
+        Drawing::RenderGuard guard(_drawing);
+        for (ChildrenList::iterator i = _children.begin(); i != _children.end(); ++i) {
+            DrawingGlyphs *g = static_cast<DrawingGlyphs *>(&*i);
+            if (!g->_drawable || g->_ctm.isSingular()) continue;
+
+            Geom::IntPoint origin;
+            cairo_surface_t *mask = cache.mask(g->_font, g->_glyph, g->_ctm, origin);
+            if (!mask) continue;
+            origin -= box->min();
+            cairo_set_source_surface(ct, mask, origin[Geom::X], origin[Geom::Y]);
+            cairo_rectangle(ct, origin[Geom::X], origin[Geom::Y],
+                            cairo_image_surface_get_width(mask), cairo_image_surface_get_height(mask));
+            cairo_fill(ct);
+        }
+    }
+    cairo_destroy(ct);
+    cairo_surface_mark_dirty(coverage);
+
+    {
+        Inkscape::DrawingContext::Save save(dc);
+        dc.transform(_ctm);
+        _nrstyle.applyFill(dc);
+        // the source keeps the fill transform, the mask is in device pixels
+        cairo_set_matrix(dc.raw(), &device);
+        cairo_mask_surface(dc.raw(), coverage, box->left(), box->top());
+    }
+    cairo_surface_destroy(coverage);
+    return true;
+}
+
+unsigned DrawingText::_renderItem(DrawingContext &dc, Geom::IntRect const &area, unsigned /*flags*/, DrawingItem * /*stop_at*/)
 {
     if (_drawing.outline()) {
         guint32 rgba = _drawing.outlinecolor;
@@ -453,7 +537,7 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, Geom::IntRect const &/*are
             if (g->_ctm.isSingular()) continue;
             dc.transform(g->_ctm);
             if(g->_drawable){
-                dc.path(*g->_font->PathVector(g->_glyph));
+                glyph_path(dc, _drawing, g->_font, g->_glyph);
                 dc.fill();
             }
         }
@@ -476,6 +560,7 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, Geom::IntRect const &/*are
     bool has_td_stroke = false;
     {
         Inkscape::DrawingContext::Save save(dc);
+        Drawing::RenderGuard guard(_drawing);
         dc.transform(_ctm);
 
         has_fill      = _nrstyle.prepareFill(                dc, _item_bbox, _fill_pattern);
@@ -573,40 +658,46 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, Geom::IntRect const &/*are
             dc.newPath(); // Clear text-decoration path
         }
 
-        // accumulate the path that represents the glyphs
-        for (ChildrenList::iterator i = _children.begin(); i != _children.end(); ++i) {
-            DrawingGlyphs *g = dynamic_cast<DrawingGlyphs *>(&*i);
-            if (!g) throw InvalidItemException();
-
-            Inkscape::DrawingContext::Save save(dc);
-            if (g->_ctm.isSingular()) continue;
-            dc.transform(g->_ctm);
-            if (g->_drawable) {
-                dc.path(*g->_font->PathVector(g->_glyph));
+        // Small text with only a fill is painted from glyph masks
+        if (!(has_fill && !has_stroke && renderGlyphMasks(dc, area))) {
+            // accumulate the path that represents the glyphs
+            {   // glyph outlines are loaded lazily by the shared font instance
+                Drawing::RenderGuard guard(_drawing);
+                for (ChildrenList::iterator i = _children.begin(); i != _children.end(); ++i) {
+                    DrawingGlyphs *g = dynamic_cast<DrawingGlyphs *>(&*i);
+                    if (!g) throw InvalidItemException();
+
+                    Inkscape::DrawingContext::Save save(dc);
+                    if (g->_ctm.isSingular()) continue;
+                    dc.transform(g->_ctm);
+                    if (g->_drawable) {
+                        glyph_path(dc, _drawing, g->_font, g->_glyph);
+                    }
+                }
             }
-        }
 
-        // Draw the glyphs.
-        {
-            Inkscape::DrawingContext::Save save(dc);
-            dc.transform(_ctm);
+            // Draw the glyphs.
+            {
+                Inkscape::DrawingContext::Save save(dc);
+                dc.transform(_ctm);
 
-            if (has_fill && fill_first) {
-                _nrstyle.applyFill(dc);
-                dc.fillPreserve();
-            }
+                if (has_fill && fill_first) {
+                    _nrstyle.applyFill(dc);
+                    dc.fillPreserve();
+                }
 
-            if (has_stroke) {
-                _nrstyle.applyStroke(dc);
-                dc.strokePreserve();
-            }
+                if (has_stroke) {
+                    _nrstyle.applyStroke(dc);
+                    dc.strokePreserve();
+                }
 
-            if (has_fill && !fill_first) {
-                _nrstyle.applyFill(dc);
-                dc.fillPreserve();
+                if (has_fill && !fill_first) {
+                    _nrstyle.applyFill(dc);
+                    dc.fillPreserve();
+                }
             }
+            dc.newPath(); // Clear glyphs path
         }
-        dc.newPath(); // Clear glyphs path
 
         // Draw text decorations that go OVER the text (line through, blink)
         if (decorate) {
@@ -667,7 +758,7 @@ void DrawingText::_clipItem(DrawingContext &dc, Geom::IntRect const &/*area*/)
         Inkscape::DrawingContext::Save save(dc);
         dc.transform(g->_ctm);
         if(g->_drawable){
-            dc.path(*g->_font->PathVector(g->_glyph));
+            glyph_path(dc, _drawing, g->_font, g->_glyph);
         }
     }
     dc.fill();
@@ -71,6 +71,7 @@ protected:
 
     void decorateItem(DrawingContext &dc, double phase_length, bool under);
     void decorateStyle(DrawingContext &dc, double vextent, double xphase, Geom::Point const &p1, Geom::Point const &p2, double thickness);
+    bool renderGlyphMasks(DrawingContext &dc, Geom::IntRect const &area);
     NRStyle _nrstyle;
 
     friend class DrawingGlyphs;
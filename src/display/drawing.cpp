@@ -10,10 +10,23 @@
  * Released under GNU GPL, read the file 'COPYING' for more information
  */
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
 #include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#ifdef HAVE_OPENMP
+# include <omp.h>
+#endif
+
 #include "display/drawing.h"
+#include "display/drawing-surface.h"
 #include "nr-filter-gaussian.h"
 #include "nr-filter-types.h"
+#include "preferences.h"
 
 //grayscale colormode:
 #include "cairo-templates.h"
@@ -22,6 +35,39 @@
 
 namespace Inkscape {
 
+/// Edge length of the tiles rendered concurrently by Drawing::render().
+static const int RENDER_TILE_SIZE = 128;
+
+struct Drawing::RenderLock {
+#ifdef HAVE_OPENMP
+    RenderLock() { omp_init_nest_lock(&lock); }
+    ~RenderLock() { omp_destroy_nest_lock(&lock); }
+    void acquire() { omp_set_nest_lock(&lock); }
+    void release() { omp_unset_nest_lock(&lock); }
+    // nestable, because rendering a pattern tile re-enters the locked code
+    omp_nest_lock_t lock;
+#else
+    void acquire() {}
+    void release() {}
+#endif
+};
+
+Drawing::RenderGuard::RenderGuard(Drawing &drawing)
+    : _drawing(drawing)
+    , _locked(drawing._render_parallel)
+{
+    if (_locked) {
+        _drawing._render_lock->acquire();
+    }
+}
+
+Drawing::RenderGuard::~RenderGuard()
+{
+    if (_locked) {
+        _drawing._render_lock->release();
+    }
+}
+
 // hardcoded grayscale color matrix values as default
 static const gdouble grayscale_value_matrix[20] = {
     0.21, 0.72, 0.072, 0, 0,
@@ -41,8 +87,11 @@ Drawing::Drawing(SPCanvasArena *arena)
     , _filter_quality(Filters::FILTER_QUALITY_BEST)
     , _cache_score_threshold(50000.0)
     , _cache_budget(0)
+    , _render_count(0)
     , _grayscale_colormatrix(std::vector<gdouble> (grayscale_value_matrix, grayscale_value_matrix + 20 ))
     , _canvasarena(arena)
+    , _render_lock(new RenderLock())
+    , _render_parallel(false)
 {
 
 }
@@ -50,6 +99,7 @@ Drawing::Drawing(SPCanvasArena *arena)
 Drawing::~Drawing()
 {
     delete _root;
+    delete _render_lock;
 }
 
 void
@@ -122,6 +172,11 @@ Drawing::setFilterQuality(int q)
 {
     _filter_quality = q;
 }
+bool
+Drawing::exact() const
+{
+    return _exact;
+}
 void
 Drawing::setExact(bool e)
 {
@@ -148,6 +203,28 @@ Drawing::setCacheBudget(size_t bytes)
 {
     _cache_budget = bytes;
     _pickItemsForCaching();
+    _evictCaches();
+}
+
+Drawing::CacheStats
+Drawing::cacheStats() const
+{
+    CacheStats stats = _cache_stats;
+    stats.memory = 0;
+    for (std::set<DrawingItem *>::const_iterator i = _cached_items.begin(); i != _cached_items.end(); ++i) {
+        if ((*i)->_cache) {
+            stats.memory += (*i)->_cache->memoryUsage();
+        }
+        if ((*i)->_filter_source) {
+            stats.memory += (*i)->_filter_source->memoryUsage();
+        }
+    }
+    return stats;
+}
+void
+Drawing::resetCacheStats()
+{
+    _cache_stats = CacheStats();
 }
 
 void
@@ -164,12 +241,14 @@ Drawing::update(Geom::IntRect const &area, UpdateContext const &ctx, unsigned fl
     }
     // process the updated cache scores
     _pickItemsForCaching();
+    _evictCaches();
 }
 
 void
 Drawing::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flags)
 {
-    if (_root) {
+    ++_render_count;
+    if (_root && !_renderTiled(dc, area, flags)) {
         _root->render(dc, area, flags);
     }
 
@@ -186,6 +265,15 @@ Drawing::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flags)
     
         cairo_surface_destroy(out);
     }
+
+    // areas painted from placeholders have to be rendered again exactly
+    if (!_exact_render_requests.empty()) {
+        std::vector<Geom::IntRect> requests;
+        requests.swap(_exact_render_requests);
+        for (std::vector<Geom::IntRect>::iterator i = requests.begin(); i != requests.end(); ++i) {
+            signal_request_render.emit(*i);
+        }
+    }
 }
 
 DrawingItem *
@@ -197,20 +285,106 @@ Drawing::pick(Geom::Point const &p, double delta, unsigned flags)
     return NULL;
 }
 
+/**
+ * Render a large area as independent tiles on all available threads.
+ * Each tile is rendered into its own surface, which starts out as a copy of the target,
+ * and the finished tiles are copied back in order. Returns false if the area should
+ * be rendered in one pass instead.
+ */
+bool
+Drawing::_renderTiled(DrawingContext &dc, Geom::IntRect const &area, unsigned flags)
+{
+#ifdef HAVE_OPENMP
+    // Outline mode modifies outlinecolor during rendering. Nested renders,
+    // e.g. feImage rendering its own drawing from a tile, stay sequential.
+    if (outline() || omp_in_parallel()) return false;
+    if (area.area() < 4 * RENDER_TILE_SIZE * RENDER_TILE_SIZE) return false;
+
+    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+    int numOfThreads = prefs->getIntLimited("/options/threading/numthreads", omp_get_num_procs(), 1, 256);
+    if (numOfThreads < 2) return false;
+
+    // Tiles are composited back pixel for pixel, so only handle pixel-aligned targets
+    cairo_matrix_t target_transform;
+    cairo_get_matrix(dc.raw(), &target_transform);
+    if (target_transform.xx != 1.0 || target_transform.yy != 1.0 ||
+        target_transform.xy != 0.0 || target_transform.yx != 0.0 ||
+        target_transform.x0 != floor(target_transform.x0) ||
+        target_transform.y0 != floor(target_transform.y0))
+    {
+        return false;
+    }
+
+    std::vector<Geom::IntRect> tiles;
+    for (int y = area.top(); y < area.bottom(); y += RENDER_TILE_SIZE) {
+        for (int x = area.left(); x < area.right(); x += RENDER_TILE_SIZE) {
+            tiles.push_back(Geom::IntRect(x, y,
+                std::min(x + RENDER_TILE_SIZE, area.right()),
+                std::min(y + RENDER_TILE_SIZE, area.bottom())));
+        }
+    }
+
+    // Copy what is already in the target, so that blend modes and translucent items
+    // composite exactly as they would in a single pass.
+    std::vector<DrawingSurface *> surfaces(tiles.size());
+    cairo_pattern_t *background = cairo_pattern_create_for_surface(dc.rawTarget());
+    cairo_pattern_set_matrix(background, &target_transform);
+    for (unsigned i = 0; i < tiles.size(); ++i) {
+        surfaces[i] = new DrawingSurface(tiles[i]);
+        DrawingContext tdc(*surfaces[i]);
+        tdc.setSource(background);
+        tdc.setOperator(CAIRO_OPERATOR_SOURCE);
+        tdc.paint();
+    }
+    cairo_pattern_destroy(background);
+
+    _render_parallel = true;
+    #pragma omp parallel for schedule(dynamic) num_threads(numOfThreads)
+    for (int i = 0; i < static_cast<int>(tiles.size()); ++i) {
+        DrawingContext tdc(*surfaces[i]);
+        _root->render(tdc, tiles[i], flags);
+    }
+    _render_parallel = false;
+
+    for (unsigned i = 0; i < tiles.size(); ++i) {
+        Inkscape::DrawingContext::Save save(dc);
+        dc.rectangle(tiles[i]);
+        dc.setSource(surfaces[i]);
+        dc.setOperator(CAIRO_OPERATOR_SOURCE);
+        dc.fill();
+        delete surfaces[i];
+    }
+    return true;
+#else
+    (void) dc; (void) area; (void) flags;
+    return false;
+#endif
+}
+
+namespace {
+
+/// Orders cache candidates by decreasing score per byte of cache memory.
+struct CacheRecordDensityGreater {
+    bool operator()(CacheRecord const &a, CacheRecord const &b) const {
+        return a.score * b.cache_size > b.score * a.cache_size;
+    }
+};
+
+} // anonymous namespace
+
 void
 Drawing::_pickItemsForCaching()
 {
-    // we cache the objects with the highest score until the budget is exhausted
-    _candidate_items.sort(std::greater<CacheRecord>());
+    // we cache the objects which save the most rendering time per byte of cache memory,
+    // until the budget is exhausted; objects which don't fit are skipped, so that smaller
+    // ones can still use the rest of the budget
+    _candidate_items.sort(CacheRecordDensityGreater());
     size_t used = 0;
-    CandidateList::iterator i;
-    for (i = _candidate_items.begin(); i != _candidate_items.end(); ++i) {
-        if (used + i->cache_size > _cache_budget) break;
-        used += i->cache_size;
-    }
 
     std::set<DrawingItem*> to_cache;
-    for (CandidateList::iterator j = _candidate_items.begin(); j != i; ++j) {
+    for (CandidateList::iterator j = _candidate_items.begin(); j != _candidate_items.end(); ++j) {
+        if (used + j->cache_size > _cache_budget) continue;
+        used += j->cache_size;
         j->item->setCached(true);
         to_cache.insert(j->item);
     }
@@ -222,10 +396,86 @@ Drawing::_pickItemsForCaching()
                         to_cache.begin(), to_cache.end(),
                         std::inserter(to_uncache, to_uncache.end()));
     for (std::set<DrawingItem*>::iterator j = to_uncache.begin(); j != to_uncache.end(); ++j) {
+        if ((*j)->_cache) {
+            ++_cache_stats.evictions;
+        }
         (*j)->setCached(false);
     }
 }
 
+/**
+ * Keep the memory used by caches within the budget. Placeholders are dropped first,
+ * then the caches of items which were not painted in the last render, least recently
+ * used first. Their items stay cached and will be rendered into a new cache when needed.
+ */
+void
+Drawing::_evictCaches()
+{
+    // pairs of last use and item, sorted to find the least recently used caches
+    std::vector<std::pair<unsigned, DrawingItem *> > lru;
+    size_t used = 0;
+    for (std::set<DrawingItem *>::iterator i = _cached_items.begin(); i != _cached_items.end(); ++i) {
+        if ((*i)->_cache) {
+            used += (*i)->_cache->memoryUsage();
+            lru.push_back(std::make_pair((*i)->_cache->lastUse(), *i));
+        }
+        if ((*i)->_filter_source) {
+            used += (*i)->_filter_source->memoryUsage();
+        }
+    }
+    if (used <= _cache_budget) return;
+    std::sort(lru.begin(), lru.end());
+
+    for (unsigned i = 0; i < lru.size() && used > _cache_budget; ++i) {
+        DrawingCache *cache = lru[i].second->_cache;
+        if (cache->hasPlaceholder()) {
+            used -= cache->memoryUsage();
+            cache->dropPlaceholder();
+            used += cache->memoryUsage();
+            ++_cache_stats.evictions;
+        }
+    }
+    for (unsigned i = 0; i < lru.size() && used > _cache_budget; ++i) {
+        if (lru[i].first >= _render_count) break;
+        DrawingItem *item = lru[i].second;
+        used -= item->_cache->memoryUsage();
+        delete item->_cache;
+        item->_cache = NULL;
+        if (item->_filter_source) {
+            used -= item->_filter_source->memoryUsage();
+            delete item->_filter_source;
+            item->_filter_source = NULL;
+        }
+        ++_cache_stats.evictions;
+    }
+}
+
+/**
+ * Whether a cached item may be painted from its placeholder, i.e. the scaled contents
+ * from a previous zoom level.
+ */
+bool
+Drawing::_usePlaceholder(DrawingItem const *item, unsigned flags) const
+{
+    // The exact rendering is requested from the canvas, so only do this for drawings on screen
+    if (!_canvasarena || _exact) return false;
+    if (flags & (DrawingItem::RENDER_BYPASS_CACHE | DrawingItem::RENDER_FILTER_BACKGROUND)) return false;
+
+    // The placeholder must not end up in another cache, or in the input of a filter,
+    // because then the exact rendering would never replace it
+    for (DrawingItem const *i = item; i->_child_type != DrawingItem::CHILD_ROOT; i = i->_parent) {
+        if (i->_child_type != DrawingItem::CHILD_NORMAL) return false;
+        if (i != item && (i->_cached || i->_filter)) return false;
+    }
+    return true;
+}
+
+void
+Drawing::_requestExactRender(Geom::IntRect const &area)
+{
+    _exact_render_requests.push_back(area);
+}
+
 } // end namespace Inkscape
 
 /*
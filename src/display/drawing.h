@@ -16,6 +16,7 @@
 #include <boost/operators.hpp>
 #include <boost/utility.hpp>
 #include <set>
+#include <vector>
 #include <sigc++/sigc++.h>
 
 #include "display/drawing-item.h"
@@ -33,6 +34,35 @@ class Drawing
     : boost::noncopyable
 {
 public:
+    /**
+     * Serializes access to render-time state shared between tiles, such as item caches,
+     * lazily created paint patterns and glyph outlines. Does nothing unless tiles
+     * are being rendered concurrently.
+     */
+    class RenderGuard
+        : boost::noncopyable
+    {
+    public:
+        explicit RenderGuard(Drawing &drawing);
+        ~RenderGuard();
+    private:
+        Drawing &_drawing;
+        bool _locked;
+    };
+
+    /// Counters describing how well item caches are reused.
+    struct CacheStats {
+        CacheStats()
+            : hits(0), partial_hits(0), misses(0), placeholder_hits(0), evictions(0), memory(0)
+        {}
+        unsigned long hits;             ///< renders of cached items painted entirely from cache
+        unsigned long partial_hits;     ///< renders of cached items painted partly from cache
+        unsigned long misses;           ///< renders of cached items that had to render everything
+        unsigned long placeholder_hits; ///< renders served by scaled contents from another zoom level
+        unsigned long evictions;        ///< caches and placeholders dropped to stay within budget
+        size_t memory;                  ///< bytes currently used by caches and placeholders
+    };
+
     struct OutlineColors {
         guint32 paths;
         guint32 clippaths;
@@ -57,11 +87,14 @@ public:
     void setColorMode(ColorMode mode);
     void setBlurQuality(int q);
     void setFilterQuality(int q);
+    bool exact() const;
     void setExact(bool e);
 
     Geom::OptIntRect const &cacheLimit() const;
     void setCacheLimit(Geom::OptIntRect const &r);
     void setCacheBudget(size_t bytes);
+    CacheStats cacheStats() const;
+    void resetCacheStats();
 
     OutlineColors const &colors() const { return _colors; }
 
@@ -77,6 +110,10 @@ public:
 
 private:
     void _pickItemsForCaching();
+    void _evictCaches();
+    bool _usePlaceholder(DrawingItem const *item, unsigned flags) const;
+    void _requestExactRender(Geom::IntRect const &area);
+    bool _renderTiled(DrawingContext &dc, Geom::IntRect const &area, unsigned flags);
 
     typedef std::list<CacheRecord> CandidateList;
 
@@ -97,12 +134,19 @@ private:
 
     double _cache_score_threshold; ///< do not consider objects for caching below this score
     size_t _cache_budget; ///< maximum allowed size of cache
+    CacheStats _cache_stats;
+    unsigned _render_count; ///< incremented on every render, used to find least recently used caches
+    std::vector<Geom::IntRect> _exact_render_requests; ///< areas painted from placeholders
 
     OutlineColors _colors;
     Filters::FilterColorMatrix::ColorMatrixMatrix _grayscale_colormatrix;
     SPCanvasArena *_canvasarena; // may be NULL if this arena is not the screen
                                  // but used for export etc.
 
+    struct RenderLock;
+    RenderLock *_render_lock;
+    bool _render_parallel; ///< true while tiles are rendered by several threads
+
     friend class DrawingItem;
 };
 
@@ -0,0 +1,231 @@
+/**
+ * @file
+ * Rendering data of glyphs shared by all text.
+ *//*
+ * Authors:
+ *   see git history
+ *
+ * Copyright (C) 2016 Authors
+ * Released under GNU GPL, read the file 'COPYING' for more information
+ */
+
+#include <cmath>
+#include <2geom/pathvector.h>
+
+#include "display/cairo-utils.h"
+#include "display/glyph-cache.h"
+#include "helper/geom.h"
+#include "libnrtype/font-instance.h"
+
+namespace Inkscape {
+
+/// Largest em size, in pixels, of glyphs kept as masks.
+static const double MASK_MAX_SCALE = 64.0;
+
+/// Positions of masks are rounded to 1/MASK_SUBPIXELS of a pixel.
+static const int MASK_SUBPIXELS = 4;
+
+/// Outlines are built with this scale, because cairo stores paths in 24.8 fixed point.
+static const double OUTLINE_SCALE = 4096.0;
+
+bool
+GlyphCache::Key::operator<(Key const &other) const
+{
+    if (font != other.font) return font < other.font;
+    if (glyph != other.glyph) return glyph < other.glyph;
+    if (xscale != other.xscale) return xscale < other.xscale;
+    if (yscale != other.yscale) return yscale < other.yscale;
+    if (xoffset != other.xoffset) return xoffset < other.xoffset;
+    return yoffset < other.yoffset;
+}
+
+GlyphCache::GlyphCache()
+    : _budget(16 << 20)
+{}
+
+GlyphCache::~GlyphCache()
+{
+    clear();
+}
+
+GlyphCache &
+GlyphCache::get()
+{
+    // Never destroyed: the entries hold fonts, which may already be gone at exit.
+    static GlyphCache *cache = new GlyphCache();
+    return *cache;
+}
+
+cairo_path_t const *
+GlyphCache::outline(font_instance *font, int glyph)
+{
+    if (!_budget) {
+        return NULL;
+    }
+    Key const key(font, glyph);
+    if (Entry *e = _find(key)) {
+        return e->path;
+    }
+
+    Geom::PathVector const *pv = font->PathVector(glyph);
+    if (!pv) {
+        return NULL;
+    }
+    cairo_surface_t *s = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+    cairo_t *ct = cairo_create(s);
+    cairo_scale(ct, OUTLINE_SCALE, OUTLINE_SCALE);
+    feed_pathvector_to_cairo(ct, *pv);
+    cairo_path_t *path = cairo_copy_path(ct);
+    cairo_destroy(ct);
+    cairo_surface_destroy(s);
+
+    if (path->status != CAIRO_STATUS_SUCCESS) {
+        cairo_path_destroy(path);
+        return NULL;
+    }
+    Entry &e = _insert(key, sizeof(Entry) + path->num_data * sizeof(cairo_path_data_t));
+    e.path = path;
+    return path;
+}
+
+bool
+GlyphCache::canMask(Geom::Affine const &ctm) const
+{
+    double const scale = fabs(ctm[0]);
+    return _budget && scale > 0 && scale <= MASK_MAX_SCALE
+        && ctm[1] == 0 && ctm[2] == 0 && fabs(fabs(ctm[3]) - scale) <= 1e-6 * scale;
+}
+
+cairo_surface_t *
+GlyphCache::mask(font_instance *font, int glyph, Geom::Affine const &ctm, Geom::IntPoint &origin)
+{
+    // split the translation into whole pixels and a subpixel offset
+    double const qx = floor(ctm[4] * MASK_SUBPIXELS + 0.5);
+    double const qy = floor(ctm[5] * MASK_SUBPIXELS + 0.5);
+    int const px = (int) floor(qx / MASK_SUBPIXELS);
+    int const py = (int) floor(qy / MASK_SUBPIXELS);
+
+    Key const key(font, glyph, ctm[0], ctm[3],
+                  (int) qx - px * MASK_SUBPIXELS, (int) qy - py * MASK_SUBPIXELS);
+    Entry *e = _find(key);
+    if (!e) {
+        Geom::PathVector const *pv = font->PathVector(glyph);
+        Geom::Affine const m = Geom::Scale(key.xscale, key.yscale)
+            * Geom::Translate(double(key.xoffset) / MASK_SUBPIXELS, double(key.yoffset) / MASK_SUBPIXELS);
+        Geom::OptRect const bounds = pv ? bounds_exact_transformed(*pv, m) : Geom::OptRect();
+        Geom::IntRect area;
+        if (bounds) {
+            area = bounds->roundOutwards();
+        }
+
+        cairo_surface_t *s = NULL;
+        if (area.width() > 0 && area.height() > 0) {
+            s = cairo_image_surface_create(CAIRO_FORMAT_A8, area.width(), area.height());
+            cairo_t *ct = cairo_create(s);
+            cairo_translate(ct, -area.left(), -area.top());
+            ink_cairo_transform(ct, m);
+            feed_pathvector_to_cairo(ct, *pv);
+            cairo_fill(ct);
+            cairo_destroy(ct);
+            cairo_surface_flush(s);
+        }
+
+        size_t const size = s ? cairo_image_surface_get_stride(s) * area.height() : 0;
+        e = &_insert(key, sizeof(Entry) + size);
+        e->mask = s;
+        e->origin = area.min();
+    }
+    origin = e->origin + Geom::IntPoint(px, py);
+    return e->mask;
+}
+
+void
+GlyphCache::setBudget(size_t bytes)
+{
+    _budget = bytes;
+    _evict(bytes);
+}
+
+void
+GlyphCache::resetStats()
+{
+    size_t const memory = _stats.memory;
+    _stats = Stats();
+    _stats.memory = memory;
+}
+
+void
+GlyphCache::clear()
+{
+    while (!_entries.empty()) {
+        _erase(_entries.begin());
+    }
+}
+
+GlyphCache::Entry *
+GlyphCache::_find(Key const &key)
+{
+    EntryMap::iterator i = _entries.find(key);
+    if (i == _entries.end()) {
+        ++_stats.misses;
+        return NULL;
+    }
+    ++_stats.hits;
+    _lru.splice(_lru.begin(), _lru, i->second.lru);
+    return &i->second;
+}
+
+GlyphCache::Entry &
+GlyphCache::_insert(Key const &key, size_t size)
+{
+    // make room first, so that the new entry is never the one dropped
+    if (size < _budget) {
+        _evict(_budget - size);
+    }
+    key.font->Ref();
+    Entry &e = _entries[key];
+    _lru.push_front(key);
+    e.lru = _lru.begin();
+    e.size = size;
+    _stats.memory += size;
+    return e;
+}
+
+void
+GlyphCache::_evict(size_t budget)
+{
+    while (_stats.memory > budget && !_lru.empty()) {
+        _erase(_entries.find(_lru.back()));
+        ++_stats.evictions;
+    }
+}
+
+void
+GlyphCache::_erase(EntryMap::iterator i)
+{
+    Entry &e = i->second;
+    if (e.path) {
+        cairo_path_destroy(e.path);
+    }
+    if (e.mask) {
+        cairo_surface_destroy(e.mask);
+    }
+    _stats.memory -= e.size;
+    _lru.erase(e.lru);
+    font_instance *font = i->first.font;
+    _entries.erase(i);
+    font->Unref();
+}
+
+} // end namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
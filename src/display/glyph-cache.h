@@ -0,0 +1,129 @@
+/**
+ * @file
+ * Rendering data of glyphs shared by all text.
+ *//*
+ * Authors:
+ *   see git history
+ *
+ * Copyright (C) 2016 Authors
+ * Released under GNU GPL, read the file 'COPYING' for more information
+ */
+
+#ifndef SEEN_INKSCAPE_DISPLAY_GLYPH_CACHE_H
+#define SEEN_INKSCAPE_DISPLAY_GLYPH_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <boost/utility.hpp>
+#include <cairo.h>
+#include <2geom/affine.h>
+#include <2geom/int-point.h>
+
+class font_instance;
+
+namespace Inkscape {
+
+/**
+ * Glyph outlines converted to cairo paths, and coverage masks of glyphs rasterized at small
+ * sizes, shared by the text of all drawings. Entries hold a reference to their font and are
+ * dropped least recently used first when the memory budget is exceeded.
+ *
+ * Not thread safe: during rendering it is only used with the drawing's RenderGuard held.
+ */
+class GlyphCache
+    : boost::noncopyable
+{
+public:
+    struct Stats {
+        Stats() : hits(0), misses(0), evictions(0), memory(0) {}
+        unsigned long hits;      ///< outlines and masks found in the cache
+        unsigned long misses;    ///< outlines and masks that had to be created
+        unsigned long evictions; ///< entries dropped to stay within budget
+        size_t memory;           ///< bytes currently used by entries
+    };
+
+    static GlyphCache &get();
+
+    /**
+     * The outline of a glyph in glyph units, to be added to a path with cairo_append_path().
+     * Valid until the next call; NULL if the glyph has no outline or the cache is disabled.
+     */
+    cairo_path_t const *outline(font_instance *font, int glyph);
+
+    /**
+     * Whether a glyph drawn with the given device transform can be painted from a mask: the
+     * transform is a uniform scale, possibly mirrored, small enough for the glyph to be cheap
+     * to keep as pixels.
+     */
+    bool canMask(Geom::Affine const &ctm) const;
+
+    /**
+     * The coverage of a glyph drawn with ctm, which must pass canMask(). The translation is
+     * rounded to a quarter of a pixel. The mask is an A8 surface to be placed with its top left
+     * corner at origin, valid until the next call; NULL if the glyph covers no pixels.
+     */
+    cairo_surface_t *mask(font_instance *font, int glyph, Geom::Affine const &ctm,
+                          Geom::IntPoint &origin);
+
+    /// Sets the memory budget in bytes; 0 disables the cache.
+    void setBudget(size_t bytes);
+    Stats stats() const { return _stats; }
+    void resetStats();
+    void clear();
+
+private:
+    struct Key {
+        Key(font_instance *f, int g, float sx = 0, float sy = 0, int ox = 0, int oy = 0)
+            : font(f), glyph(g), xscale(sx), yscale(sy), xoffset(ox), yoffset(oy)
+        {}
+        bool operator<(Key const &other) const;
+
+        font_instance *font;
+        int glyph;
+        float xscale;   ///< 0 for outlines
+        float yscale;
+        int xoffset;    ///< subpixel position, in quarters of a pixel
+        int yoffset;
+    };
+
+    struct Entry {
+        Entry() : path(NULL), mask(NULL), size(0) {}
+
+        cairo_path_t *path;
+        cairo_surface_t *mask;
+        Geom::IntPoint origin;  ///< top left corner of the mask, relative to the glyph's pixel
+        size_t size;
+        std::list<Key>::iterator lru;
+    };
+
+    typedef std::map<Key, Entry> EntryMap;
+
+    GlyphCache();
+    ~GlyphCache();
+
+    Entry *_find(Key const &key);
+    Entry &_insert(Key const &key, size_t size);
+    void _evict(size_t budget);
+    void _erase(EntryMap::iterator i);
+
+    EntryMap _entries;
+    std::list<Key> _lru; ///< most recently used first
+    size_t _budget;
+    Stats _stats;
+};
+
+} // end namespace Inkscape
+
+#endif // !SEEN_INKSCAPE_DISPLAY_GLYPH_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
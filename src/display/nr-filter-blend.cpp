@@ -163,6 +163,11 @@ void FilterBlend::set_input(int input, int slot) {
     if (input == 1) _input2 = slot;
 }
 
+void FilterBlend::get_inputs(std::vector<int> &inputs) const {
+    inputs.push_back(_input);
+    inputs.push_back(_input2);
+}
+
 void FilterBlend::set_mode(FilterBlendMode mode) {
     if (mode == BLEND_NORMAL     || mode == BLEND_MULTIPLY   ||
         mode == BLEND_SCREEN     || mode == BLEND_DARKEN     ||
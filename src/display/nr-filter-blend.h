@@ -56,6 +56,7 @@ public:
 
     virtual void set_input(int slot);
     virtual void set_input(int input, int slot);
+    virtual void get_inputs(std::vector<int> &inputs) const;
     void set_mode(FilterBlendMode mode);
 
 private:
@@ -12,6 +12,7 @@
 
 #include <math.h>
 #include <algorithm>
+#include "display/cairo-simd.h"
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
 #include "display/nr-filter-colormatrix.h"
@@ -73,6 +74,16 @@ guint32 FilterColorMatrix::ColorMatrixMatrix::operator()(guint32 in) {
     return pxout;
 }
 
+void ink_cairo_filter_span(FilterColorMatrix::ColorMatrixMatrix &matrix, guint32 const *in, guint32 *out, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        i += ink_simd_color_matrix(in + i, out + i, n - i, matrix._v);
+        if (i < n) {
+            out[i] = matrix(in[i]);
+        }
+    }
+}
+
 
 struct ColorMatrixSaturate {
     ColorMatrixSaturate(double v_in) {
@@ -148,6 +159,18 @@ struct ColorMatrixLuminanceToAlpha {
     }
 };
 
+template <typename Filter>
+class ColorMatrixOperation : public FilterPixelOperation {
+public:
+    ColorMatrixOperation(Filter const &filter) : _filter(filter) {}
+    virtual void filter(guint32 const *in, guint32 *out, int n) {
+        using ::ink_cairo_filter_span;
+        ink_cairo_filter_span(_filter, in, out, n);
+    }
+private:
+    Filter _filter;
+};
+
 void FilterColorMatrix::render_cairo(FilterSlot &slot)
 {
     cairo_surface_t *input = slot.getcairo(_input);
@@ -192,6 +215,22 @@ void FilterColorMatrix::render_cairo(FilterSlot &slot)
     cairo_surface_destroy(out);
 }
 
+FilterPixelOperation *FilterColorMatrix::pixel_operation() const
+{
+    switch (type) {
+    case COLORMATRIX_MATRIX:
+        return new ColorMatrixOperation<ColorMatrixMatrix>(ColorMatrixMatrix(values));
+    case COLORMATRIX_SATURATE:
+        return new ColorMatrixOperation<ColorMatrixSaturate>(ColorMatrixSaturate(value));
+    case COLORMATRIX_HUEROTATE:
+        return new ColorMatrixOperation<ColorMatrixHueRotate>(ColorMatrixHueRotate(value));
+    case COLORMATRIX_LUMINANCETOALPHA: // the output is an alpha-only image
+    case COLORMATRIX_ENDTYPE:
+    default:
+        return NULL;
+    }
+}
+
 bool FilterColorMatrix::can_handle_affine(Geom::Affine const &)
 {
     return true;
@@ -41,6 +41,7 @@ public:
     virtual void render_cairo(FilterSlot &slot);
     virtual bool can_handle_affine(Geom::Affine const &);
     virtual double complexity(Geom::Affine const &ctm);
+    virtual FilterPixelOperation *pixel_operation() const;
 
     virtual void set_type(FilterColorMatrixType type);
     virtual void set_value(double value);
@@ -50,6 +51,8 @@ public:
     struct ColorMatrixMatrix {
         ColorMatrixMatrix(std::vector<double> const &values);
         guint32 operator()(guint32 in);
+        /// Vectorized version of operator(), used by ink_cairo_surface_filter().
+        friend void ink_cairo_filter_span(ColorMatrixMatrix &matrix, guint32 const *in, guint32 *out, int n);
     private:
         gint32 _v[20];
     };
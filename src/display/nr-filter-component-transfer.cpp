@@ -11,6 +11,7 @@
  */
 
 #include <math.h>
+#include "display/cairo-simd.h"
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
 #include "display/nr-filter-component-transfer.h"
@@ -41,6 +42,14 @@ struct UnmultiplyAlpha {
         ASSEMBLE_ARGB32(out, a, r, g, b);
         return out;
     }
+    friend void ink_cairo_filter_span(UnmultiplyAlpha &filter, guint32 const *in, guint32 *out, int n) {
+        for (int i = 0; i < n; ++i) {
+            i += ink_simd_unpremultiply(in + i, out + i, n - i);
+            if (i < n) {
+                out[i] = filter(in[i]);
+            }
+        }
+    }
 };
 
 struct MultiplyAlpha {
@@ -54,6 +63,14 @@ struct MultiplyAlpha {
         ASSEMBLE_ARGB32(out, a, r, g, b);
         return out;
     }
+    friend void ink_cairo_filter_span(MultiplyAlpha &filter, guint32 const *in, guint32 *out, int n) {
+        for (int i = 0; i < n; ++i) {
+            i += ink_simd_premultiply(in + i, out + i, n - i);
+            if (i < n) {
+                out[i] = filter(in[i]);
+            }
+        }
+    }
 };
 
 struct ComponentTransfer {
@@ -146,63 +163,123 @@ private:
     double _offset;
 };
 
-void FilterComponentTransfer::render_cairo(FilterSlot &slot)
-{
-    cairo_surface_t *input = slot.getcairo(_input);
-    cairo_surface_t *out = ink_cairo_surface_create_same_size(input, CAIRO_CONTENT_COLOR_ALPHA);
-
-    // We may need to transform input surface to correct color interpolation space. The input surface
-    // might be used as input to another primitive but it is likely that all the primitives in a given
-    // filter use the same color interpolation space so we don't copy the input before converting.
-    SPColorInterpolation ci_fp = SP_CSS_COLOR_INTERPOLATION_AUTO;
-    if( _style ) {
-        ci_fp = (SPColorInterpolation)_style->color_interpolation_filters.computed;
-        set_cairo_surface_ci(out, ci_fp );
+// Each transfer function only depends on its own component, so they are tabulated
+// and applied together in a single pass.
+struct ComponentTransferLookup {
+    ComponentTransferLookup() {
+        for (unsigned c = 0; c < 4; ++c) {
+            for (unsigned x = 0; x < 256; ++x) {
+                _table[c][x] = x;
+            }
+        }
     }
-    set_cairo_surface_ci( input, ci_fp );
-
-    //cairo_surface_t *outtemp = ink_cairo_surface_create_identical(out);
-    ink_cairo_surface_blit(input, out);
-
-    // We need to operate on unmultipled by alpha color values otherwise a change in alpha screws
-    // up the premultiplied by alpha r, g, b values.
-    ink_cairo_surface_filter(out, out, UnmultiplyAlpha());
+    template <typename Transfer>
+    void set(guint32 color, Transfer transfer) {
+        for (guint32 x = 0; x < 256; ++x) {
+            _table[color][x] = (transfer(x << (color * 8)) >> (color * 8)) & 0xff;
+        }
+    }
+    guint32 operator()(guint32 in) {
+        return (guint32(_table[3][in >> 24]) << 24)
+             | (guint32(_table[2][(in >> 16) & 0xff]) << 16)
+             | (guint32(_table[1][(in >> 8) & 0xff]) << 8)
+             | guint32(_table[0][in & 0xff]);
+    }
+private:
+    guint8 _table[4][256];
+};
 
+// Returns false if all transfer functions are the identity.
+static bool build_lookup(FilterComponentTransfer const &transfer, ComponentTransferLookup &lookup)
+{
     // parameters: R = 0, G = 1, B = 2, A = 3
     // Cairo:      R = 2, G = 1, B = 0, A = 3
     // If tableValues is empty, use identity.
+    bool identity = true;
     for (unsigned i = 0; i < 4; ++i) {
 
         guint32 color = 2 - i;
         if(i==3) color = 3; // alpha
 
-        switch (type[i]) {
+        switch (transfer.type[i]) {
         case COMPONENTTRANSFER_TYPE_TABLE:
-            if(!tableValues[i].empty()) {
-              ink_cairo_surface_filter(out, out,
-                  ComponentTransferTable(color, tableValues[i]));
+            if(!transfer.tableValues[i].empty()) {
+                lookup.set(color, ComponentTransferTable(color, transfer.tableValues[i]));
+                identity = false;
             }
             break;
         case COMPONENTTRANSFER_TYPE_DISCRETE:
-            if(!tableValues[i].empty()) {
-                ink_cairo_surface_filter(out, out,
-                    ComponentTransferDiscrete(color, tableValues[i]));
+            if(!transfer.tableValues[i].empty()) {
+                lookup.set(color, ComponentTransferDiscrete(color, transfer.tableValues[i]));
+                identity = false;
             }
             break;
         case COMPONENTTRANSFER_TYPE_LINEAR:
-            ink_cairo_surface_filter(out, out,
-                ComponentTransferLinear(color, intercept[i], slope[i]));
+            lookup.set(color, ComponentTransferLinear(color, transfer.intercept[i], transfer.slope[i]));
+            identity = false;
             break;
         case COMPONENTTRANSFER_TYPE_GAMMA:
-            ink_cairo_surface_filter(out, out,
-                ComponentTransferGamma(color, amplitude[i], exponent[i], offset[i]));
+            lookup.set(color, ComponentTransferGamma(color, transfer.amplitude[i], transfer.exponent[i],
+                                                     transfer.offset[i]));
+            identity = false;
             break;
         case COMPONENTTRANSFER_TYPE_ERROR:
         case COMPONENTTRANSFER_TYPE_IDENTITY:
         default:
             break;
         }
-        //ink_cairo_surface_blit(out, outtemp);
+    }
+    return !identity;
+}
+
+// The same steps as render_cairo(), on a span of pixels.
+class ComponentTransferOperation : public FilterPixelOperation {
+public:
+    ComponentTransferOperation(FilterComponentTransfer const &transfer) {
+        _identity = !build_lookup(transfer, _lookup);
+    }
+    virtual void filter(guint32 const *in, guint32 *out, int n) {
+        using ::ink_cairo_filter_span;
+        UnmultiplyAlpha unmultiply;
+        MultiplyAlpha multiply;
+        ink_cairo_filter_span(unmultiply, in, out, n);
+        if (!_identity) {
+            for (int i = 0; i < n; ++i) {
+                out[i] = _lookup(out[i]);
+            }
+        }
+        ink_cairo_filter_span(multiply, out, out, n);
+    }
+private:
+    ComponentTransferLookup _lookup;
+    bool _identity;
+};
+
+void FilterComponentTransfer::render_cairo(FilterSlot &slot)
+{
+    cairo_surface_t *input = slot.getcairo(_input);
+    cairo_surface_t *out = ink_cairo_surface_create_same_size(input, CAIRO_CONTENT_COLOR_ALPHA);
+
+    // We may need to transform input surface to correct color interpolation space. The input surface
+    // might be used as input to another primitive but it is likely that all the primitives in a given
+    // filter use the same color interpolation space so we don't copy the input before converting.
+    SPColorInterpolation ci_fp = SP_CSS_COLOR_INTERPOLATION_AUTO;
+    if( _style ) {
+        ci_fp = (SPColorInterpolation)_style->color_interpolation_filters.computed;
+        set_cairo_surface_ci(out, ci_fp );
+    }
+    set_cairo_surface_ci( input, ci_fp );
+
+    //cairo_surface_t *outtemp = ink_cairo_surface_create_identical(out);
+    ink_cairo_surface_blit(input, out);
+
+    // We need to operate on unmultipled by alpha color values otherwise a change in alpha screws
+    // up the premultiplied by alpha r, g, b values.
+    ink_cairo_surface_filter(out, out, UnmultiplyAlpha());
+
+    ComponentTransferLookup lookup;
+    if (build_lookup(*this, lookup)) {
+        ink_cairo_surface_filter(out, out, lookup);
     }
 
     ink_cairo_surface_filter(out, out, MultiplyAlpha());
@@ -212,6 +289,11 @@ void FilterComponentTransfer::render_cairo(FilterSlot &slot)
     //cairo_surface_destroy(outtemp);
 }
 
+FilterPixelOperation *FilterComponentTransfer::pixel_operation() const
+{
+    return new ComponentTransferOperation(*this);
+}
+
 bool FilterComponentTransfer::can_handle_affine(Geom::Affine const &)
 {
     return true;
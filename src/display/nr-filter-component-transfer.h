@@ -38,6 +38,7 @@ public:
     virtual void render_cairo(FilterSlot &slot);
     virtual bool can_handle_affine(Geom::Affine const &);
     virtual double complexity(Geom::Affine const &ctm);
+    virtual FilterPixelOperation *pixel_operation() const;
 
     FilterComponentTransferType type[4];
     std::vector<double> tableValues[4];
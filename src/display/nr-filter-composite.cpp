@@ -11,6 +11,7 @@
 
 #include <cmath>
 
+#include "display/cairo-simd.h"
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
 #include "display/nr-filter-composite.h"
@@ -57,6 +58,16 @@ struct ComposeArithmetic {
         ASSEMBLE_ARGB32(pxout, ao, ro, go, bo)
         return pxout;
     }
+    friend void ink_cairo_blend_span(ComposeArithmetic &blend, guint32 const *in1, guint32 const *in2,
+                                     guint32 *out, int n) {
+        for (int i = 0; i < n; ++i) {
+            i += ink_simd_compose_arithmetic(in1 + i, in2 + i, out + i, n - i,
+                                             blend._k1, blend._k2, blend._k3, blend._k4);
+            if (i < n) {
+                out[i] = blend(in1[i], in2[i]);
+            }
+        }
+    }
 private:
     gint32 _k1, _k2, _k3, _k4;
 };
@@ -153,6 +164,11 @@ void FilterComposite::set_input(int input, int slot) {
     if (input == 1) _input2 = slot;
 }
 
+void FilterComposite::get_inputs(std::vector<int> &inputs) const {
+    inputs.push_back(_input);
+    inputs.push_back(_input2);
+}
+
 void FilterComposite::set_operator(FeCompositeOperator op) {
     if (op == COMPOSITE_DEFAULT) {
         this->op = COMPOSITE_OVER;
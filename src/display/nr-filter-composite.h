@@ -32,6 +32,7 @@ public:
 
     virtual void set_input(int input);
     virtual void set_input(int input, int slot);
+    virtual void get_inputs(std::vector<int> &inputs) const;
 
     void set_operator(FeCompositeOperator op);
     void set_arithmetic(double k1, double k2, double k3, double k4);
@@ -32,6 +32,7 @@ public:
 
     virtual void set_input(int slot);
     virtual void set_input(int input, int slot);
+    virtual void get_inputs(std::vector<int> &inputs) const;
     virtual void set_scale(double s);
     virtual void set_channel_selector(int s, FilterDisplacementMapChannelSelector channel);
 
@@ -30,6 +30,7 @@ public:
     virtual bool can_handle_affine(Geom::Affine const &);
     virtual double complexity(Geom::Affine const &ctm);
     virtual bool uses_background() { return false; }
+    virtual void get_inputs(std::vector<int> &) const {} // only the size of the input is used
     
     virtual void set_opacity(double o);
     virtual void set_color(guint32 c);
@@ -0,0 +1,225 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cairo.h>
+#include <glib.h>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include "display/nr-filter-gaussian.h"
+
+using Inkscape::Filters::GaussianBlurMode;
+using Inkscape::Filters::gaussian_blur_surface;
+
+class NrFilterGaussianTest : public CxxTest::TestSuite {
+private:
+    static int channels(cairo_surface_t *s) {
+        return cairo_image_surface_get_format(s) == CAIRO_FORMAT_A8 ? 1 : 4;
+    }
+
+    /// Random noise, with valid premultiplied colors for ARGB32.
+    static cairo_surface_t *noise(cairo_format_t format, int w, int h) {
+        cairo_surface_t *s = cairo_image_surface_create(format, w, h);
+        unsigned char *data = cairo_image_surface_get_data(s);
+        int stride = cairo_image_surface_get_stride(s);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                guint32 a = std::rand() & 0xff;
+                if (format == CAIRO_FORMAT_A8) {
+                    data[y*stride + x] = a;
+                } else {
+                    guint32 c = (std::rand() & 0xff) * a / 255;
+                    *reinterpret_cast<guint32*>(data + y*stride + 4*x) = (a << 24) | (c << 16) | (c/2 << 8) | c/3;
+                }
+            }
+        }
+        cairo_surface_mark_dirty(s);
+        return s;
+    }
+
+    /// Opaque bars of the given width on a transparent background, away from the left and right edges.
+    static cairo_surface_t *bars(cairo_format_t format, int w, int h, int bar, int margin) {
+        cairo_surface_t *s = cairo_image_surface_create(format, w, h);
+        cairo_t *ct = cairo_create(s);
+        for (int x = margin; x + bar <= w - margin; x += 4*bar) {
+            cairo_rectangle(ct, x, 0, bar, h);
+        }
+        cairo_fill(ct);
+        cairo_destroy(ct);
+        return s;
+    }
+
+    static cairo_surface_t *copy(cairo_surface_t *s) {
+        cairo_surface_t *c = cairo_image_surface_create(cairo_image_surface_get_format(s),
+            cairo_image_surface_get_width(s), cairo_image_surface_get_height(s));
+        cairo_t *ct = cairo_create(c);
+        cairo_set_source_surface(ct, s, 0, 0);
+        cairo_set_operator(ct, CAIRO_OPERATOR_SOURCE);
+        cairo_paint(ct);
+        cairo_destroy(ct);
+        return c;
+    }
+
+    static cairo_surface_t *transposed(cairo_surface_t *s) {
+        int w = cairo_image_surface_get_width(s);
+        int h = cairo_image_surface_get_height(s);
+        int pc = channels(s);
+        cairo_surface_t *t = cairo_image_surface_create(cairo_image_surface_get_format(s), h, w);
+        cairo_surface_flush(s);
+        unsigned char const *sd = cairo_image_surface_get_data(s);
+        unsigned char *td = cairo_image_surface_get_data(t);
+        int sstride = cairo_image_surface_get_stride(s);
+        int tstride = cairo_image_surface_get_stride(t);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                std::copy(sd + y*sstride + x*pc, sd + y*sstride + (x+1)*pc, td + x*tstride + y*pc);
+            }
+        }
+        cairo_surface_mark_dirty(t);
+        return t;
+    }
+
+    static int maxDifference(cairo_surface_t *a, cairo_surface_t *b) {
+        cairo_surface_flush(a);
+        cairo_surface_flush(b);
+        unsigned char const *ad = cairo_image_surface_get_data(a);
+        unsigned char const *bd = cairo_image_surface_get_data(b);
+        int stride = cairo_image_surface_get_stride(a);
+        int bytes = cairo_image_surface_get_width(a) * channels(a);
+        int diff = 0;
+        for (int y = 0; y < cairo_image_surface_get_height(a); ++y) {
+            for (int x = 0; x < bytes; ++x) {
+                diff = std::max(diff, std::abs(ad[y*stride + x] - bd[y*stride + x]));
+            }
+        }
+        return diff;
+    }
+
+    static bool validPremultiplied(cairo_surface_t *s) {
+        cairo_surface_flush(s);
+        unsigned char const *data = cairo_image_surface_get_data(s);
+        int stride = cairo_image_surface_get_stride(s);
+        for (int y = 0; y < cairo_image_surface_get_height(s); ++y) {
+            for (int x = 0; x < cairo_image_surface_get_width(s); ++x) {
+                guint32 px = *reinterpret_cast<guint32 const*>(data + y*stride + 4*x);
+                guint32 a = px >> 24;
+                if (((px >> 16) & 0xff) > a || ((px >> 8) & 0xff) > a || (px & 0xff) > a) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+public:
+    NrFilterGaussianTest() {}
+    virtual ~NrFilterGaussianTest() {}
+
+    static NrFilterGaussianTest *createSuite() { return new NrFilterGaussianTest(); }
+    static void destroySuite( NrFilterGaussianTest *suite ) { delete suite; }
+
+    // The horizontal and vertical passes work differently, but have to give the same result.
+    // The sizes are no multiples of the number of lines or columns filtered together.
+    void testDirectionsAgree()
+    {
+        std::srand(1);
+        cairo_format_t const formats[2] = { CAIRO_FORMAT_A8, CAIRO_FORMAT_ARGB32 };
+        for (unsigned f = 0; f < 2; ++f) {
+            for (int mode = Inkscape::Filters::GAUSSIAN_BLUR_FIR; mode <= Inkscape::Filters::GAUSSIAN_BLUR_BOX; ++mode) {
+                for (int threads = 1; threads <= 3; threads += 2) {
+                    cairo_surface_t *s = noise(formats[f], 45, 31);
+                    cairo_surface_t *t = transposed(s);
+                    gaussian_blur_surface(s, 5.5, 0, static_cast<GaussianBlurMode>(mode), threads);
+                    gaussian_blur_surface(t, 0, 5.5, static_cast<GaussianBlurMode>(mode), threads);
+                    cairo_surface_t *tt = transposed(t);
+                    TS_ASSERT_EQUALS(maxDifference(s, tt), 0);
+                    if (formats[f] == CAIRO_FORMAT_ARGB32) {
+                        TS_ASSERT(validPremultiplied(s));
+                        TS_ASSERT(validPremultiplied(tt));
+                    }
+                    cairo_surface_destroy(s);
+                    cairo_surface_destroy(t);
+                    cairo_surface_destroy(tt);
+                }
+            }
+        }
+    }
+
+    void testConstant()
+    {
+        for (int mode = Inkscape::Filters::GAUSSIAN_BLUR_AUTO; mode <= Inkscape::Filters::GAUSSIAN_BLUR_BOX; ++mode) {
+            cairo_surface_t *s = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 37, 29);
+            cairo_t *ct = cairo_create(s);
+            cairo_set_source_rgba(ct, 0.5, 0.25, 0.125, 0.5);
+            cairo_paint(ct);
+            cairo_destroy(ct);
+            cairo_surface_t *c = copy(s);
+            gaussian_blur_surface(s, 4.5, 6.5, static_cast<GaussianBlurMode>(mode), 2);
+            TS_ASSERT_EQUALS(maxDifference(s, c), 0);
+            cairo_surface_destroy(s);
+            cairo_surface_destroy(c);
+        }
+    }
+
+    void testModesApproximateEachOther()
+    {
+        double const deviations[3] = { 4, 8, 16 };
+        for (unsigned d = 0; d < 3; ++d) {
+            // the approximation differs most at the edges, which the bars keep away from
+            cairo_surface_t *fir = bars(CAIRO_FORMAT_ARGB32, 256, 150, 4, 64);
+            cairo_surface_t *iir = copy(fir);
+            cairo_surface_t *box = copy(fir);
+            gaussian_blur_surface(fir, deviations[d], deviations[d], Inkscape::Filters::GAUSSIAN_BLUR_FIR, 1);
+            gaussian_blur_surface(iir, deviations[d], deviations[d], Inkscape::Filters::GAUSSIAN_BLUR_IIR, 1);
+            gaussian_blur_surface(box, deviations[d], deviations[d], Inkscape::Filters::GAUSSIAN_BLUR_BOX, 1);
+            TS_ASSERT_LESS_THAN_EQUALS(maxDifference(fir, iir), 3);
+            TS_ASSERT_LESS_THAN_EQUALS(maxDifference(fir, box), 10);
+            cairo_surface_destroy(fir);
+            cairo_surface_destroy(iir);
+            cairo_surface_destroy(box);
+        }
+    }
+
+    // Set INKSCAPE_BENCHMARK_BLUR to go on with larger surfaces, up to 4096x4096 pixels.
+    void testSurfaceSizes()
+    {
+        std::srand(2);
+        int const sizes[3] = { 256, 1024, 4096 };
+        double const deviations[4] = { 1, 3, 10, 50 };
+        unsigned const count = g_getenv("INKSCAPE_BENCHMARK_BLUR") ? G_N_ELEMENTS(sizes) : 1;
+        int const threads = 4;
+        TS_TRACE("Benchmarking blur modes...");
+        GTimer *timer = g_timer_new();
+        for (unsigned i = 0; i < count; ++i) {
+            cairo_surface_t *surface = noise(CAIRO_FORMAT_ARGB32, sizes[i], sizes[i]);
+            for (unsigned d = 0; d < G_N_ELEMENTS(deviations); ++d) {
+                for (int mode = Inkscape::Filters::GAUSSIAN_BLUR_AUTO; mode <= Inkscape::Filters::GAUSSIAN_BLUR_BOX; ++mode) {
+                    if (mode == Inkscape::Filters::GAUSSIAN_BLUR_IIR && deviations[d] < 2) {
+                        continue; // unstable
+                    }
+                    // blur a fresh copy, as blurred images take the FIR filter less time
+                    cairo_surface_t *blurred = copy(surface);
+                    g_timer_start(timer);
+                    gaussian_blur_surface(blurred, deviations[d], deviations[d], static_cast<GaussianBlurMode>(mode), threads);
+                    double elapsed = g_timer_elapsed(timer, NULL);
+                    std::cout << "Took " << elapsed << " seconds to blur " << sizes[i] << "x" << sizes[i] << " pixels by "
+                              << deviations[d] << " in mode " << mode << " with " << threads << " threads\n";
+                    TS_ASSERT(validPremultiplied(blurred));
+                    cairo_surface_destroy(blurred);
+                }
+            }
+            cairo_surface_destroy(surface);
+        }
+        g_timer_destroy(timer);
+    }
+};
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
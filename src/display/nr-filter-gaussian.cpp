@@ -288,13 +288,16 @@ static void calcTriggsSdikaInitialization(double const M[N*N], IIRValue const uo
     }
 }
 
-// Filters over 1st dimension
-template<typename PT, unsigned int PC, bool PREMULTIPLIED_ALPHA>
-static void
-filter2D_IIR(PT *const dest, int const dstr1, int const dstr2,
-             PT const *const src, int const sstr1, int const sstr2,
-             int const n1, int const n2, IIRValue const b[N+1], double const M[N*N],
-             IIRValue *const tmpdata[], int const num_threads)
+// Number of values which the IIR filter and the box blur process side by side: several
+// neighbouring lines are filtered in lockstep, so that the compiler can vectorize the
+// recursion over them and the vertical passes read whole runs of pixels from each row
+// instead of striding through the image one pixel at a time.
+static unsigned int const LINE_BLOCK_VALUES = 16;
+
+// Store one filtered pixel of each of LINES lines.
+template<typename PT, unsigned int PC, bool PREMULTIPLIED_ALPHA, unsigned int LINES>
+static inline void
+store_IIR_pixels(PT *const dst, int const dstr2, IIRValue const v[LINES*PC])
 {
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
     static unsigned int const alpha_PC = PC-1;
@@ -304,60 +307,98 @@ filter2D_IIR(PT *const dest, int const dstr1, int const dstr2,
     #define PREMUL_ALPHA_LOOP for(unsigned int c=1; c<PC; ++c)
 #endif
 
+    for(unsigned int l=0; l<LINES; l++) {
+        PT *const px = dst + l*dstr2;
+        IIRValue const *const pv = v + l*PC;
+        if ( PREMULTIPLIED_ALPHA ) {
+            px[alpha_PC] = clip_round_cast<PT>(pv[alpha_PC]);
+            PREMUL_ALPHA_LOOP px[c] = clip_round_cast_varmax<PT>(pv[c], px[alpha_PC]);
+        } else {
+            for(unsigned int c=0; c<PC; c++) px[c] = clip_round_cast<PT>(pv[c]);
+        }
+    }
+
+#undef PREMUL_ALPHA_LOOP
+}
+
+// Filters LINES neighbouring lines over 1st dimension
+// tmpdata must have room for n1*LINES*PC values
+template<typename PT, unsigned int PC, bool PREMULTIPLIED_ALPHA, unsigned int LINES>
+static void
+filter_lines_IIR(PT *const dest, int const dstr1, int const dstr2,
+                 PT const *const src, int const sstr1, int const sstr2,
+                 int const n1, IIRValue const b[N+1], double const M[N*N], IIRValue *const tmpdata)
+{
+    static unsigned int const V = LINES*PC;
+
+    // Border constants
+    IIRValue imin[V];
+    IIRValue iplus[V];
+    for(unsigned int l=0; l<LINES; l++) {
+        copy_n(src + l*sstr2, PC, imin + l*PC);
+        copy_n(src + l*sstr2 + (n1-1)*sstr1, PC, iplus + l*PC);
+    }
+    // Forward pass
+    IIRValue u[N+1][V];
+    for(unsigned int i=0; i<N; i++) copy_n(imin, V, u[i]);
+    for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
+        for(unsigned int i=N; i>0; i--) copy_n(u[i-1], V, u[i]);
+        PT const *const srcpx = src + c1*sstr1;
+        for(unsigned int l=0; l<LINES; l++) copy_n(srcpx + l*sstr2, PC, u[0] + l*PC);
+        for(unsigned int k=0; k<V; k++) u[0][k] *= b[0];
+        for(unsigned int i=1; i<N+1; i++) {
+            for(unsigned int k=0; k<V; k++) u[0][k] += u[i][k]*b[i];
+        }
+        copy_n(u[0], V, tmpdata+c1*V);
+    }
+    // Backward pass
+    IIRValue v[N+1][V];
+    calcTriggsSdikaInitialization<V>(M, u, iplus, iplus, b[0], v);
+    store_IIR_pixels<PT,PC,PREMULTIPLIED_ALPHA,LINES>(dest + (n1-1)*dstr1, dstr2, v[0]);
+    for ( int c1 = n1-2 ; c1 >= 0 ; c1-- ) {
+        for(unsigned int i=N; i>0; i--) copy_n(v[i-1], V, v[i]);
+        copy_n(tmpdata+c1*V, V, v[0]);
+        for(unsigned int k=0; k<V; k++) v[0][k] *= b[0];
+        for(unsigned int i=1; i<N+1; i++) {
+            for(unsigned int k=0; k<V; k++) v[0][k] += v[i][k]*b[i];
+        }
+        store_IIR_pixels<PT,PC,PREMULTIPLIED_ALPHA,LINES>(dest + c1*dstr1, dstr2, v[0]);
+    }
+}
+
+// Filters over 1st dimension
+// tmpdata must have room for n1*LINE_BLOCK_VALUES values per thread
+template<typename PT, unsigned int PC, bool PREMULTIPLIED_ALPHA>
+static void
+filter2D_IIR(PT *const dest, int const dstr1, int const dstr2,
+             PT const *const src, int const sstr1, int const sstr2,
+             int const n1, int const n2, IIRValue const b[N+1], double const M[N*N],
+             IIRValue *const tmpdata, int const num_threads)
+{
+    static unsigned int const LINES = LINE_BLOCK_VALUES/PC;
+    // whole blocks of lines first, then the remaining lines one by one
+    int const blocks = n2 / LINES;
+    int const jobs = blocks + n2 % LINES;
+
 INK_UNUSED(num_threads); // to suppress unused argument compiler warning
 #if HAVE_OPENMP
 #pragma omp parallel for num_threads(num_threads)
 #endif // HAVE_OPENMP
-    for ( int c2 = 0 ; c2 < n2 ; c2++ ) {
+    for ( int job = 0 ; job < jobs ; job++ ) {
 #if HAVE_OPENMP
         unsigned int tid = omp_get_thread_num();
 #else
         unsigned int tid = 0;
 #endif // HAVE_OPENMP
-        // corresponding line in the source and output buffer
-        PT const * srcimg = src  + c2*sstr2;
-        PT       * dstimg = dest + c2*dstr2 + n1*dstr1;
-        // Border constants
-        IIRValue imin[PC];  copy_n(srcimg + (0)*sstr1, PC, imin);
-        IIRValue iplus[PC]; copy_n(srcimg + (n1-1)*sstr1, PC, iplus);
-        // Forward pass
-        IIRValue u[N+1][PC];
-        for(unsigned int i=0; i<N; i++) copy_n(imin, PC, u[i]);
-        for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
-            for(unsigned int i=N; i>0; i--) copy_n(u[i-1], PC, u[i]);
-            copy_n(srcimg, PC, u[0]);
-            srcimg += sstr1;
-            for(unsigned int c=0; c<PC; c++) u[0][c] *= b[0];
-            for(unsigned int i=1; i<N+1; i++) {
-                for(unsigned int c=0; c<PC; c++) u[0][c] += u[i][c]*b[i];
-            }
-            copy_n(u[0], PC, tmpdata[tid]+c1*PC);
-        }
-        // Backward pass
-        IIRValue v[N+1][PC];
-        calcTriggsSdikaInitialization<PC>(M, u, iplus, iplus, b[0], v);
-        dstimg -= dstr1;
-        if ( PREMULTIPLIED_ALPHA ) {
-            dstimg[alpha_PC] = clip_round_cast<PT>(v[0][alpha_PC]);
-            PREMUL_ALPHA_LOOP dstimg[c] = clip_round_cast_varmax<PT>(v[0][c], dstimg[alpha_PC]);
+        IIRValue *const tmp = tmpdata + tid*n1*LINE_BLOCK_VALUES;
+        if ( job < blocks ) {
+            int const c2 = job*LINES;
+            filter_lines_IIR<PT,PC,PREMULTIPLIED_ALPHA,LINES>(dest + c2*dstr2, dstr1, dstr2,
+                src + c2*sstr2, sstr1, sstr2, n1, b, M, tmp);
         } else {
-            for(unsigned int c=0; c<PC; c++) dstimg[c] = clip_round_cast<PT>(v[0][c]);
-        }
-        int c1=n1-1;
-        while(c1-->0) {
-            for(unsigned int i=N; i>0; i--) copy_n(v[i-1], PC, v[i]);
-            copy_n(tmpdata[tid]+c1*PC, PC, v[0]);
-            for(unsigned int c=0; c<PC; c++) v[0][c] *= b[0];
-            for(unsigned int i=1; i<N+1; i++) {
-                for(unsigned int c=0; c<PC; c++) v[0][c] += v[i][c]*b[i];
-            }
-            dstimg -= dstr1;
-            if ( PREMULTIPLIED_ALPHA ) {
-                dstimg[alpha_PC] = clip_round_cast<PT>(v[0][alpha_PC]);
-                PREMUL_ALPHA_LOOP dstimg[c] = clip_round_cast_varmax<PT>(v[0][c], dstimg[alpha_PC]);
-            } else {
-                for(unsigned int c=0; c<PC; c++) dstimg[c] = clip_round_cast<PT>(v[0][c]);
-            }
+            int const c2 = blocks*LINES + job - blocks;
+            filter_lines_IIR<PT,PC,PREMULTIPLIED_ALPHA,1>(dest + c2*dstr2, dstr1, dstr2,
+                src + c2*sstr2, sstr1, sstr2, n1, b, M, tmp);
         }
     }
 }
@@ -468,9 +509,148 @@ INK_UNUSED(num_threads); // suppresses unused argument compiler warning
     }
 }
 
+// Number of columns which the vertical FIR pass filters together.
+static int const FIR_STRIP_WIDTH = 16;
+
+// Filters over 2nd dimension (the columns of an image)
+// Strips of columns are copied into a buffer in which every column is contiguous, filtered
+// there and copied back, so that the image itself is only read and written row by row.
+template<typename PT, unsigned int PC>
+static void
+filter2D_FIR_columns(PT *const dst, int const dstride, PT const *const src, int const sstride,
+                     int const w, int const h, FIRValue const *const kernel, int const scr_len,
+                     int const num_threads)
+{
+    int const strips = (w + FIR_STRIP_WIDTH - 1) / FIR_STRIP_WIDTH;
+    int const strip_size = FIR_STRIP_WIDTH * h * PC;
+    std::vector<PT> buffers(num_threads * strip_size);
+
+INK_UNUSED(num_threads); // suppresses unused argument compiler warning
+#if HAVE_OPENMP
+#pragma omp parallel for num_threads(num_threads)
+#endif // HAVE_OPENMP
+    for ( int strip = 0 ; strip < strips ; strip++ ) {
+#if HAVE_OPENMP
+        unsigned int tid = omp_get_thread_num();
+#else
+        unsigned int tid = 0;
+#endif // HAVE_OPENMP
+        PT *const buf = &buffers[tid * strip_size];
+        int const x0 = strip * FIR_STRIP_WIDTH;
+        int const sw = std::min(FIR_STRIP_WIDTH, w - x0);
+
+        for ( int y = 0 ; y < h ; y++ ) {
+            PT const *const row = src + y*sstride + x0*PC;
+            for ( int x = 0 ; x < sw ; x++ ) copy_n(row + x*PC, PC, buf + (x*h + y)*PC);
+        }
+        filter2D_FIR<PT,PC>(buf, PC, h*PC, buf, PC, h*PC, h, sw, kernel, scr_len, 1);
+        for ( int y = 0 ; y < h ; y++ ) {
+            PT *const row = dst + y*dstride + x0*PC;
+            for ( int x = 0 ; x < sw ; x++ ) copy_n(buf + (x*h + y)*PC, PC, row + x*PC);
+        }
+    }
+}
+
+// Box sizes approximating a gaussian blur by three successive box blurs, as described in the
+// SVG specification: for odd d three boxes of size d centered on the output pixel, otherwise
+// two boxes of size d centered on the pixel boundaries left and right of the output pixel and
+// one of size d+1. left and right are the extents of each box around the output pixel.
+// Returns d; the boxes are only valid if it is at least 1.
+static int
+_box_blur_extents(double const deviation, int left[3], int right[3])
+{
+    int const d = static_cast<int>(std::floor(deviation * 3 * std::sqrt(2 * M_PI) / 4 + 0.5));
+    if ( d % 2 == 1 ) {
+        for(unsigned int i=0; i<3; i++) left[i] = right[i] = (d-1)/2;
+    } else {
+        left[0] = d/2;   right[0] = d/2-1;
+        left[1] = d/2-1; right[1] = d/2;
+        left[2] = d/2;   right[2] = d/2;
+    }
+    return d;
+}
+
+// Box blurs LINES neighbouring lines over 1st dimension
+// tmpdata must have room for 2*n1*LINES*PC values
+// Premultiplied colors stay valid, as every box averages the color components and the alpha
+// of the same pixels with the same rounding.
+template<typename PT, unsigned int PC, unsigned int LINES>
+static void
+filter_lines_box(PT *const dest, int const dstr1, int const dstr2,
+                 PT const *const src, int const sstr1, int const sstr2,
+                 int const n1, int const left[3], int const right[3], int *const tmpdata)
+{
+    static unsigned int const V = LINES*PC;
+    int *in = tmpdata;
+    int *out = tmpdata + n1*V;
+
+    for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
+        for(unsigned int l=0; l<LINES; l++) copy_n(src + c1*sstr1 + l*sstr2, PC, in + c1*V + l*PC);
+    }
+    for(unsigned int pass=0; pass<3; pass++) {
+        int const size = left[pass] + right[pass] + 1;
+        // Exact division of (sum + size/2) by size, as sum < 256*size and size < 2^16
+        guint64 const inv = ((G_GUINT64_CONSTANT(1) << 40) + size - 1) / size;
+        // Window of the first pixel, extending the image by its border pixels
+        int sum[V];
+        std::fill_n(sum, V, 0);
+        for ( int i = -left[pass] ; i <= right[pass] ; i++ ) {
+            int const *const px = in + clip(i, 0, n1-1)*V;
+            for(unsigned int k=0; k<V; k++) sum[k] += px[k];
+        }
+        for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
+            for(unsigned int k=0; k<V; k++) out[c1*V+k] = ((sum[k] + size/2) * inv) >> 40;
+            int const *const add = in + std::min(c1 + right[pass] + 1, n1-1)*V;
+            int const *const sub = in + std::max(c1 - left[pass], 0)*V;
+            for(unsigned int k=0; k<V; k++) sum[k] += add[k] - sub[k];
+        }
+        std::swap(in, out);
+    }
+    for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
+        for(unsigned int l=0; l<LINES; l++) copy_n(in + c1*V + l*PC, PC, dest + c1*dstr1 + l*dstr2);
+    }
+}
+
+// Box blurs over 1st dimension
+// tmpdata must have room for 2*n1*LINE_BLOCK_VALUES values per thread
+template<typename PT, unsigned int PC>
+static void
+filter2D_box(PT *const dest, int const dstr1, int const dstr2,
+             PT const *const src, int const sstr1, int const sstr2,
+             int const n1, int const n2, int const left[3], int const right[3],
+             int *const tmpdata, int const num_threads)
+{
+    static unsigned int const LINES = LINE_BLOCK_VALUES/PC;
+    // whole blocks of lines first, then the remaining lines one by one
+    int const blocks = n2 / LINES;
+    int const jobs = blocks + n2 % LINES;
+
+INK_UNUSED(num_threads); // to suppress unused argument compiler warning
+#if HAVE_OPENMP
+#pragma omp parallel for num_threads(num_threads)
+#endif // HAVE_OPENMP
+    for ( int job = 0 ; job < jobs ; job++ ) {
+#if HAVE_OPENMP
+        unsigned int tid = omp_get_thread_num();
+#else
+        unsigned int tid = 0;
+#endif // HAVE_OPENMP
+        int *const tmp = tmpdata + tid*2*n1*LINE_BLOCK_VALUES;
+        if ( job < blocks ) {
+            int const c2 = job*LINES;
+            filter_lines_box<PT,PC,LINES>(dest + c2*dstr2, dstr1, dstr2,
+                src + c2*sstr2, sstr1, sstr2, n1, left, right, tmp);
+        } else {
+            int const c2 = blocks*LINES + job - blocks;
+            filter_lines_box<PT,PC,1>(dest + c2*dstr2, dstr1, dstr2,
+                src + c2*sstr2, sstr1, sstr2, n1, left, right, tmp);
+        }
+    }
+}
+
 static void
 gaussian_pass_IIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_surface_t *dest,
-    IIRValue **tmpdata, int num_threads)
+    int num_threads)
 {
     // Filter variables
     IIRValue b[N+1];  // scaling coefficient + filter coefficients (can be 10.21 fixed point)
@@ -494,19 +674,23 @@ gaussian_pass_IIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_su
     int h = cairo_image_surface_get_height(src);
     if (d != Geom::X) std::swap(w, h);
 
+    // Temporary storage for the forward pass
+    // NOTE: This can be eliminated, but it reduces the precision a bit
+    std::vector<IIRValue> tmpdata(num_threads * w * LINE_BLOCK_VALUES);
+
     // Filter
     switch (cairo_image_surface_get_format(src)) {
     case CAIRO_FORMAT_A8:        ///< Grayscale
         filter2D_IIR<unsigned char,1,false>(
             cairo_image_surface_get_data(dest), d == Geom::X ? 1 : stride, d == Geom::X ? stride : 1,
             cairo_image_surface_get_data(src),  d == Geom::X ? 1 : stride, d == Geom::X ? stride : 1,
-            w, h, b, M, tmpdata, num_threads);
+            w, h, b, M, &tmpdata[0], num_threads);
         break;
     case CAIRO_FORMAT_ARGB32: ///< Premultiplied 8 bit RGBA
         filter2D_IIR<unsigned char,4,true>(
             cairo_image_surface_get_data(dest), d == Geom::X ? 4 : stride, d == Geom::X ? stride : 4,
             cairo_image_surface_get_data(src),  d == Geom::X ? 4 : stride, d == Geom::X ? stride : 4,
-            w, h, b, M, tmpdata, num_threads);
+            w, h, b, M, &tmpdata[0], num_threads);
         break;
     default:
         g_warning("gaussian_pass_IIR: unsupported image format");
@@ -527,25 +711,113 @@ gaussian_pass_FIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_su
     int h = cairo_image_surface_get_height(src);
     if (d != Geom::X) std::swap(w, h);
 
-    // Filter (x)
+    // Filter
     switch (cairo_image_surface_get_format(src)) {
     case CAIRO_FORMAT_A8:        ///< Grayscale
-        filter2D_FIR<unsigned char,1>(
+        if (d == Geom::X) {
+            filter2D_FIR<unsigned char,1>(
+                cairo_image_surface_get_data(dest), 1, stride,
+                cairo_image_surface_get_data(src),  1, stride,
+                w, h, &kernel[0], scr_len, num_threads);
+        } else {
+            filter2D_FIR_columns<unsigned char,1>(
+                cairo_image_surface_get_data(dest), stride,
+                cairo_image_surface_get_data(src),  stride,
+                h, w, &kernel[0], scr_len, num_threads);
+        }
+        break;
+    case CAIRO_FORMAT_ARGB32: ///< Premultiplied 8 bit RGBA
+        if (d == Geom::X) {
+            filter2D_FIR<unsigned char,4>(
+                cairo_image_surface_get_data(dest), 4, stride,
+                cairo_image_surface_get_data(src),  4, stride,
+                w, h, &kernel[0], scr_len, num_threads);
+        } else {
+            filter2D_FIR_columns<unsigned char,4>(
+                cairo_image_surface_get_data(dest), stride,
+                cairo_image_surface_get_data(src),  stride,
+                h, w, &kernel[0], scr_len, num_threads);
+        }
+        break;
+    default:
+        g_warning("gaussian_pass_FIR: unsupported image format");
+    };
+}
+
+static void
+gaussian_pass_box(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_surface_t *dest,
+    int num_threads)
+{
+    int left[3], right[3];
+    int const size = _box_blur_extents(deviation, left, right);
+    if (size < 1 || size >= (1 << 16)) {
+        return;
+    }
+
+    int stride = cairo_image_surface_get_stride(src);
+    int w = cairo_image_surface_get_width(src);
+    int h = cairo_image_surface_get_height(src);
+    if (d != Geom::X) std::swap(w, h);
+
+    std::vector<int> tmpdata(num_threads * 2 * w * LINE_BLOCK_VALUES);
+
+    // Filter
+    switch (cairo_image_surface_get_format(src)) {
+    case CAIRO_FORMAT_A8:        ///< Grayscale
+        filter2D_box<unsigned char,1>(
             cairo_image_surface_get_data(dest), d == Geom::X ? 1 : stride, d == Geom::X ? stride : 1,
             cairo_image_surface_get_data(src),  d == Geom::X ? 1 : stride, d == Geom::X ? stride : 1,
-            w, h, &kernel[0], scr_len, num_threads);
+            w, h, left, right, &tmpdata[0], num_threads);
         break;
     case CAIRO_FORMAT_ARGB32: ///< Premultiplied 8 bit RGBA
-        filter2D_FIR<unsigned char,4>(
+        filter2D_box<unsigned char,4>(
             cairo_image_surface_get_data(dest), d == Geom::X ? 4 : stride, d == Geom::X ? stride : 4,
             cairo_image_surface_get_data(src),  d == Geom::X ? 4 : stride, d == Geom::X ? stride : 4,
-            w, h, &kernel[0], scr_len, num_threads);
+            w, h, left, right, &tmpdata[0], num_threads);
         break;
     default:
-        g_warning("gaussian_pass_FIR: unsupported image format");
+        g_warning("gaussian_pass_box: unsupported image format");
     };
 }
 
+void gaussian_blur_surface(cairo_surface_t *surface, double deviation_x, double deviation_y,
+                           GaussianBlurMode mode, int num_threads)
+{
+    cairo_surface_flush(surface);
+
+    for (unsigned i = 0; i < 2; ++i) {
+        Geom::Dim2 d = i == 0 ? Geom::X : Geom::Y;
+        double deviation = i == 0 ? deviation_x : deviation_y;
+        if (_effect_area_scr(deviation) <= 0) {
+            continue;
+        }
+
+        // This threshold was determined by trial-and-error for one specific machine,
+        // so there's a good chance that it's not optimal.
+        // Whatever you do, don't go below 1 (and preferrably not even below 2), as
+        // the IIR filter gets unstable there.
+        GaussianBlurMode pass_mode = mode;
+        if (pass_mode == GAUSSIAN_BLUR_AUTO) {
+            pass_mode = deviation > 3 ? GAUSSIAN_BLUR_IIR : GAUSSIAN_BLUR_FIR;
+        }
+
+        switch (pass_mode) {
+        case GAUSSIAN_BLUR_IIR:
+            gaussian_pass_IIR(d, deviation, surface, surface, num_threads);
+            break;
+        case GAUSSIAN_BLUR_BOX:
+            gaussian_pass_box(d, deviation, surface, surface, num_threads);
+            break;
+        case GAUSSIAN_BLUR_FIR:
+        default:
+            gaussian_pass_FIR(d, deviation, surface, surface, num_threads);
+            break;
+        }
+    }
+
+    cairo_surface_mark_dirty(surface);
+}
+
 void FilterGaussian::render_cairo(FilterSlot &slot)
 {
     cairo_surface_t *in = slot.getcairo(_input);
@@ -583,24 +855,21 @@ void FilterGaussian::render_cairo(FilterSlot &slot)
 
     double deviation_x_orig = dx * trans.expansionX();
     double deviation_y_orig = dy * trans.expansionY();
-    cairo_format_t fmt = cairo_image_surface_get_format(in);
-    int bytes_per_pixel = 0;
-    switch (fmt) {
-        case CAIRO_FORMAT_A8:
-            bytes_per_pixel = 1; break;
-        case CAIRO_FORMAT_ARGB32:
-        default:
-            bytes_per_pixel = 4; break;
-    }
 
-#if HAVE_OPENMP
     Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+#if HAVE_OPENMP
     int threads = prefs->getIntLimited("/options/threading/numthreads", omp_get_num_procs(), 1, 256);
 #else
     int threads = 1;
 #endif
 
     int quality = slot.get_blurquality();
+    // The lower display qualities may approximate the blur by box blurs
+    GaussianBlurMode mode = GAUSSIAN_BLUR_AUTO;
+    if ((quality == BLUR_QUALITY_WORSE || quality == BLUR_QUALITY_WORST)
+        && prefs->getBool("/options/blurquality/boxblur", false)) {
+        mode = GAUSSIAN_BLUR_BOX;
+    }
     int x_step = 1 << _effect_subsample_step_log2(deviation_x_orig, quality);
     int y_step = 1 << _effect_subsample_step_log2(deviation_y_orig, quality);
     bool resampling = x_step > 1 || y_step > 1;
@@ -610,26 +879,6 @@ void FilterGaussian::render_cairo(FilterSlot &slot)
     int h_downsampled = resampling ? static_cast<int>(ceil(static_cast<double>(h_orig)/y_step))+1 : h_orig;
     double deviation_x = deviation_x_orig / x_step;
     double deviation_y = deviation_y_orig / y_step;
-    int scr_len_x = _effect_area_scr(deviation_x);
-    int scr_len_y = _effect_area_scr(deviation_y);
-
-    // Decide which filter to use for X and Y
-    // This threshold was determined by trial-and-error for one specific machine,
-    // so there's a good chance that it's not optimal.
-    // Whatever you do, don't go below 1 (and preferrably not even below 2), as
-    // the IIR filter gets unstable there.
-    bool use_IIR_x = deviation_x > 3;
-    bool use_IIR_y = deviation_y > 3;
-
-    // Temporary storage for IIR filter
-    // NOTE: This can be eliminated, but it reduces the precision a bit
-    IIRValue * tmpdata[threads];
-    std::fill_n(tmpdata, threads, (IIRValue*)0);
-    if ( use_IIR_x || use_IIR_y ) {
-        for(int i = 0; i < threads; ++i) {
-            tmpdata[i] = new IIRValue[std::max(w_downsampled,h_downsampled)*bytes_per_pixel];
-        }
-    }
 
     cairo_surface_t *downsampled = NULL;
     if (resampling) {
@@ -643,32 +892,9 @@ void FilterGaussian::render_cairo(FilterSlot &slot)
     } else {
         downsampled = ink_cairo_surface_copy(in);
     }
-    cairo_surface_flush(downsampled);
 
-    if (scr_len_x > 0) {
-        if (use_IIR_x) {
-            gaussian_pass_IIR(Geom::X, deviation_x, downsampled, downsampled, tmpdata, threads);
-        } else {
-            gaussian_pass_FIR(Geom::X, deviation_x, downsampled, downsampled, threads);
-        }
-    }
-
-    if (scr_len_y > 0) {
-        if (use_IIR_y) {
-            gaussian_pass_IIR(Geom::Y, deviation_y, downsampled, downsampled, tmpdata, threads);
-        } else {
-            gaussian_pass_FIR(Geom::Y, deviation_y, downsampled, downsampled, threads);
-        }
-    }
-
-    // free the temporary data
-    if ( use_IIR_x || use_IIR_y ) {
-        for(int i = 0; i < threads; ++i) {
-            delete[] tmpdata[i];
-        }
-    }
+    gaussian_blur_surface(downsampled, deviation_x, deviation_y, mode, threads);
 
-    cairo_surface_mark_dirty(downsampled);
     if (resampling) {
         cairo_surface_t *upsampled = cairo_surface_create_similar(downsampled, cairo_surface_get_content(downsampled),
             w_orig, h_orig);
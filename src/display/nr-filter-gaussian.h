@@ -25,9 +25,29 @@ enum {
     BLUR_QUALITY_WORST = -2
 };
 
+typedef struct _cairo_surface cairo_surface_t;
+
 namespace Inkscape {
 namespace Filters {
 
+/**
+ * Algorithms for gaussian_blur_surface().
+ */
+enum GaussianBlurMode {
+    GAUSSIAN_BLUR_AUTO, ///< FIR filter for small deviations, IIR filter for large ones
+    GAUSSIAN_BLUR_FIR,
+    GAUSSIAN_BLUR_IIR,
+    GAUSSIAN_BLUR_BOX   ///< three successive box blurs, a fast approximation for previews
+};
+
+/**
+ * Blur an A8 or ARGB32 image surface in place. The deviations are in pixels of the surface;
+ * a deviation of zero leaves that direction unchanged. Used by FilterGaussian after it has
+ * subsampled its input, and by the tests and benchmarks of the different modes.
+ */
+void gaussian_blur_surface(cairo_surface_t *surface, double deviation_x, double deviation_y,
+                           GaussianBlurMode mode, int num_threads);
+
 class FilterGaussian : public FilterPrimitive {
 public:
     FilterGaussian();
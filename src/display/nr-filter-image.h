@@ -32,6 +32,7 @@ public:
     virtual void render_cairo(FilterSlot &slot);
     virtual bool can_handle_affine(Geom::Affine const &);
     virtual double complexity(Geom::Affine const &ctm);
+    virtual void get_inputs(std::vector<int> &) const {}
 
     void set_document( SPDocument *document );
     void set_href(char const *href);
@@ -108,6 +108,10 @@ void FilterMerge::set_input(int input, int slot) {
     }
 }
 
+void FilterMerge::get_inputs(std::vector<int> &inputs) const {
+    inputs.insert(inputs.end(), _input_image.begin(), _input_image.end());
+}
+
 } /* namespace Filters */
 } /* namespace Inkscape */
 
@@ -31,6 +31,7 @@ public:
 
     virtual void set_input(int input);
     virtual void set_input(int input, int slot);
+    virtual void get_inputs(std::vector<int> &inputs) const;
 
 private:
     std::vector<int> _input_image;
@@ -80,6 +80,18 @@ void FilterPrimitive::set_output(int slot) {
     if (slot >= 0) _output = slot;
 }
 
+void FilterPrimitive::get_inputs(std::vector<int> &inputs) const {
+    inputs.push_back(_input);
+}
+
+SPColorInterpolation FilterPrimitive::color_interpolation() const
+{
+    if (_style) {
+        return (SPColorInterpolation)_style->color_interpolation_filters.computed;
+    }
+    return SP_CSS_COLOR_INTERPOLATION_AUTO;
+}
+
 // We need to copy reference even if unset as we need to know if
 // someone has unset a value.
 void FilterPrimitive::set_x(SVGLength const &length)
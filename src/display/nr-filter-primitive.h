@@ -14,8 +14,11 @@
 #include <2geom/forward.h>
 #include <2geom/rect.h>
 
+#include <vector>
+#include <glib.h>
 #include "display/nr-filter-types.h"
 #include "svg/svg-length.h"
+#include "style-enums.h"
 
 class SPStyle;
 
@@ -25,6 +28,18 @@ namespace Filters {
 class FilterSlot;
 class FilterUnits;
 
+/**
+ * Operation of a primitive which computes every pixel from the same pixel of its input,
+ * see FilterPrimitive::pixel_operation().
+ */
+class FilterPixelOperation {
+public:
+    virtual ~FilterPixelOperation() {}
+
+    /// Filter n premultiplied ARGB32 pixels. The input and output may be the same.
+    virtual void filter(guint32 const *in, guint32 *out, int n) = 0;
+};
+
 class FilterPrimitive {
 public:
     FilterPrimitive();
@@ -66,6 +81,27 @@ public:
      */
     virtual void set_output(int slot);
 
+    /**
+     * Appends the slots read by this primitive to 'inputs'. Slots which are
+     * only used for the size of the output are not included.
+     */
+    virtual void get_inputs(std::vector<int> &inputs) const;
+
+    /** Returns the slot written by this primitive. */
+    int get_output() const { return _output; }
+
+    /**
+     * Primitives whose output pixels each depend only on the same pixel of
+     * their single input, in the same image format, return the operation
+     * computing them. Filter then runs chains of such primitives in one pass
+     * instead of creating an intermediate image for each of them.
+     * The caller deletes the operation. Returns NULL for other primitives.
+     */
+    virtual FilterPixelOperation *pixel_operation() const { return NULL; }
+
+    /** Returns the color interpolation space the primitive works in. */
+    SPColorInterpolation color_interpolation() const;
+
     // returns cache score factor, reflecting the cost of rendering this filter
     // this should return how many times slower this primitive is that normal rendering
     virtual double complexity(Geom::Affine const &/*ctm*/) { return 1.0; }
@@ -47,6 +47,7 @@ public:
     virtual void render_cairo(FilterSlot &slot);
     virtual double complexity(Geom::Affine const &ctm);
     virtual bool uses_background() { return false; }
+    virtual void get_inputs(std::vector<int> &) const {} // only the size of the input is used
 
     void set_baseFrequency(int axis, double freq);
     void set_numOctaves(int num);
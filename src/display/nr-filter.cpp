@@ -12,6 +12,7 @@
 #include <glib.h>
 #include <cmath>
 #include <cstring>
+#include <map>
 #include <string>
 #include <cairo.h>
 
@@ -38,6 +39,7 @@
 #include "display/nr-filter-tile.h"
 #include "display/nr-filter-turbulence.h"
 
+#include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
 #include "display/drawing.h"
 #include "display/drawing-item.h"
@@ -154,9 +156,7 @@ int Filter::render(Inkscape::DrawingItem const *item, DrawingContext &graphic, D
     slot.set_quality(filterquality);
     slot.set_blurquality(blurquality);
 
-    for (unsigned i = 0 ; i < _primitive.size() ; i++) {
-        _primitive[i]->render_cairo(slot);
-    }
+    _render_primitives(slot);
 
     Geom::Point origin = graphic.targetLogicalBounds().min();
     cairo_surface_t *result = slot.get_result(_output_slot);
@@ -173,6 +173,136 @@ int Filter::render(Inkscape::DrawingItem const *item, DrawingContext &graphic, D
     return 0;
 }
 
+/// Applies the pixel operations of a chain of primitives one after the other.
+struct PixelOperationChain {
+    PixelOperationChain(std::vector<FilterPixelOperation*> const &ops)
+        : _ops(ops)
+    {}
+    guint32 operator()(guint32 in) {
+        guint32 out;
+        ink_cairo_filter_span(*this, &in, &out, 1);
+        return out;
+    }
+    friend void ink_cairo_filter_span(PixelOperationChain &chain, guint32 const *in, guint32 *out, int n) {
+        chain._ops[0]->filter(in, out, n);
+        for (unsigned i = 1; i < chain._ops.size(); ++i) {
+            chain._ops[i]->filter(out, out, n);
+        }
+    }
+private:
+    std::vector<FilterPixelOperation*> const &_ops;
+};
+
+void Filter::_render_primitives(FilterSlot &slot)
+{
+    int const count = _primitive.size();
+
+    // Find the primitive producing every input, -1 for the standard inputs and
+    // slots which no earlier primitive writes.
+    std::vector< std::vector<int> > sources(count);
+    std::map<int, int> writer;
+    std::vector<int> inputs;
+    for (int i = 0; i < count; ++i) {
+        inputs.clear();
+        _primitive[i]->get_inputs(inputs);
+        for (unsigned j = 0; j < inputs.size(); ++j) {
+            if (inputs[j] == NR_FILTER_SLOT_NOT_SET) {
+                sources[i].push_back(i - 1);
+            } else {
+                std::map<int, int>::iterator w = writer.find(inputs[j]);
+                sources[i].push_back(w != writer.end() ? w->second : -1);
+            }
+        }
+        int output = _primitive[i]->get_output();
+        writer[output == NR_FILTER_SLOT_NOT_SET ? NR_FILTER_UNNAMED_SLOT : output] = i;
+    }
+
+    int result = count - 1;
+    if (_output_slot != NR_FILTER_SLOT_NOT_SET) {
+        std::map<int, int>::iterator w = writer.find(_output_slot);
+        result = (w != writer.end() ? w->second : -1);
+    }
+
+    // Primitives whose output does not reach the result are not rendered.
+    std::vector<bool> live(count, false);
+    std::vector<int> consumers(count, 0);
+    if (result >= 0) {
+        live[result] = true;
+    }
+    for (int i = count - 1; i >= 0; --i) {
+        if (!live[i]) continue;
+        for (unsigned j = 0; j < sources[i].size(); ++j) {
+            if (sources[i][j] >= 0) {
+                live[sources[i][j]] = true;
+                ++consumers[sources[i][j]];
+            }
+        }
+    }
+
+    std::vector<FilterPixelOperation*> ops(count, static_cast<FilterPixelOperation*>(NULL));
+    for (int i = 0; i < count; ++i) {
+        if (live[i]) {
+            ops[i] = _primitive[i]->pixel_operation();
+        }
+    }
+
+    int i = 0;
+    while (i < count) {
+        if (!live[i]) {
+            ++i;
+            continue;
+        }
+
+        // A primitive with a pixel operation can be joined by the next one if that reads
+        // its output, which nothing else uses, in the same color interpolation space.
+        std::vector<int> chain(1, i);
+        if (ops[i]) {
+            for (int j = i + 1; j < count; ++j) {
+                if (!live[j]) continue;
+                int last = chain.back();
+                if (!ops[j] || last == result || consumers[last] != 1
+                    || sources[j].size() != 1 || sources[j][0] != last
+                    || _primitive[j]->color_interpolation() != _primitive[i]->color_interpolation())
+                {
+                    break;
+                }
+                chain.push_back(j);
+            }
+        }
+        i = chain.back() + 1;
+
+        if (chain.size() > 1) {
+            inputs.clear();
+            _primitive[chain[0]]->get_inputs(inputs);
+            cairo_surface_t *input = slot.getcairo(inputs[0]);
+            if (cairo_image_surface_get_format(input) == CAIRO_FORMAT_ARGB32) {
+                SPColorInterpolation ci = _primitive[chain[0]]->color_interpolation();
+                set_cairo_surface_ci(input, ci);
+                cairo_surface_t *out = ink_cairo_surface_create_identical(input);
+                set_cairo_surface_ci(out, ci);
+
+                std::vector<FilterPixelOperation*> chain_ops;
+                for (unsigned j = 0; j < chain.size(); ++j) {
+                    chain_ops.push_back(ops[chain[j]]);
+                }
+                ink_cairo_surface_filter(input, out, PixelOperationChain(chain_ops));
+
+                slot.set(_primitive[chain.back()]->get_output(), out);
+                cairo_surface_destroy(out);
+                continue;
+            }
+        }
+
+        for (unsigned j = 0; j < chain.size(); ++j) {
+            _primitive[chain[j]]->render_cairo(slot);
+        }
+    }
+
+    for (int j = 0; j < count; ++j) {
+        delete ops[j];
+    }
+}
+
 void Filter::set_filter_units(SPFilterUnits unit) {
     _filter_units = unit;
 }
@@ -199,6 +199,9 @@ private:
 
     void _create_constructor_table();
     void _common_init();
+    /** Renders the primitives which contribute to the filter output, running
+     * chains of primitives with a pixel operation in a single pass. */
+    void _render_primitives(FilterSlot &slot);
     int _resolution_limit(FilterQuality const quality) const;
     std::pair<double,double> _filter_resolution(Geom::Rect const &area,
                                                 Geom::Affine const &trans,
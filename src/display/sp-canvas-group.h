@@ -29,8 +29,16 @@
 #define SP_CANVAS_GROUP(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj), SP_TYPE_CANVAS_GROUP, SPCanvasGroup))
 #define SP_IS_CANVAS_GROUP(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), SP_TYPE_CANVAS_GROUP))
 
+struct SPCanvasGroup;
+
 GType sp_canvas_group_get_type();
 
+/**
+ * Makes the group keep the boxes of its children in a grid index, so that drawing a tile and
+ * picking the item under the pointer only visit the children nearby. Meant for groups of many
+ * small items, like the knots of all the nodes of a large path.
+ */
+void sp_canvas_group_set_indexed(SPCanvasGroup *group, bool indexed);
 
 
 #endif // SEEN_SP_CANVAS_GROUP_H
@@ -21,12 +21,16 @@
 
 #include <gdkmm/rectangle.h>
 #include <cairomm/region.h>
+#ifdef HAVE_OPENMP
+# include <omp.h>
+#endif
 
 #include "helper/sp-marshal.h"
 #include <2geom/rect.h>
 #include <2geom/affine.h>
 #include "display/sp-canvas.h"
 #include "display/sp-canvas-group.h"
+#include "display/canvas-item-index.h"
 #include "preferences.h"
 #include "inkscape.h"
 #include "sodipodi-ctrlrect.h"
@@ -102,8 +106,26 @@ struct SPCanvasGroup {
      */
     static void render(SPCanvasItem *item, SPCanvasBuf *buf);
 
+    /**
+     * Picks a child if its box touches area, the pointer expanded by close_enough, and its
+     * distance to the pointer is within close_enough. Later children win over earlier ones.
+     */
+    static void pointChild(SPCanvasItem *child, Geom::Point const &p, Geom::IntRect const &area,
+                           double &best, SPCanvasItem **actual_item);
+
+    /**
+     * Renders a child if it is visible and touches the buf rectangle.
+     */
+    static void renderChild(SPCanvasItem *child, SPCanvasBuf *buf);
+
     static void viewboxChanged(SPCanvasItem *item, Geom::IntRect const &new_area);
 
+    /**
+     * Marks the grid index, if any, out of date after the children or their order changed.
+     * It is rebuilt on the next update and not used until then.
+     */
+    void invalidateIndex();
+
 
     // Data members: ----------------------------------------------------------
 
@@ -111,6 +133,9 @@ struct SPCanvasGroup {
 
     std::list<SPCanvasItem *> items;
 
+    /// Boxes of the children, if enabled with sp_canvas_group_set_indexed().
+    Inkscape::CanvasItemIndex *index;
+
 };
 
 /**
@@ -611,6 +636,7 @@ void sp_canvas_item_raise(SPCanvasItem *item, int positions)
 
     parent->items.remove(item);
     parent->items.insert(l, item);
+    parent->invalidateIndex();
 
     redraw_if_visible (item);
     item->canvas->need_repick = TRUE;
@@ -625,6 +651,7 @@ void sp_canvas_item_raise_to_top(SPCanvasItem *item)
     SPCanvasGroup *parent = SP_CANVAS_GROUP (item->parent);
     parent->items.remove(item);
     parent->items.push_back(item);
+    parent->invalidateIndex();
     redraw_if_visible (item);
     item->canvas->need_repick = TRUE;
 }
@@ -660,6 +687,7 @@ void sp_canvas_item_lower(SPCanvasItem *item, int positions)
     
     parent->items.remove(item);
     parent->items.insert(l, item);
+    parent->invalidateIndex();
 
     redraw_if_visible (item);
     item->canvas->need_repick = TRUE;
@@ -674,6 +702,7 @@ void sp_canvas_item_lower_to_bottom(SPCanvasItem *item)
     SPCanvasGroup *parent = SP_CANVAS_GROUP (item->parent);
     parent->items.remove(item);
     parent->items.push_front(item);
+    parent->invalidateIndex();
     redraw_if_visible (item); 
     item->canvas->need_repick = TRUE;
 }
@@ -901,6 +930,7 @@ static void sp_canvas_group_class_init(SPCanvasGroupClass *klass)
 static void sp_canvas_group_init(SPCanvasGroup * group)
 {
     new (&group->items) std::list<SPCanvasItem *>;
+    group->index = NULL;
 }
 
 void SPCanvasGroup::destroy(SPCanvasItem *object)
@@ -917,6 +947,9 @@ void SPCanvasGroup::destroy(SPCanvasItem *object)
     group->items.clear();
     group->items.~list(); // invoke manually
 
+    delete group->index;
+    group->index = NULL;
+
     if (SP_CANVAS_ITEM_CLASS(sp_canvas_group_parent_class)->destroy) {
         (* SP_CANVAS_ITEM_CLASS(sp_canvas_group_parent_class)->destroy)(object);
     }
@@ -925,9 +958,11 @@ void SPCanvasGroup::destroy(SPCanvasItem *object)
 void SPCanvasGroup::update(SPCanvasItem *item, Geom::Affine const &affine, unsigned int flags)
 {
     SPCanvasGroup const *group = SP_CANVAS_GROUP(item);
+    Inkscape::CanvasItemIndex *index = group->index;
     Geom::OptRect bounds;
 
-    for (std::list<SPCanvasItem *>::const_iterator it = group->items.begin(); it != group->items.end(); ++it) {
+    unsigned pos = 0;
+    for (std::list<SPCanvasItem *>::const_iterator it = group->items.begin(); it != group->items.end(); ++it, ++pos) {
         SPCanvasItem *i = *it;
 
         sp_canvas_item_invoke_update (i, affine, flags);
@@ -936,6 +971,21 @@ void SPCanvasGroup::update(SPCanvasItem *item, Geom::Affine const &affine, unsig
             bounds.expandTo(Geom::Point(i->x1, i->y1));
             bounds.expandTo(Geom::Point(i->x2, i->y2));
         }
+
+        if (index && index->isValid()) {
+            Geom::Rect const box(i->x1, i->y1, i->x2, i->y2);
+            if (box != index->box(pos)) {
+                index->setBox(pos, box);
+            }
+        }
+    }
+
+    if (index && !index->isValid()) {
+        index->clear();
+        for (std::list<SPCanvasItem *>::const_iterator it = group->items.begin(); it != group->items.end(); ++it) {
+            SPCanvasItem *i = *it;
+            index->add(i, Geom::Rect(i->x1, i->y1, i->x2, i->y2));
+        }
     }
 
     if (bounds) {
@@ -958,55 +1008,83 @@ double SPCanvasGroup::point(SPCanvasItem *item, Geom::Point p, SPCanvasItem **ac
     int y1 = (int)(y - item->canvas->close_enough);
     int x2 = (int)(x + item->canvas->close_enough);
     int y2 = (int)(y + item->canvas->close_enough);
+    Geom::IntRect const area(x1, y1, x2, y2);
 
     double best = 0.0;
     *actual_item = NULL;
 
-    double dist = 0.0;
-    for (std::list<SPCanvasItem *>::const_iterator it = group->items.begin(); it != group->items.end(); ++it) {
-        SPCanvasItem *child = *it;
+    if (group->index && group->index->isValid()) {
+        // only the children near the pointer, still in stacking order
+        std::vector<unsigned> nearby;
+        group->index->query(area, nearby);
+        for (std::vector<unsigned>::const_iterator it = nearby.begin(); it != nearby.end(); ++it) {
+            pointChild(group->index->item(*it), p, area, best, actual_item);
+        }
+    } else {
+        for (std::list<SPCanvasItem *>::const_iterator it = group->items.begin(); it != group->items.end(); ++it) {
+            pointChild(*it, p, area, best, actual_item);
+        }
+    }
 
-        if ((child->x1 <= x2) && (child->y1 <= y2) && (child->x2 >= x1) && (child->y2 >= y1)) {
-            SPCanvasItem *point_item = NULL; // cater for incomplete item implementations
+    return best;
+}
 
-            int pickable;
-            if (child->visible && child->pickable && SP_CANVAS_ITEM_GET_CLASS(child)->point) {
-                dist = sp_canvas_item_invoke_point(child, p, &point_item);
-                pickable = TRUE;
-            } else {
-                pickable = FALSE;
-            }
+void SPCanvasGroup::pointChild(SPCanvasItem *child, Geom::Point const &p, Geom::IntRect const &area,
+                               double &best, SPCanvasItem **actual_item)
+{
+    if ((child->x1 <= area.right()) && (child->y1 <= area.bottom()) &&
+        (child->x2 >= area.left()) && (child->y2 >= area.top())) {
+        SPCanvasItem *point_item = NULL; // cater for incomplete item implementations
 
-            // TODO: This metric should be improved, because in case of (partly) overlapping items we will now
-            // always select the last one that has been added to the group. We could instead select the one
-            // of which the center is the closest, for example. One can then move to the center
-            // of the item to be focused, and have that one selected. Of course this will only work if the
-            // centers are not coincident, but at least it's better than what we have now.
-            // See the extensive comment in Inkscape::SelTrans::_updateHandles()
-            if (pickable && point_item && ((int) (dist + 0.5) <= item->canvas->close_enough)) {
-                best = dist;
-                *actual_item = point_item;
-            }
+        double dist = 0.0;
+        int pickable;
+        if (child->visible && child->pickable && SP_CANVAS_ITEM_GET_CLASS(child)->point) {
+            dist = sp_canvas_item_invoke_point(child, p, &point_item);
+            pickable = TRUE;
+        } else {
+            pickable = FALSE;
         }
-    }
 
-    return best;
+        // TODO: This metric should be improved, because in case of (partly) overlapping items we will now
+        // always select the last one that has been added to the group. We could instead select the one
+        // of which the center is the closest, for example. One can then move to the center
+        // of the item to be focused, and have that one selected. Of course this will only work if the
+        // centers are not coincident, but at least it's better than what we have now.
+        // See the extensive comment in Inkscape::SelTrans::_updateHandles()
+        if (pickable && point_item && ((int) (dist + 0.5) <= child->canvas->close_enough)) {
+            best = dist;
+            *actual_item = point_item;
+        }
+    }
 }
 
 void SPCanvasGroup::render(SPCanvasItem *item, SPCanvasBuf *buf)
 {
     SPCanvasGroup const *group = SP_CANVAS_GROUP(item);
 
-    for (std::list<SPCanvasItem *>::const_iterator it = group->items.begin(); it != group->items.end(); ++it) {
-        SPCanvasItem *child = *it;
-        if (child->visible) {
-            if ((child->x1 < buf->rect.right()) &&
-                (child->y1 < buf->rect.bottom()) &&
-                (child->x2 > buf->rect.left()) &&
-                (child->y2 > buf->rect.top())) {
-                if (SP_CANVAS_ITEM_GET_CLASS(child)->render) {
-                    SP_CANVAS_ITEM_GET_CLASS(child)->render(child, buf);
-                }
+    if (group->index && group->index->isValid()) {
+        // one pass over the children touching the tile, in stacking order
+        std::vector<unsigned> nearby;
+        group->index->query(buf->rect, nearby);
+        for (std::vector<unsigned>::const_iterator it = nearby.begin(); it != nearby.end(); ++it) {
+            renderChild(group->index->item(*it), buf);
+        }
+    } else {
+        for (std::list<SPCanvasItem *>::const_iterator it = group->items.begin(); it != group->items.end(); ++it) {
+            renderChild(*it, buf);
+        }
+    }
+}
+
+void SPCanvasGroup::renderChild(SPCanvasItem *child, SPCanvasBuf *buf)
+{
+    if (child->visible) {
+        if ((child->x1 < buf->rect.right()) &&
+            (child->y1 < buf->rect.bottom()) &&
+            (child->x2 > buf->rect.left()) &&
+            (child->y2 > buf->rect.top())) {
+            if (SP_CANVAS_ITEM_GET_CLASS(child)->render) {
+                SP_CANVAS_ITEM_GET_CLASS(child)->render(child, buf);
             }
         }
     }
@@ -1032,6 +1110,7 @@ void SPCanvasGroup::add(SPCanvasItem *item)
     g_object_ref_sink(item);
 
     items.push_back(item);
+    invalidateIndex();
 
     sp_canvas_item_request_update(item);
 }
@@ -1041,6 +1120,7 @@ void SPCanvasGroup::remove(SPCanvasItem *item)
  
     g_return_if_fail(item != NULL);
     items.remove(item);
+    invalidateIndex();
 
     // Unparent the child
     item->parent = NULL;
@@ -1048,6 +1128,28 @@ void SPCanvasGroup::remove(SPCanvasItem *item)
 
 }
 
+void SPCanvasGroup::invalidateIndex()
+{
+    if (index) {
+        index->invalidate();
+    }
+}
+
+void sp_canvas_group_set_indexed(SPCanvasGroup *group, bool indexed)
+{
+    g_return_if_fail(group != NULL);
+    g_return_if_fail(SP_IS_CANVAS_GROUP(group));
+
+    if (indexed && !group->index) {
+        // built on the next update
+        group->index = new Inkscape::CanvasItemIndex();
+        sp_canvas_item_request_update(SP_CANVAS_ITEM(group));
+    } else if (!indexed && group->index) {
+        delete group->index;
+        group->index = NULL;
+    }
+}
+
 static void sp_canvas_dispose            (GObject  *object);
 static void sp_canvas_shutdown_transients(SPCanvas *canvas);
 
@@ -1960,6 +2062,13 @@ bool SPCanvasImpl::sp_canvas_paint_rect(SPCanvas *canvas, int xx0, int yy0, int
         // use 256K as a compromise to not slow down gradients
         // 256K is the cached buffer and we need 4 channels
         setup.max_pixels = 65536; // 256K/4
+#ifdef HAVE_OPENMP
+        // Inkscape::Drawing renders large buffers as tiles on all threads,
+        // so give it enough pixels per buffer to keep every thread busy
+        Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+        int numOfThreads = prefs->getIntLimited("/options/threading/numthreads", omp_get_num_procs(), 1, 256);
+        setup.max_pixels *= numOfThreads;
+#endif
     } else {
         // paths only, so 1M works faster
         // 1M is the cached buffer and we need 4 channels
@@ -46,6 +46,7 @@
 #include "widgets/desktop-widget.h"
 #include "desktop.h"
 #include "dir-util.h"
+#include "display/drawing-group.h"
 #include "display/drawing-item.h"
 #include "document-private.h"
 #include "document-undo.h"
@@ -1261,21 +1262,69 @@ static bool overlaps(Geom::Rect const &area, Geom::Rect const &box)
     return area.intersects(box);
 }
 
+/**
+Returns the area of the drawing shown with dkey (in drawing pixels) that corresponds to
+the given area in desktop coordinates, or nothing if the document is not shown with dkey.
+ */
+static Geom::OptRect desktop_area_to_drawing(SPDocument const *document, unsigned int dkey, Geom::Rect const &area)
+{
+    SPItem *root = SP_ITEM(document->root);
+    Inkscape::DrawingItem *root_item = root->get_arenaitem(dkey);
+    if (!root_item) {
+        return Geom::OptRect();
+    }
+    /// @fixme hardcoded desktop transform, see SPItem::desktopVisualBounds()
+    Geom::Affine dt2doc = Geom::Scale(1, -1) * Geom::Translate(0, document->getHeight().value("px"));
+    Geom::Rect drawing_area = area;
+    drawing_area *= dt2doc * root->transform.inverse() * root_item->ctm();
+    // drawing item bounding boxes are rounded to whole pixels
+    drawing_area.expandBy(2);
+    return drawing_area;
+}
+
+/**
+Collects the item children of group whose rendering for dkey may intersect the given
+area of the drawing, in z-order, using the spatial index of the group's drawing item.
+If the drawing is not available or not up to date, collects all item children.
+ */
+static void group_children_in_area(std::vector<SPItem*> &items, SPGroup *group, unsigned int dkey, Geom::OptRect const &area)
+{
+    Inkscape::DrawingGroup *drawing_group = dynamic_cast<Inkscape::DrawingGroup *>(group->get_arenaitem(dkey));
+    std::vector<Inkscape::DrawingItem *> found;
+    if (area && drawing_group && drawing_group->childrenInArea(*area, found)) {
+        for (std::vector<Inkscape::DrawingItem *>::iterator i = found.begin(); i != found.end(); ++i) {
+            SPItem *item = static_cast<SPItem *>((*i)->data());
+            if (item && item->parent == group) {
+                items.push_back(item);
+            }
+        }
+        return;
+    }
+
+    for ( SPObject *o = group->firstChild() ; o ; o = o->getNext() ) {
+        if ( SP_IS_ITEM(o) ) {
+            items.push_back(SP_ITEM(o));
+        }
+    }
+}
+
 static std::vector<SPItem*> &find_items_in_area(std::vector<SPItem*> &s, SPGroup *group, unsigned int dkey, Geom::Rect const &area,
+                                  Geom::OptRect const &drawing_area,
                                   bool (*test)(Geom::Rect const &, Geom::Rect const &), bool take_insensitive = false)
 {
     g_return_val_if_fail(SP_IS_GROUP(group), s);
 
-    for ( SPObject *o = group->firstChild() ; o ; o = o->getNext() ) {
-        if ( SP_IS_ITEM(o) ) {
-            if (SP_IS_GROUP(o) && SP_GROUP(o)->effectiveLayerMode(dkey) == SPGroup::LAYER ) {
-                s = find_items_in_area(s, SP_GROUP(o), dkey, area, test);
-            } else {
-                SPItem *child = SP_ITEM(o);
-                Geom::OptRect box = child->desktopVisualBounds();
-                if ( box && test(area, *box) && (take_insensitive || child->isVisibleAndUnlocked(dkey))) {
-                    s.push_back(child);
-                }
+    std::vector<SPItem*> children;
+    group_children_in_area(children, group, dkey, drawing_area);
+
+    for (std::vector<SPItem*>::iterator i = children.begin(); i != children.end(); ++i) {
+        SPItem *child = *i;
+        if (SP_IS_GROUP(child) && SP_GROUP(child)->effectiveLayerMode(dkey) == SPGroup::LAYER ) {
+            s = find_items_in_area(s, SP_GROUP(child), dkey, area, drawing_area, test);
+        } else {
+            Geom::OptRect box = child->desktopVisualBounds();
+            if ( box && test(area, *box) && (take_insensitive || child->isVisibleAndUnlocked(dkey))) {
+                s.push_back(child);
             }
         }
     }
@@ -1391,6 +1440,36 @@ static SPItem *find_item_at_point(std::deque<SPItem*> *nodes, unsigned int dkey,
     return seen;
 }
 
+/**
+Returns the topmost (in z-order) item from the descendants of group which is at the point p,
+or NULL if none. Recurses into layers, and into other groups if into_groups is set.
+Gives the same result as find_item_at_point on a list built by build_flat_item_list
+without upto, but only visits items whose bounding boxes contain the point.
+ */
+static SPItem *find_item_at_point(unsigned int dkey, SPGroup *group, Geom::Point const &p, gdouble delta, gboolean into_groups)
+{
+    Geom::Rect area(p, p);
+    area.expandBy(delta);
+    std::vector<SPItem*> children;
+    group_children_in_area(children, group, dkey, area);
+
+    for (std::vector<SPItem*>::reverse_iterator i = children.rbegin(); i != children.rend(); ++i) {
+        SPItem *child = *i;
+        if (SP_IS_GROUP(child) && (SP_GROUP(child)->effectiveLayerMode(dkey) == SPGroup::LAYER || into_groups)) {
+            SPItem *seen = find_item_at_point(dkey, SP_GROUP(child), p, delta, into_groups);
+            if (seen) {
+                return seen;
+            }
+        } else if (child->isVisibleAndUnlocked(dkey)) {
+            Inkscape::DrawingItem *arenaitem = child->get_arenaitem(dkey);
+            if (arenaitem && arenaitem->pick(p, delta, 1) != NULL) {
+                return child;
+            }
+        }
+    }
+    return NULL;
+}
+
 /**
 Returns the topmost non-layer group from the descendants of group which is at point
 p, or NULL if none. Recurses into layers but not into groups.
@@ -1401,10 +1480,13 @@ static SPItem *find_group_at_point(unsigned int dkey, SPGroup *group, Geom::Poin
     Inkscape::Preferences *prefs = Inkscape::Preferences::get();
     gdouble delta = prefs->getDouble("/options/cursortolerance/value", 1.0);
 
-    for ( SPObject *o = group->firstChild() ; o ; o = o->getNext() ) {
-        if (!SP_IS_ITEM(o)) {
-            continue;
-        }
+    Geom::Rect area(p, p);
+    area.expandBy(delta);
+    std::vector<SPItem*> children;
+    group_children_in_area(children, group, dkey, area);
+
+    for (std::vector<SPItem*>::iterator i = children.begin(); i != children.end(); ++i) {
+        SPItem *o = *i;
         if (SP_IS_GROUP(o) && SP_GROUP(o)->effectiveLayerMode(dkey) == SPGroup::LAYER) {
             SPItem *newseen = find_group_at_point(dkey, SP_GROUP(o), p);
             if (newseen) {
@@ -1412,7 +1494,7 @@ static SPItem *find_group_at_point(unsigned int dkey, SPGroup *group, Geom::Poin
             }
         }
         if (SP_IS_GROUP(o) && SP_GROUP(o)->effectiveLayerMode(dkey) != SPGroup::LAYER ) {
-            SPItem *child = SP_ITEM(o);
+            SPItem *child = o;
             Inkscape::DrawingItem *arenaitem = child->get_arenaitem(dkey);
 
             // seen remembers the last (topmost) of groups pickable at this point
@@ -1434,7 +1516,8 @@ std::vector<SPItem*> SPDocument::getItemsInBox(unsigned int dkey, Geom::Rect con
 {
     std::vector<SPItem*> x;
     g_return_val_if_fail(this->priv != NULL, x);
-    return find_items_in_area(x, SP_GROUP(this->root), dkey, box, is_within);
+    Geom::OptRect drawing_box = desktop_area_to_drawing(this, dkey, box);
+    return find_items_in_area(x, SP_GROUP(this->root), dkey, box, drawing_box, is_within);
 }
 
 /*
@@ -1448,7 +1531,8 @@ std::vector<SPItem*> SPDocument::getItemsPartiallyInBox(unsigned int dkey, Geom:
 {
     std::vector<SPItem*> x;
     g_return_val_if_fail(this->priv != NULL, x);
-    return find_items_in_area(x, SP_GROUP(this->root), dkey, box, overlaps);
+    Geom::OptRect drawing_box = desktop_area_to_drawing(this, dkey, box);
+    return find_items_in_area(x, SP_GROUP(this->root), dkey, box, drawing_box, overlaps);
 }
 
 std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vector<Geom::Point> points, bool all_layers, size_t limit) const
@@ -1462,9 +1546,6 @@ std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vecto
     gdouble saved_delta = prefs->getDouble("/options/cursortolerance/value", 1.0);
     prefs->setDouble("/options/cursortolerance/value", 0.25);
 
-    // Cache a flattened SVG DOM to speed up selection.
-    std::deque<SPItem*> nodes;
-    build_flat_item_list(&nodes, key, SP_GROUP(this->root), true, false, NULL);
     SPObject *current_layer = SP_ACTIVE_DESKTOP->currentLayer();
     SPDesktop *desktop = SP_ACTIVE_DESKTOP;
     Inkscape::LayerModel *layer_model = NULL;
@@ -1473,7 +1554,7 @@ std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vecto
     }
     size_t item_counter = 0;
     for(int i = points.size()-1;i>=0; i--) {
-        SPItem *item = find_item_at_point(&nodes, key, points[i]);
+        SPItem *item = find_item_at_point(key, SP_GROUP(this->root), points[i], 0.25, true);
         if (item && items.end()==find(items.begin(),items.end(), item))
             if(all_layers || (layer_model && layer_model->layerForObject(item) == current_layer)){
                 items.push_back(item);
@@ -1497,6 +1578,12 @@ SPItem *SPDocument::getItemAtPoint( unsigned const key, Geom::Point const &p,
 {
     g_return_val_if_fail(this->priv != NULL, NULL);
 
+    if (!upto) {
+        Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+        gdouble delta = prefs->getDouble("/options/cursortolerance/value", 1.0);
+        return find_item_at_point(key, SP_GROUP(this->root), p, delta, into_groups);
+    }
+
     // Build a flattened SVG DOM for find_item_at_point.
     std::deque<SPItem*> nodes;
     build_flat_item_list(&nodes, key, SP_GROUP(this->root), into_groups, false, upto);
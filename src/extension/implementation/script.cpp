@@ -40,7 +40,7 @@
 #include "extension/system.h"
 #include "ui/view/view.h"
 #include "xml/node.h"
-#include "xml/attribute-record.h"
+#include "xml/repr.h"
 
 #include "path-prefix.h"
 
@@ -622,15 +622,11 @@ void Script::save(Inkscape::Extension::Output *module,
     \param     module   Extention to effect with.
     \param     doc      Document to run through the effect.
 
-    This function is a little bit trickier than the previous two.  It
-    needs two temporary files to get it's work done.  Both of these
-    files have random names created for them using the g_file_open_temp function
-    with the ink_ext_ prefix in the temporary directory.  Like the other
-    functions, the temporary files are deleted at the end.
-
-    To save/load the two temporary documents (both are SVG) the internal
-    modules for SVG load and save are used.  They are both used through
-    the module system function by passing their keys into the functions.
+    This function is a little bit trickier than the previous two.  The
+    document is given to the script in the temporary file kept by the
+    document cache, so that it is only saved once for all the runs of a
+    live preview.  What the script writes out is parsed straight from
+    memory, without going through a file or building a second SPDocument.
 
     The command itself is built a little bit differently than in other
     functions because the effect support selections.  So on the command
@@ -640,9 +636,8 @@ void Script::save(Inkscape::Extension::Output *module,
     it is freed.
 
     The execute function is used at the core of this function
-    to execute the Script on the two SVG documents (actually only one
-    exists at the time, the other is created by that script).  At that
-    point both should be full, and the second one is loaded.
+    to execute the Script on the SVG document.  The tree it returns is
+    then merged into the document by copy_doc.
 */
 void Script::effect(Inkscape::Extension::Effect *module,
                Inkscape::UI::View::View *doc,
@@ -679,15 +674,6 @@ void Script::effect(Inkscape::Extension::Effect *module,
         return;
     }
 
-    std::string tempfilename_out;
-    int tempfd_out = 0;
-    try {
-        tempfd_out = Inkscape::IO::file_open_tmp(tempfilename_out, "ink_ext_XXXXXX.svg");
-    } catch (...) {
-        /// \todo Popup dialog here
-        return;
-    }
-
     std::vector<SPItem*> selected =
         desktop->getSelection()->itemList(); //desktop should not be NULL since doc was checked and desktop is a casted pointer
     for(std::vector<SPItem*>::const_iterator x = selected.begin(); x != selected.end(); ++x){
@@ -699,49 +685,34 @@ void Script::effect(Inkscape::Extension::Effect *module,
 
     file_listener fileout;
     int data_read = execute(command, params, dc->_filename, fileout);
-    fileout.toFile(tempfilename_out);
 
     pump_events();
 
-    SPDocument * mydoc = NULL;
+    Inkscape::XML::Document * mydoc = NULL;
     if (data_read > 10) {
-        mydoc = Inkscape::Extension::open(
-              Inkscape::Extension::db.get(SP_MODULE_KEY_INPUT_SVG),
-              tempfilename_out.c_str());
+        mydoc = sp_repr_read_buf(fileout.string(), SP_SVG_NS_URI);
     } // data_read
 
     pump_events();
 
-    // make sure we don't leak file descriptors from g_file_open_tmp
-    close(tempfd_out);
-
-    g_unlink(tempfilename_out.c_str());
-
     if (mydoc) {
         SPDocument* vd=doc->doc();
         if (vd != NULL)
         {
             vd->emitReconstructionStart();
-            copy_doc(vd->rroot, mydoc->rroot);
+            copy_doc(vd->rroot, mydoc->root());
             vd->emitReconstructionFinish();
 
             // Getting the named view from the document generated by the extension
-            SPNamedView *nv = sp_document_namedview(mydoc, NULL);
-            
+            Inkscape::XML::Node *nv = sp_repr_lookup_name(mydoc->root(), "sodipodi:namedview", 1);
+
             //Check if it has a default layer set up
             SPObject *layer = NULL;
-            if ( nv != NULL)
-            {
-                if( nv->default_layer_id != 0 ) {
-                    SPDocument *document = desktop->doc();
-                    //If so, get that layer
-                    if (document != NULL)
-                    {
-                        layer = document->getObjectById(g_quark_to_string(nv->default_layer_id));
-                    }
-                }
+            if (nv != NULL && nv->attribute("inkscape:current-layer")) {
+                //If so, get that layer
+                layer = vd->getObjectById(nv->attribute("inkscape:current-layer"));
             }
-            
+
             sp_namedview_update_layers_from_document(desktop);
             //If that layer exists,
             if (layer) {
@@ -749,7 +720,7 @@ void Script::effect(Inkscape::Extension::Effect *module,
                 desktop->setCurrentLayer(layer);
             }
         }
-        mydoc->release();
+        Inkscape::GC::release(mydoc);
     }
 
     return;
@@ -758,21 +729,18 @@ void Script::effect(Inkscape::Extension::Effect *module,
 
 
 /**
-    \brief  A function to replace all the elements in an old document
-            by those from a new document.
-            document and repinserts them into an emptied old document.
+    \brief  A function to make an old document equal to a new document.
     \param  oldroot  The root node of the old (destination) document.
     \param  newroot  The root node of the new (source) document.
 
-    This function first deletes all the elements in the old document by
-    making two pass, the first to create a list of the old elements and
-    the second to actually delete them. This two pass approach removes issues
-    with the list being change while parsing through it... lots of nasty bugs.
-
-    Then, it copies all the element in the new document into the old document.
+    The old document is updated in place with sp_repr_update_from, so the
+    elements the script did not touch keep their objects, and undo only
+    records what actually changed.  Elements are paired by id, which the
+    scripts keep as they were given.
 
-    Finally, it replaces the attributes in the root element of the old document
-    by the attributes in root of the new document.
+    The namedview is always kept and updated in place: the one from the new
+    document is given the id of the old one so that they are paired, and if
+    the script dropped it the old one stays as it is.
 */
 void Script::copy_doc (Inkscape::XML::Node * oldroot, Inkscape::XML::Node * newroot)
 {
@@ -782,103 +750,35 @@ void Script::copy_doc (Inkscape::XML::Node * oldroot, Inkscape::XML::Node * newr
         return;
     }
 
-    // For copying attributes in root and in namedview
-    using Inkscape::Util::List;
-    using Inkscape::XML::AttributeRecord;
+    if (strcmp(oldroot->name(), newroot->name()))
+    {
+        g_warning("Error on copy_doc: Not an SVG document.");
+        return;
+    }
 
     // Question: Why is the "sodipodi:namedview" special? Treating it as a normal
     // elmement results in crashes.
     // Seems to be a bug:
     // http://inkscape.13.x6.nabble.com/Effect-that-modifies-the-document-properties-tt2822126.html
 
-    std::vector<Inkscape::XML::Node *> delete_list;
-    Inkscape::XML::Node * oldroot_namedview = NULL;
-    Inkscape::XML::Node * newroot_namedview = NULL;
-
-    // Make list
-    for (Inkscape::XML::Node * child = oldroot->firstChild();
-            child != NULL;
-            child = child->next()) {
-        if (!strcmp("sodipodi:namedview", child->name())) {
-            oldroot_namedview = child;
-            for (Inkscape::XML::Node * oldroot_namedview_child = child->firstChild();
-                    oldroot_namedview_child != NULL;
-                    oldroot_namedview_child = oldroot_namedview_child->next()) {
-                delete_list.push_back(oldroot_namedview_child);
-            }
-        } else {
-            delete_list.push_back(child);
-        }
-    }
-
+    Inkscape::XML::Node * oldroot_namedview = sp_repr_lookup_name(oldroot, "sodipodi:namedview", 1);
     if(!oldroot_namedview)
     {
         g_warning("Error on copy_doc: No namedview on destination document.");
         return;
     }
 
-    // Unparent (delete)
-    for (unsigned int i = 0; i < delete_list.size(); i++) {
-        sp_repr_unparent(delete_list[i]);
-    }
-
-    // Copy
-    for (Inkscape::XML::Node * child = newroot->firstChild();
-            child != NULL;
-            child = child->next()) {
-        if (!strcmp("sodipodi:namedview", child->name())) {
-            newroot_namedview = child;
-            for (Inkscape::XML::Node * newroot_namedview_child = child->firstChild();
-                    newroot_namedview_child != NULL;
-                    newroot_namedview_child = newroot_namedview_child->next()) {
-                oldroot_namedview->appendChild(newroot_namedview_child->duplicate(oldroot->document()));
-            }
-        } else {
-            oldroot->appendChild(child->duplicate(oldroot->document()));
-        }
-    }
-
-    std::vector<gchar const *> attribs;
-
-    // Must explicitly copy root attributes.
-
-    // Make a list of all attributes of the old root node.
-    for (List<AttributeRecord const> iter = oldroot->attributeList(); iter; ++iter) {
-        attribs.push_back(g_quark_to_string(iter->key));
-    }
-
-    // Delete the attributes of the old root node.
-    for (std::vector<gchar const *>::const_iterator it = attribs.begin(); it != attribs.end(); ++it) {
-        oldroot->setAttribute(*it, NULL);
-    }
-
-    // Set the new attributes.
-    for (List<AttributeRecord const> iter = newroot->attributeList(); iter; ++iter) {
-        gchar const *name = g_quark_to_string(iter->key);
-        oldroot->setAttribute(name, newroot->attribute(name));
-    }
-
-    attribs.clear();
-
-    // Must explicitly copy namedview attributes.
-
-    // Make a list of all attributes of the old namedview node.
-    for (List<AttributeRecord const> iter = oldroot_namedview->attributeList(); iter; ++iter) {
-        attribs.push_back(g_quark_to_string(iter->key));
-    }
-
-    // Delete the attributes of the old namedview node.
-    for (std::vector<gchar const *>::const_iterator it = attribs.begin(); it != attribs.end(); ++it) {
-        oldroot_namedview->setAttribute(*it, NULL);
+    Inkscape::XML::Node * newroot_namedview = sp_repr_lookup_name(newroot, "sodipodi:namedview", 1);
+    if (newroot_namedview) {
+        newroot_namedview->setAttribute("id", oldroot_namedview->attribute("id"));
+    } else {
+        newroot_namedview = oldroot_namedview->duplicate(newroot->document());
+        newroot->addChild(newroot_namedview, NULL);
+        Inkscape::GC::release(newroot_namedview);
     }
 
-    // Set the new attributes.
-    for (List<AttributeRecord const> iter = newroot_namedview->attributeList(); iter; ++iter) {
-        gchar const *name = g_quark_to_string(iter->key);
-        oldroot_namedview->setAttribute(name, newroot_namedview->attribute(name));
-    }
+    sp_repr_update_from(oldroot, newroot);
 
-    /** \todo  Restore correct layer */
     /** \todo  Restore correct selection */
 }
 
@@ -1469,9 +1469,7 @@ void png_write_base64stream(png_structp png_ptr, png_bytep data, png_size_t leng
 {
     Inkscape::IO::Base64OutputStream *stream =
             (Inkscape::IO::Base64OutputStream*)png_get_io_ptr(png_ptr); // Get pointer to stream
-    for ( unsigned i = 0 ; i < length ; i++ ) {
-        stream->put((int)data[i]);
-    }
+    stream->write(reinterpret_cast<char const *>(data), length);
 }
 
 void png_flush_base64stream(png_structp png_ptr)
@@ -21,6 +21,9 @@
 #include <cstdlib>
 #include <float.h>
 #include <2geom/transforms.h>
+#if HAVE_OPENMP
+#include <omp.h>
+#endif
 
 #include "desktop.h"
 #include "inkscape.h"
@@ -36,12 +39,20 @@
 #include "libavoid/router.h"
 #include "libavoid/geomtypes.h"
 #include "libcola/cola.h"
+#include "libcola/sparse_stress.h"
 #include "libvpsc/generate-constraints.h"
+#include "libvpsc/remove_rectangle_overlap.h"
 #include "preferences.h"
 
 using namespace std;
 using namespace cola;
 using namespace vpsc;
+
+/// Components with more nodes than this are laid out with SparseStressLayout, which does not
+/// need memory quadratic in the number of nodes. It ignores the directed edge constraints, so
+/// components which have some keep the constrained layout.
+static unsigned const SPARSE_LAYOUT_SIZE = 500;
+
 /**
  * Returns true if item is a connector
  */
@@ -208,10 +219,24 @@ void graphlayout(std::vector<SPItem*> const &items) {
     fill(eweights,eweights+E,1);
     vector<Component*> cs;
     connectedComponents(rs,es,scx,scy,cs);
+#if HAVE_OPENMP
+    int threads = prefs->getIntLimited("/options/threading/numthreads", omp_get_num_procs(), 1, 256);
+#else
+    int threads = 1;
+#endif
     for(unsigned i=0;i<cs.size();i++) {
         Component* c=cs[i];
         if(c->edges.size()<2) continue;
         CheckProgress test(0.0001,100,selected,rs,nodelookup);
+        if(c->rects.size()>SPARSE_LAYOUT_SIZE && c->scy.empty()) {
+            SparseStressLayout alg(c->rects,c->edges,eweights,ideal_connector_length,test);
+            alg.setThreads(threads);
+            alg.run();
+            if(avoid_overlaps) {
+                removeRectangleOverlap(c->rects.size(),&c->rects[0],0,0);
+            }
+            continue;
+        }
         ConstrainedMajorizationLayout alg(c->rects,c->edges,eweights,ideal_connector_length,test);
         alg.setupConstraints(NULL,NULL,avoid_overlaps,
                 NULL,NULL,&c->scx,&c->scy,NULL,NULL);
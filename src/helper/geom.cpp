@@ -20,6 +20,7 @@
 #include <2geom/rect.h>
 #include <2geom/coord.h>
 #include <2geom/sbasis-to-bezier.h>
+#include <2geom/path-sink.h>
 #include <math.h> // for M_PI
 
 using Geom::X;
@@ -850,6 +851,50 @@ recursive_bezier4(const double x1, const double y1,
         recursive_bezier4(x1234, y1234, x234, y234, x34, y34, x4, y4, m_points, level + 1); 
 }
 
+namespace {
+
+/// Hashes what is fed to it with FNV-1a.
+class PathHashSink : public Geom::PathSink {
+public:
+    PathHashSink() : hash(G_GUINT64_CONSTANT(14695981039346656037)) {}
+
+    void moveTo(Geom::Point const &p) { _byte('M'); _point(p); }
+    void lineTo(Geom::Point const &p) { _byte('L'); _point(p); }
+    void curveTo(Geom::Point const &c0, Geom::Point const &c1, Geom::Point const &p) {
+        _byte('C'); _point(c0); _point(c1); _point(p);
+    }
+    void quadTo(Geom::Point const &c, Geom::Point const &p) { _byte('Q'); _point(c); _point(p); }
+    void arcTo(Geom::Coord rx, Geom::Coord ry, Geom::Coord angle, bool large_arc, bool sweep,
+               Geom::Point const &p)
+    {
+        _byte('A'); _coord(rx); _coord(ry); _coord(angle);
+        _byte(large_arc); _byte(sweep); _point(p);
+    }
+    void closePath() { _byte('Z'); }
+    void flush() {}
+
+    guint64 hash;
+
+private:
+    void _byte(unsigned char b) { hash = (hash ^ b) * G_GUINT64_CONSTANT(1099511628211); }
+    void _coord(Geom::Coord c) {
+        unsigned char const *bytes = reinterpret_cast<unsigned char const *>(&c);
+        for (unsigned i = 0; i < sizeof(c); ++i) {
+            _byte(bytes[i]);
+        }
+    }
+    void _point(Geom::Point const &p) { _coord(p[Geom::X]); _coord(p[Geom::Y]); }
+};
+
+} // namespace
+
+guint64 pathv_hash(Geom::PathVector const &pathv)
+{
+    PathHashSink sink;
+    sink.feed(pathv);
+    return sink.hash;
+}
+
 /*
   Local Variables:
   mode:c++
@@ -14,6 +14,7 @@
  * Released under GNU GPL
  */
 
+#include <glib.h>
 #include <2geom/forward.h>
 #include <2geom/rect.h>
 #include <2geom/affine.h>
@@ -33,6 +34,12 @@ void recursive_bezier4(const double x1, const double y1, const double x2, const
                        std::vector<Geom::Point> &pointlist,
                        int level);
 
+/**
+ * Hashes the segments of a path vector: equal path vectors hash the same, and any change to
+ * them almost certainly changes the hash.
+ */
+guint64 pathv_hash(Geom::PathVector const &pathv);
+
 #endif  // INKSCAPE_HELPER_GEOM_H
 
 /*
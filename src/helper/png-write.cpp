@@ -18,6 +18,9 @@
 #endif
 
 #include <png.h>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
 #include "ui/interface.h"
 #include <2geom/rect.h>
 #include <2geom/transforms.h>
@@ -122,8 +125,51 @@ void PngTextList::add(gchar const* key, gchar const* text)
     }
 }
 
+/**
+ * Collect the document metadata which is written into PNG files.
+ */
+static void
+sp_png_get_text(SPDocument *doc, PngTextList &textList)
+{
+    textList.add("Software", "www.inkscape.org"); // Made by Inkscape comment
+    const gchar* pngToDc[] = {"Title", "title",
+                           "Author", "creator",
+                           "Description", "description",
+                           //"Copyright", "",
+                           "Creation Time", "date",
+                           //"Disclaimer", "",
+                           //"Warning", "",
+                           "Source", "source"
+                           //"Comment", ""
+    };
+    for (size_t i = 0; i < G_N_ELEMENTS(pngToDc); i += 2) {
+        struct rdf_work_entity_t * entity = rdf_find_entity ( pngToDc[i + 1] );
+        if (entity) {
+            gchar const* data = rdf_get_work_entity(doc, entity);
+            if (data && *data) {
+                textList.add(pngToDc[i], data);
+            }
+        } else {
+            g_warning("Unable to find entity [%s]", pngToDc[i + 1]);
+        }
+    }
+
+    struct rdf_license_t *license =  rdf_get_license(doc);
+    if (license) {
+        if (license->name && license->uri) {
+            gchar* tmp = g_strdup_printf("%s %s", license->name, license->uri);
+            textList.add("Copyright", tmp);
+            g_free(tmp);
+        } else if (license->name) {
+            textList.add("Copyright", license->name);
+        } else if (license->uri) {
+            textList.add("Copyright", license->uri);
+        }
+    }
+}
+
 static bool
-sp_png_write_rgba_striped(SPDocument *doc,
+sp_png_write_rgba_striped(PngTextList &textList,
                           gchar const *filename, unsigned long int width, unsigned long int height, double xdpi, double ydpi,
                           int (* get_rows)(guchar const **rows, void **to_free, int row, int num_rows, void *data),
                           void *data)
@@ -203,46 +249,6 @@ sp_png_write_rgba_striped(SPDocument *doc,
     sig_bit.alpha = 8;
     png_set_sBIT(png_ptr, info_ptr, &sig_bit);
 
-    PngTextList textList;
-
-    textList.add("Software", "www.inkscape.org"); // Made by Inkscape comment
-    {
-        const gchar* pngToDc[] = {"Title", "title",
-                               "Author", "creator",
-                               "Description", "description",
-                               //"Copyright", "",
-                               "Creation Time", "date",
-                               //"Disclaimer", "",
-                               //"Warning", "",
-                               "Source", "source"
-                               //"Comment", ""
-        };
-        for (size_t i = 0; i < G_N_ELEMENTS(pngToDc); i += 2) {
-            struct rdf_work_entity_t * entity = rdf_find_entity ( pngToDc[i + 1] );
-            if (entity) {
-                gchar const* data = rdf_get_work_entity(doc, entity);
-                if (data && *data) {
-                    textList.add(pngToDc[i], data);
-                }
-            } else {
-                g_warning("Unable to find entity [%s]", pngToDc[i + 1]);
-            }
-        }
-
-
-        struct rdf_license_t *license =  rdf_get_license(doc);
-        if (license) {
-            if (license->name && license->uri) {
-                gchar* tmp = g_strdup_printf("%s %s", license->name, license->uri);
-                textList.add("Copyright", tmp);
-                g_free(tmp);
-            } else if (license->name) {
-                textList.add("Copyright", license->name);
-            } else if (license->uri) {
-                textList.add("Copyright", license->uri);
-            }
-        }
-    }
     if (textList.getCount() > 0) {
         png_set_text(png_ptr, info_ptr, textList.getPtext(), textList.getCount());
     }
@@ -307,49 +313,58 @@ sp_png_write_rgba_striped(SPDocument *doc,
 
 
 /**
- *
+ * Render rows of an export into px, in the pixel format of PNG files.
  */
-static int
-sp_export_get_rows(guchar const **rows, void **to_free, int row, int num_rows, void *data)
+static void
+sp_export_render_rows(Inkscape::Drawing &drawing, guint32 background, unsigned long width,
+                      int row, int num_rows, guchar *px, int stride)
 {
-    struct SPEBP *ebp = (struct SPEBP *) data;
-
-    if (ebp->status) {
-        if (!ebp->status((float) row / ebp->height, ebp->data)) return 0;
-    }
-
-    num_rows = MIN(num_rows, static_cast<int>(ebp->sheight));
-    num_rows = MIN(num_rows, static_cast<int>(ebp->height - row));
-
     /* Set area of interest */
     // bbox is now set to the entire image to prevent discontinuities
     // in the image when blur is used (the borders may still be a bit
     // off, but that's less noticeable).
-    Geom::IntRect bbox = Geom::IntRect::from_xywh(0, row, ebp->width, num_rows);
+    Geom::IntRect bbox = Geom::IntRect::from_xywh(0, row, width, num_rows);
 
     /* Update to renderable state */
-    ebp->drawing->update(bbox);
-
-    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, ebp->width);
-    unsigned char *px = g_new(guchar, num_rows * stride);
+    drawing.update(bbox);
 
     cairo_surface_t *s = cairo_image_surface_create_for_data(
-        px, CAIRO_FORMAT_ARGB32, ebp->width, num_rows, stride);
+        px, CAIRO_FORMAT_ARGB32, width, num_rows, stride);
     Inkscape::DrawingContext dc(s, bbox.min());
-    dc.setSource(ebp->background);
+    dc.setSource(background);
     dc.setOperator(CAIRO_OPERATOR_SOURCE);
     dc.paint();
     dc.setOperator(CAIRO_OPERATOR_OVER);
 
     /* Render */
-    ebp->drawing->render(dc, bbox);
+    drawing.render(dc, bbox);
     cairo_surface_destroy(s);
 
-    *to_free = px;
-
     // PNG stores data as unpremultiplied big-endian RGBA, which means
     // it's identical to the GdkPixbuf format.
-    convert_pixels_argb32_to_pixbuf(px, ebp->width, num_rows, stride);
+    convert_pixels_argb32_to_pixbuf(px, width, num_rows, stride);
+}
+
+/**
+ *
+ */
+static int
+sp_export_get_rows(guchar const **rows, void **to_free, int row, int num_rows, void *data)
+{
+    struct SPEBP *ebp = (struct SPEBP *) data;
+
+    if (ebp->status) {
+        if (!ebp->status((float) row / ebp->height, ebp->data)) return 0;
+    }
+
+    num_rows = MIN(num_rows, static_cast<int>(ebp->sheight));
+    num_rows = MIN(num_rows, static_cast<int>(ebp->height - row));
+
+    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, ebp->width);
+    unsigned char *px = g_new(guchar, num_rows * stride);
+    sp_export_render_rows(*ebp->drawing, ebp->background, ebp->width, row, num_rows, px, stride);
+
+    *to_free = px;
 
     for (int r = 0; r < num_rows; r++) {
         rows[r] = px + r * stride;
@@ -381,6 +396,34 @@ static void hide_other_items_recursively(SPObject *o, const std::vector<SPItem*>
 }
 
 
+/**
+ * Transform from document coordinates to the pixels of an export of area at the given size.
+ */
+static Geom::Affine
+sp_export_png_transform(SPDocument *doc, Geom::Rect const &area, unsigned long width, unsigned long height)
+{
+    /* Calculate translation by transforming to document coordinates (flipping Y)*/
+    Geom::Point translation = Geom::Point(-area[Geom::X][0], area[Geom::Y][1] - doc->getHeight().value("px"));
+
+    /*  This calculation is only valid when assumed that (x0,y0)= area.corner(0) and (x1,y1) = area.corner(2)
+     * 1) a[0] * x0 + a[2] * y1 + a[4] = 0.0
+     * 2) a[1] * x0 + a[3] * y1 + a[5] = 0.0
+     * 3) a[0] * x1 + a[2] * y1 + a[4] = width
+     * 4) a[1] * x0 + a[3] * y0 + a[5] = height
+     * 5) a[1] = 0.0;
+     * 6) a[2] = 0.0;
+     *
+     * (1,3) a[0] * x1 - a[0] * x0 = width
+     * a[0] = width / (x1 - x0)
+     * (2,4) a[3] * y0 - a[3] * y1 = height
+     * a[3] = height / (y0 - y1)
+     * (1) a[4] = -a[0] * x0
+     * (2) a[5] = -a[3] * y1
+     */
+
+    return Geom::Translate(translation) * Geom::Scale(width / area.width(), height / area.height());
+}
+
 ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
                                 double x0, double y0, double x1, double y1,
                                 unsigned long int width, unsigned long int height, double xdpi, double ydpi,
@@ -415,28 +458,7 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
 
     doc->ensureUpToDate();
 
-    /* Calculate translation by transforming to document coordinates (flipping Y)*/
-    Geom::Point translation = Geom::Point(-area[Geom::X][0], area[Geom::Y][1] - doc->getHeight().value("px"));
-
-    /*  This calculation is only valid when assumed that (x0,y0)= area.corner(0) and (x1,y1) = area.corner(2)
-     * 1) a[0] * x0 + a[2] * y1 + a[4] = 0.0
-     * 2) a[1] * x0 + a[3] * y1 + a[5] = 0.0
-     * 3) a[0] * x1 + a[2] * y1 + a[4] = width
-     * 4) a[1] * x0 + a[3] * y0 + a[5] = height
-     * 5) a[1] = 0.0;
-     * 6) a[2] = 0.0;
-     *
-     * (1,3) a[0] * x1 - a[0] * x0 = width
-     * a[0] = width / (x1 - x0)
-     * (2,4) a[3] * y0 - a[3] * y1 = height
-     * a[3] = height / (y0 - y1)
-     * (1) a[4] = -a[0] * x0
-     * (2) a[5] = -a[3] * y1
-     */
-
-    Geom::Affine const affine(Geom::Translate(translation)
-                            * Geom::Scale(width / area.width(),
-                                        height / area.height()));
+    Geom::Affine const affine = sp_export_png_transform(doc, area, width, height);
 
     //SP_PRINT_MATRIX("SVG2PNG", &affine);
 
@@ -470,7 +492,9 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
     ebp.px = g_try_new(guchar, 4 * ebp.sheight * width);
 
     if (ebp.px) {
-        write_status = sp_png_write_rgba_striped(doc, filename, width, height, xdpi, ydpi, sp_export_get_rows, &ebp);
+        PngTextList textList;
+        sp_png_get_text(doc, textList);
+        write_status = sp_png_write_rgba_striped(textList, filename, width, height, xdpi, ydpi, sp_export_get_rows, &ebp);
         g_free(ebp.px);
     }
 
@@ -480,6 +504,177 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
     return write_status ? EXPORT_OK : EXPORT_ERROR;
 }
 
+/**
+ * Hide the drawing items of all items not listed in list, like hide_other_items_recursively(),
+ * but keep them so that they can be shown again. The hidden drawing items are added to hidden.
+ */
+static void hide_other_drawing_items_recursively(SPObject *o, const std::vector<SPItem*> &list, unsigned dkey,
+                                                 std::vector<Inkscape::DrawingItem *> &hidden)
+{
+    bool listed = list.end() != find(list.begin(), list.end(), o);
+    if ( SP_IS_ITEM(o)
+         && !SP_IS_DEFS(o)
+         && !SP_IS_ROOT(o)
+         && !SP_IS_GROUP(o)
+         && !listed)
+    {
+        Inkscape::DrawingItem *ai = SP_ITEM(o)->get_arenaitem(dkey);
+        if (ai && ai->visible()) {
+            ai->setVisible(false);
+            hidden.push_back(ai);
+        }
+    }
+
+    if (!listed) {
+        for ( SPObject *child = o->firstChild() ; child; child = child->getNext() ) {
+            hide_other_drawing_items_recursively(child, list, dkey, hidden);
+        }
+    }
+}
+
+/**
+ * A rendered image of sp_export_png_batch() which is compressed and written by a worker thread.
+ */
+struct SPPngEncodeTask {
+    unsigned index;
+    SPPngExportJob const *job;
+    PngTextList *text;
+    guchar *px;
+    bool written;
+};
+
+static int
+sp_export_get_rendered_rows(guchar const **rows, void **to_free, int row, int num_rows, void *data)
+{
+    struct SPEBP *ebp = (struct SPEBP *) data;
+    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, ebp->width);
+
+    for (int r = 0; r < num_rows; r++) {
+        rows[r] = ebp->px + (row + r) * stride;
+    }
+    *to_free = NULL;
+    return num_rows;
+}
+
+static void
+sp_png_encode_task(gpointer data, gpointer user_data)
+{
+    SPPngEncodeTask *task = static_cast<SPPngEncodeTask *>(data);
+    GAsyncQueue *finished = static_cast<GAsyncQueue *>(user_data);
+
+    struct SPEBP ebp;
+    ebp.width = task->job->width;
+    ebp.height = task->job->height;
+    ebp.sheight = task->job->height;
+    ebp.background = 0;
+    ebp.drawing = NULL;
+    ebp.px = task->px;
+    ebp.status = NULL;
+    ebp.data = NULL;
+
+    task->written = sp_png_write_rgba_striped(*task->text, task->job->filename.c_str(),
+                                              ebp.width, ebp.height, task->job->dpi, task->job->dpi,
+                                              sp_export_get_rendered_rows, &ebp);
+    g_free(task->px);
+    task->px = NULL;
+    g_async_queue_push(finished, task);
+}
+
+unsigned sp_export_png_batch(SPDocument *doc, std::vector<SPPngExportJob> const &jobs, unsigned long bgcolor,
+                             void (*done)(unsigned, ExportResult, void *), void *data)
+{
+    g_return_val_if_fail(doc != NULL, jobs.size());
+
+    doc->ensureUpToDate();
+
+    Inkscape::Drawing drawing;
+    drawing.setExact(true); // export with maximum blur rendering quality
+    unsigned const dkey = SPItem::display_key_new(1);
+    drawing.setRoot(doc->getRoot()->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY));
+
+    PngTextList textList;
+    sp_png_get_text(doc, textList);
+
+    unsigned threads = Inkscape::Preferences::get()->getIntLimited("/options/threading/numthreads",
+#ifdef HAVE_OPENMP
+                                                                   omp_get_num_procs(),
+#else
+                                                                   1,
+#endif // HAVE_OPENMP
+                                                                   1, 256);
+    GAsyncQueue *finished = g_async_queue_new();
+    GThreadPool *pool = g_thread_pool_new(sp_png_encode_task, finished, threads, FALSE, NULL);
+
+    unsigned failed = 0;
+    unsigned pending = 0;
+    for (unsigned i = 0; i <= jobs.size(); ++i) {
+        if (i < jobs.size()) {
+            SPPngExportJob const &job = jobs[i];
+            guchar *px = NULL;
+            if (job.width >= 1 && job.height >= 1 && !job.area.hasZeroArea()) {
+                px = g_try_new(guchar, 4 * job.width * job.height);
+            }
+            if (!px) {
+                ++failed;
+                if (done) {
+                    done(i, EXPORT_ERROR, data);
+                }
+                continue;
+            }
+
+            drawing.root()->setTransform(sp_export_png_transform(doc, job.area, job.width, job.height));
+            std::vector<Inkscape::DrawingItem *> hidden;
+            if (!job.items_only.empty()) {
+                hide_other_drawing_items_recursively(doc->getRoot(), job.items_only, dkey, hidden);
+            }
+            int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, job.width);
+            sp_export_render_rows(drawing, bgcolor, job.width, 0, job.height, px, stride);
+            for (unsigned k = 0; k < hidden.size(); ++k) {
+                hidden[k]->setVisible(true);
+            }
+
+            SPPngEncodeTask *task = new SPPngEncodeTask();
+            task->index = i;
+            task->job = &job;
+            task->text = &textList;
+            task->px = px;
+            task->written = false;
+            g_thread_pool_push(pool, task, NULL);
+            ++pending;
+        }
+
+        // Report the images written in the meantime. Rendering waits for the workers
+        // when too many images are waiting to be written, and after the last job.
+        while (pending > 0) {
+            SPPngEncodeTask *task;
+            if (i == jobs.size() || pending > 2 * threads) {
+                task = static_cast<SPPngEncodeTask *>(g_async_queue_pop(finished));
+            } else {
+                task = static_cast<SPPngEncodeTask *>(g_async_queue_try_pop(finished));
+            }
+            if (!task) {
+                break;
+            }
+            --pending;
+            if (!task->written) {
+                ++failed;
+            }
+            if (done) {
+                done(task->index, task->written ? EXPORT_OK : EXPORT_ERROR, data);
+            }
+            delete task;
+        }
+    }
+
+    g_thread_pool_free(pool, FALSE, TRUE);
+    g_async_queue_unref(finished);
+
+    // Hide items, this releases arenaitem
+    doc->getRoot()->invoke_hide(dkey);
+
+    return failed;
+}
+
 
 /*
   Local Variables:
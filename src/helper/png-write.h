@@ -14,10 +14,12 @@
  * Released under GNU GPL, read the file 'COPYING' for more information
  */
 
-#include <2geom/forward.h>
-
+#include <string>
+#include <vector>
+#include <2geom/rect.h>
 
 class SPDocument;
+class SPItem;
 
 enum ExportResult {
     EXPORT_ERROR = 0,
@@ -42,4 +44,28 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
 				unsigned long bgcolor,
 				unsigned int (*status) (float, void *), void *data, bool force_overwrite = false, const std::vector<SPItem*> &items_only = std::vector<SPItem*>());
 
+/**
+ * One image exported by sp_export_png_batch().
+ */
+struct SPPngExportJob {
+    std::string filename;
+    Geom::Rect area;      ///< in document coordinates
+    unsigned long width;  ///< size of the image in pixels
+    unsigned long height;
+    double dpi;           ///< resolution stored in the file
+    std::vector<SPItem*> items_only; ///< if not empty, only these items are shown
+};
+
+/**
+ * Export several images of a document in one go, e.g. a set of icons at several sizes.
+ * The document is shown only once, and the images are rendered one after another while
+ * the finished ones are compressed and written concurrently. Existing files are overwritten.
+ * done, if given, is called for each image with its index in jobs as soon as it is written,
+ * in the order in which they finish.
+ *
+ * @return the number of images which could not be exported.
+ */
+unsigned sp_export_png_batch(SPDocument *doc, std::vector<SPPngExportJob> const &jobs, unsigned long bgcolor,
+                             void (*done)(unsigned, ExportResult, void *), void *data);
+
 #endif // SEEN_SP_PNG_WRITE_H
@@ -291,6 +291,16 @@ void Base64OutputStream::putCh(int ch)
  * Writes the specified byte to this output stream.
  */ 
 int Base64OutputStream::put(gunichar ch)
+{
+    char byte = static_cast<char>(ch & 0xff);
+    return write(&byte, 1) < 0 ? -1 : 1;
+}
+
+/**
+ * Writes length bytes to this output stream.  The encoded text is
+ * collected in a buffer and passed on a block of lines at a time.
+ */ 
+int Base64OutputStream::write(char const *buffer, int length)
 {
     if (closed)
         {
@@ -298,31 +308,38 @@ int Base64OutputStream::put(gunichar ch)
         return -1;
         }
 
-    outBuf   <<=  8;
-    outBuf   |=  (ch & 0xff);
-    bitCount +=  8;
-    if (bitCount >= 24)
+    char out[4096];
+    int outLen = 0;
+    for (int i = 0; i < length; i++)
         {
-        int indx  = (int)((outBuf & 0x00fc0000L) >> 18);
-        int obyte = (int)base64encode[indx & 63];
-        putCh(obyte);
-
-        indx      = (int)((outBuf & 0x0003f000L) >> 12);
-        obyte     = (int)base64encode[indx & 63];
-        putCh(obyte);
-
-        indx      = (int)((outBuf & 0x00000fc0L) >>  6);
-        obyte     = (int)base64encode[indx & 63];
-        putCh(obyte);
-
-        indx      = (int)((outBuf & 0x0000003fL)      );
-        obyte     = (int)base64encode[indx & 63];
-        putCh(obyte);
-
-        bitCount = 0;
-        outBuf   = 0L;
+        outBuf   <<=  8;
+        outBuf   |=  (buffer[i] & 0xff);
+        bitCount +=  8;
+        if (bitCount >= 24)
+            {
+            for (int shift = 18; shift >= 0; shift -= 6)
+                {
+                out[outLen++] = base64encode[(outBuf >> shift) & 63];
+                column++;
+                if (columnWidth > 0 && column >= columnWidth)
+                    {
+                    out[outLen++] = '\n';
+                    column = 0;
+                    }
+                }
+            bitCount = 0;
+            outBuf   = 0L;
+            //room for another 4 characters and their line breaks
+            if (outLen > (int)sizeof(out) - 8)
+                {
+                destination.write(out, outLen);
+                outLen = 0;
+                }
+            }
         }
-    return 1;
+    if (outLen > 0)
+        destination.write(out, outLen);
+    return length;
 }
 
 
@@ -90,6 +90,8 @@ public:
     
     virtual int put(gunichar ch);
 
+    virtual int write(char const *buffer, int length);
+
     /**
      * Sets the maximum line length for base64 output.  If
      * set to <=0, then there will be no line breaks;
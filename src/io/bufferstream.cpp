@@ -32,6 +32,8 @@
  */
 
 #include "bufferstream.h"
+#include <algorithm>
+#include <cstring>
 
 namespace Inkscape
 {
@@ -95,6 +97,19 @@ int BufferInputStream::get()
     return ch;
 }
 
+/**
+ * Copies up to length bytes out of the buffer.
+ */
+int BufferInputStream::read(char *buf, int length)
+{
+    if (closed || position >= (long)buffer.size())
+        return 0;
+    int count = std::min<long>(length, buffer.size() - position);
+    memcpy(buf, &buffer[position], count);
+    position += count;
+    return count;
+}
+
 
 
 
@@ -146,6 +161,17 @@ int BufferOutputStream::put(gunichar ch)
     return 1;
 }
 
+/**
+ * Appends length bytes to the buffer.
+ */
+int BufferOutputStream::write(char const *buf, int length)
+{
+    if (closed)
+        return -1;
+    buffer.insert(buffer.end(), buf, buf + length);
+    return length;
+}
+
 
 
 
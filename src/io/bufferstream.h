@@ -59,6 +59,8 @@ public:
     virtual void close();
     virtual int get();
 
+    virtual int read(char *buffer, int length);
+
 private:
     const std::vector<unsigned char> &buffer;
     long position;
@@ -87,6 +89,8 @@ public:
     virtual void close();
     virtual void flush();
     virtual int put(gunichar ch);
+
+    virtual int write(char const *buffer, int length);
     virtual std::vector<unsigned char> &getBuffer()
         { return buffer; }
 
@@ -31,6 +31,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#include <algorithm>
 
 namespace Inkscape
 {
@@ -41,7 +42,7 @@ namespace IO
 //# G Z I P    I N P U T    S T R E A M
 //#########################################################################
 
-#define OUT_SIZE 4000
+#define OUT_SIZE 16384
 
 /**
  *
@@ -145,6 +146,36 @@ int GzipInputStream::get()
     return ch;
 }
 
+/**
+ * Reads up to length bytes of decompressed data.
+ */ 
+int GzipInputStream::read(char *buffer, int length)
+{
+    if (closed) {
+        return 0;
+    }
+    if (!loaded && !load()) {
+        closed=true;
+        return 0;
+    }
+    loaded = true;
+
+    int count = 0;
+    while (count < length) {
+        if ( outputBufPos >= outputBufLen ) {
+            fetchMore();
+            if ( outputBufPos >= outputBufLen ) {
+                break;
+            }
+        }
+        int some = std::min<long>(length - count, outputBufLen - outputBufPos);
+        memcpy(buffer + count, outputBuf + outputBufPos, some);
+        outputBufPos += some;
+        count += some;
+    }
+    return count;
+}
+
 #define FTEXT 0x01
 #define FHCRC 0x02
 #define FEXTRA 0x04
@@ -156,12 +187,15 @@ bool GzipInputStream::load()
     crc = crc32(0L, Z_NULL, 0);
     
     std::vector<Byte> inputBuf;
+    int const chunk = 65536;
     while (true)
         {
-        int ch = source.get();
-        if (ch<0)
+        size_t old = inputBuf.size();
+        inputBuf.resize(old + chunk);
+        int len = source.read(reinterpret_cast<char *>(&inputBuf[old]), chunk);
+        inputBuf.resize(old + len);
+        if (len < chunk)
             break;
-        inputBuf.push_back(static_cast<Byte>(ch & 0xff));
         }
     long inputBufLen = inputBuf.size();
     
@@ -184,12 +218,7 @@ bool GzipInputStream::load()
     }
     outputBufLen = 0; // Not filled in yet
 
-    std::vector<unsigned char>::iterator iter;
-    Bytef *p = srcBuf;
-    for (iter=inputBuf.begin() ; iter != inputBuf.end() ; ++iter)
-	{
-        *p++ = *iter;
-	}
+    memcpy(srcBuf, &inputBuf[0], srcLen);
 
     int headerLen = 10;
 
@@ -310,30 +339,16 @@ GzipOutputStream::GzipOutputStream(OutputStream &destinationStream)
     totalOut        = 0;
     crc             = crc32(0L, Z_NULL, 0);
 
-    //Gzip header
-    destination.put(0x1f);
-    destination.put(0x8b);
-
-    //Say it is compressed
-    destination.put(Z_DEFLATED);
-
-    //flags
-    destination.put(0);
-
-    //time
-    destination.put(0);
-    destination.put(0);
-    destination.put(0);
-    destination.put(0);
-
-    //xflags
-    destination.put(0);
-
-    //OS code - from zutil.h
-    //destination.put(OS_CODE);
-    //apparently, we should not explicitly include zutil.h
-    destination.put(0);
-
+    char const header[10] = {
+        0x1f, static_cast<char>(0x8b), //Gzip header
+        Z_DEFLATED,                     //Say it is compressed
+        0,                              //flags
+        0, 0, 0, 0,                     //time
+        0,                              //xflags
+        0                               //OS code - from zutil.h
+        //apparently, we should not explicitly include zutil.h
+    };
+    destination.write(header, sizeof(header));
 }
 
 /**
@@ -355,20 +370,22 @@ void GzipOutputStream::close()
 
     flush();
 
+    char trailer[8];
     //# Send the CRC
     uLong outlong = crc;
     for (int n = 0; n < 4; n++)
         {
-        destination.put(static_cast<gunichar>(outlong & 0xff));
+        trailer[n] = static_cast<char>(outlong & 0xff);
         outlong >>= 8;
         }
     //# send the file length
     outlong = totalIn & 0xffffffffL;
-    for (int n = 0; n < 4; n++)
+    for (int n = 4; n < 8; n++)
         {
-        destination.put(static_cast<gunichar>(outlong & 0xff));
+        trailer[n] = static_cast<char>(outlong & 0xff);
         outlong >>= 8;
         }
+    destination.write(trailer, sizeof(trailer));
 
     destination.close();
     closed = true;
@@ -386,25 +403,15 @@ void GzipOutputStream::flush()
     }
 	
     uLong srclen = inputBuf.size();
-    Bytef *srcbuf = new Bytef [srclen];
-    if (!srcbuf)
-        {
-        return;
-        }
-        
-    uLong destlen = srclen;
-    Bytef *destbuf = new Bytef [(destlen + (srclen/100) + 13)];
+    Bytef *srcbuf = &inputBuf[0];
+
+    uLong destlen = compressBound(srclen);
+    Bytef *destbuf = new Bytef [destlen];
     if (!destbuf)
         {
-        delete[] srcbuf;
         return;
         }
         
-    std::vector<unsigned char>::iterator iter;
-    Bytef *p = srcbuf;
-    for (iter=inputBuf.begin() ; iter != inputBuf.end() ; ++iter)
-        *p++ = *iter;
-        
     crc = crc32(crc, const_cast<const Bytef *>(srcbuf), srclen);
     
     int zerr = compress(destbuf, static_cast<uLongf *>(&destlen), srcbuf, srclen);
@@ -415,15 +422,14 @@ void GzipOutputStream::flush()
 
     totalOut += destlen;
     //skip the redundant zlib header and checksum
-    for (uLong i=2; i<destlen-4 ; i++)
+    if (destlen > 6)
         {
-        destination.put((int)destbuf[i]);
+        destination.write(reinterpret_cast<char *>(destbuf) + 2, destlen - 6);
         }
         
     destination.flush();
 
     inputBuf.clear();
-    delete[] srcbuf;
     delete[] destbuf;
 }
 
@@ -447,6 +453,21 @@ int GzipOutputStream::put(gunichar ch)
     return 1;
 }
 
+/**
+ * Writes length bytes to this output stream.
+ */ 
+int GzipOutputStream::write(char const *buffer, int length)
+{
+    if (closed)
+        {
+        return -1;
+        }
+
+    inputBuf.insert(inputBuf.end(), buffer, buffer + length);
+    totalIn += length;
+    return length;
+}
+
 
 
 } // namespace IO
@@ -49,6 +49,8 @@ public:
     
     virtual int get();
     
+    virtual int read(char *buffer, int length);
+    
 private:
 
     bool load();
@@ -100,6 +102,8 @@ public:
     
     virtual int put(gunichar ch);
 
+    virtual int write(char const *buffer, int length);
+
 private:
 
     std::vector<unsigned char> inputBuf;
@@ -0,0 +1,192 @@
+#include <cxxtest/TestSuite.h>
+
+#include <glib.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "io/base64stream.h"
+#include "io/bufferstream.h"
+#include "io/gzipstream.h"
+#include "io/stringstream.h"
+
+using Inkscape::IO::BufferInputStream;
+using Inkscape::IO::BufferOutputStream;
+
+class InkscapeStreamTest : public CxxTest::TestSuite {
+private:
+    /// Compressible data: words from a small vocabulary, with some random bytes.
+    static std::vector<unsigned char> sample(int size) {
+        static char const *words[] = { "<path ", "d=\"M ", "0.5,", "12 ", "z\" ", "/>\n", "\xc3\xa9" };
+        std::vector<unsigned char> data;
+        while ((int)data.size() < size) {
+            if (std::rand() % 8 == 0) {
+                data.push_back(std::rand() & 0xff);
+            } else {
+                char const *w = words[std::rand() % 7];
+                data.insert(data.end(), w, w + strlen(w));
+            }
+        }
+        data.resize(size);
+        return data;
+    }
+
+    /// Writes the data in pieces of varying size, or byte by byte if bulk is false.
+    static void send(Inkscape::IO::OutputStream &out, std::vector<unsigned char> const &data, bool bulk) {
+        char const *p = reinterpret_cast<char const *>(&data[0]);
+        int pos = 0;
+        while (pos < (int)data.size()) {
+            if (bulk) {
+                int len = std::min<int>(std::rand() % 5000, data.size() - pos);
+                out.write(p + pos, len);
+                pos += len;
+            } else {
+                out.put((unsigned char)p[pos++]);
+            }
+        }
+    }
+
+    /// Reads everything in pieces of varying size, or byte by byte if bulk is false.
+    static std::vector<unsigned char> receive(Inkscape::IO::InputStream &in, bool bulk) {
+        std::vector<unsigned char> data;
+        if (bulk) {
+            char buffer[5000];
+            for (;;) {
+                int want = 1 + std::rand() % sizeof(buffer);
+                int len = in.read(buffer, want);
+                data.insert(data.end(), buffer, buffer + len);
+                if (len < want) break;
+            }
+        } else {
+            for (int ch = in.get(); ch >= 0; ch = in.get()) {
+                data.push_back(ch);
+            }
+        }
+        return data;
+    }
+
+public:
+    InkscapeStreamTest() {}
+    virtual ~InkscapeStreamTest() {}
+
+    static InkscapeStreamTest *createSuite() { return new InkscapeStreamTest(); }
+    static void destroySuite( InkscapeStreamTest *suite ) { delete suite; }
+
+    void testGzipRoundTrip()
+    {
+        std::srand(1);
+        std::vector<unsigned char> data = sample(300000);
+        BufferOutputStream bytewise, bulk;
+        {
+            Inkscape::IO::GzipOutputStream gout(bytewise);
+            send(gout, data, false);
+            gout.close();
+        }
+        {
+            Inkscape::IO::GzipOutputStream gout(bulk);
+            send(gout, data, true);
+            gout.close();
+        }
+        TS_ASSERT(bytewise.getBuffer() == bulk.getBuffer());
+
+        for (int b = 0; b < 2; ++b) {
+            BufferInputStream bin(bulk.getBuffer());
+            Inkscape::IO::GzipInputStream gin(bin);
+            TS_ASSERT(receive(gin, b) == data);
+        }
+    }
+
+    void testBase64RoundTrip()
+    {
+        std::srand(2);
+        std::vector<unsigned char> data = sample(10001);
+        for (int width = 0; width <= 72; width += 72) {
+            BufferOutputStream bytewise, bulk;
+            {
+                Inkscape::IO::Base64OutputStream bout(bytewise);
+                bout.setColumnWidth(width);
+                send(bout, data, false);
+                bout.close();
+            }
+            {
+                Inkscape::IO::Base64OutputStream bout(bulk);
+                bout.setColumnWidth(width);
+                send(bout, data, true);
+                bout.close();
+            }
+            TS_ASSERT(bytewise.getBuffer() == bulk.getBuffer());
+
+            BufferInputStream bin(bulk.getBuffer());
+            Inkscape::IO::Base64InputStream din(bin);
+            TS_ASSERT(receive(din, false) == data);
+        }
+    }
+
+    void testPipeStream()
+    {
+        std::srand(3);
+        std::vector<unsigned char> data = sample(12345);
+        BufferInputStream bin(data);
+        BufferOutputStream bout;
+        Inkscape::IO::pipeStream(bin, bout);
+        TS_ASSERT(bout.getBuffer() == data);
+    }
+
+    // Bytes written in bulk end up as the same characters as when put one by one.
+    void testStringOutput()
+    {
+        std::srand(4);
+        std::vector<unsigned char> data = sample(2000);
+        Inkscape::IO::StringOutputStream bytewise, bulk;
+        send(bytewise, data, false);
+        send(bulk, data, true);
+        TS_ASSERT_EQUALS(bytewise.getString(), bulk.getString());
+    }
+
+    // Set INKSCAPE_BENCHMARK_IO to go on with larger data, up to 64 MB.
+    void testGzipThroughput()
+    {
+        int const sizes[3] = { 1, 16, 64 };
+        unsigned const count = g_getenv("INKSCAPE_BENCHMARK_IO") ? G_N_ELEMENTS(sizes) : 1;
+        TS_TRACE("Benchmarking gzip streams...");
+        GTimer *timer = g_timer_new();
+        for (unsigned i = 0; i < count; ++i) {
+            std::srand(5);
+            std::vector<unsigned char> data = sample(sizes[i] << 20);
+            for (int b = 0; b < 2; ++b) {
+                char const *how = b ? "in bulk" : "byte by byte";
+                BufferOutputStream compressed;
+                g_timer_start(timer);
+                {
+                    Inkscape::IO::GzipOutputStream gout(compressed);
+                    send(gout, data, b);
+                    gout.close();
+                }
+                double elapsed = g_timer_elapsed(timer, NULL);
+                std::cout << "Took " << elapsed << " seconds to save " << sizes[i] << " MB " << how << "\n";
+
+                BufferInputStream bin(compressed.getBuffer());
+                Inkscape::IO::GzipInputStream gin(bin);
+                g_timer_start(timer);
+                std::vector<unsigned char> loaded = receive(gin, b);
+                elapsed = g_timer_elapsed(timer, NULL);
+                std::cout << "Took " << elapsed << " seconds to load " << sizes[i] << " MB " << how << "\n";
+                TS_ASSERT(loaded == data);
+            }
+        }
+        g_timer_destroy(timer);
+    }
+};
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -25,16 +25,38 @@ namespace IO
 
 void pipeStream(InputStream &source, OutputStream &dest)
 {
+    char buffer[4096];
     for (;;)
         {
-        int ch = source.get();
-        if (ch<0)
+        int len = source.read(buffer, sizeof(buffer));
+        if (len > 0)
+            dest.write(buffer, len);
+        if (len < (int)sizeof(buffer))
             break;
-        dest.put(ch);
         }
     dest.flush();
 }
 
+//#########################################################################
+//# I N P U T    S T R E A M
+//#########################################################################
+
+/**
+ * Reads up to length bytes, one at a time.
+ */ 
+int InputStream::read(char *buffer, int length)
+{
+    int count = 0;
+    while (count < length)
+        {
+        int ch = get();
+        if (ch < 0)
+            break;
+        buffer[count++] = ch;
+        }
+    return count;
+}
+
 //#########################################################################
 //# B A S I C    I N P U T    S T R E A M
 //#########################################################################
@@ -83,9 +105,36 @@ int BasicInputStream::get()
         return -1;
     return source.get();
 }
+
+/**
+ * Reads up to length bytes from the source stream.
+ */ 
+int BasicInputStream::read(char *buffer, int length)
+{
+    if (closed)
+        return 0;
+    return source.read(buffer, length);
+}
    
 
 
+//#########################################################################
+//# O U T P U T    S T R E A M
+//#########################################################################
+
+/**
+ * Writes length bytes, one at a time.
+ */ 
+int OutputStream::write(char const *buffer, int length)
+{
+    for (int i = 0; i < length; i++)
+        {
+        if (put((unsigned char)buffer[i]) < 0)
+            return -1;
+        }
+    return length;
+}
+
 //#########################################################################
 //# B A S I C    O U T P U T    S T R E A M
 //#########################################################################
@@ -133,6 +182,17 @@ int BasicOutputStream::put(gunichar ch)
     return 1;
 }
 
+/**
+ * Writes length bytes to the destination stream.
+ */ 
+int BasicOutputStream::write(char const *buffer, int length)
+{
+    if (closed)
+        return -1;
+    destination.write(buffer, length);
+    return length;
+}
+
 
 
 //#########################################################################
@@ -470,6 +530,15 @@ void BasicWriter::put(gunichar ch)
         destination->put(ch);
 }
 
+/**
+ * Writes length bytes to this output writer.
+ */ 
+void BasicWriter::write(char const *buffer, int length)
+{
+    for (int i = 0; i < length; i++)
+        put((gunichar)buffer[i]);
+}
+
 /**
  * Provide printf()-like formatting
  */ 
@@ -521,6 +590,19 @@ Writer &BasicWriter::writeStdString(std::string &str)
  */ 
 Writer &BasicWriter::writeString(const char *str)
 {
+    // plain ASCII, which is almost everything written, can be passed on unchanged
+    if (str)
+        {
+        int len = 0;
+        while (str[len] && !(str[len] & 0x80))
+            len++;
+        if (!str[len])
+            {
+            write(str, len);
+            return *this;
+            }
+        }
+
     Glib::ustring tmp;
     if (str)
         tmp = str;
@@ -742,6 +824,14 @@ void OutputStreamWriter::put(gunichar ch)
     outputStream.put(ch);
 }
 
+/**
+ *  Passes the bytes on to the OutputStream in one call.
+ */
+void OutputStreamWriter::write(char const *buffer, int length)
+{
+    outputStream.write(buffer, length);
+}
+
 //#########################################################################
 //# S T D    W R I T E R
 //#########################################################################
@@ -792,6 +882,14 @@ void StdWriter::put(gunichar ch)
     outputStream->put(ch);
 }
 
+/**
+ *  Passes the bytes on to the OutputStream in one call.
+ */
+void StdWriter::write(char const *buffer, int length)
+{
+    outputStream->write(buffer, length);
+}
+
 
 } // namespace IO
 } // namespace Inkscape
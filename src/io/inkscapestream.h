@@ -85,6 +85,14 @@ public:
      */
     virtual int get() = 0;
     
+    /**
+     * Read up to 'length' bytes into 'buffer'.  This is a blocking
+     * call like get().  Returns the number of bytes read, which is
+     * less than 'length' only at the end of the stream.
+     * The default implementation calls get() for every byte.
+     */
+    virtual int read(char *buffer, int length);
+    
 }; // class InputStream
 
 
@@ -110,6 +118,8 @@ public:
     
     virtual int get();
     
+    virtual int read(char *buffer, int length);
+    
 protected:
 
     bool closed;
@@ -191,6 +201,14 @@ public:
      */
     virtual int put(gunichar ch) = 0;
 
+    /**
+     * Send 'length' bytes to the destination stream, like put() on
+     * every one of them.  Returns the number of bytes written, or -1
+     * if the stream is closed.
+     * The default implementation calls put() for every byte.
+     */
+    virtual int write(char const *buffer, int length);
+
 
 }; // class OutputStream
 
@@ -214,6 +232,8 @@ public:
     
     virtual int put(gunichar ch);
 
+    virtual int write(char const *buffer, int length);
+
 protected:
 
     bool closed;
@@ -472,6 +492,11 @@ public:
     
     virtual void put(gunichar ch) = 0;
     
+    /**
+     * Write 'length' bytes, like writeChar() on every one of them.
+     */
+    virtual void write(char const *buffer, int length) = 0;
+    
     /* Formatted output */
     virtual Writer& printf(char const *fmt, ...) G_GNUC_PRINTF(2,3) = 0;
 
@@ -526,6 +551,8 @@ public:
     
     virtual void put(gunichar ch);
     
+    virtual void write(char const *buffer, int length);
+    
     
     
     /* Formatted output */
@@ -617,6 +644,8 @@ public:
     
     virtual void put(gunichar ch);
 
+    virtual void write(char const *buffer, int length);
+
 
 private:
 
@@ -645,6 +674,8 @@ public:
     
     virtual void put(gunichar ch);
 
+    virtual void write(char const *buffer, int length);
+
 
 private:
 
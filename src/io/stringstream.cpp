@@ -118,6 +118,26 @@ int StringOutputStream::put(gunichar ch)
 	return 1;
 }
 
+/**
+ * Writes length bytes to this output stream.  Like put(), every
+ * byte becomes one character, so runs of ASCII are appended at once.
+ */ 
+int StringOutputStream::write(char const *buf, int length)
+{
+    int start = 0;
+    for (int i = 0; i < length; i++)
+        {
+        if (buf[i] & 0x80)
+            {
+            buffer.append(buf + start, i - start);
+            buffer.push_back((unsigned char)buf[i]);
+            start = i + 1;
+            }
+        }
+    buffer.append(buf + start, length - start);
+    return length;
+}
+
 
 } // namespace IO
 } // namespace Inkscape
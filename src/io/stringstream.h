@@ -69,6 +69,8 @@ public:
     
     virtual int put(gunichar ch);
 
+    virtual int write(char const *buffer, int length);
+
     virtual Glib::ustring &getString()
         { return buffer; }
 
@@ -15,6 +15,7 @@
 #include "sys.h"
 #include <string>
 #include <cstring>
+#include <algorithm>
 
 
 namespace Inkscape
@@ -227,6 +228,36 @@ int UriInputStream::get()
     return retVal;
 }
 
+/**
+ * Reads up to length bytes from the file or data.
+ */
+int UriInputStream::read(char *buffer, int length)
+{
+    int count = 0;
+    if (!closed && length > 0)
+    {
+        switch (scheme) {
+
+            case SCHEME_FILE:
+                if (inf)
+                {
+                    count = fread(buffer, 1, length, inf);
+                }
+                break;
+
+            case SCHEME_DATA:
+                if (dataPos < dataLen)
+                {
+                    count = std::min(length, dataLen - dataPos);
+                    memcpy(buffer, data + dataPos, count);
+                    dataPos += count;
+                }
+                break;
+        }//switch
+    }
+    return count;
+}
+
 
 
 
@@ -428,6 +459,31 @@ int UriOutputStream::put(gunichar ch)
     return 1;
 }
 
+/**
+ * Writes length bytes to this output stream.
+ */
+int UriOutputStream::write(char const *buffer, int length)
+{
+    if (closed)
+        return -1;
+
+    switch (scheme) {
+        case SCHEME_FILE:
+            if (!outf)
+                return -1;
+            if ((int)fwrite(buffer, 1, length, outf) != length) {
+                Glib::ustring err = "ERROR writing to file ";
+                throw StreamException(err);
+            }
+            break;
+
+        case SCHEME_DATA:
+            return OutputStream::write(buffer, length);
+
+    }//switch
+    return length;
+}
+
 
 
 
@@ -49,6 +49,8 @@ public:
 
     virtual int get();
 
+    virtual int read(char *buffer, int length);
+
 private:
     Inkscape::URI &uri;
     FILE *inf;           //for file: uris
@@ -117,6 +119,8 @@ public:
 
     virtual int put(gunichar ch);
 
+    virtual int write(char const *buffer, int length);
+
 private:
 
     bool closed;
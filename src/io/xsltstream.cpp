@@ -13,6 +13,8 @@
 #include "xsltstream.h"
 #include "stringstream.h"
 #include <libxslt/transform.h>
+#include <algorithm>
+#include <cstring>
 
 
 
@@ -146,6 +148,19 @@ int XsltInputStream::get()
     int ch = (int) outbuf[outpos++];
     return ch;
 }
+
+/**
+ * Copies up to length bytes of the transformed document.
+ */ 
+int XsltInputStream::read(char *buffer, int length)
+{
+    if (closed || outpos >= outsize)
+        return 0;
+    int count = std::min(length, outsize - outpos);
+    memcpy(buffer, outbuf + outpos, count);
+    outpos += count;
+    return count;
+}
    
 
 
@@ -211,11 +226,7 @@ void XsltOutputStream::flush()
         }
     */
 
-    for (int i=0 ; i<resSize ; i++)
-        {
-        char ch = resbuf[i];
-        destination.put(ch);
-        }
+    destination.write(reinterpret_cast<char *>(resbuf), resSize);
         
     //Free our mem
     xmlFree(resbuf);
@@ -84,6 +84,8 @@ public:
     
     virtual int get();
     
+    virtual int read(char *buffer, int length);
+    
 
 private:
 
@@ -0,0 +1,193 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <glib.h>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+#include "libcola/sparse_stress.h"
+
+class SparseStressTest : public CxxTest::TestSuite {
+private:
+    std::vector<vpsc::Rectangle*> _rs;
+    std::vector<cola::Edge> _es;
+    std::vector<double> _weights;
+
+    void clear() {
+        for (unsigned i = 0; i < _rs.size(); i++) {
+            delete _rs[i];
+        }
+        _rs.clear();
+        _es.clear();
+        _weights.clear();
+    }
+
+    // Nodes of 10x10 around random positions.
+    void addNodes(unsigned n) {
+        for (unsigned i = 0; i < n; i++) {
+            double x = std::rand() % 1000, y = std::rand() % 1000;
+            _rs.push_back(new vpsc::Rectangle(x, x + 10, y, y + 10));
+        }
+    }
+
+    void addEdge(unsigned u, unsigned v) {
+        _es.push_back(cola::Edge(u, v));
+        _weights.push_back(1);
+    }
+
+    void grid(unsigned w, unsigned h) {
+        clear();
+        addNodes(w * h);
+        for (unsigned y = 0; y < h; y++) {
+            for (unsigned x = 0; x < w; x++) {
+                if (x + 1 < w) addEdge(y * w + x, y * w + x + 1);
+                if (y + 1 < h) addEdge(y * w + x, (y + 1) * w + x);
+            }
+        }
+    }
+
+    // A random tree with a few more edges, like a diagram of connected modules.
+    void network(unsigned n) {
+        clear();
+        addNodes(n);
+        for (unsigned i = 1; i < n; i++) {
+            addEdge(std::rand() % i, i);
+        }
+        for (unsigned i = 0; i < n / 10; i++) {
+            unsigned u = std::rand() % n, v = std::rand() % n;
+            if (u != v) addEdge(u, v);
+        }
+    }
+
+    double edgeLength(unsigned e) {
+        vpsc::Rectangle *u = _rs[_es[e].first], *v = _rs[_es[e].second];
+        return hypot(u->getCentreX() - v->getCentreX(), u->getCentreY() - v->getCentreY());
+    }
+
+public:
+    SparseStressTest() {}
+    virtual ~SparseStressTest() { clear(); }
+
+    static SparseStressTest *createSuite() { return new SparseStressTest(); }
+    static void destroySuite( SparseStressTest *suite ) { delete suite; }
+
+    void testSmall()
+    {
+        std::srand(1);
+        grid(2, 1);
+        cola::TestConvergence test(0.0001, 100);
+        cola::SparseStressLayout alg(_rs, _es, &_weights[0], 50, test);
+        alg.run();
+        TS_ASSERT_EQUALS(alg.levelCount(), 1u);
+        TS_ASSERT_DELTA(edgeLength(0), 50, 0.5);
+    }
+
+    // Sum over all pairs of nodes of a w x h grid of the stress, the graph distance being the
+    // Manhattan distance in the grid.
+    double gridStress(unsigned w, double length) {
+        double sum = 0;
+        for (unsigned i = 0; i < _rs.size(); i++) {
+            for (unsigned j = 0; j < i; j++) {
+                double d = length * (abs(int(i % w) - int(j % w)) + abs(int(i / w) - int(j / w)));
+                double e = hypot(_rs[i]->getCentreX() - _rs[j]->getCentreX(),
+                                 _rs[i]->getCentreY() - _rs[j]->getCentreY());
+                sum += (e - d) * (e - d) / (d * d);
+            }
+        }
+        return sum;
+    }
+
+    // The sparse stress gives about the same layout as the full one.
+    void testGridStress()
+    {
+        std::srand(2);
+        grid(12, 12);
+        cola::TestConvergence dense_test(0.0001, 100);
+        cola::ConstrainedMajorizationLayout dense(_rs, _es, &_weights[0], 50, dense_test);
+        dense.run();
+        double dense_stress = gridStress(12, 50);
+
+        grid(12, 12);
+        cola::TestConvergence test(0.0001, 100);
+        cola::SparseStressLayout alg(_rs, _es, &_weights[0], 50, test);
+        alg.run();
+        TS_ASSERT_LESS_THAN(1u, alg.levelCount());
+        TS_ASSERT_LESS_THAN(gridStress(12, 50), dense_stress * 1.05);
+    }
+
+    // A large grid is unfolded into a square.
+    void testGrid()
+    {
+        std::srand(3);
+        grid(30, 30);
+        cola::TestConvergence test(0.0001, 100);
+        cola::SparseStressLayout alg(_rs, _es, &_weights[0], 50, test);
+        alg.run();
+        vpsc::Rectangle *a = _rs[0], *b = _rs[29], *c = _rs[29 * 30], *d = _rs[30 * 30 - 1];
+        double ab = hypot(a->getCentreX() - b->getCentreX(), a->getCentreY() - b->getCentreY());
+        double ac = hypot(a->getCentreX() - c->getCentreX(), a->getCentreY() - c->getCentreY());
+        double ad = hypot(a->getCentreX() - d->getCentreX(), a->getCentreY() - d->getCentreY());
+        TS_ASSERT_DELTA(ab, ac, ab * 0.05);
+        TS_ASSERT_DELTA(ad, ab * sqrt(2.0), ab * 0.1);
+    }
+
+    void testNetwork()
+    {
+        std::srand(4);
+        network(2000);
+        cola::TestConvergence test(0.0001, 100);
+        cola::SparseStressLayout alg(_rs, _es, &_weights[0], 100, test);
+        alg.setThreads(2);
+        alg.run();
+        unsigned far = 0;
+        for (unsigned e = 0; e < _es.size(); e++) {
+            TS_ASSERT(edgeLength(e) == edgeLength(e)); // not NaN
+            if (edgeLength(e) > 300) far++;
+        }
+        // only some of the extra edges may end up long
+        TS_ASSERT_LESS_THAN(far, _es.size() / 20);
+    }
+
+    // Set INKSCAPE_BENCHMARK_COLA to go on with larger networks, up to 50000 nodes.
+    void testLargeNetwork()
+    {
+        unsigned const sizes[] = { 1000, 5000, 10000, 20000, 50000 };
+        unsigned const count = g_getenv("INKSCAPE_BENCHMARK_COLA") ? G_N_ELEMENTS(sizes) : 1;
+        TS_TRACE("Benchmarking sparse stress layout...");
+        GTimer *timer = g_timer_new();
+        for (unsigned i = 0; i < count; i++) {
+            std::srand(5);
+            network(sizes[i]);
+            cola::TestConvergence test(0.0001, 100);
+            cola::SparseStressLayout alg(_rs, _es, &_weights[0], 100, test);
+#ifdef HAVE_OPENMP
+            alg.setThreads(omp_get_num_procs());
+#endif
+            g_timer_start(timer);
+            alg.run();
+            double elapsed = g_timer_elapsed(timer, NULL);
+            std::cout << "Took " << elapsed << " seconds to lay out " << sizes[i] << " nodes in " << alg.levelCount() << " levels\n";
+            unsigned far = 0;
+            for (unsigned e = 0; e < _es.size(); e++) {
+                if (edgeLength(e) > 300) far++;
+            }
+            // there are sizes[i] / 10 extra edges
+            TS_ASSERT_LESS_THAN(far, sizes[i] / 10);
+        }
+        g_timer_destroy(timer);
+        clear();
+    }
+};
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,620 @@
+/*
+ * Authors:
+ *   see git history
+ *
+ * Copyright (C) 2016 Authors
+ *
+ * Released under GNU LGPL.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <algorithm>
+#include <float.h>
+#include <functional>
+#include <queue>
+#include "sparse_stress.h"
+
+using namespace std;
+
+namespace cola {
+
+/// Levels are coarsened until they have no more than this many nodes.
+static const unsigned COARSEST_SIZE = 50;
+
+/// Coarsening stops when a level keeps more than this fraction of the nodes of the one below.
+static const double MIN_SHRINK = 0.8;
+
+/// Iterations of conjugate gradient for each majorization step.
+static const unsigned CG_ITERATIONS = 10;
+
+static const unsigned NONE = ~0u;
+
+/**
+ * One level of the graph, with its adjacency lists in compressed rows, and how it maps to the
+ * next coarser level.
+ */
+struct SparseStressLayout::Graph {
+    unsigned n;
+    vector<unsigned> start; // n + 1 offsets into adj and len
+    vector<unsigned> adj;
+    vector<double> len;
+
+    vector<unsigned> parent; // node of the coarser level this node was merged into
+    vector<unsigned> mate;   // node it was merged with, itself if none
+    vector<double> offset;   // distance from the centre of its parent
+
+    struct Link {
+        unsigned u, v;
+        double len;
+        bool operator<(Link const &o) const {
+            return u != o.u ? u < o.u : v != o.v ? v < o.v : len < o.len;
+        }
+    };
+
+    /// Builds the adjacency lists, keeping the shortest of parallel edges and no loops.
+    void build(unsigned n, vector<Link> &links) {
+        this->n = n;
+        for (unsigned i = 0; i < links.size(); i++) {
+            if (links[i].u > links[i].v) {
+                swap(links[i].u, links[i].v);
+            }
+        }
+        sort(links.begin(), links.end());
+        start.assign(n + 1, 0);
+        unsigned kept = 0;
+        for (unsigned i = 0; i < links.size(); i++) {
+            Link const &l = links[i];
+            if (l.u == l.v || (kept && links[kept - 1].u == l.u && links[kept - 1].v == l.v)) {
+                continue;
+            }
+            links[kept++] = l;
+            start[l.u + 1]++;
+            start[l.v + 1]++;
+        }
+        links.resize(kept);
+        for (unsigned i = 0; i < n; i++) {
+            start[i + 1] += start[i];
+        }
+        adj.resize(start[n]);
+        len.resize(start[n]);
+        vector<unsigned> fill(start.begin(), start.end() - 1);
+        for (unsigned i = 0; i < links.size(); i++) {
+            Link const &l = links[i];
+            adj[fill[l.u]] = l.v;
+            len[fill[l.u]++] = l.len;
+            adj[fill[l.v]] = l.u;
+            len[fill[l.v]++] = l.len;
+        }
+    }
+
+    /**
+     * Merges nodes pairwise along their shortest edges, visiting nodes of low degree first so
+     * that leaves are merged with their neighbour. The distance between two merged nodes is
+     * that between their centres: the edge length plus how far each end is from its centre.
+     */
+    void coarsen(Graph &coarse) {
+        vector<unsigned> order(n);
+        for (unsigned i = 0; i < n; i++) {
+            order[i] = i;
+        }
+        stable_sort(order.begin(), order.end(), DegreeLess(*this));
+
+        mate.assign(n, NONE);
+        offset.assign(n, 0);
+        for (unsigned k = 0; k < n; k++) {
+            unsigned i = order[k];
+            if (mate[i] != NONE) continue;
+            unsigned best = NONE;
+            for (unsigned e = start[i]; e < start[i + 1]; e++) {
+                if (mate[adj[e]] == NONE && (best == NONE || len[e] < len[best])) {
+                    best = e;
+                }
+            }
+            if (best == NONE) {
+                mate[i] = i;
+            } else {
+                mate[i] = adj[best];
+                mate[adj[best]] = i;
+                offset[i] = offset[adj[best]] = len[best] / 2;
+            }
+        }
+
+        parent.resize(n);
+        unsigned nc = 0;
+        for (unsigned i = 0; i < n; i++) {
+            if (mate[i] >= i) {
+                parent[i] = parent[mate[i]] = nc++;
+            }
+        }
+
+        vector<Link> links;
+        for (unsigned i = 0; i < n; i++) {
+            for (unsigned e = start[i]; e < start[i + 1]; e++) {
+                unsigned j = adj[e];
+                if (i < j && parent[i] != parent[j]) {
+                    Link l = { parent[i], parent[j], offset[i] + len[e] + offset[j] };
+                    links.push_back(l);
+                }
+            }
+        }
+        coarse.build(nc, links);
+    }
+
+    struct DegreeLess {
+        DegreeLess(Graph const &g) : g(g) {}
+        bool operator()(unsigned a, unsigned b) const {
+            return g.start[a + 1] - g.start[a] < g.start[b + 1] - g.start[b];
+        }
+        Graph const &g;
+    };
+
+    /// Lengths of the shortest paths from s, DBL_MAX for nodes that cannot be reached.
+    void dijkstra(unsigned s, double *d) const {
+        typedef pair<double, unsigned> Item;
+        priority_queue<Item, vector<Item>, greater<Item> > queue;
+        fill(d, d + n, DBL_MAX);
+        d[s] = 0;
+        queue.push(Item(0, s));
+        while (!queue.empty()) {
+            Item top = queue.top();
+            queue.pop();
+            unsigned u = top.second;
+            if (top.first > d[u]) continue;
+            for (unsigned e = start[u]; e < start[u + 1]; e++) {
+                double du = d[u] + len[e];
+                if (du < d[adj[e]]) {
+                    d[adj[e]] = du;
+                    queue.push(Item(du, adj[e]));
+                }
+            }
+        }
+    }
+};
+
+namespace {
+
+/**
+ * The terms of the sparse stress of a level: every edge, and every pair of a node and a
+ * pivot, each with a target distance and a weight. Since the stress is a sum over those terms,
+ * its majorizing function is a quadratic form whose matrix (a weighted Laplacian) and linear
+ * part are sums over the same terms, so both are applied in time linear in their number.
+ */
+class StressTerms {
+public:
+    StressTerms(vector<unsigned> const &start, vector<unsigned> const &adj,
+                vector<double> const &len, vector<unsigned> const &pivots,
+                vector<double> const &dist, vector<double> const &weight, unsigned threads)
+        : n(start.size() - 1), k(pivots.size()), start(start), adj(adj), len(len),
+          pivots(pivots), dist(dist), weight(weight), threads(threads),
+          pivot_sum(k)
+    {}
+
+    /**
+     * Stores in b the linear part of the majorizing function at the positions (x, y) for the
+     * coordinate coords (either x or y), and returns the stress at those positions.
+     */
+    double linear(vector<double> const &x, vector<double> const &y, vector<double> const &coords,
+                  vector<double> &b)
+    {
+        double stress = 0;
+        fill(pivot_sum.begin(), pivot_sum.end(), 0.0);
+#ifdef HAVE_OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+        {
+            // each node and pivot term also adds to the row of the pivot, with the opposite sign
+            vector<double> to_pivot(k, 0.0);
+#ifdef HAVE_OPENMP
+#pragma omp for reduction(+:stress) schedule(static, 1024)
+#endif
+            for (int ii = 0; ii < int(n); ii++) {
+                unsigned const i = ii;
+                double sum = 0;
+                for (unsigned e = start[i]; e < start[i + 1]; e++) {
+                    unsigned const j = adj[e];
+                    double const d = len[e];
+                    if (d > 1e-30) {
+                        double const actual = distance(x, y, i, j);
+                        if (actual > 1e-30) {
+                            sum += (coords[i] - coords[j]) / (d * actual);
+                        }
+                        if (i < j) {
+                            stress += (actual - d) * (actual - d) / (d * d);
+                        }
+                    }
+                }
+                double const *w = &weight[size_t(i) * k];
+                double const *dist_i = &dist[size_t(i) * k];
+                for (unsigned p = 0; p < k; p++) {
+                    if (w[p] > 0) {
+                        double const actual = distance(x, y, i, pivots[p]);
+                        if (actual > 1e-30) {
+                            double const term = w[p] * dist_i[p] * (coords[i] - coords[pivots[p]]) / actual;
+                            sum += term;
+                            to_pivot[p] -= term;
+                        }
+                        stress += w[p] * (actual - dist_i[p]) * (actual - dist_i[p]);
+                    }
+                }
+                b[i] = sum;
+            }
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+            for (unsigned p = 0; p < k; p++) {
+                pivot_sum[p] += to_pivot[p];
+            }
+        }
+        for (unsigned p = 0; p < k; p++) {
+            b[pivots[p]] += pivot_sum[p];
+        }
+        return stress;
+    }
+
+    /// Stores in result the weighted Laplacian times v.
+    void laplacian(vector<double> const &v, vector<double> &result) {
+        fill(pivot_sum.begin(), pivot_sum.end(), 0.0);
+#ifdef HAVE_OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+        {
+            vector<double> to_pivot(k, 0.0);
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(static, 1024)
+#endif
+            for (int ii = 0; ii < int(n); ii++) {
+                unsigned const i = ii;
+                double sum = 0;
+                for (unsigned e = start[i]; e < start[i + 1]; e++) {
+                    double const d = len[e];
+                    if (d > 1e-30) {
+                        sum += (v[i] - v[adj[e]]) / (d * d);
+                    }
+                }
+                double const *w = &weight[size_t(i) * k];
+                for (unsigned p = 0; p < k; p++) {
+                    double const term = w[p] * (v[i] - v[pivots[p]]);
+                    sum += term;
+                    to_pivot[p] -= term;
+                }
+                result[i] = sum;
+            }
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+            for (unsigned p = 0; p < k; p++) {
+                pivot_sum[p] += to_pivot[p];
+            }
+        }
+        for (unsigned p = 0; p < k; p++) {
+            result[pivots[p]] += pivot_sum[p];
+        }
+    }
+
+    double inner(vector<double> const &a, vector<double> const &b) const {
+        double sum = 0;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for reduction(+:sum) num_threads(threads)
+#endif
+        for (int i = 0; i < int(n); i++) {
+            sum += a[i] * b[i];
+        }
+        return sum;
+    }
+
+    /// Improves x towards a solution of L x = b, starting from x.
+    void solve(vector<double> &x, vector<double> const &b) {
+        vector<double> r(n), p(n), lp(n);
+        laplacian(x, lp);
+        for (unsigned i = 0; i < n; i++) {
+            r[i] = b[i] - lp[i];
+        }
+        p = r;
+        double rr = inner(r, r);
+        double const tol = 1e-10 * inner(b, b);
+        for (unsigned it = 0; it < CG_ITERATIONS && rr > tol; it++) {
+            laplacian(p, lp);
+            double const plp = inner(p, lp);
+            if (!(plp > 0)) break;
+            double const alpha = rr / plp;
+            for (unsigned i = 0; i < n; i++) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * lp[i];
+            }
+            double const rr_new = inner(r, r);
+            for (unsigned i = 0; i < n; i++) {
+                p[i] = r[i] + rr_new / rr * p[i];
+            }
+            rr = rr_new;
+        }
+    }
+
+private:
+    static double distance(vector<double> const &x, vector<double> const &y, unsigned i, unsigned j) {
+        double const dx = x[i] - x[j], dy = y[i] - y[j];
+        return sqrt(dx * dx + dy * dy);
+    }
+
+    unsigned n, k;
+    vector<unsigned> const &start;
+    vector<unsigned> const &adj;
+    vector<double> const &len;
+    vector<unsigned> const &pivots;
+    vector<double> const &dist;   // n x k
+    vector<double> const &weight; // n x k
+    unsigned threads;
+    vector<double> pivot_sum;
+};
+
+/// Top eigenvector of the symmetric k x k matrix m, and its eigenvalue.
+double power_iteration(vector<double> const &m, unsigned k, vector<double> &v) {
+    vector<double> w(k);
+    double lambda = 0;
+    for (unsigned it = 0; it < 100; it++) {
+        double norm = 0;
+        for (unsigned i = 0; i < k; i++) {
+            w[i] = 0;
+            for (unsigned j = 0; j < k; j++) {
+                w[i] += m[i * k + j] * v[j];
+            }
+            norm += w[i] * w[i];
+        }
+        norm = sqrt(norm);
+        if (norm < 1e-30) {
+            return 0;
+        }
+        double change = 0;
+        for (unsigned i = 0; i < k; i++) {
+            change += fabs(w[i] / norm - v[i]);
+            v[i] = w[i] / norm;
+        }
+        lambda = norm;
+        if (change < 1e-9) break;
+    }
+    return lambda;
+}
+
+}
+
+SparseStressLayout::SparseStressLayout(
+        std::vector<Rectangle*>& rs,
+        std::vector<Edge>& es,
+        double* eweights,
+        double idealLength,
+        TestConvergence& done)
+    : rs(rs),
+      es(es),
+      eweights(eweights),
+      edge_length(idealLength),
+      done(done),
+      pivots(50),
+      threads(1),
+      levels(0)
+{
+}
+
+/**
+ * Lays out one level: picks pivots far apart from each other, weights each node and pivot
+ * pair by the nodes the pivot stands for, starts from PivotMDS unless start is true and the
+ * given positions have a lower stress, then runs stress majorization until test says it
+ * converged.
+ */
+void SparseStressLayout::layout(Graph const &g, vector<double> &x, vector<double> &y,
+                                bool start, TestConvergence &test) const
+{
+    unsigned const n = g.n;
+    unsigned const k = std::min(pivots, n);
+    if (n < 2 || k == 0) return;
+
+    // pivots by max-min distance, starting from a node far from node 0
+    vector<unsigned> pivot;
+    vector<double> from_pivot(size_t(k) * n); // k x n
+    vector<double> mindist(n, DBL_MAX);
+    vector<unsigned> nearest(n, 0);
+    g.dijkstra(0, &from_pivot[0]);
+    unsigned next = 0;
+    for (unsigned i = 0; i < n; i++) {
+        if (from_pivot[i] != DBL_MAX && from_pivot[i] > from_pivot[next]) next = i;
+    }
+    while (pivot.size() < k) {
+        unsigned const p = pivot.size();
+        pivot.push_back(next);
+        double *d = &from_pivot[size_t(p) * n];
+        g.dijkstra(next, d);
+        for (unsigned i = 0; i < n; i++) {
+            if (d[i] < mindist[i]) {
+                mindist[i] = d[i];
+                nearest[i] = p;
+            }
+        }
+        next = max_element(mindist.begin(), mindist.end()) - mindist.begin();
+        if (mindist[next] == 0) break;
+    }
+    unsigned const np = pivot.size();
+
+    // A pivot stands, for a node at distance d, for the nodes of its region closer than d / 2.
+    vector<double> dist(size_t(n) * np), weight(size_t(n) * np, 0.0);
+    vector<vector<double> > region(np);
+    for (unsigned i = 0; i < n; i++) {
+        region[nearest[i]].push_back(from_pivot[size_t(nearest[i]) * n + i]);
+    }
+    for (unsigned p = 0; p < np; p++) {
+        sort(region[p].begin(), region[p].end());
+        for (unsigned i = 0; i < n; i++) {
+            double const d = from_pivot[size_t(p) * n + i];
+            dist[size_t(i) * np + p] = d;
+            if (d > 1e-30 && d != DBL_MAX) {
+                double const count = upper_bound(region[p].begin(), region[p].end(), d / 2)
+                                     - region[p].begin();
+                weight[size_t(i) * np + p] = count / (d * d);
+            }
+        }
+    }
+
+    // PivotMDS: classical scaling of the node to pivot distances, projected on the two main
+    // axes of the pivots
+    vector<double> mx(n, 0.0), my(n, 0.0);
+    {
+        double largest = 0;
+        for (size_t i = 0; i < from_pivot.size(); i++) {
+            if (from_pivot[i] != DBL_MAX) largest = std::max(largest, from_pivot[i]);
+        }
+        vector<double> c(size_t(n) * np), col(np, 0.0), row(n, 0.0);
+        double all = 0;
+        for (unsigned i = 0; i < n; i++) {
+            for (unsigned p = 0; p < np; p++) {
+                double d = from_pivot[size_t(p) * n + i];
+                if (d == DBL_MAX) d = 2 * largest;
+                c[size_t(i) * np + p] = d * d;
+                col[p] += d * d / n;
+                row[i] += d * d / np;
+                all += d * d / (double(n) * np);
+            }
+        }
+        for (unsigned i = 0; i < n; i++) {
+            for (unsigned p = 0; p < np; p++) {
+                double &v = c[size_t(i) * np + p];
+                v = -0.5 * (v - col[p] - row[i] + all);
+            }
+        }
+        vector<double> ctc(np * np, 0.0);
+        for (unsigned i = 0; i < n; i++) {
+            double const *ci = &c[size_t(i) * np];
+            for (unsigned p = 0; p < np; p++) {
+                for (unsigned q = 0; q < np; q++) {
+                    ctc[p * np + q] += ci[p] * ci[q];
+                }
+            }
+        }
+        vector<double> v1(np), v2(np);
+        for (unsigned p = 0; p < np; p++) {
+            v1[p] = 1.0 / (p + 1);
+            v2[p] = p % 2 ? 1 : -1.0 / (p + 1);
+        }
+        double const lambda = power_iteration(ctc, np, v1);
+        for (unsigned p = 0; p < np; p++) {
+            for (unsigned q = 0; q < np; q++) {
+                ctc[p * np + q] -= lambda * v1[p] * v1[q];
+            }
+        }
+        power_iteration(ctc, np, v2);
+        for (unsigned i = 0; i < n; i++) {
+            for (unsigned p = 0; p < np; p++) {
+                mx[i] += c[size_t(i) * np + p] * v1[p];
+                my[i] += c[size_t(i) * np + p] * v2[p];
+            }
+        }
+
+        // scale to best fit the edge lengths
+        double num = 0, den = 0;
+        for (unsigned i = 0; i < n; i++) {
+            for (unsigned e = g.start[i]; e < g.start[i + 1]; e++) {
+                double const d = g.len[e];
+                double const actual = hypot(mx[i] - mx[g.adj[e]], my[i] - my[g.adj[e]]);
+                if (d > 1e-30) {
+                    num += actual / d;
+                    den += actual * actual / (d * d);
+                }
+            }
+        }
+        if (den > 1e-30) {
+            for (unsigned i = 0; i < n; i++) {
+                mx[i] *= num / den;
+                my[i] *= num / den;
+            }
+        }
+    }
+
+    StressTerms terms(g.start, g.adj, g.len, pivot, dist, weight, threads);
+    vector<double> bx(n), by(n);
+    // the positions from a coarser level can be tangled where PivotMDS is not, or the other way
+    if (!start || terms.linear(mx, my, mx, bx) < terms.linear(x, y, x, bx)) {
+        x.swap(mx);
+        y.swap(my);
+    }
+    test.reset();
+    while (true) {
+        double const stress = terms.linear(x, y, x, bx);
+        terms.linear(x, y, y, by);
+        if (test(stress, &x[0], &y[0])) break;
+        terms.solve(x, bx);
+        terms.solve(y, by);
+    }
+}
+
+bool SparseStressLayout::run() {
+    unsigned const n = rs.size();
+    levels = 0;
+    if (n < 2) return true;
+
+    vector<Graph> graphs(1);
+    vector<Graph::Link> links;
+    for (unsigned i = 0; i < es.size(); i++) {
+        Graph::Link l = { es[i].first, es[i].second, eweights[i] * edge_length };
+        links.push_back(l);
+    }
+    graphs[0].build(n, links);
+    while (graphs.back().n > COARSEST_SIZE) {
+        graphs.push_back(Graph());
+        Graph &fine = graphs[graphs.size() - 2];
+        fine.coarsen(graphs.back());
+        if (graphs.back().n > MIN_SHRINK * fine.n) {
+            graphs.pop_back();
+            break;
+        }
+    }
+    levels = graphs.size();
+
+    vector<double> x(graphs.back().n), y(graphs.back().n);
+    TestConvergence coarse(0.001, 50);
+    layout(graphs.back(), x, y, false, levels > 1 ? coarse : done);
+    for (unsigned l = levels - 1; l > 0; l--) {
+        // split merged nodes apart along an arbitrary but fixed direction
+        Graph const &fine = graphs[l - 1];
+        vector<double> fx(fine.n), fy(fine.n);
+        for (unsigned i = 0; i < fine.n; i++) {
+            unsigned const p = fine.parent[i];
+            double const angle = 2.399963 * p; // golden angle
+            double const side = i < fine.mate[i] ? 1 : -1;
+            fx[i] = x[p] + side * fine.offset[i] * cos(angle);
+            fy[i] = y[p] + side * fine.offset[i] * sin(angle);
+        }
+        x.swap(fx);
+        y.swap(fy);
+        layout(fine, x, y, true, l > 1 ? coarse : done);
+    }
+
+    for (unsigned i = 0; i < n; i++) {
+        rs[i]->moveCentreX(x[i]);
+        rs[i]->moveCentreY(y[i]);
+    }
+    return true;
+}
+
+double SparseStressLayout::edgeStress() const {
+    double sum = 0;
+    for (unsigned i = 0; i < es.size(); i++) {
+        Rectangle const *u = rs[es[i].first], *v = rs[es[i].second];
+        double const d = eweights[i] * edge_length;
+        double const actual = hypot(u->getCentreX() - v->getCentreX(),
+                                    u->getCentreY() - v->getCentreY());
+        sum += (actual - d) * (actual - d) / (d * d);
+    }
+    return sum;
+}
+
+} // namespace cola
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=4:softtabstop=4
@@ -0,0 +1,86 @@
+#ifndef COLA_SPARSE_STRESS_H
+#define COLA_SPARSE_STRESS_H
+
+/*
+ * Authors:
+ *   see git history
+ *
+ * Copyright (C) 2016 Authors
+ *
+ * Released under GNU LGPL.
+ */
+
+#include <vector>
+#include "cola.h"
+
+namespace cola {
+
+/**
+ * Stress layout for large graphs, in time and memory linear in the number of nodes and edges.
+ *
+ * ConstrainedMajorizationLayout needs the distances between all pairs of nodes and solves a
+ * dense system on every iteration, which is O(n^2) in memory and worse in time. Here instead:
+ *
+ * - the graph is coarsened by repeatedly merging pairs of nodes joined by their shortest edge,
+ *   until it is small or stops shrinking;
+ * - the stress of each level only counts the edges, plus the distances from every node to a
+ *   few pivot nodes, weighted by the number of nodes each pivot stands for (sparse stress,
+ *   Ortmann, Klimenta and Brandes 2016);
+ * - the coarsest level starts from a classical MDS of the pivot distances (PivotMDS), and each
+ *   finer level from the positions of the level above, split apart along the merged edges,
+ *   unless its own PivotMDS layout has a lower stress;
+ * - every level is then improved with localized majorization updates, which only read the
+ *   positions of the previous iteration and so run for all nodes in parallel.
+ *
+ * Constraints, overlap avoidance and clusters are not supported.
+ */
+class SparseStressLayout {
+public:
+    SparseStressLayout(
+        std::vector<Rectangle*>& rs,
+        std::vector<Edge>& es,
+        double* eweights,
+        double idealLength,
+        TestConvergence& done=defaultTest);
+
+    /// Number of pivots each node is laid out against, 50 by default.
+    void setPivots(unsigned pivots) { this->pivots = pivots; }
+    /// Number of threads used for the updates when built with OpenMP, 1 by default.
+    void setThreads(unsigned threads) { this->threads = threads; }
+
+    bool run();
+
+    /// Number of levels used by the last run, including the graph itself.
+    unsigned levelCount() const { return levels; }
+
+    /// Sum over the edges of ((length - ideal length) / ideal length)^2 in the current layout.
+    double edgeStress() const;
+
+private:
+    struct Graph;
+
+    void layout(Graph const &g, std::vector<double> &x, std::vector<double> &y,
+                bool start, TestConvergence &test) const;
+
+    std::vector<Rectangle*>& rs;
+    std::vector<Edge>& es;
+    double* eweights;
+    double edge_length;
+    TestConvergence& done;
+    unsigned pivots;
+    unsigned threads;
+    unsigned levels;
+};
+
+}
+#endif // COLA_SPARSE_STRESS_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=4:softtabstop=4
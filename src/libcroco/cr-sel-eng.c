@@ -946,6 +946,378 @@ cr_sel_eng_get_matched_rulesets_real (CRSelEng * a_this,
         return CR_OK;
 }
 
+/*
+ *The selector index of a stylesheet.
+ *Each selector of the sheet is put in one bucket, chosen from what
+ *its rightmost simple selector requires of the node: an id, else a
+ *class, else an element name. Selectors that require none of these
+ *go in the "others" list. Only the selectors of the buckets a node
+ *can fall in have to be evaluated against it.
+ *
+ *The candidates found for a node only depend on its element name,
+ *class attribute and (if some selector asks for it) id, so they are
+ *cached under these. Selectors made of a single simple selector with
+ *only class and id conditions are evaluated once, when the cache
+ *entry is built. A node whose class or id changes gets another key.
+ *
+ *The index is kept in the croco_data of the stylesheet, and is
+ *rebuilt if statements get added to the sheet.
+ */
+typedef struct _CRSelIndexEntry CRSelIndexEntry;
+struct _CRSelIndexEntry {
+        CRStatement *stmt;
+        CRSelector *sel;
+        /*the match only depends on the element name, class and id*/
+        gboolean local;
+};
+
+typedef struct _CRSelCandidate CRSelCandidate;
+struct _CRSelCandidate {
+        guint entry;
+        /*the selector is known to match, no need to evaluate it*/
+        gboolean matched;
+};
+
+typedef struct _CRSelIndex CRSelIndex;
+struct _CRSelIndex {
+        CRStatement *first_stmt;
+        CRStatement *last_stmt;
+        /*CRSelIndexEntry, in the order of the stylesheet*/
+        GArray *entries;
+        /*string -> GArray of entry numbers*/
+        GHashTable *by_id;
+        GHashTable *by_class;
+        GHashTable *by_element;
+        GArray *others;
+        /*node key -> GArray of CRSelCandidate*/
+        GHashTable *candidates;
+        /*bit (1 << combinator) for every combinator the selectors use*/
+        guint combinators;
+};
+
+static void
+sel_index_free_array (gpointer a_array)
+{
+        g_array_free ((GArray *) a_array, TRUE);
+}
+
+static void
+sel_index_destroy (gpointer a_data)
+{
+        CRSelIndex *index = (CRSelIndex *) a_data;
+
+        g_array_free (index->entries, TRUE);
+        g_hash_table_destroy (index->by_id);
+        g_hash_table_destroy (index->by_class);
+        g_hash_table_destroy (index->by_element);
+        g_array_free (index->others, TRUE);
+        g_hash_table_destroy (index->candidates);
+        g_free (index);
+}
+
+static gchar const *
+cr_string_peek_str (CRString const *a_string)
+{
+        if (a_string && a_string->stryng && a_string->stryng->str)
+                return a_string->stryng->str;
+        return NULL;
+}
+
+static void
+sel_index_add_to_bucket (GHashTable *a_buckets, gchar const *a_key, guint a_entry)
+{
+        GArray *bucket = (GArray *) g_hash_table_lookup (a_buckets, a_key);
+
+        if (!bucket) {
+                bucket = g_array_new (FALSE, FALSE, sizeof (guint));
+                g_hash_table_insert (a_buckets, (gpointer) a_key, bucket);
+        }
+        g_array_append_val (bucket, a_entry);
+}
+
+static void
+sel_index_add (CRSelIndex *a_index, CRStatement *a_stmt, CRSelector *a_sel)
+{
+        CRSimpleSel *last = a_sel->simple_sel;
+        CRSimpleSel *cur = NULL;
+        CRAdditionalSel *add_sel = NULL;
+        CRSelIndexEntry entry;
+        guint nr = a_index->entries->len;
+        gchar const *id = NULL,
+                *klass = NULL;
+
+        while (last->next)
+                last = last->next;
+        for (cur = a_sel->simple_sel->next; cur; cur = cur->next)
+                a_index->combinators |= 1 << cur->combinator;
+
+        entry.stmt = a_stmt;
+        entry.sel = a_sel;
+        entry.local = (a_sel->simple_sel->next == NULL);
+
+        for (add_sel = last->add_sel; add_sel; add_sel = add_sel->next) {
+                if (add_sel->type == ID_ADD_SELECTOR
+                    && cr_string_peek_str (add_sel->content.id_name)) {
+                        id = cr_string_peek_str (add_sel->content.id_name);
+                } else if (add_sel->type == CLASS_ADD_SELECTOR
+                           && cr_string_peek_str (add_sel->content.class_name)) {
+                        if (!klass)
+                                klass = cr_string_peek_str (add_sel->content.class_name);
+                } else {
+                        entry.local = FALSE;
+                }
+        }
+        g_array_append_val (a_index->entries, entry);
+
+        if (id) {
+                sel_index_add_to_bucket (a_index->by_id, id, nr);
+        } else if (klass) {
+                sel_index_add_to_bucket (a_index->by_class, klass, nr);
+        } else if ((last->type_mask & TYPE_SELECTOR)
+                   && !(last->type_mask & UNIVERSAL_SELECTOR)
+                   && cr_string_peek_str (last->name)) {
+                sel_index_add_to_bucket (a_index->by_element,
+                                         cr_string_peek_str (last->name), nr);
+        } else {
+                g_array_append_val (a_index->others, nr);
+        }
+}
+
+/*
+ *The selector list of a statement, looked up the same way as
+ *cr_sel_eng_get_matched_rulesets_real() does.
+ */
+static CRSelector *
+get_statement_sel_list (CRStatement *a_stmt)
+{
+        switch (a_stmt->type) {
+        case RULESET_STMT:
+                if (a_stmt->kind.ruleset)
+                        return a_stmt->kind.ruleset->sel_list;
+                break;
+        case AT_MEDIA_RULE_STMT:
+                if (a_stmt->kind.media_rule
+                    && a_stmt->kind.media_rule->rulesets
+                    && a_stmt->kind.media_rule->rulesets->kind.ruleset)
+                        return a_stmt->kind.media_rule->rulesets->kind.ruleset->sel_list;
+                break;
+        default:
+                break;
+        }
+        return NULL;
+}
+
+static CRSelIndex *
+sel_index_get (CRStyleSheet *a_sheet)
+{
+        CRSelIndex *index = NULL;
+        CRStatement *cur_stmt = NULL;
+        CRSelector *cur_sel = NULL;
+
+        if (a_sheet->croco_data) {
+                if (a_sheet->croco_data_destroy != sel_index_destroy) {
+                        /*someone else's data*/
+                        return NULL;
+                }
+                index = (CRSelIndex *) a_sheet->croco_data;
+                if (index->first_stmt == a_sheet->statements
+                    && (!index->last_stmt || !index->last_stmt->next)) {
+                        return index;
+                }
+                sel_index_destroy (index);
+                a_sheet->croco_data = NULL;
+        }
+
+        index = g_new0 (CRSelIndex, 1);
+        index->entries = g_array_new (FALSE, FALSE, sizeof (CRSelIndexEntry));
+        index->by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              NULL, sel_index_free_array);
+        index->by_class = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 NULL, sel_index_free_array);
+        index->by_element = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                   NULL, sel_index_free_array);
+        index->others = g_array_new (FALSE, FALSE, sizeof (guint));
+        index->candidates = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                   g_free, sel_index_free_array);
+
+        index->first_stmt = a_sheet->statements;
+        for (cur_stmt = a_sheet->statements; cur_stmt; cur_stmt = cur_stmt->next) {
+                index->last_stmt = cur_stmt;
+                for (cur_sel = get_statement_sel_list (cur_stmt);
+                     cur_sel; cur_sel = cur_sel->next) {
+                        if (cur_sel->simple_sel)
+                                sel_index_add (index, cur_stmt, cur_sel);
+                }
+        }
+
+        a_sheet->croco_data = index;
+        a_sheet->croco_data_destroy = sel_index_destroy;
+        return index;
+}
+
+static void
+append_bucket (GArray *a_to, GHashTable *a_buckets, gchar const *a_key)
+{
+        GArray *bucket = (GArray *) g_hash_table_lookup (a_buckets, a_key);
+
+        if (bucket)
+                g_array_append_vals (a_to, bucket->data, bucket->len);
+}
+
+static gint
+compare_entry_nrs (gconstpointer a, gconstpointer b)
+{
+        guint const x = *(guint const *) a,
+                y = *(guint const *) b;
+
+        return (x > y) - (x < y);
+}
+
+/*
+ *The selectors which may match a node with this name, id and class,
+ *in the order of the stylesheet.
+ */
+static GArray *
+sel_index_find_candidates (CRSelEng *a_this, CRSelIndex *a_index,
+                           CRXMLNodePtr a_node, gchar const *a_name,
+                           gchar const *a_id, gchar const *a_class)
+{
+        GArray *nrs = g_array_new (FALSE, FALSE, sizeof (guint));
+        GArray *result = g_array_new (FALSE, FALSE, sizeof (CRSelCandidate));
+        guint i = 0;
+
+        if (a_id)
+                append_bucket (nrs, a_index->by_id, a_id);
+        if (a_class) {
+                gchar const *cur = a_class;
+
+                while (*cur) {
+                        gchar const *end = NULL;
+                        gchar *klass = NULL;
+
+                        while (*cur && cr_utils_is_white_space (*cur) == TRUE)
+                                cur++;
+                        for (end = cur;
+                             *end && cr_utils_is_white_space (*end) == FALSE;
+                             end++) ;
+                        if (end != cur) {
+                                klass = g_strndup (cur, end - cur);
+                                append_bucket (nrs, a_index->by_class, klass);
+                                g_free (klass);
+                        }
+                        cur = end;
+                }
+        }
+        append_bucket (nrs, a_index->by_element, a_name);
+        g_array_append_vals (nrs, a_index->others->data, a_index->others->len);
+        g_array_sort (nrs, compare_entry_nrs);
+
+        for (i = 0; i < nrs->len; i++) {
+                guint const nr = g_array_index (nrs, guint, i);
+                CRSelIndexEntry const *entry =
+                        &g_array_index (a_index->entries, CRSelIndexEntry, nr);
+                CRSelCandidate candidate;
+
+                /*a class given twice*/
+                if (i > 0 && nr == g_array_index (nrs, guint, i - 1))
+                        continue;
+
+                candidate.entry = nr;
+                candidate.matched = FALSE;
+                if (entry->local) {
+                        gboolean matches = FALSE;
+
+                        if (cr_sel_eng_matches_node (a_this, entry->sel->simple_sel,
+                                                     a_node, &matches) != CR_OK
+                            || !matches)
+                                continue;
+                        candidate.matched = TRUE;
+                }
+                g_array_append_val (result, candidate);
+        }
+        g_array_free (nrs, TRUE);
+        return result;
+}
+
+/*
+ *Same as cr_sel_eng_get_matched_rulesets_real(), but only evaluates
+ *the selectors the index gives for the node, and appends all the
+ *matching rulesets to a_rulesets at once.
+ */
+static enum CRStatus
+cr_sel_eng_get_matched_rulesets_indexed (CRSelEng * a_this,
+                                         CRStyleSheet * a_stylesheet,
+                                         CRXMLNodePtr a_node,
+                                         GPtrArray * a_rulesets)
+{
+        CRNodeIface const *node_iface = NULL;
+        CRSelIndex *index = NULL;
+        GArray *candidates = NULL;
+        gchar const *name = NULL;
+        char *id = NULL,
+                *klass = NULL;
+        gchar *key = NULL;
+        guint i = 0;
+        enum CRStatus status = CR_OK;
+
+        g_return_val_if_fail (a_this && PRIVATE (a_this)
+                              && a_stylesheet
+                              && a_node && a_rulesets, CR_BAD_PARAM_ERROR);
+
+        node_iface = PRIVATE (a_this)->node_iface;
+        if (!a_stylesheet->statements || !node_iface->isElementNode (a_node))
+                return CR_OK;
+
+        index = sel_index_get (a_stylesheet);
+        g_return_val_if_fail (index, CR_ERROR);
+
+        name = (gchar const *) node_iface->getLocalName (a_node);
+        id = node_iface->getProp (a_node, "id");
+        klass = node_iface->getProp (a_node, "class");
+
+        /*an id that no selector asks for does not need its own key*/
+        key = g_strjoin ("\n", name ? name : "",
+                         (id && g_hash_table_lookup (index->by_id, id)) ? id : "",
+                         klass ? klass : "", NULL);
+        candidates = (GArray *) g_hash_table_lookup (index->candidates, key);
+        if (candidates) {
+                g_free (key);
+        } else {
+                candidates = sel_index_find_candidates (a_this, index, a_node,
+                                                        name ? name : "", id, klass);
+                g_hash_table_insert (index->candidates, key, candidates);
+        }
+
+        for (i = 0; i < candidates->len; i++) {
+                CRSelCandidate const *candidate =
+                        &g_array_index (candidates, CRSelCandidate, i);
+                CRSelIndexEntry const *entry =
+                        &g_array_index (index->entries, CRSelIndexEntry,
+                                        candidate->entry);
+                gboolean matches = candidate->matched;
+
+                if (!matches
+                    && cr_sel_eng_matches_node (a_this, entry->sel->simple_sel,
+                                                a_node, &matches) != CR_OK)
+                        continue;
+                if (matches == TRUE) {
+                        if (cr_simple_sel_compute_specificity (entry->sel->simple_sel)
+                            != CR_OK) {
+                                status = CR_ERROR;
+                                break;
+                        }
+                        entry->stmt->specificity = entry->sel->simple_sel->specificity;
+                        g_ptr_array_add (a_rulesets, entry->stmt);
+                }
+        }
+
+        if (id)
+                node_iface->freePropVal (id);
+        if (klass)
+                node_iface->freePropVal (klass);
+        return status;
+}
+
 static enum CRStatus
 put_css_properties_in_props_list (CRPropList ** a_props, CRStatement * a_stmt)
 {
@@ -1312,6 +1684,32 @@ cr_sel_eng_matches_node (CRSelEng * a_this, CRSimpleSel * a_sel,
                                       TRUE, TRUE);
 }
 
+/**
+ * cr_sel_eng_get_combinators:
+ *@a_sheet: the stylesheet.
+ *
+ *Tells which combinators the selectors of the stylesheet use. A change
+ *to the class or id of a node can only change the rules matching its
+ *descendants (through COMB_WS and COMB_GT) or its following siblings
+ *(through COMB_PLUS) when the stylesheet uses these.
+ *
+ *Returns a mask with the bit (1 << combinator) set for every combinator
+ *used.
+ */
+guint
+cr_sel_eng_get_combinators (CRStyleSheet * a_sheet)
+{
+        CRSelIndex *index = NULL;
+
+        g_return_val_if_fail (a_sheet, 0);
+
+        index = sel_index_get (a_sheet);
+        if (!index) {
+                return (1 << COMB_WS) | (1 << COMB_PLUS) | (1 << COMB_GT);
+        }
+        return index->combinators;
+}
+
 /**
  * cr_sel_eng_get_matched_rulesets:
  *@a_this: the current instance of the selection engine.
@@ -1402,66 +1800,28 @@ cr_sel_eng_get_matched_properties_from_cascade (CRSelEng * a_this,
                                                 CRXMLNodePtr a_node,
                                                 CRPropList ** a_props)
 {
-        CRStatement **stmts_tab = NULL;
+        GPtrArray *stmts_tab = NULL;
         enum CRStatus status = CR_OK;
-        gulong tab_size = 0,
-                tab_len = 0,
-                i = 0,
-                index = 0;
+        gulong i = 0;
         enum CRStyleOrigin origin;
-        gushort stmts_chunck_size = 8;
         CRStyleSheet *sheet = NULL;
 
         g_return_val_if_fail (a_this
                               && a_cascade
                               && a_node && a_props, CR_BAD_PARAM_ERROR);
 
+        stmts_tab = g_ptr_array_new ();
         for (origin = ORIGIN_UA; origin < NB_ORIGINS; origin = (enum CRStyleOrigin) (origin + 1)) {
                 sheet = cr_cascade_get_sheet (a_cascade, origin);
                 if (!sheet)
                         continue;
-                if (tab_size - index < 1) {
-                        stmts_tab = (CRStatement **) g_try_realloc
-                                (stmts_tab, (tab_size + stmts_chunck_size)
-                                 * sizeof (CRStatement *));
-                        if (!stmts_tab) {
-                                cr_utils_trace_info ("Out of memory");
-                                status = CR_ERROR;
-                                goto cleanup;
-                        }
-                        tab_size += stmts_chunck_size;
-                        /*
-                         *compute the max size left for
-                         *cr_sel_eng_get_matched_rulesets_real()'s output tab 
-                         */
-                        tab_len = tab_size - index;
-                }
-                while ((status = cr_sel_eng_get_matched_rulesets_real
-                        (a_this, sheet, a_node, stmts_tab + index, &tab_len))
-                       == CR_OUTPUT_TOO_SHORT_ERROR) {
-                        stmts_tab = (CRStatement **) g_try_realloc
-                                (stmts_tab, (tab_size + stmts_chunck_size)
-                                 * sizeof (CRStatement *));
-                        if (!stmts_tab) {
-                                cr_utils_trace_info ("Out of memory");
-                                status = CR_ERROR;
-                                goto cleanup;
-                        }
-                        tab_size += stmts_chunck_size;
-                        index += tab_len;
-                        /*
-                         *compute the max size left for
-                         *cr_sel_eng_get_matched_rulesets_real()'s output tab 
-                         */
-                        tab_len = tab_size - index;
-                }
+                status = cr_sel_eng_get_matched_rulesets_indexed
+                        (a_this, sheet, a_node, stmts_tab);
                 if (status != CR_OK) {
                         cr_utils_trace_info ("Error while running "
                                              "selector engine");
                         goto cleanup;
                 }
-                index += tab_len;
-                tab_len = tab_size - index;
         }
 
         /*
@@ -1470,8 +1830,8 @@ cr_sel_eng_get_matched_properties_from_cascade (CRSelEng * a_this,
          *Make sure one can walk from the declaration to
          *the stylesheet.
          */
-        for (i = 0; i < index; i++) {
-                CRStatement *stmt = stmts_tab[i];
+        for (i = 0; i < stmts_tab->len; i++) {
+                CRStatement *stmt = (CRStatement *) g_ptr_array_index (stmts_tab, i);
 
                 if (!stmt)
                         continue;
@@ -1489,10 +1849,7 @@ cr_sel_eng_get_matched_properties_from_cascade (CRSelEng * a_this,
         }
         status = CR_OK ;
  cleanup:
-        if (stmts_tab) {
-                g_free (stmts_tab);
-                stmts_tab = NULL;
-        }
+        g_ptr_array_free (stmts_tab, TRUE);
 
         return status;
 }
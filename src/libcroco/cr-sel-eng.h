@@ -85,6 +85,8 @@ enum CRStatus cr_sel_eng_matches_node (CRSelEng *a_this,
                                        CRXMLNodePtr a_node, 
                                        gboolean *a_result) ;
 
+guint cr_sel_eng_get_combinators (CRStyleSheet *a_sheet) ;
+
 enum CRStatus cr_sel_eng_get_matched_rulesets (CRSelEng *a_this,
                                                CRStyleSheet *a_sheet,
                                                CRXMLNodePtr a_node,
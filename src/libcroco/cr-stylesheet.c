@@ -170,6 +170,10 @@ cr_stylesheet_destroy (CRStyleSheet * a_this)
 {
         g_return_if_fail (a_this);
 
+        if (a_this->croco_data && a_this->croco_data_destroy) {
+                a_this->croco_data_destroy (a_this->croco_data);
+                a_this->croco_data = NULL;
+        }
         if (a_this->statements) {
                 cr_statement_destroy (a_this->statements);
                 a_this->statements = NULL;
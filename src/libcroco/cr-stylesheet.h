@@ -67,6 +67,9 @@ struct _CRStyleSheet
 	/**custom data used by libcroco*/
 	gpointer croco_data ;
 
+	/**frees croco_data when the stylesheet is destroyed*/
+	GDestroyNotify croco_data_destroy ;
+
 	/**
 	 *custom application data pointer
 	 *Can be used by applications.
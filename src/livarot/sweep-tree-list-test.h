@@ -0,0 +1,217 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <glib.h>
+#include "livarot/Shape.h"
+#include "livarot/sweep-tree-list.h"
+
+class SweepTreeListTest : public CxxTest::TestSuite {
+private:
+    SweepTreeList::Backend _backend;
+
+    /// Closed polygons through random points of a grid.  A small grid gives many shared points,
+    /// overlapping edges and points lying on other edges.
+    static void randomPolygons(Shape &s, int polygons, int points, int grid) {
+        s.Reset(0, 0);
+        for (int p = 0; p < polygons; ++p) {
+            int const first = s.numberOfPoints();
+            for (int i = 0; i < points; ++i) {
+                s.AddPoint(Geom::Point(std::rand() % grid, std::rand() % grid) * (64.0 / grid));
+            }
+            for (int i = 0; i < points; ++i) {
+                s.AddEdge(first + i, first + (i + 1) % points);
+            }
+        }
+    }
+
+    /// Points in general position, off the rounding grid.
+    static void randomGeneralPolygon(Shape &s, int points) {
+        s.Reset(0, 0);
+        for (int i = 0; i < points; ++i) {
+            s.AddPoint(Geom::Point((std::rand() % 100000) / 997.0, (std::rand() % 100000) / 991.0));
+        }
+        for (int i = 0; i < points; ++i) {
+            s.AddEdge(i, (i + 1) % points);
+        }
+    }
+
+    /// Many small triangles spread over a square: few intersections, but many edges on the sweepline.
+    static void scatteredTriangles(Shape &s, int count) {
+        s.Reset(0, 0);
+        for (int i = 0; i < count; ++i) {
+            Geom::Point const p((std::rand() % 100000) / 97.0, (std::rand() % 100000) / 97.0);
+            int const first = s.numberOfPoints();
+            s.AddPoint(p);
+            s.AddPoint(p + Geom::Point(4 + (std::rand() % 1000) / 331.0, 1 + (std::rand() % 1000) / 337.0));
+            s.AddPoint(p + Geom::Point(1 + (std::rand() % 1000) / 347.0, 4 + (std::rand() % 1000) / 353.0));
+            s.AddEdge(first, first + 1);
+            s.AddEdge(first + 1, first + 2);
+            s.AddEdge(first + 2, first);
+        }
+    }
+
+    static int convert(Shape &out, Shape &in, FillRule rule, SweepTreeList::Backend b) {
+        SweepTreeList::setDefaultBackend(b);
+        return out.ConvertToShape(&in, rule);
+    }
+
+    static int booleen(Shape &out, Shape &a, Shape &b, BooleanOp op, SweepTreeList::Backend backend) {
+        SweepTreeList::setDefaultBackend(backend);
+        return out.Booleen(&a, &b, op);
+    }
+
+    /// In general position both backends make the same comparisons, so the shapes are identical.
+    static void assertSameShape(Shape &a, Shape &b) {
+        TS_ASSERT_EQUALS(a.numberOfPoints(), b.numberOfPoints());
+        TS_ASSERT_EQUALS(a.numberOfEdges(), b.numberOfEdges());
+        if (a.numberOfPoints() != b.numberOfPoints() || a.numberOfEdges() != b.numberOfEdges()) {
+            return;
+        }
+        for (int i = 0; i < a.numberOfPoints(); ++i) {
+            TS_ASSERT_EQUALS(a.getPoint(i).x, b.getPoint(i).x);
+        }
+        for (int i = 0; i < a.numberOfEdges(); ++i) {
+            TS_ASSERT_EQUALS(a.getEdge(i).st, b.getEdge(i).st);
+            TS_ASSERT_EQUALS(a.getEdge(i).en, b.getEdge(i).en);
+        }
+    }
+
+    /// The winding number of the edges around p, from their crossings with a ray going right.
+    static int winding(Shape &s, Geom::Point const &p) {
+        int w = 0;
+        for (int i = 0; i < s.numberOfEdges(); ++i) {
+            Geom::Point const a = s.getPoint(s.getEdge(i).st).x;
+            Geom::Point const b = s.getPoint(s.getEdge(i).en).x;
+            if ((a[Geom::Y] <= p[Geom::Y]) != (b[Geom::Y] <= p[Geom::Y])) {
+                double const x = a[Geom::X] + (p[Geom::Y] - a[Geom::Y]) * (b[Geom::X] - a[Geom::X]) / (b[Geom::Y] - a[Geom::Y]);
+                if (x > p[Geom::X]) {
+                    w += (b[Geom::Y] > a[Geom::Y]) ? 1 : -1;
+                }
+            }
+        }
+        return w;
+    }
+
+    /// With coincident points and edges, ties can be broken in another order, which changes the
+    /// numbering and may leave a zero-length or doubled edge in one of them, but not the area covered.
+    static void assertSameArea(Shape &a, Shape &b) {
+        for (int i = 0; i < 200; ++i) {
+            Geom::Point const p((std::rand() % 6400 + 0.37) / 100, (std::rand() % 6400 + 0.61) / 100);
+            TS_ASSERT_EQUALS(winding(a, p), winding(b, p));
+        }
+    }
+
+    static void assertBackendsAgree(Shape &in, FillRule rule, bool general) {
+        Shape tree, blocks;
+        int const treeErr = convert(tree, in, rule, SweepTreeList::AVL_TREE);
+        int const blocksErr = convert(blocks, in, rule, SweepTreeList::SORTED_BLOCKS);
+        TS_ASSERT_EQUALS(treeErr, blocksErr);
+        assertSame(tree, blocks, general);
+    }
+
+    static void assertSame(Shape &tree, Shape &blocks, bool general) {
+        if (general) {
+            assertSameShape(tree, blocks);
+        } else {
+            assertSameArea(tree, blocks);
+        }
+    }
+
+public:
+    SweepTreeListTest() : _backend(SweepTreeList::defaultBackend()) {}
+    virtual ~SweepTreeListTest() {
+        SweepTreeList::setDefaultBackend(_backend);
+    }
+
+    static SweepTreeListTest *createSuite() { return new SweepTreeListTest(); }
+    static void destroySuite( SweepTreeListTest *suite ) { delete suite; }
+
+    void testGeneralPosition()
+    {
+        std::srand(1);
+        for (int i = 0; i < 50; ++i) {
+            Shape in;
+            randomGeneralPolygon(in, 5 + i * 4);
+            assertBackendsAgree(in, fill_nonZero, true);
+            assertBackendsAgree(in, fill_oddEven, true);
+        }
+    }
+
+    void testDegenerate()
+    {
+        std::srand(2);
+        int const grids[3] = { 3, 5, 12 };
+        for (unsigned g = 0; g < 3; ++g) {
+            for (int i = 0; i < 40; ++i) {
+                Shape in;
+                randomPolygons(in, 1 + i % 4, 4 + i, grids[g]);
+                assertBackendsAgree(in, fill_nonZero, false);
+                assertBackendsAgree(in, fill_positive, false);
+            }
+        }
+    }
+
+    void testBooleen()
+    {
+        std::srand(3);
+        BooleanOp const ops[4] = { bool_op_union, bool_op_inters, bool_op_diff, bool_op_symdiff };
+        for (int i = 0; i < 40; ++i) {
+            // odd rounds are degenerate
+            bool const general = i % 2 == 0;
+            Shape a, b, pa, pb;
+            if (general) {
+                randomGeneralPolygon(a, 6 + i % 20);
+                randomGeneralPolygon(b, 6 + i % 13);
+            } else {
+                randomPolygons(a, 2, 6 + i % 20, 7);
+                randomPolygons(b, 2, 6 + i % 13, 7);
+            }
+            convert(pa, a, fill_nonZero, SweepTreeList::AVL_TREE);
+            convert(pb, b, fill_nonZero, SweepTreeList::AVL_TREE);
+            for (unsigned o = 0; o < 4; ++o) {
+                Shape tree, blocks;
+                int const treeErr = booleen(tree, pa, pb, ops[o], SweepTreeList::AVL_TREE);
+                int const blocksErr = booleen(blocks, pa, pb, ops[o], SweepTreeList::SORTED_BLOCKS);
+                TS_ASSERT_EQUALS(treeErr, blocksErr);
+                assertSame(tree, blocks, general);
+            }
+        }
+    }
+
+    void testManyEdges()
+    {
+        int const sizes[3] = { 1000, 10000, 100000 };
+        unsigned const count = g_getenv("INKSCAPE_BENCHMARK_SWEEP") ? G_N_ELEMENTS(sizes) : 1;
+        TS_TRACE("Benchmarking sweepline backends...");
+        GTimer *timer = g_timer_new();
+        for (unsigned i = 0; i < count; ++i) {
+            std::srand(4);
+            Shape in;
+            scatteredTriangles(in, sizes[i]);
+            Shape tree, blocks;
+            g_timer_start(timer);
+            int const treeErr = convert(tree, in, fill_nonZero, SweepTreeList::AVL_TREE);
+            double elapsed = g_timer_elapsed(timer, NULL);
+            std::cout << "Took " << elapsed << " seconds to convert " << sizes[i] << " triangles with the AVL tree\n";
+            g_timer_start(timer);
+            int const blocksErr = convert(blocks, in, fill_nonZero, SweepTreeList::SORTED_BLOCKS);
+            elapsed = g_timer_elapsed(timer, NULL);
+            std::cout << "Took " << elapsed << " seconds to convert " << sizes[i] << " triangles with sorted blocks\n";
+            TS_ASSERT_EQUALS(treeErr, blocksErr);
+            assertSameShape(tree, blocks);
+        }
+        g_timer_destroy(timer);
+    }
+};
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -1,13 +1,23 @@
+#include <cstring>
 #include <glib.h>
 #include "livarot/sweep-tree.h"
 #include "livarot/sweep-tree-list.h"
 
+static SweepTreeList::Backend backend_from_environment()
+{
+    gchar const *name = g_getenv("INKSCAPE_LIVAROT_SWEEP");
+    return (name && !strcmp(name, "blocks")) ? SweepTreeList::SORTED_BLOCKS : SweepTreeList::AVL_TREE;
+}
+
+static SweepTreeList::Backend default_backend = backend_from_environment();
 
-SweepTreeList::SweepTreeList(int s) :
+
+SweepTreeList::SweepTreeList(int s, Backend b) :
     nbTree(0),
     maxTree(s),
     trees((SweepTree *) g_malloc(s * sizeof(SweepTree))),
-    racine(NULL)
+    racine(NULL),
+    backend(b)
 {
     /* FIXME: Use new[] for trees initializer above, but watch out for bad things happening when
      * SweepTree::~SweepTree is called.
@@ -19,6 +29,9 @@ SweepTreeList::~SweepTreeList()
 {
     g_free(trees);
     trees = NULL;
+    for (unsigned i = 0; i < blocks.size(); i++) {
+        delete blocks[i];
+    }
 }
 
 
@@ -35,6 +48,144 @@ SweepTree *SweepTreeList::add(Shape *iSrc, int iBord, int iWeight, int iStartPoi
 }
 
 
+void SweepTreeList::link(SweepTree *node, SweepTree *insertL)
+{
+    SweepTree *insertR = insertL ? static_cast<SweepTree *>(insertL->elem[RIGHT]) : racine;
+
+    SweepTreeBlock *block;
+    int pos = 0;
+    if (insertL) {
+        block = insertL->block;
+        pos = insertL->rank + 1;
+    } else if (blocks.empty()) {
+        block = new SweepTreeBlock;
+        block->count = 0;
+        insertBlock(0, block);
+    } else {
+        block = blocks[0];
+    }
+
+    if (block->count == SweepTreeBlock::CAPACITY) {
+        // split the block in halves, the node goes in the one it falls into
+        int const half = SweepTreeBlock::CAPACITY / 2;
+        SweepTreeBlock *next = new SweepTreeBlock;
+        next->count = block->count - half;
+        for (int i = 0; i < next->count; i++) {
+            next->nodes[i] = block->nodes[half + i];
+            next->nodes[i]->block = next;
+            next->nodes[i]->rank = i;
+        }
+        block->count = half;
+        insertBlock(block->index + 1, next);
+        if (pos > half) {
+            block = next;
+            pos -= half;
+        }
+    }
+
+    for (int i = block->count; i > pos; i--) {
+        block->nodes[i] = block->nodes[i - 1];
+        block->nodes[i]->rank = i;
+    }
+    block->nodes[pos] = node;
+    block->count++;
+    node->block = block;
+    node->rank = pos;
+
+    node->elem[LEFT] = insertL;
+    node->elem[RIGHT] = insertR;
+    if (insertL) {
+        insertL->elem[RIGHT] = node;
+    }
+    if (insertR) {
+        insertR->elem[LEFT] = node;
+    }
+    racine = blocks[0]->nodes[0];
+}
+
+
+void SweepTreeList::unlink(SweepTree *node)
+{
+    SweepTree *insertL = static_cast<SweepTree *>(node->elem[LEFT]);
+    SweepTree *insertR = static_cast<SweepTree *>(node->elem[RIGHT]);
+    if (insertL) {
+        insertL->elem[RIGHT] = insertR;
+    }
+    if (insertR) {
+        insertR->elem[LEFT] = insertL;
+    }
+    node->elem[LEFT] = node->elem[RIGHT] = NULL;
+
+    SweepTreeBlock *block = node->block;
+    for (int i = node->rank + 1; i < block->count; i++) {
+        block->nodes[i - 1] = block->nodes[i];
+        block->nodes[i - 1]->rank = i - 1;
+    }
+    block->count--;
+    node->block = NULL;
+    node->rank = -1;
+
+    if (block->count == 0) {
+        eraseBlock(block);
+    } else {
+        // merge with a neighbour when both are less than half full together, so that the
+        // blocks stay reasonably filled
+        int const half = SweepTreeBlock::CAPACITY / 2;
+        SweepTreeBlock *left = NULL;
+        SweepTreeBlock *right = NULL;
+        if (block->index + 1 < int(blocks.size()) && block->count + blocks[block->index + 1]->count <= half) {
+            left = block;
+            right = blocks[block->index + 1];
+        } else if (block->index > 0 && blocks[block->index - 1]->count + block->count <= half) {
+            left = blocks[block->index - 1];
+            right = block;
+        }
+        if (left) {
+            for (int i = 0; i < right->count; i++) {
+                SweepTree *moved = right->nodes[i];
+                left->nodes[left->count] = moved;
+                moved->block = left;
+                moved->rank = left->count++;
+            }
+            eraseBlock(right);
+        }
+    }
+    racine = blocks.empty() ? NULL : blocks[0]->nodes[0];
+}
+
+
+void SweepTreeList::insertBlock(int index, SweepTreeBlock *block)
+{
+    blocks.insert(blocks.begin() + index, block);
+    for (int i = index; i < int(blocks.size()); i++) {
+        blocks[i]->index = i;
+    }
+}
+
+
+void SweepTreeList::eraseBlock(SweepTreeBlock *block)
+{
+    int const index = block->index;
+    blocks.erase(blocks.begin() + index);
+    for (int i = index; i < int(blocks.size()); i++) {
+        blocks[i]->index = i;
+    }
+    delete block;
+}
+
+
+SweepTreeList::Backend SweepTreeList::defaultBackend()
+{
+    return default_backend;
+}
+
+
+void SweepTreeList::setDefaultBackend(Backend b)
+{
+    default_backend = b;
+}
+
+
 /*
   Local Variables:
   mode:c++
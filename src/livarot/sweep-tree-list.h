@@ -5,24 +5,58 @@
 #ifndef INKSCAPE_LIVAROT_SWEEP_TREE_LIST_H
 #define INKSCAPE_LIVAROT_SWEEP_TREE_LIST_H
 
+#include <vector>
+
 class Shape;
 class SweepTree;
 
+/**
+ * A run of consecutive nodes of the sweepline, for the SORTED_BLOCKS backend.
+ */
+struct SweepTreeBlock {
+    enum { CAPACITY = 64 };
+    int index;   ///< Position in SweepTreeList::blocks.
+    int count;   ///< Number of nodes.
+    SweepTree *nodes[CAPACITY];   ///< The nodes from left to right.
+};
+
 /**
  * The sweepline: a set of edges intersecting the current sweepline
- * stored as an AVL tree.
+ * stored as an AVL tree, or as sorted blocks of nodes.
  */
 class SweepTreeList {
 public:
+    /// How the nodes are ordered.  The sweep is the same, the nodes are linked by elem[] either way.
+    enum Backend {
+        AVL_TREE,       ///< An AVL tree, searched from the root.
+        SORTED_BLOCKS   ///< Blocks in a sorted array, searched by bisection; racine is the leftmost node.
+    };
+
     int nbTree;   ///< Number of nodes in the tree.
     int const maxTree;   ///< Max number of nodes in the tree.
     SweepTree *trees;    ///< The array of nodes.
     SweepTree *racine;   ///< Root of the tree.
+    Backend const backend;
+    std::vector<SweepTreeBlock *> blocks;   ///< With SORTED_BLOCKS, the nodes from left to right.
 
-    SweepTreeList(int s);
+    SweepTreeList(int s, Backend b = defaultBackend());
     virtual ~SweepTreeList();
 
     SweepTree *add(Shape *iSrc, int iBord, int iWeight, int iStartPoint, Shape *iDst);
+
+    /// With SORTED_BLOCKS: puts the node just after insertL, or first if insertL is NULL.
+    void link(SweepTree *node, SweepTree *insertL);
+    /// With SORTED_BLOCKS: takes the node out of its block and of the elem[] links.
+    void unlink(SweepTree *node);
+
+    /// The backend of the lists created from now on.  Set INKSCAPE_LIVAROT_SWEEP=blocks
+    /// to start with SORTED_BLOCKS.
+    static Backend defaultBackend();
+    static void setDefaultBackend(Backend b);
+
+private:
+    void insertBlock(int index, SweepTreeBlock *block);
+    void eraseBlock(SweepTreeBlock *block);
 };
 
 
@@ -18,6 +18,8 @@ SweepTree::SweepTree()
     src = NULL;
     bord = -1;
     startPoint = -1;
+    block = NULL;
+    rank = -1;
     evt[LEFT] = evt[RIGHT] = NULL;
     sens = true;
     //invDirLength=1;
@@ -32,6 +34,8 @@ void
 SweepTree::MakeNew(Shape *iSrc, int iBord, int iWeight, int iStartPoint)
 {
     AVLTree::MakeNew();
+    block = NULL;
+    rank = -1;
     ConvertTo(iSrc, iBord, iWeight, iStartPoint);
 }
 
@@ -71,13 +75,11 @@ void SweepTree::MakeDelete()
 }
 
 
-// find the position at which node "newOne" should be inserted in the subtree rooted here
-// we want to order with respect to the order of intersections with the sweepline, currently 
+// compare node "newOne" with this one, in the order of intersections with the sweepline, currently
 // lying at y=px[1].
 // px is the upper endpoint of newOne
-int
-SweepTree::Find(Geom::Point const &px, SweepTree *newOne, SweepTree *&insertL,
-                SweepTree *&insertR, bool sweepSens)
+double
+SweepTree::Compare(Geom::Point const &px, SweepTree *newOne, bool sweepSens)
 {
     // get the edge associated with this node: one point+one direction
     // since we're dealing with line, the direction (bNorm) is taken downwards
@@ -123,13 +125,22 @@ SweepTree::Find(Geom::Point const &px, SweepTree *newOne, SweepTree *&insertL,
         }
         if (y == 0) {
             y = dot(bNorm, nNorm);
-            if (y == 0) {
-                insertL = this;
-                insertR = static_cast<SweepTree *>(elem[RIGHT]);
-                return found_exact;
-            }
         }
     }
+    return y;
+}
+
+// find the position at which node "newOne" should be inserted in the subtree rooted here
+int
+SweepTree::Find(Geom::Point const &px, SweepTree *newOne, SweepTree *&insertL,
+                SweepTree *&insertR, bool sweepSens)
+{
+    double const y = Compare(px, newOne, sweepSens);
+    if (y == 0) {
+        insertL = this;
+        insertR = static_cast<SweepTree *>(elem[RIGHT]);
+        return found_exact;
+    }
     if (y < 0) {
         if (child[LEFT]) {
             return (static_cast<SweepTree *>(child[LEFT]))->Find(px, newOne,
@@ -162,6 +173,60 @@ SweepTree::Find(Geom::Point const &px, SweepTree *newOne, SweepTree *&insertL,
     return not_found;
 }
 
+// the same as Find() on the root, for the lists that keep their nodes in sorted blocks:
+// a bisection on the first nodes of the blocks, then in the block, with the same comparisons
+// as the descent in the tree
+static int
+find_in_blocks(SweepTreeList const &list, Geom::Point const &px, SweepTree *newOne,
+               SweepTree *&insertL, SweepTree *&insertR, bool sweepSens)
+{
+    int lo = 0;
+    int hi = list.blocks.size();
+    while (lo < hi) {
+        int const mid = (lo + hi) / 2;
+        SweepTree *node = list.blocks[mid]->nodes[0];
+        double const y = node->Compare(px, newOne, sweepSens);
+        if (y == 0) {
+            insertL = node;
+            insertR = static_cast<SweepTree *>(node->elem[RIGHT]);
+            return found_exact;
+        }
+        if (y < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    if (lo == 0) {
+        insertL = NULL;
+        insertR = list.racine;
+        return found_on_left;
+    }
+
+    // newOne goes to the right of the first node of this block
+    SweepTreeBlock const *block = list.blocks[lo - 1];
+    lo = 1;
+    hi = block->count;
+    while (lo < hi) {
+        int const mid = (lo + hi) / 2;
+        SweepTree *node = block->nodes[mid];
+        double const y = node->Compare(px, newOne, sweepSens);
+        if (y == 0) {
+            insertL = node;
+            insertR = static_cast<SweepTree *>(node->elem[RIGHT]);
+            return found_exact;
+        }
+        if (y < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    insertL = block->nodes[lo - 1];
+    insertR = static_cast<SweepTree *>(insertL->elem[RIGHT]);
+    return insertR ? found_between : found_on_right;
+}
+
 // only find a point's position
 int
 SweepTree::Find(Geom::Point const &px, SweepTree * &insertL,
@@ -252,9 +317,17 @@ SweepTree::Remove(SweepTreeList &list, SweepEventQueue &queue,
                   bool rebalance)
 {
   RemoveEvents(queue);
-  AVLTree *tempR = static_cast<AVLTree *>(list.racine);
-  int err = AVLTree::Remove(tempR, rebalance);
-  list.racine = static_cast<SweepTree *>(tempR);
+  int err = avl_no_err;
+  if (list.backend == SweepTreeList::SORTED_BLOCKS)
+    {
+      list.unlink(this);
+    }
+  else
+    {
+      AVLTree *tempR = static_cast<AVLTree *>(list.racine);
+      err = AVLTree::Remove(tempR, rebalance);
+      list.racine = static_cast<SweepTree *>(tempR);
+    }
   MakeDelete();
   if (list.nbTree <= 1)
     {
@@ -266,6 +339,8 @@ SweepTree::Remove(SweepTreeList &list, SweepEventQueue &queue,
       if (list.racine == list.trees + (list.nbTree - 1))
 	list.racine = this;
       list.trees[--list.nbTree].Relocate(this);
+      if (block)
+	block->nodes[rank] = this;
     }
   return err;
 }
@@ -276,14 +351,21 @@ SweepTree::Insert(SweepTreeList &list, SweepEventQueue &queue,
 {
   if (list.racine == NULL)
     {
-      list.racine = this;
+      if (list.backend == SweepTreeList::SORTED_BLOCKS)
+	list.link(this, NULL);
+      else
+	list.racine = this;
       return avl_no_err;
     }
   SweepTree *insertL = NULL;
   SweepTree *insertR = NULL;
-  int insertion =
-    list.racine->Find(iDst->getPoint(iAtPoint).x, this,
-		       insertL, insertR, sweepSens);
+  int insertion;
+  if (list.backend == SweepTreeList::SORTED_BLOCKS)
+    insertion = find_in_blocks(list, iDst->getPoint(iAtPoint).x, this,
+			      insertL, insertR, sweepSens);
+  else
+    insertion = list.racine->Find(iDst->getPoint(iAtPoint).x, this,
+				  insertL, insertR, sweepSens);
   
     if (insertion == found_exact) {
 	if (insertR) {
@@ -298,6 +380,12 @@ SweepTree::Insert(SweepTreeList &list, SweepEventQueue &queue,
       insertL->RemoveEvent(queue, RIGHT);
     }
 
+  if (list.backend == SweepTreeList::SORTED_BLOCKS)
+    {
+      list.link(this, insertL);
+      return avl_no_err;
+    }
+
   AVLTree *tempR = static_cast<AVLTree *>(list.racine);
   int err =
     AVLTree::Insert(tempR, insertion, static_cast<AVLTree *>(insertL),
@@ -318,7 +406,10 @@ SweepTree::InsertAt(SweepTreeList &list, SweepEventQueue &queue,
 {
   if (list.racine == NULL)
     {
-      list.racine = this;
+      if (list.backend == SweepTreeList::SORTED_BLOCKS)
+	list.link(this, NULL);
+      else
+	list.racine = this;
       return avl_no_err;
     }
 
@@ -458,6 +549,12 @@ SweepTree::InsertAt(SweepTreeList &list, SweepEventQueue &queue,
       insertL->RemoveEvent(queue, RIGHT);
   }
 
+  if (list.backend == SweepTreeList::SORTED_BLOCKS)
+    {
+      list.link(this, insertL);
+      return avl_no_err;
+    }
+
   AVLTree *tempR = static_cast<AVLTree *>(list.racine);
   int err =
     AVLTree::Insert(tempR, insertion, static_cast<AVLTree *>(insertL),
@@ -478,6 +575,8 @@ SweepTree::Relocate(SweepTree * to)
   to->evt[LEFT] = evt[LEFT];
   to->evt[RIGHT] = evt[RIGHT];
   to->startPoint = startPoint;
+  to->block = block;
+  to->rank = rank;
   if (unsigned(bord) < src->swsData.size())
     src->swsData[bord].misc = to;
   if (unsigned(bord) < src->swrData.size())
@@ -8,6 +8,7 @@ class Shape;
 class SweepEvent;
 class SweepEventQueue;
 class SweepTreeList;
+struct SweepTreeBlock;
 
 
 /**
@@ -25,6 +26,8 @@ public:
     int bord;     ///< Edge index in the Shape.
     bool sens;    ///< true= top->bottom; false= bottom->top.
     int startPoint;   ///< point index in the result Shape associated with the upper end of the edge
+    SweepTreeBlock *block;   ///< With the SORTED_BLOCKS backend, the block holding this node,
+    int rank;                ///< and the position in it.
 
     SweepTree();
     virtual ~SweepTree();
@@ -40,6 +43,9 @@ public:
 
     // utilites
 
+    // the side of this edge on which newOne goes: < 0 for the left, > 0 for the right, 0 if they coincide
+    double Compare(Geom::Point const &iPt, SweepTree *newOne, bool sweepSens = true);
+
     // the find function that was missing in the AVLTrree class
     // the return values are defined in LivarotDefs.h
     int Find(Geom::Point const &iPt, SweepTree *newOne, SweepTree *&insertL,
@@ -360,6 +360,7 @@ Effect::Effect(LivePathEffectObject *lpeobject)
       oncanvasedit_it(0),
       is_visible(_("Is visible?"), _("If unchecked, the effect remains applied to the object but is temporarily disabled on canvas"), "is_visible", &wr, this, true),
       show_orig_path(false),
+      cacheable(false),
       lpeobj(lpeobject),
       concatenate_before_pwd2(false),
       sp_lpe_item(NULL),
@@ -562,6 +563,20 @@ Effect::doEffect_pwd2 (Geom::Piecewise<Geom::D2<Geom::SBasis> > const & pwd2_in)
     return pwd2_in;
 }
 
+/**
+ * Combines the hashes of all parameters, to tell whether a result computed earlier was computed
+ * with the current values.
+ */
+guint64
+Effect::hashParams() const
+{
+    guint64 hash = G_GUINT64_CONSTANT(14695981039346656037);
+    for (std::vector<Parameter *>::const_iterator p = param_vector.begin(); p != param_vector.end(); ++p) {
+        hash = (hash ^ (*p)->param_hash()) * G_GUINT64_CONSTANT(1099511628211);
+    }
+    return hash;
+}
+
 void
 Effect::readallParameters(Inkscape::XML::Node const* repr)
 {
@@ -120,6 +120,11 @@ public:
 
     inline bool isVisible() const { return is_visible; }
 
+    // whether the result may be reused while the input path, the item's original path and the
+    // parameters are unchanged; see SPLPEItem::performPathEffect
+    inline bool isCacheable() const { return cacheable; }
+    guint64 hashParams() const;
+
     void editNextParamOncanvas(SPItem * item, SPDesktop * desktop);
 
 protected:
@@ -150,6 +155,10 @@ protected:
     bool show_orig_path; // set this to true in derived effects to automatically have the original
                          // path displayed as helperpath
 
+    bool cacheable; // set this to true in derived effects whose result only depends on the input path,
+                    // the original path of the item and the parameters (not on the item's style,
+                    // transform or other objects, the zoom or the selected nodes)
+
     Inkscape::UI::Widget::Registry wr;
 
     LivePathEffectObject *lpeobj;
@@ -49,6 +49,19 @@ void Parameter::write_to_SVG(void)
     g_free(str);
 }
 
+guint64
+Parameter::param_hash() const
+{
+    // FNV-1a
+    guint64 hash = G_GUINT64_CONSTANT(14695981039346656037);
+    gchar * str = param_getSVGValue();
+    for (gchar const *c = str; c && *c; ++c) {
+        hash = (hash ^ (guchar) *c) * G_GUINT64_CONSTANT(1099511628211);
+    }
+    g_free(str);
+    return hash;
+}
+
 /*###########################################
  *   REAL PARAM
  */
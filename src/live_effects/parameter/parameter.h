@@ -57,6 +57,10 @@ public:
     virtual bool param_readSVGValue(const gchar * strvalue) = 0;   // returns true if new value is valid / accepted.
     virtual gchar * param_getSVGValue() const = 0;
     void write_to_SVG();
+
+    // identifies the current value, so that results computed with it can be reused; defaults to
+    // hashing the SVG value
+    virtual guint64 param_hash() const;
  
     virtual void param_set_default() = 0;
 
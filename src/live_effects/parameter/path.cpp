@@ -39,6 +39,7 @@
 #include "sp-shape.h"
 #include "sp-text.h"
 #include "display/curve.h"
+#include "helper/geom.h"
 
 #include "ui/tools/node-tool.h"
 #include "ui/tool/multi-path-manipulator.h"
@@ -150,6 +151,13 @@ PathParam::param_getSVGValue() const
     }
 }
 
+guint64
+PathParam::param_hash() const
+{
+    // the path data, which a linked path changes without changing the SVG value
+    return pathv_hash(_pathvector);
+}
+
 Gtk::Widget *
 PathParam::param_newWidget()
 {
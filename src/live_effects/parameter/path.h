@@ -38,6 +38,7 @@ public:
 
     virtual bool param_readSVGValue(const gchar * strvalue);
     virtual gchar * param_getSVGValue() const;
+    virtual guint64 param_hash() const;
 
     virtual void param_set_default();
     void param_set_and_write_default();
@@ -78,6 +78,20 @@ CmdLineAction::doList (ActionContext const & context) {
   return hasActions;
 }
 
+bool
+CmdLineAction::isEmpty (void) {
+	return _list.empty();
+}
+
+void
+CmdLineAction::clearList (void) {
+	for (std::list<CmdLineAction *>::iterator i = _list.begin();
+			i != _list.end(); ++i) {
+		delete *i;
+	}
+	_list.clear();
+}
+
 bool
 CmdLineAction::idle (void) {
 	std::list<SPDesktop *> desktops;
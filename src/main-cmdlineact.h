@@ -32,6 +32,10 @@ public:
     void doIt (ActionContext const & context);
     /** Return true if any actions were performed */
     static bool doList (ActionContext const & context);
+    /** Return true if no actions were given */
+    static bool isEmpty (void);
+    /** Forget all actions, e.g. before the next command in shell mode */
+    static void clearList (void);
     static bool idle (void);
 };
 
@@ -49,6 +49,7 @@
 
 #include <libxml/tree.h>
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
 #include <glib-object.h>
 #include <gtk/gtk.h>
 
@@ -99,8 +100,18 @@
 #ifdef WIN32
 #include <windows.h>
 #include "registrytool.h"
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #endif // WIN32
 
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
 #include "extension/init.h"
 // Not ideal, but there doesn't appear to be a nicer system in place for
 // passing command-line parameters to extensions before initialization...
@@ -122,7 +133,11 @@
 #include "widgets/icon.h"
 
 #include <errno.h>
+#include <map>
+#include <string>
 #include "verbs.h"
+#include "preferences.h"
+#include "libnrtype/FontFactory.h"
 
 #include <gdk/gdkkeysyms.h>
 
@@ -138,6 +153,7 @@ enum {
     SP_ARG_FILE,
     SP_ARG_PRINT,
     SP_ARG_EXPORT_PNG,
+    SP_ARG_EXPORT_PNG_BATCH,
     SP_ARG_EXPORT_DPI,
     SP_ARG_EXPORT_AREA,
     SP_ARG_EXPORT_AREA_DRAWING,
@@ -170,6 +186,7 @@ enum {
     SP_ARG_QUERY_ALL,
     SP_ARG_QUERY_ID,
     SP_ARG_SHELL,
+    SP_ARG_EXPORT_SERVER,
     SP_ARG_VERSION,
     SP_ARG_VACUUM_DEFS,
 #ifdef WITH_DBUS
@@ -185,6 +202,7 @@ enum {
 int sp_main_gui(int argc, char const **argv);
 int sp_main_console(int argc, char const **argv);
 static int sp_do_export_png(SPDocument *doc);
+static int sp_do_export_png_batch(SPDocument *doc);
 static int do_export_ps_pdf(SPDocument* doc, gchar const* uri, char const *mime);
 static int do_export_emf(SPDocument* doc, gchar const* uri, char const *mime);
 static int do_export_wmf(SPDocument* doc, gchar const* uri, char const *mime);
@@ -195,6 +213,7 @@ static void do_query_all_recurse (SPObject *o);
 
 static gchar *sp_global_printer = NULL;
 static gchar *sp_export_png = NULL;
+static gchar *sp_export_png_batch_list = NULL;
 static gchar *sp_export_dpi = NULL;
 static gchar *sp_export_area = NULL;
 static gboolean sp_export_area_drawing = FALSE;
@@ -227,6 +246,7 @@ static gboolean sp_query_height = FALSE;
 static gboolean sp_query_all = FALSE;
 static gchar *sp_query_id = NULL;
 static gboolean sp_shell = FALSE;
+static gboolean sp_export_server = FALSE;
 static gboolean sp_vacuum_defs = FALSE;
 #ifdef WITH_DBUS
 static gboolean sp_dbus_listen = FALSE;
@@ -243,6 +263,7 @@ static gchar *sp_global_printer_utf8 = NULL;
 static void resetCommandlineGlobals() {
         sp_global_printer = NULL;
         sp_export_png = NULL;
+        sp_export_png_batch_list = NULL;
         sp_export_dpi = NULL;
         sp_export_area = NULL;
         sp_export_area_drawing = FALSE;
@@ -275,6 +296,7 @@ static void resetCommandlineGlobals() {
         sp_query_all = FALSE;
         sp_query_id = NULL;
         sp_vacuum_defs = FALSE;
+        Inkscape::CmdLineAction::clearList();
 #ifdef WITH_DBUS
         sp_dbus_listen = FALSE;
         sp_dbus_name = NULL;
@@ -320,6 +342,11 @@ struct poptOption options[] = {
      N_("Export document to a PNG file"),
      N_("FILENAME")},
 
+    {"export-png-batch", 0,
+     POPT_ARG_STRING, &sp_export_png_batch_list, SP_ARG_EXPORT_PNG_BATCH,
+     N_("Export several PNG files listed in a file, one 'OBJECT-ID SIZE FILENAME' per line"),
+     N_("LISTFILE")},
+
     {"export-dpi", 'd',
      POPT_ARG_STRING, &sp_export_dpi, SP_ARG_EXPORT_DPI,
      N_("Resolution for exporting to bitmap and for rasterization of filters in PS/EPS/PDF (default 96)"),
@@ -521,6 +548,11 @@ struct poptOption options[] = {
      N_("Start Inkscape in interactive shell mode."),
      NULL},
 
+    {"export-server", 0,
+     POPT_ARG_NONE, &sp_export_server, SP_ARG_EXPORT_SERVER,
+     N_("Run export commands read from standard input concurrently, keeping documents loaded between commands."),
+     NULL},
+
     POPT_AUTOHELP POPT_TABLEEND
 };
 
@@ -765,6 +797,7 @@ main(int argc, char **argv)
             || !strcmp(argv[i], "--dbus-listen")
 #endif // WITH_DBUS
             || !strcmp(argv[i], "--shell")
+            || !strcmp(argv[i], "--export-server")
            )
         {
             /* main_console handles any exports -- not the gui */
@@ -1087,143 +1120,167 @@ sp_main_gui(int argc, char const **argv)
 }
 
 /**
- * Process file list
+ * Open a document named on the command line.
+ * Returns NULL and prints a warning if it cannot be opened.
  */
-static int sp_process_file_list(GSList *fl)
+static SPDocument *sp_open_document(gchar const *filename)
 {
-    int retVal = 0;
-#ifdef WITH_DBUS
-    if (!fl) {
-        // If we've been asked to listen for D-Bus messages, enter a main loop here
-        // The main loop may be exited by calling "exit" on the D-Bus application interface.
-        if (sp_dbus_listen) {
-            Gtk::Main main_dbus_loop(0, NULL);
-            main_dbus_loop.run();
-        }
+    SPDocument *doc = NULL;
+    try {
+        doc = Inkscape::Extension::open(NULL, filename);
+    } catch (Inkscape::Extension::Input::no_extension_found &e) {
+        doc = NULL;
+    } catch (Inkscape::Extension::Input::open_failed &e) {
+        doc = NULL;
     }
-#endif // WITH_DBUS
-
-    while (fl) {
-        const gchar *filename = (gchar *)fl->data;
 
-        SPDocument *doc = NULL;
+    if (doc == NULL) {
         try {
-            doc = Inkscape::Extension::open(NULL, filename);
+            doc = Inkscape::Extension::open(Inkscape::Extension::db.get(SP_MODULE_KEY_INPUT_SVG), filename);
         } catch (Inkscape::Extension::Input::no_extension_found &e) {
             doc = NULL;
         } catch (Inkscape::Extension::Input::open_failed &e) {
             doc = NULL;
         }
+    }
+    if (doc == NULL) {
+        g_warning("Specified document %s cannot be opened (does not exist or not a valid SVG file)", filename);
+    }
+    return doc;
+}
 
-        if (doc == NULL) {
-            try {
-                doc = Inkscape::Extension::open(Inkscape::Extension::db.get(SP_MODULE_KEY_INPUT_SVG), filename);
-            } catch (Inkscape::Extension::Input::no_extension_found &e) {
-                doc = NULL;
-            } catch (Inkscape::Extension::Input::open_failed &e) {
-                doc = NULL;
-            }
-        }
-        if (doc == NULL) {
-            g_warning("Specified document %s cannot be opened (does not exist or not a valid SVG file)", filename);
-            retVal++;
-        } else {
+/**
+ * Perform the actions, exports and queries given on the command line on an open document.
+ */
+static int sp_process_document(SPDocument *doc, gchar const *filename)
+{
+    int retVal = 0;
 
-            INKSCAPE.add_document(doc);
+    INKSCAPE.add_document(doc);
 
-            if (sp_vacuum_defs) {
-                doc->vacuumDocument();
-            }
-            
-            // Execute command-line actions (selections and verbs) using our local models
-            bool has_performed_actions = Inkscape::CmdLineAction::doList(INKSCAPE.active_action_context());
+    if (sp_vacuum_defs) {
+        doc->vacuumDocument();
+    }
+    
+    // Execute command-line actions (selections and verbs) using our local models
+    bool has_performed_actions = Inkscape::CmdLineAction::doList(INKSCAPE.active_action_context());
 
 #ifdef WITH_DBUS
-            // If we've been asked to listen for D-Bus messages, enter a main loop here
-            // The main loop may be exited by calling "exit" on the D-Bus application interface.
-            if (sp_dbus_listen) {
-                Gtk::Main main_dbus_loop(0, NULL);
-                main_dbus_loop.run();
-            }
+    // If we've been asked to listen for D-Bus messages, enter a main loop here
+    // The main loop may be exited by calling "exit" on the D-Bus application interface.
+    if (sp_dbus_listen) {
+        Gtk::Main main_dbus_loop(0, NULL);
+        main_dbus_loop.run();
+    }
 #endif // WITH_DBUS
 
-            if (!sp_export_svg && (sp_vacuum_defs || has_performed_actions)) {
-                // save under the name given in the command line
-                Inkscape::Extension::save(Inkscape::Extension::db.get("org.inkscape.output.svg.inkscape"), doc, filename, false,
-                            false, false, Inkscape::Extension::FILE_SAVE_METHOD_INKSCAPE_SVG);
-            }
-            if (sp_global_printer) {
-                sp_print_document_to_file(doc, sp_global_printer);
-            }
-            if (sp_export_png || (sp_export_id && sp_export_use_hints)) {
-                retVal |= sp_do_export_png(doc);
+    if (!sp_export_svg && (sp_vacuum_defs || has_performed_actions)) {
+        // save under the name given in the command line
+        Inkscape::Extension::save(Inkscape::Extension::db.get("org.inkscape.output.svg.inkscape"), doc, filename, false,
+                    false, false, Inkscape::Extension::FILE_SAVE_METHOD_INKSCAPE_SVG);
+    }
+    if (sp_global_printer) {
+        sp_print_document_to_file(doc, sp_global_printer);
+    }
+    if (sp_export_png || (sp_export_id && sp_export_use_hints)) {
+        retVal |= sp_do_export_png(doc);
+    }
+    if (sp_export_png_batch_list) {
+        retVal |= sp_do_export_png_batch(doc);
+    }
+    if (sp_export_svg) {
+        if (sp_export_text_to_path) {
+        	std::vector<SPItem*> items;
+            SPRoot *root = doc->getRoot();
+            doc->ensureUpToDate();
+            for ( SPObject *iter = root->firstChild(); iter ; iter = iter->getNext()) {
+                SPItem* item = (SPItem*) iter;
+                if (! (SP_IS_TEXT(item) || SP_IS_FLOWTEXT(item) || SP_IS_GROUP(item))) {
+                    continue;
+                }
+
+                te_update_layout_now_recursive(item);
+                items.push_back(item);
             }
-            if (sp_export_svg) {
-                if (sp_export_text_to_path) {
-                	std::vector<SPItem*> items;
-                    SPRoot *root = doc->getRoot();
-                    doc->ensureUpToDate();
-                    for ( SPObject *iter = root->firstChild(); iter ; iter = iter->getNext()) {
-                        SPItem* item = (SPItem*) iter;
-                        if (! (SP_IS_TEXT(item) || SP_IS_FLOWTEXT(item) || SP_IS_GROUP(item))) {
-                            continue;
-                        }
 
-                        te_update_layout_now_recursive(item);
-                        items.push_back(item);
-                    }
+            std::vector<SPItem*> selected;
+            std::vector<Inkscape::XML::Node*> to_select;
 
-                    std::vector<SPItem*> selected;
-                    std::vector<Inkscape::XML::Node*> to_select;
+            sp_item_list_to_curves(items, selected, to_select);
 
-                    sp_item_list_to_curves(items, selected, to_select);
+        }
+        if(sp_export_id) {
+            doc->ensureUpToDate();
 
-                }
-                if(sp_export_id) {
-                    doc->ensureUpToDate();
+            // "crop" the document to the specified object, cleaning as we go.
+            SPObject *obj = doc->getObjectById(sp_export_id);
+            Geom::OptRect const bbox(SP_ITEM(obj)->visualBounds());
 
-                    // "crop" the document to the specified object, cleaning as we go.
-                    SPObject *obj = doc->getObjectById(sp_export_id);
-                    Geom::OptRect const bbox(SP_ITEM(obj)->visualBounds());
+            if (bbox) {
+                doc->fitToRect(*bbox, false);
+            }
 
-                    if (bbox) {
-                        doc->fitToRect(*bbox, false);
-                    }
+            if (sp_export_id_only) {
+                // If -j then remove all other objects to complete the "crop"
+                doc->getRoot()->cropToObject(obj);
+            }
+        }
 
-                    if (sp_export_id_only) {
-                        // If -j then remove all other objects to complete the "crop"
-                        doc->getRoot()->cropToObject(obj);
-                    }
-                }
+        Inkscape::Extension::save(Inkscape::Extension::db.get("org.inkscape.output.svg.plain"), doc, sp_export_svg, false,
+                    false, false, Inkscape::Extension::FILE_SAVE_METHOD_SAVE_COPY);
+    }
+    if (sp_export_ps) {
+        retVal |= do_export_ps_pdf(doc, sp_export_ps, "image/x-postscript");
+    }
+    if (sp_export_eps) {
+        retVal |= do_export_ps_pdf(doc, sp_export_eps, "image/x-e-postscript");
+    }
+    if (sp_export_pdf) {
+        retVal |= do_export_ps_pdf(doc, sp_export_pdf, "application/pdf");
+    }
+    if (sp_export_emf) {
+        retVal |= do_export_emf(doc, sp_export_emf, "image/x-emf");
+    }
+    if (sp_export_wmf) {
+        retVal |= do_export_wmf(doc, sp_export_wmf, "image/x-wmf");
+    }
+    if (sp_query_all) {
+        do_query_all (doc);
+    } else if (sp_query_width || sp_query_height) {
+        do_query_dimension (doc, true, sp_query_width? Geom::X : Geom::Y, sp_query_id);
+    } else if (sp_query_x || sp_query_y) {
+        do_query_dimension (doc, false, sp_query_x? Geom::X : Geom::Y, sp_query_id);
+    }
 
-                Inkscape::Extension::save(Inkscape::Extension::db.get("org.inkscape.output.svg.plain"), doc, sp_export_svg, false,
-                            false, false, Inkscape::Extension::FILE_SAVE_METHOD_SAVE_COPY);
-            }
-            if (sp_export_ps) {
-                retVal |= do_export_ps_pdf(doc, sp_export_ps, "image/x-postscript");
-            }
-            if (sp_export_eps) {
-                retVal |= do_export_ps_pdf(doc, sp_export_eps, "image/x-e-postscript");
-            }
-            if (sp_export_pdf) {
-                retVal |= do_export_ps_pdf(doc, sp_export_pdf, "application/pdf");
-            }
-            if (sp_export_emf) {
-                retVal |= do_export_emf(doc, sp_export_emf, "image/x-emf");
-            }
-            if (sp_export_wmf) {
-                retVal |= do_export_wmf(doc, sp_export_wmf, "image/x-wmf");
-            }
-            if (sp_query_all) {
-                do_query_all (doc);
-            } else if (sp_query_width || sp_query_height) {
-                do_query_dimension (doc, true, sp_query_width? Geom::X : Geom::Y, sp_query_id);
-            } else if (sp_query_x || sp_query_y) {
-                do_query_dimension (doc, false, sp_query_x? Geom::X : Geom::Y, sp_query_id);
-            }
+    INKSCAPE.remove_document(doc);
+    return retVal;
+}
 
-            INKSCAPE.remove_document(doc);
+/**
+ * Process file list
+ */
+static int sp_process_file_list(GSList *fl)
+{
+    int retVal = 0;
+#ifdef WITH_DBUS
+    if (!fl) {
+        // If we've been asked to listen for D-Bus messages, enter a main loop here
+        // The main loop may be exited by calling "exit" on the D-Bus application interface.
+        if (sp_dbus_listen) {
+            Gtk::Main main_dbus_loop(0, NULL);
+            main_dbus_loop.run();
+        }
+    }
+#endif // WITH_DBUS
+
+    while (fl) {
+        const gchar *filename = (gchar *)fl->data;
 
+        SPDocument *doc = sp_open_document(filename);
+        if (doc == NULL) {
+            retVal++;
+        } else {
+            retVal |= sp_process_document(doc, filename);
             delete doc;
         }
         fl = g_slist_remove(fl, fl->data);
@@ -1306,6 +1363,402 @@ static int sp_main_shell(char const* command_name)
     return retval;
 }
 
+/// A document kept loaded by the export server, with the state of the file it was read from.
+struct CachedDocument {
+    SPDocument *doc;
+    time_t mtime;
+    off_t size;
+    unsigned long last_use;
+};
+
+typedef std::map<std::string, CachedDocument> DocumentCache;
+typedef std::vector<std::pair<gchar const *, SPDocument *> > DocumentList;
+
+/// Number of documents the export server keeps loaded between commands.
+static const unsigned DOCUMENT_CACHE_SIZE = 32;
+
+static DocumentCache sp_document_cache;
+static unsigned long sp_document_cache_clock = 0;
+
+/**
+ * Return the loaded document for a file, opening it if it was not loaded yet or the file
+ * has changed since. Returns NULL if the document cannot be opened.
+ */
+static SPDocument *sp_get_cached_document(gchar const *filename)
+{
+    struct stat st;
+    if (g_stat(filename, &st) != 0) {
+        g_warning("Specified document %s cannot be opened (does not exist or not a valid SVG file)", filename);
+        return NULL;
+    }
+
+    DocumentCache::iterator i = sp_document_cache.find(filename);
+    if (i != sp_document_cache.end()) {
+        if (i->second.mtime == st.st_mtime && i->second.size == st.st_size) {
+            i->second.last_use = ++sp_document_cache_clock;
+            return i->second.doc;
+        }
+        delete i->second.doc;
+        sp_document_cache.erase(i);
+    }
+
+    SPDocument *doc = sp_open_document(filename);
+    if (doc == NULL) {
+        return NULL;
+    }
+    // Commands start from the updated document instead of each updating it on its own.
+    doc->ensureUpToDate();
+
+    if (sp_document_cache.size() >= DOCUMENT_CACHE_SIZE) {
+        DocumentCache::iterator oldest = sp_document_cache.begin();
+        for (i = sp_document_cache.begin(); i != sp_document_cache.end(); ++i) {
+            if (i->second.last_use < oldest->second.last_use) {
+                oldest = i;
+            }
+        }
+        delete oldest->second.doc;
+        sp_document_cache.erase(oldest);
+    }
+
+    CachedDocument &entry = sp_document_cache[filename];
+    entry.doc = doc;
+    entry.mtime = st.st_mtime;
+    entry.size = st.st_size;
+    entry.last_use = ++sp_document_cache_clock;
+    return doc;
+}
+
+static void sp_clear_document_cache()
+{
+    for (DocumentCache::iterator i = sp_document_cache.begin(); i != sp_document_cache.end(); ++i) {
+        delete i->second.doc;
+    }
+    sp_document_cache.clear();
+}
+
+static void sp_report_export_job(unsigned job, bool ok)
+{
+    fprintf(stdout, "done %u %s\n", job, ok ? "ok" : "failed");
+    fflush(stdout);
+}
+
+#ifdef WIN32
+static void sp_drop_cached_document(gchar const *filename)
+{
+    DocumentCache::iterator i = sp_document_cache.find(filename);
+    if (i != sp_document_cache.end()) {
+        delete i->second.doc;
+        sp_document_cache.erase(i);
+    }
+}
+
+/**
+ * Whether the current command changes the documents it works on instead of only exporting them.
+ */
+static bool sp_command_modifies_document()
+{
+    return sp_vacuum_defs || !Inkscape::CmdLineAction::isEmpty()
+        || (sp_export_svg && (sp_export_text_to_path || sp_export_id));
+}
+
+/**
+ * Process the documents of an export server command in the server itself.
+ * Documents which the command changes are reloaded by the next command using them.
+ */
+static int sp_process_cached_documents(DocumentList const &docs)
+{
+    int retVal = 0;
+    for (DocumentList::const_iterator i = docs.begin(); i != docs.end(); ++i) {
+        retVal |= sp_process_document(i->second, i->first);
+        if (sp_command_modifies_document()) {
+            sp_drop_cached_document(i->first);
+        }
+    }
+    return retVal;
+}
+
+/**
+ * Read the next command line of the export server, without the line end.
+ * Returns false at the end of the input.
+ */
+static bool sp_read_export_command(std::string &line)
+{
+    line.clear();
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), stdin)) {
+        line += buffer;
+        if (line[line.size() - 1] == '\n') {
+            line.erase(line.size() - 1);
+            return true;
+        }
+    }
+    return !line.empty();
+}
+#else
+/**
+ * Report the export server commands which have finished, waiting for them
+ * until at most max_running are left.
+ */
+static void sp_wait_export_jobs(std::map<pid_t, unsigned> &running, unsigned max_running)
+{
+    while (!running.empty()) {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, running.size() > max_running ? 0 : WNOHANG);
+        if (pid == 0) {
+            break;
+        }
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        std::map<pid_t, unsigned>::iterator i = running.find(pid);
+        if (i != running.end()) {
+            sp_report_export_job(i->second, WIFEXITED(status) && WEXITSTATUS(status) == 0);
+            running.erase(i);
+        }
+    }
+}
+
+/// The SIGCHLD handler writes to this pipe, so that the export server wakes up when a command ends.
+static int sp_child_exit_pipe[2] = { -1, -1 };
+
+static void sp_child_exit_handler(int)
+{
+    int saved_errno = errno;
+    char c = 0;
+    if (write(sp_child_exit_pipe[1], &c, 1) < 0) {
+        // The pipe is full, so the server will wake up anyway.
+    }
+    errno = saved_errno;
+}
+
+static bool sp_watch_export_jobs(bool watch)
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    if (!watch) {
+        action.sa_handler = SIG_DFL;
+        sigaction(SIGCHLD, &action, NULL);
+        for (int i = 0; i < 2; ++i) {
+            if (sp_child_exit_pipe[i] >= 0) {
+                close(sp_child_exit_pipe[i]);
+                sp_child_exit_pipe[i] = -1;
+            }
+        }
+        return true;
+    }
+
+    if (pipe(sp_child_exit_pipe) != 0) {
+        return false;
+    }
+    for (int i = 0; i < 2; ++i) {
+        fcntl(sp_child_exit_pipe[i], F_SETFL, fcntl(sp_child_exit_pipe[i], F_GETFL) | O_NONBLOCK);
+        fcntl(sp_child_exit_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+    action.sa_handler = sp_child_exit_handler;
+    action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    return sigaction(SIGCHLD, &action, NULL) == 0;
+}
+
+/**
+ * Read the next command line of the export server, without the line end. input keeps what
+ * was read beyond that line. While waiting for input, the commands which end are reported
+ * right away, so that clients can wait for them without sending anything else.
+ * Returns false at the end of the input or on error.
+ */
+static bool sp_read_export_command(std::string &input, std::string &line, std::map<pid_t, unsigned> &running)
+{
+    std::string::size_type end;
+    while ((end = input.find('\n')) == std::string::npos) {
+        struct pollfd fds[2];
+        fds[0].fd = STDIN_FILENO;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = sp_child_exit_pipe[0];
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            char buffer[64];
+            while (read(sp_child_exit_pipe[0], buffer, sizeof(buffer)) > 0) {
+            }
+            sp_wait_export_jobs(running, running.size());
+        }
+
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            char buffer[4096];
+            ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (n == 0) {
+                if (input.empty()) {
+                    return false;
+                }
+                // the last line has no line end
+                input += '\n';
+            } else {
+                input.append(buffer, n);
+            }
+        }
+    }
+    line.assign(input, 0, end);
+    input.erase(0, end + 1);
+    return true;
+}
+#endif // WIN32
+
+/**
+ * Run the application as an export server. Like the interactive shell, it reads command
+ * lines from stdin, but the documents stay loaded between commands and the commands
+ * run concurrently, each in a process of its own working on a copy of the loaded documents.
+ * The end of each command is reported as soon as it happens as "done N ok" or "done N failed",
+ * where N counts the commands from 1. "wait" waits for all running commands and answers
+ * with "ready".
+ * Returns -1 on error.
+ */
+static int sp_main_export_server(char const* command_name)
+{
+    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+    unsigned max_running = prefs->getIntLimited("/options/threading/numthreads",
+#ifdef HAVE_OPENMP
+                                                omp_get_num_procs(),
+#else
+                                                1,
+#endif // HAVE_OPENMP
+                                                1, 256);
+
+    // Set up the fonts once, so that the commands don't each have to.
+    font_instance *font = font_factory::Default()->FaceFromFontSpecification("sans-serif");
+    if (font) {
+        font->Unref();
+    }
+
+    fprintf(stdout, "Inkscape %s export server mode. Type 'quit' to quit.\n", Inkscape::version_string);
+    fflush(stdout);
+
+    unsigned job = 0;
+    std::string line;
+#ifdef WIN32
+    while (sp_read_export_command(line)) {
+#else
+    std::map<pid_t, unsigned> running;
+    std::string input;
+    if (!sp_watch_export_jobs(true)) {
+        g_warning("Cannot watch the processes of the commands: %s", g_strerror(errno));
+        sp_watch_export_jobs(false);
+        return -1;
+    }
+    while (sp_read_export_command(input, line, running)) {
+#endif // WIN32
+        while (!line.empty() && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1);
+        }
+
+        if (line == "quit") {
+            break;
+        } else if (line == "wait") {
+#ifndef WIN32
+            sp_wait_export_jobs(running, 0);
+#endif // !WIN32
+            fprintf(stdout, "ready\n");
+            fflush(stdout);
+            continue;
+        } else if (line.empty()) {
+            continue;
+        }
+
+        ++job;
+        gchar *command_line = g_strconcat(command_name, " ", line.c_str(), NULL);
+        GError* parseError = 0;
+        gchar** argv = 0;
+        gint argc = 0;
+        if (!g_shell_parse_argv(command_line, &argc, &argv, &parseError)) {
+            g_warning("Cannot parse commandline: %s", line.c_str());
+            g_error_free(parseError);
+            g_free(command_line);
+            sp_report_export_job(job, false);
+            continue;
+        }
+        g_free(command_line);
+
+        poptContext ctx = poptGetContext(NULL, argc, const_cast<const gchar**>(argv), options, 0);
+        GSList *fl = sp_process_args(ctx);
+
+        // The documents are loaded here, so that later commands find them loaded too.
+        DocumentList docs;
+        int failed = 0;
+        for (GSList *i = fl; i; i = i->next) {
+            gchar const *filename = static_cast<gchar const *>(i->data);
+            SPDocument *doc = sp_get_cached_document(filename);
+            if (doc) {
+                docs.push_back(std::make_pair(filename, doc));
+            } else {
+                failed++;
+            }
+        }
+
+#ifdef WIN32
+        failed |= sp_process_cached_documents(docs);
+        sp_report_export_job(job, failed == 0);
+#else
+        if (docs.empty()) {
+            sp_report_export_job(job, failed == 0);
+        } else {
+            sp_wait_export_jobs(running, max_running - 1);
+            fflush(stdout);
+            fflush(stderr);
+            pid_t pid = fork();
+            if (pid == 0) {
+                sp_watch_export_jobs(false);
+                // Changes made by the command stay in this process. Documents which
+                // could not be opened count as failures of the command.
+                for (DocumentList::iterator i = docs.begin(); i != docs.end(); ++i) {
+                    failed |= sp_process_document(i->second, i->first);
+                }
+                fflush(stdout);
+                fflush(stderr);
+                _exit(failed ? 1 : 0);
+            } else if (pid < 0) {
+                // Running the command in the server could start threads, which the
+                // processes of later commands would inherit.
+                g_warning("Cannot start a process for the command: %s", g_strerror(errno));
+                sp_report_export_job(job, false);
+            } else {
+                running[pid] = job;
+            }
+        }
+#endif // WIN32
+
+        for (GSList *i = fl; i; i = i->next) {
+            g_free(i->data);
+        }
+        g_slist_free(fl);
+        poptFreeContext(ctx);
+        resetCommandlineGlobals();
+        g_strfreev(argv);
+    }
+
+#ifndef WIN32
+    sp_wait_export_jobs(running, 0);
+    sp_watch_export_jobs(false);
+#endif // !WIN32
+    sp_clear_document_cache();
+    return 0;
+}
+
 int sp_main_console(int argc, char const **argv)
 {
     /* We are started in text mode */
@@ -1327,7 +1780,7 @@ int sp_main_console(int argc, char const **argv)
     int retVal = sp_common_main( argc, argv, &fl );
     g_return_val_if_fail(retVal == 0, 1);
 
-    if (fl == NULL && !sp_shell
+    if (fl == NULL && !sp_shell && !sp_export_server
 #ifdef WITH_DBUS
         && !sp_dbus_listen
 #endif // WITH_DBUS
@@ -1341,6 +1794,9 @@ int sp_main_console(int argc, char const **argv)
     if (sp_shell) {
         int retVal = sp_main_shell(argv[0]); // Run as interactive shell
         exit((retVal < 0) ? 1 : 0);
+    } else if (sp_export_server) {
+        int retVal = sp_main_export_server(argv[0]);
+        exit((retVal < 0) ? 1 : 0);
     } else {
         int retVal = sp_process_file_list(fl); // Normal command line invokation
         if (retVal){
@@ -1426,6 +1882,48 @@ do_query_all_recurse (SPObject *o)
 }
 
 
+/**
+ * Background color of PNG exports, from the command line or else the page color.
+ */
+static guint32 sp_export_background_color(SPDocument *doc)
+{
+    guint32 bgcolor = 0x00000000;
+    if (sp_export_background) {
+        // override the page color
+        bgcolor = sp_svg_read_color(sp_export_background, 0xffffff00);
+        bgcolor |= 0xff; // default is no opacity
+    } else {
+        // read from namedview
+        Inkscape::XML::Node *nv = sp_repr_lookup_name (doc->rroot, "sodipodi:namedview");
+        if (nv && nv->attribute("pagecolor")){
+            bgcolor = sp_svg_read_color(nv->attribute("pagecolor"), 0xffffff00);
+        }
+        if (nv && nv->attribute("inkscape:pageopacity")){
+            double opacity = 1.0;
+            sp_repr_get_double (nv, "inkscape:pageopacity", &opacity);
+            bgcolor |= SP_COLOR_F_TO_U(opacity);
+        }
+    }
+
+    if (sp_export_background_opacity) {
+        // override opacity
+        gfloat value;
+        if (sp_svg_number_read_f (sp_export_background_opacity, &value)) {
+            if (value > 1.0) {
+                value = CLAMP (value, 1.0f, 255.0f);
+                bgcolor &= (guint32) 0xffffff00;
+                bgcolor |= (guint32) floor(value);
+            } else {
+                value = CLAMP (value, 0.0f, 1.0f);
+                bgcolor &= (guint32) 0xffffff00;
+                bgcolor |= SP_COLOR_F_TO_U(value);
+            }
+        }
+    }
+
+    return bgcolor;
+}
+
 static int sp_do_export_png(SPDocument *doc)
 {
     Glib::ustring filename;
@@ -1585,39 +2083,7 @@ static int sp_do_export_png(SPDocument *doc)
         height = (unsigned long int) (Inkscape::Util::Quantity::convert(area.height(), "px", "in") * dpi + 0.5);
     }
 
-    guint32 bgcolor = 0x00000000;
-    if (sp_export_background) {
-        // override the page color
-        bgcolor = sp_svg_read_color(sp_export_background, 0xffffff00);
-        bgcolor |= 0xff; // default is no opacity
-    } else {
-        // read from namedview
-        Inkscape::XML::Node *nv = sp_repr_lookup_name (doc->rroot, "sodipodi:namedview");
-        if (nv && nv->attribute("pagecolor")){
-            bgcolor = sp_svg_read_color(nv->attribute("pagecolor"), 0xffffff00);
-        }
-        if (nv && nv->attribute("inkscape:pageopacity")){
-            double opacity = 1.0;
-            sp_repr_get_double (nv, "inkscape:pageopacity", &opacity);
-            bgcolor |= SP_COLOR_F_TO_U(opacity);
-        }
-    }
-
-    if (sp_export_background_opacity) {
-        // override opacity
-        gfloat value;
-        if (sp_svg_number_read_f (sp_export_background_opacity, &value)) {
-            if (value > 1.0) {
-                value = CLAMP (value, 1.0f, 255.0f);
-                bgcolor &= (guint32) 0xffffff00;
-                bgcolor |= (guint32) floor(value);
-            } else {
-                value = CLAMP (value, 0.0f, 1.0f);
-                bgcolor &= (guint32) 0xffffff00;
-                bgcolor |= SP_COLOR_F_TO_U(value);
-            }
-        }
-    }
+    guint32 bgcolor = sp_export_background_color(doc);
 
     Glib::ustring path;
     if (filename_from_hint) {
@@ -1664,6 +2130,164 @@ static int sp_do_export_png(SPDocument *doc)
 }
 
 
+/**
+ * Terminate the whitespace separated field at the start of field and return the rest of the line.
+ */
+static gchar *sp_split_field(gchar *field)
+{
+    gchar *rest = field;
+    while (*rest && !g_ascii_isspace(*rest)) {
+        ++rest;
+    }
+    if (*rest) {
+        *rest++ = '\0';
+    }
+    while (g_ascii_isspace(*rest)) {
+        ++rest;
+    }
+    return rest;
+}
+
+static void sp_export_png_batch_done(unsigned job, ExportResult result, void *data)
+{
+    std::vector<SPPngExportJob> const *jobs = static_cast<std::vector<SPPngExportJob> const *>(data);
+    if (result == EXPORT_OK) {
+        g_print("Bitmap saved as: %s\n", (*jobs)[job].filename.c_str());
+    } else {
+        g_warning("Bitmap failed to save to: %s", (*jobs)[job].filename.c_str());
+    }
+}
+
+/**
+ * Export the PNG files listed in the file given with --export-png-batch.
+ *
+ * Each line has the form "OBJECT-ID SIZE FILENAME". OBJECT-ID may be "-" to export the area
+ * given with the other options, like --export-png does. SIZE is the width in pixels,
+ * a resolution such as "300dpi", or "-" for the --export-dpi resolution. Empty lines and
+ * lines starting with '#' are skipped.
+ */
+static int sp_do_export_png_batch(SPDocument *doc)
+{
+    gchar *contents = NULL;
+    GError *error = NULL;
+    if (!g_file_get_contents(sp_export_png_batch_list, &contents, NULL, &error)) {
+        g_warning("Cannot read the export list %s: %s. Nothing exported.", sp_export_png_batch_list, error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    doc->ensureUpToDate();
+
+    gdouble default_dpi = Inkscape::Util::Quantity::convert(1, "in", "px");
+    if (sp_export_dpi) {
+        default_dpi = atof(sp_export_dpi);
+        if ((default_dpi < 0.1) || (default_dpi > 10000.0)) {
+            g_warning("DPI value %s out of range [0.1 - 10000.0]. Nothing exported.", sp_export_dpi);
+            g_free(contents);
+            return 1;
+        }
+    }
+
+    Geom::OptRect default_area;
+    if (sp_export_area) {
+        gdouble x0,y0,x1,y1;
+        if (sscanf(sp_export_area, "%lg:%lg:%lg:%lg", &x0, &y0, &x1, &y1) != 4) {
+            g_warning("Cannot parse export area '%s'; use 'x0:y0:x1:y1'. Nothing exported.", sp_export_area);
+            g_free(contents);
+            return 1;
+        }
+        default_area = Geom::Rect(Geom::Interval(x0,x1), Geom::Interval(y0,y1));
+    } else if (sp_export_area_drawing) {
+        default_area = doc->getRoot()->desktopVisualBounds();
+    } else {
+        Geom::Point origin(doc->getRoot()->x.computed, doc->getRoot()->y.computed);
+        default_area = Geom::Rect(origin, origin + doc->getDimensions());
+    }
+
+    int retcode = 0;
+    std::vector<SPPngExportJob> jobs;
+    gchar **lines = g_strsplit(contents, "\n", -1);
+    for (unsigned n = 0; lines[n]; ++n) {
+        gchar *line = g_strstrip(lines[n]);
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        gchar *id = line;
+        gchar *size = sp_split_field(id);
+        gchar *filename = sp_split_field(size);
+        if (!*filename) {
+            g_warning("Cannot parse line %u of the export list; use 'OBJECT-ID SIZE FILENAME'.", n + 1);
+            retcode = 1;
+            continue;
+        }
+
+        SPPngExportJob job;
+        job.filename = filename;
+        Geom::OptRect area = default_area;
+        if (strcmp(id, "-") != 0) {
+            SPObject *o = doc->getObjectById(id);
+            if (!o || !SP_IS_ITEM(o)) {
+                g_warning("Object with id=\"%s\" was not found or is not a visible item. %s not exported.", id, filename);
+                retcode = 1;
+                continue;
+            }
+            if (!sp_export_area && !sp_export_area_page) {
+                area = sp_export_area_drawing ? doc->getRoot()->desktopVisualBounds()
+                                              : SP_ITEM(o)->desktopVisualBounds();
+            }
+            if (sp_export_id_only) {
+                job.items_only.push_back(SP_ITEM(o));
+            }
+        }
+        if (!area || area->hasZeroArea()) {
+            g_warning("Unable to determine a valid bounding box. %s not exported.", filename);
+            retcode = 1;
+            continue;
+        }
+        job.area = *area;
+        if (sp_export_area_snap) {
+            job.area = job.area.roundOutwards();
+        }
+
+        job.dpi = default_dpi;
+        if (g_str_has_suffix(size, "dpi")) {
+            job.dpi = atof(size);
+        } else if (strcmp(size, "-") != 0) {
+            unsigned long width = strtoul(size, NULL, 0);
+            job.dpi = Inkscape::Util::Quantity::convert(width, "in", "px") / job.area.width();
+        }
+        job.width = (unsigned long int) (Inkscape::Util::Quantity::convert(job.area.width(), "px", "in") * job.dpi + 0.5);
+        job.height = (unsigned long int) (Inkscape::Util::Quantity::convert(job.area.height(), "px", "in") * job.dpi + 0.5);
+        if ((job.width < 1) || (job.height < 1) || (job.width > PNG_UINT_31_MAX) || (job.height > PNG_UINT_31_MAX)) {
+            g_warning("Calculated bitmap dimensions %lu %lu are out of range (1 - %lu). %s not exported.",
+                      job.width, job.height, (unsigned long int)PNG_UINT_31_MAX, filename);
+            retcode = 1;
+            continue;
+        }
+        if (!Inkscape::IO::file_directory_exists(job.filename.c_str())) {
+            g_warning("File path \"%s\" includes directory that doesn't exist.\n", job.filename.c_str());
+            retcode = 1;
+            continue;
+        }
+
+        jobs.push_back(job);
+    }
+    g_strfreev(lines);
+    g_free(contents);
+
+    if (!jobs.empty()) {
+        guint32 bgcolor = sp_export_background_color(doc);
+        g_print("Background RRGGBBAA: %08x\n", bgcolor);
+        g_print("Exporting %u bitmaps\n", (unsigned) jobs.size());
+        if (sp_export_png_batch(doc, jobs, bgcolor, sp_export_png_batch_done, &jobs) > 0) {
+            retcode = 1;
+        }
+    }
+
+    return retcode;
+}
+
+
 /**
  *  Perform a PDF/PS/EPS export
  *
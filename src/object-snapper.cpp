@@ -38,12 +38,71 @@
 #include "desktop.h"
 #include "sp-root.h"
 
+/**
+ * Path of a snap target in document coordinates, with a bounding box tree over its curves
+ * so that only the curves near the snap point have to be examined.
+ *
+ * Instances are kept in the path cache of the snapper until their item is modified or
+ * released, so that snapping to large paths (e.g. traced bitmaps) doesn't require copying,
+ * transforming and indexing them again for every snapping session.
+ */
+class Inkscape::ObjectSnapper::PathIndex {
+public:
+    PathIndex() : stale(true), generation(0) {}
+    ~PathIndex() {
+        _modified_connection.disconnect();
+        _release_connection.disconnect();
+    }
+
+    void set(SPItem *item, Geom::PathVector const &pv, Geom::Affine const &affine) {
+        pathv = pv;
+        pathv *= affine;
+        transform = affine;
+        curves.build(pathv);
+        stale = false;
+
+        _modified_connection.disconnect();
+        _release_connection.disconnect();
+        _modified_connection = item->connectModified(sigc::mem_fun(*this, &PathIndex::_onModified));
+        _release_connection = item->connectRelease(sigc::mem_fun(*this, &PathIndex::_onRelease));
+    }
+
+    Geom::PathVector pathv;
+    Geom::Affine transform;
+    SnapPathIndex curves;
+    bool stale;
+    unsigned generation; ///< last collection of snap targets this path was part of
+
+private:
+    void _onModified(SPObject *, unsigned) {
+        stale = true;
+    }
+    void _onRelease(SPObject *) {
+        stale = true;
+        _modified_connection.disconnect();
+        _release_connection.disconnect();
+    }
+
+    sigc::connection _modified_connection;
+    sigc::connection _release_connection;
+};
+
+namespace {
+
+/// Number of collections of snap targets after which unused cached paths are dropped
+unsigned const PATH_CACHE_GENERATIONS = 16;
+
+} // anonymous namespace
+
 Inkscape::ObjectSnapper::ObjectSnapper(SnapManager *sm, Geom::Coord const d)
     : Snapper(sm, d)
+    , _path_cache_generation(0)
 {
     _candidates = new std::vector<SnapCandidateItem>;
     _points_to_snap_to = new std::vector<SnapCandidatePoint>;
     _paths_to_snap_to = new std::vector<SnapCandidatePath >;
+    _path_indices = new std::vector<PathIndex const *>;
+    _path_cache = new std::map<SPItem const *, PathIndex *>;
 }
 
 Inkscape::ObjectSnapper::~ObjectSnapper()
@@ -56,6 +115,12 @@ Inkscape::ObjectSnapper::~ObjectSnapper()
 
     _clear_paths();
     delete _paths_to_snap_to;
+    delete _path_indices;
+
+    for (std::map<SPItem const *, PathIndex *>::iterator i = _path_cache->begin(); i != _path_cache->end(); ++i) {
+        delete i->second;
+    }
+    delete _path_cache;
 }
 
 Geom::Coord Inkscape::ObjectSnapper::getSnapperTolerance() const
@@ -357,6 +422,7 @@ void Inkscape::ObjectSnapper::_collectPaths(Geom::Point /*p*/,
     // first point and store the collection for later use. This significantly improves the performance
     if (first_point) {
         _clear_paths();
+        _path_cache_generation++;
 
         // Determine the type of bounding box we should snap to
         SPItem::BBoxType bbox_type = SPItem::GEOMETRIC_BBOX;
@@ -376,7 +442,7 @@ void Inkscape::ObjectSnapper::_collectPaths(Geom::Point /*p*/,
         if (_snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_PAGE_BORDER) && _snapmanager->snapprefs.isAnyCategorySnappable()) {
             Geom::PathVector *border_path = _getBorderPathv();
             if (border_path != NULL) {
-                _paths_to_snap_to->push_back(SnapCandidatePath(border_path, SNAPTARGET_PAGE_BORDER, Geom::OptRect()));
+                _addPath(SnapCandidatePath(border_path, SNAPTARGET_PAGE_BORDER, Geom::OptRect()));
             }
         }
 
@@ -408,20 +474,17 @@ void Inkscape::ObjectSnapper::_collectPaths(Geom::Point /*p*/,
                             if (layout != NULL && layout->outputExists()) {
                                 Geom::PathVector *pv = new Geom::PathVector();
                                 pv->push_back(layout->baseline() * root_item->i2dt_affine() * (*i).additional_affine * _snapmanager->getDesktop()->doc2dt());
-                                _paths_to_snap_to->push_back(SnapCandidatePath(pv, SNAPTARGET_TEXT_BASELINE, Geom::OptRect()));
+                                _addPath(SnapCandidatePath(pv, SNAPTARGET_TEXT_BASELINE, Geom::OptRect()));
                             }
                         }
-                    } else {
-                        // Snapping for example to a traced bitmap is very stressing for
-                        // the CPU, so we'll only snap to paths having no more than 500 nodes
-                        // This also leads to a lag of approx. 500 msec (in my lousy test set-up).
-                        bool very_complex_path = false;
-                        SPPath *path = dynamic_cast<SPPath *>(root_item);
-                        if (path) {
-                            very_complex_path = path->nodesInPath() > 500;
-                        }
-
-                        if (!very_complex_path && root_item && _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_PATH, SNAPTARGET_PATH_INTERSECTION)) {
+                    } else if (root_item && _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_PATH, SNAPTARGET_PATH_INTERSECTION)) {
+                        // Paths can be huge (e.g. traced bitmaps), so we keep them transformed and indexed
+                        // between snapping sessions instead of copying them again for each one
+                        Geom::Affine const transform = root_item->i2dt_affine() * (*i).additional_affine * _snapmanager->getDesktop()->doc2dt(); // (_edit_transform * _i2d_transform);
+                        PathIndex *index = _getCachedPath(root_item, transform);
+                        if (index) {
+                            _addPath(SnapCandidatePath(&index->pathv, SNAPTARGET_PATH, Geom::OptRect()), index);
+                        } else {
                             SPCurve *curve = NULL;
                             SPShape *shape = dynamic_cast<SPShape *>(root_item);
                             if (shape) {
@@ -430,14 +493,12 @@ void Inkscape::ObjectSnapper::_collectPaths(Geom::Point /*p*/,
                                curve = te_get_layout(root_item)->convertToCurves();
                             }*/
                             if (curve) {
-                                // We will get our own copy of the pathvector, which must be freed at some point
-
-                                // Geom::PathVector *pv = pathvector_for_curve(root_item, curve, true, true, Geom::identity(), (*i).additional_affine);
-
+                                // The cached path is already in use with a different transform (e.g. a clip path
+                                // shared by several items), so we will get our own copy of the pathvector, which
+                                // must be freed at some point
                                 Geom::PathVector *pv = new Geom::PathVector(curve->get_pathvector());
-                                (*pv) *= root_item->i2dt_affine() * (*i).additional_affine * _snapmanager->getDesktop()->doc2dt(); // (_edit_transform * _i2d_transform);
-
-                                _paths_to_snap_to->push_back(SnapCandidatePath(pv, SNAPTARGET_PATH, Geom::OptRect())); // Perhaps for speed, get a reference to the Geom::pathvector, and store the transformation besides it.
+                                (*pv) *= transform;
+                                _addPath(SnapCandidatePath(pv, SNAPTARGET_PATH, Geom::OptRect()));
                                 curve->unref();
                             }
                         }
@@ -455,12 +516,14 @@ void Inkscape::ObjectSnapper::_collectPaths(Geom::Point /*p*/,
                         if (rect) {
                             Geom::PathVector *path = _getPathvFromRect(*rect);
                             rect = root_item->desktopBounds(bbox_type);
-                            _paths_to_snap_to->push_back(SnapCandidatePath(path, SNAPTARGET_BBOX_EDGE, rect));
+                            _addPath(SnapCandidatePath(path, SNAPTARGET_BBOX_EDGE, rect));
                         }
                     }
                 }
             }
         }
+
+        _pruneCachedPaths();
     }
 }
 
@@ -495,7 +558,7 @@ void Inkscape::ObjectSnapper::_snapPaths(IntermSnapResults &isr,
                                                                true,
                                                                Geom::identity(),
                                                                Geom::identity()); // We will get our own copy of the path, which must be freed at some point
-                _paths_to_snap_to->push_back(SnapCandidatePath(pathv, SNAPTARGET_PATH, Geom::OptRect(), true));
+                _addPath(SnapCandidatePath(pathv, SNAPTARGET_PATH, Geom::OptRect(), true));
                 curve->unref();
             }
         }
@@ -509,70 +572,73 @@ void Inkscape::ObjectSnapper::_snapPaths(IntermSnapResults &isr,
     bool snap_perp = _snapmanager->snapprefs.getSnapPerp();
     bool snap_tang = _snapmanager->snapprefs.getSnapTang();
 
+    // Only curves whose bounding box is within snapping range can be snapped to
+    Geom::Rect snap_area(p_doc, p_doc);
+    snap_area.expandBy(getSnapperTolerance());
+    std::vector<SnapPathIndex::CurveRef> curves;
+    std::vector<unsigned> nearby;
+
     //dt->snapindicator->remove_debugging_points();
-    for (std::vector<SnapCandidatePath >::const_iterator it_p = _paths_to_snap_to->begin(); it_p != _paths_to_snap_to->end(); ++it_p) {
+    for (unsigned k = 0; k < _paths_to_snap_to->size(); ++k) {
+        SnapCandidatePath const *it_p = &(*_paths_to_snap_to)[k];
         if (_allowSourceToSnapToTarget(p.getSourceType(), (*it_p).target_type, strict_snapping)) {
             bool const being_edited = node_tool_active && (*it_p).currently_being_edited;
             //if true then this pathvector it_pv is currently being edited in the node tool
 
-            for(Geom::PathVector::iterator it_pv = (it_p->path_vector)->begin(); it_pv != (it_p->path_vector)->end(); ++it_pv) {
-                // Find a nearest point for each curve within this path
-                // n curves will return n time values with 0 <= t <= 1
-                std::vector<double> anp = (*it_pv).nearestTimePerCurve(p_doc);
-
-                //std::cout << "#nearest points = " << anp.size() << " | p = " << p.getPoint() << std::endl;
-                // Now we will examine each of the nearest points, and determine whether it's within snapping range and if we should snap to it
-                std::vector<double>::const_iterator np = anp.begin();
-                unsigned int index = 0;
-                for (; np != anp.end(); ++np, index++) {
-                    Geom::Curve const *curve = &(it_pv->at(index));
-                    Geom::Point const sp_doc = curve->pointAt(*np);
-                    //dt->snapindicator->set_new_debugging_point(sp_doc*dt->doc2dt());
-                    bool c1 = true;
-                    bool c2 = true;
-                    if (being_edited) {
-                        /* If the path is being edited, then we should only snap though to stationary pieces of the path
-                         * and not to the pieces that are being dragged around. This way we avoid
-                         * self-snapping. For this we check whether the nodes at both ends of the current
-                         * piece are unselected; if they are then this piece must be stationary
-                         */
-                        g_assert(unselected_nodes != NULL);
-                        Geom::Point start_pt = dt->doc2dt(curve->pointAt(0));
-                        Geom::Point end_pt = dt->doc2dt(curve->pointAt(1));
-                        c1 = isUnselectedNode(start_pt, unselected_nodes);
-                        c2 = isUnselectedNode(end_pt, unselected_nodes);
-                        /* Unfortunately, this might yield false positives for coincident nodes. Inkscape might therefore mistakenly
-                         * snap to path segments that are not stationary. There are at least two possible ways to overcome this:
-                         * - Linking the individual nodes of the SPPath we have here, to the nodes of the NodePath::SubPath class as being
-                         *   used in sp_nodepath_selected_nodes_move. This class has a member variable called "selected". For this the nodes
-                         *   should be in the exact same order for both classes, so we can index them
-                         * - Replacing the SPPath being used here by the NodePath::SubPath class; but how?
-                         */
-                    }
+            Geom::PathVector const &pathv = *(it_p->path_vector);
+            SnapPathIndex::findCurves(pathv, _curveIndex(k), snap_area, curves, nearby);
+
+            // Find a nearest point for each curve in range
+            for (std::vector<SnapPathIndex::CurveRef>::const_iterator c = curves.begin(); c != curves.end(); ++c) {
+                unsigned int index = c->curve;
+                Geom::Curve const *curve = &(pathv[c->path][index]);
+                double const np = curve->nearestTime(p_doc);
+                Geom::Point const sp_doc = curve->pointAt(np);
+                //dt->snapindicator->set_new_debugging_point(sp_doc*dt->doc2dt());
+                bool c1 = true;
+                bool c2 = true;
+                if (being_edited) {
+                    /* If the path is being edited, then we should only snap though to stationary pieces of the path
+                     * and not to the pieces that are being dragged around. This way we avoid
+                     * self-snapping. For this we check whether the nodes at both ends of the current
+                     * piece are unselected; if they are then this piece must be stationary
+                     */
+                    g_assert(unselected_nodes != NULL);
+                    Geom::Point start_pt = dt->doc2dt(curve->pointAt(0));
+                    Geom::Point end_pt = dt->doc2dt(curve->pointAt(1));
+                    c1 = isUnselectedNode(start_pt, unselected_nodes);
+                    c2 = isUnselectedNode(end_pt, unselected_nodes);
+                    /* Unfortunately, this might yield false positives for coincident nodes. Inkscape might therefore mistakenly
+                     * snap to path segments that are not stationary. There are at least two possible ways to overcome this:
+                     * - Linking the individual nodes of the SPPath we have here, to the nodes of the NodePath::SubPath class as being
+                     *   used in sp_nodepath_selected_nodes_move. This class has a member variable called "selected". For this the nodes
+                     *   should be in the exact same order for both classes, so we can index them
+                     * - Replacing the SPPath being used here by the NodePath::SubPath class; but how?
+                     */
+                }
 
-                    Geom::Point const sp_dt = dt->doc2dt(sp_doc);
-                    if (!being_edited || (c1 && c2)) {
-                        Geom::Coord dist = Geom::distance(sp_doc, p_doc);
-                        // std::cout << "  dist -> " << dist << std::endl;
-                        if (dist < getSnapperTolerance()) {
-                            // Add the curve we have snapped to
-                            Geom::Point sp_tangent_dt = Geom::Point(0,0);
-                            if (p.getSourceType() == Inkscape::SNAPSOURCE_GUIDE_ORIGIN) {
-                                // We currently only use the tangent when snapping guides, so only in this case we will
-                                // actually calculate the tangent to avoid wasting CPU cycles
-                                Geom::Point sp_tangent_doc = curve->unitTangentAt(*np);
-                                sp_tangent_dt = dt->doc2dt(sp_tangent_doc) - dt->doc2dt(Geom::Point(0,0));
-                            }
-                            isr.curves.push_back(SnappedCurve(sp_dt, sp_tangent_dt, num_path, index, dist, getSnapperTolerance(), getSnapperAlwaysSnap(), false, curve, p.getSourceType(), p.getSourceNum(), it_p->target_type, it_p->target_bbox));
-                            if (snap_tang || snap_perp) {
-                                // For each curve that's within snapping range, we will now also search for tangential and perpendicular snaps
-                                _snapPathsTangPerp(snap_tang, snap_perp, isr, p, curve, dt);
-                            }
+                Geom::Point const sp_dt = dt->doc2dt(sp_doc);
+                if (!being_edited || (c1 && c2)) {
+                    Geom::Coord dist = Geom::distance(sp_doc, p_doc);
+                    // std::cout << "  dist -> " << dist << std::endl;
+                    if (dist < getSnapperTolerance()) {
+                        // Add the curve we have snapped to
+                        Geom::Point sp_tangent_dt = Geom::Point(0,0);
+                        if (p.getSourceType() == Inkscape::SNAPSOURCE_GUIDE_ORIGIN) {
+                            // We currently only use the tangent when snapping guides, so only in this case we will
+                            // actually calculate the tangent to avoid wasting CPU cycles
+                            Geom::Point sp_tangent_doc = curve->unitTangentAt(np);
+                            sp_tangent_dt = dt->doc2dt(sp_tangent_doc) - dt->doc2dt(Geom::Point(0,0));
+                        }
+                        isr.curves.push_back(SnappedCurve(sp_dt, sp_tangent_dt, num_path + c->path, index, dist, getSnapperTolerance(), getSnapperAlwaysSnap(), false, curve, p.getSourceType(), p.getSourceNum(), it_p->target_type, it_p->target_bbox));
+                        if (snap_tang || snap_perp) {
+                            // For each curve that's within snapping range, we will now also search for tangential and perpendicular snaps
+                            _snapPathsTangPerp(snap_tang, snap_perp, isr, p, curve, dt);
                         }
                     }
                 }
-                num_path++;
-            } // End of: for (Geom::PathVector::iterator ....)
+            }
+            num_path += pathv.size();
         }
     }
 }
@@ -641,11 +707,11 @@ void Inkscape::ObjectSnapper::_snapPathsConstrained(IntermSnapResults &isr,
     bool strict_snapping = _snapmanager->snapprefs.getStrictSnapping();
 
     // Find all intersections of the constrained path with the snap target candidates
-    std::vector<Geom::Point> intersections;
-    for (std::vector<SnapCandidatePath >::const_iterator k = _paths_to_snap_to->begin(); k != _paths_to_snap_to->end(); ++k) {
+    for (unsigned n = 0; n < _paths_to_snap_to->size(); ++n) {
+        SnapCandidatePath const *k = &(*_paths_to_snap_to)[n];
         if (k->path_vector && _allowSourceToSnapToTarget(p.getSourceType(), (*k).target_type, strict_snapping)) {
-            // Do the intersection math
-            std::vector<Geom::PVIntersection> inters = constraint_path.intersect(*(k->path_vector));
+            // Do the intersection math, but only for the curves near the constraint
+            std::vector<Geom::PVIntersection> inters = SnapPathIndex::intersect(constraint_path.front(), *(k->path_vector), _curveIndex(n));
 
             // Convert the collected intersections to snapped points
             for (std::vector<Geom::PVIntersection>::const_iterator i = inters.begin(); i != inters.end(); ++i) {
@@ -741,12 +807,74 @@ bool Inkscape::ObjectSnapper::ThisSnapperMightSnap() const
     return true;
 }
 
+void Inkscape::ObjectSnapper::_addPath(SnapCandidatePath const &path, PathIndex const *index) const
+{
+    _paths_to_snap_to->push_back(path);
+    _path_indices->push_back(index);
+}
+
+/// Returns the curve index of the n-th path to snap to, or NULL if it must be searched linearly
+Inkscape::SnapPathIndex const *Inkscape::ObjectSnapper::_curveIndex(unsigned n) const
+{
+    PathIndex const *index = (*_path_indices)[n];
+    return index ? &index->curves : NULL;
+}
+
+/**
+ * Returns the path of an item transformed to document coordinates, from the path cache if it's still
+ * valid. Returns NULL if the item has no path, or if its cached path is already being used in the
+ * current collection of snap targets with a different transform.
+ */
+Inkscape::ObjectSnapper::PathIndex *Inkscape::ObjectSnapper::_getCachedPath(SPItem *item, Geom::Affine const &transform) const
+{
+    SPShape *shape = dynamic_cast<SPShape *>(item);
+    if (!shape) {
+        return NULL;
+    }
+
+    PathIndex *&index = (*_path_cache)[item];
+    if (index == NULL) {
+        index = new PathIndex();
+    } else if (index->generation == _path_cache_generation) {
+        return index->transform == transform ? index : NULL;
+    }
+
+    if (index->stale || index->transform != transform) {
+        SPCurve *curve = shape->getCurve();
+        if (!curve) {
+            return NULL;
+        }
+        index->set(item, curve->get_pathvector(), transform);
+        curve->unref();
+    }
+    index->generation = _path_cache_generation;
+    return index;
+}
+
+/// Drops the cached paths that haven't been snapped to for a while
+void Inkscape::ObjectSnapper::_pruneCachedPaths() const
+{
+    std::map<SPItem const *, PathIndex *>::iterator i = _path_cache->begin();
+    while (i != _path_cache->end()) {
+        if (i->second->stale || _path_cache_generation - i->second->generation > PATH_CACHE_GENERATIONS) {
+            delete i->second;
+            _path_cache->erase(i++);
+        } else {
+            ++i;
+        }
+    }
+}
+
 void Inkscape::ObjectSnapper::_clear_paths() const
 {
-    for (std::vector<SnapCandidatePath >::const_iterator k = _paths_to_snap_to->begin(); k != _paths_to_snap_to->end(); ++k) {
-        delete k->path_vector;
+    for (unsigned k = 0; k < _paths_to_snap_to->size(); ++k) {
+        if ((*_path_indices)[k] == NULL) {
+            // cached paths are owned by the path cache
+            delete (*_paths_to_snap_to)[k].path_vector;
+        }
     }
     _paths_to_snap_to->clear();
+    _path_indices->clear();
 }
 
 Geom::PathVector* Inkscape::ObjectSnapper::_getBorderPathv() const
@@ -10,10 +10,13 @@
  * Released under GNU GPL, read the file 'COPYING' for more information
  */
 
+#include <map>
+
 #include "snapper.h"
 #include "sp-path.h"
 #include "splivarot.h"
 #include "snap-candidate.h"
+#include "snap-path-index.h"
 
 class SPNamedView;
 class  SPItem;
@@ -63,6 +66,13 @@ private:
     std::vector<SnapCandidatePoint> *_points_to_snap_to;
     std::vector<SnapCandidatePath > *_paths_to_snap_to;
 
+    class PathIndex;
+    /// Index over the curves of each path in _paths_to_snap_to, or NULL if it must be searched linearly
+    std::vector<PathIndex const *> *_path_indices;
+    /// Transformed and indexed paths of the items we snapped to recently, kept between snapping sessions
+    std::map<SPItem const *, PathIndex *> *_path_cache;
+    mutable unsigned _path_cache_generation;
+
     /**
      * Find all items within snapping range.
      * @param parent Pointer to the document's root, or to a clipped path or mask object.
@@ -116,6 +126,10 @@ private:
                       Inkscape::SnapSourceType const source_type,
                       bool const &first_point) const;
 
+    void _addPath(SnapCandidatePath const &path, PathIndex const *index = NULL) const;
+    SnapPathIndex const *_curveIndex(unsigned n) const;
+    PathIndex *_getCachedPath(SPItem *item, Geom::Affine const &transform) const;
+    void _pruneCachedPaths() const;
     void _clear_paths() const;
     Geom::PathVector* _getBorderPathv() const;
     Geom::PathVector* _getPathvFromRect(Geom::Rect const rect) const;
@@ -233,7 +233,7 @@ static char const preferences_skeleton[] =
 "  </group>\n"
 "\n"
 "  <group id=\"options\">\n"
-"    <group id=\"renderingcache\" size=\"64\" />"
+"    <group id=\"renderingcache\" size=\"64\" glyphs=\"16\" />"
 "    <group id=\"useoldpdfexporter\" value=\"0\" />"
 "    <group id=\"highlightoriginal\" value=\"1\" />"
 "    <group id=\"relinkclonesonduplicate\" value=\"0\" />"
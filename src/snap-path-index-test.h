@@ -0,0 +1,215 @@
+#ifndef SEEN_SNAP_PATH_INDEX_TEST_H
+#define SEEN_SNAP_PATH_INDEX_TEST_H
+
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+
+#include <2geom/circle.h>
+#include <2geom/path-sink.h>
+#include <2geom/pathvector.h>
+#include "snap-path-index.h"
+
+using Inkscape::SnapPathIndex;
+
+class SnapPathIndexTest : public CxxTest::TestSuite {
+private:
+    Geom::PathVector _pathv;
+    SnapPathIndex _index;
+    Geom::PathVector _polygons;
+    SnapPathIndex _polygon_index;
+
+    static double random(double lo, double hi) {
+        return lo + (hi - lo) * (std::rand() % 10000) / 10000.0;
+    }
+
+    static Geom::Point randomPoint() {
+        return Geom::Point(random(0, 100), random(0, 100));
+    }
+
+    /// A closed, wiggly loop around a random centre, of lines and possibly cubic Béziers.
+    static Geom::Path randomLoop(unsigned nodes, bool curved) {
+        Geom::Point const centre(random(20, 80), random(20, 80));
+        double const radius = random(5, 20);
+        std::vector<Geom::Point> points;
+        for (unsigned i = 0; i < nodes; ++i) {
+            double const angle = 2 * M_PI * i / nodes;
+            points.push_back(centre + Geom::Point::polar(angle, radius * random(0.8, 1.2)));
+        }
+        Geom::Path path(points[0]);
+        for (unsigned i = 1; i <= nodes; ++i) {
+            Geom::Point const &a = points[i - 1];
+            Geom::Point const &b = points[i % nodes];
+            if (!curved || std::rand() % 2) {
+                path.appendNew<Geom::LineSegment>(b);
+            } else {
+                path.appendNew<Geom::CubicBezier>(a + Geom::Point(random(-1, 1), random(-1, 1)),
+                                                  b + Geom::Point(random(-1, 1), random(-1, 1)), b);
+            }
+        }
+        path.close();
+        return path;
+    }
+
+    /// The nearest points within tolerance, from the curves of the index.
+    static std::vector<Geom::PathVectorTime> nearest(Geom::PathVector const &pathv, SnapPathIndex const *index,
+                                                     Geom::Point const &p, double tolerance) {
+        Geom::Rect area(p, p);
+        area.expandBy(tolerance);
+        std::vector<SnapPathIndex::CurveRef> curves;
+        std::vector<unsigned> scratch;
+        SnapPathIndex::findCurves(pathv, index, area, curves, scratch);
+        std::vector<Geom::PathVectorTime> result;
+        for (std::vector<SnapPathIndex::CurveRef>::const_iterator c = curves.begin(); c != curves.end(); ++c) {
+            Geom::Curve const &curve = pathv[c->path][c->curve];
+            double const t = curve.nearestTime(p);
+            if (Geom::distance(curve.pointAt(t), p) < tolerance) {
+                result.push_back(Geom::PathVectorTime(c->path, c->curve, t));
+            }
+        }
+        return result;
+    }
+
+    /// The nearest points within tolerance, searching all curves as the snapper used to.
+    static std::vector<Geom::PathVectorTime> nearestLinear(Geom::PathVector const &pathv, Geom::Point const &p,
+                                                           double tolerance) {
+        std::vector<Geom::PathVectorTime> result;
+        for (unsigned i = 0; i < pathv.size(); ++i) {
+            std::vector<double> anp = pathv[i].nearestTimePerCurve(p);
+            for (unsigned j = 0; j < anp.size(); ++j) {
+                if (Geom::distance(pathv[i][j].pointAt(anp[j]), p) < tolerance) {
+                    result.push_back(Geom::PathVectorTime(i, j, anp[j]));
+                }
+            }
+        }
+        return result;
+    }
+
+    static void assertSameTimes(std::vector<Geom::PathVectorTime> const &a, std::vector<Geom::PathVectorTime> const &b) {
+        TS_ASSERT_EQUALS(a.size(), b.size());
+        for (unsigned i = 0; i < a.size() && i < b.size(); ++i) {
+            TS_ASSERT(a[i] == b[i]);
+        }
+    }
+
+    /// Intersections at a node are found on both curves, which can give slightly different
+    /// points; either of them may be kept.
+    static void assertSameIntersections(std::vector<Geom::PVIntersection> const &a,
+                                        std::vector<Geom::PVIntersection> const &b) {
+        TS_ASSERT_EQUALS(a.size(), b.size());
+        for (unsigned i = 0; i < a.size() && i < b.size(); ++i) {
+            TS_ASSERT(a[i].first == b[i].first);
+            TS_ASSERT(a[i].second == b[i].second);
+            TS_ASSERT_LESS_THAN(Geom::distance(a[i].point(), b[i].point()), 1e-6);
+        }
+    }
+
+    /// Compares the intersections with the ones of Geom::PathVector::intersect(), which the
+    /// snapper used before, and with a linear search.
+    static void assertSameAsLinear(Geom::Path const &constraint, Geom::PathVector const &pathv, SnapPathIndex const &index) {
+        Geom::PathVector constraint_path(constraint);
+        std::vector<Geom::PVIntersection> expected = constraint_path.intersect(pathv);
+        assertSameIntersections(SnapPathIndex::intersect(constraint, pathv, &index), expected);
+        assertSameIntersections(SnapPathIndex::intersect(constraint, pathv, NULL), expected);
+    }
+
+public:
+    // 8 overlapping loops of 80 nodes each, so that constraints cross several of them.
+    // Circular constraints only go with the polygons, as 2geom's intersections of elliptical
+    // arcs with cubic Béziers can fail its own precision assertions.
+    SnapPathIndexTest() {
+        std::srand(1);
+        for (unsigned i = 0; i < 8; ++i) {
+            _pathv.push_back(randomLoop(80, true));
+            _polygons.push_back(randomLoop(80, false));
+        }
+        _index.build(_pathv);
+        _polygon_index.build(_polygons);
+    }
+    virtual ~SnapPathIndexTest() {}
+
+    static SnapPathIndexTest *createSuite() { return new SnapPathIndexTest(); }
+    static void destroySuite( SnapPathIndexTest *suite ) { delete suite; }
+
+    void testNodeCount()
+    {
+        // one node per curve, as the loops are closed
+        TS_ASSERT_LESS_THAN(500u, _pathv.curveCount());
+        TS_ASSERT_LESS_THAN(500u, _polygons.curveCount());
+    }
+
+    void testFreeSnap()
+    {
+        std::srand(2);
+        unsigned snapped = 0;
+        for (int i = 0; i < 500; ++i) {
+            Geom::Point const p = randomPoint();
+            std::vector<Geom::PathVectorTime> expected = nearestLinear(_pathv, p, 1);
+            snapped += !expected.empty();
+            assertSameTimes(nearest(_pathv, &_index, p, 1), expected);
+            assertSameTimes(nearest(_pathv, NULL, p, 1), expected);
+        }
+        TS_ASSERT_LESS_THAN(50u, snapped);
+    }
+
+    void testConstrainedSnap()
+    {
+        std::srand(3);
+        for (int i = 0; i < 200; ++i) {
+            // as long as the snapper's constraints, or across the whole drawing
+            Geom::Point const p = randomPoint();
+            double const length = (i % 2) ? 2 : 100;
+            Geom::Path line(p);
+            line.appendNew<Geom::LineSegment>(p + Geom::Point::polar(random(0, 2 * M_PI), length));
+            assertSameAsLinear(line, _pathv, _index);
+            assertSameAsLinear(line, _polygons, _polygon_index);
+        }
+        for (int i = 0; i < 100; ++i) {
+            Geom::PathBuilder pb;
+            pb.feed(Geom::Circle(randomPoint(), random(0.5, 30)));
+            pb.flush();
+            assertSameAsLinear(pb.peek().front(), _polygons, _polygon_index);
+        }
+    }
+
+    void testManySnaps()
+    {
+        std::srand(4);
+        std::vector<Geom::Point> points;
+        for (int i = 0; i < 2000; ++i) {
+            points.push_back(randomPoint());
+        }
+        TS_TRACE("Benchmarking free snaps...");
+        unsigned indexed = 0;
+        clock_t begin = clock();
+        for (unsigned i = 0; i < points.size(); ++i) {
+            indexed += nearest(_pathv, &_index, points[i], 1).size();
+        }
+        clock_t end = clock();
+        std::cout << "Took " << double(end - begin) / double(CLOCKS_PER_SEC) << " seconds to snap 2000 points with the index\n";
+        unsigned linear = 0;
+        begin = clock();
+        for (unsigned i = 0; i < points.size(); ++i) {
+            linear += nearestLinear(_pathv, points[i], 1).size();
+        }
+        end = clock();
+        std::cout << "Took " << double(end - begin) / double(CLOCKS_PER_SEC) << " seconds to snap 2000 points linearly\n";
+        TS_ASSERT_EQUALS(indexed, linear);
+    }
+};
+
+#endif // SEEN_SNAP_PATH_INDEX_TEST_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
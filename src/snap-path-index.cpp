@@ -0,0 +1,104 @@
+/**
+ *    \file src/snap-path-index.cpp
+ *    SnapPathIndex class.
+ *
+ *    Copyright (C) 2016 Authors
+ *
+ *    Released under GNU GPL, read the file 'COPYING' for more information.
+ */
+
+#include "snap-path-index.h"
+#include <algorithm>
+
+namespace {
+
+/// Groups the intersections by subpath of the path snapped to, like Geom::PathVector::intersect()
+bool by_target_path(Geom::PVIntersection const &a, Geom::PVIntersection const &b)
+{
+    if (a.second.path_index != b.second.path_index) {
+        return a.second.path_index < b.second.path_index;
+    }
+    return a < b;
+}
+
+} // anonymous namespace
+
+void Inkscape::SnapPathIndex::build(Geom::PathVector const &pathv)
+{
+    _curves.clear();
+    for (unsigned i = 0; i < pathv.size(); ++i) {
+        for (unsigned j = 0; j < pathv[i].size_default(); ++j) {
+            CurveRef ref;
+            ref.path = i;
+            ref.curve = j;
+            _curves.add(ref, pathv[i][j].boundsFast());
+        }
+    }
+    _curves.build();
+}
+
+void Inkscape::SnapPathIndex::findCurves(Geom::PathVector const &pathv,
+                                         SnapPathIndex const *index,
+                                         Geom::Rect const &area,
+                                         std::vector<CurveRef> &curves,
+                                         std::vector<unsigned> &scratch)
+{
+    curves.clear();
+    if (index) {
+        scratch.clear();
+        index->_curves.intersecting(area, scratch);
+        for (std::vector<unsigned>::const_iterator i = scratch.begin(); i != scratch.end(); ++i) {
+            curves.push_back(index->_curves.value(*i));
+        }
+        return;
+    }
+
+    for (unsigned i = 0; i < pathv.size(); ++i) {
+        for (unsigned j = 0; j < pathv[i].size_default(); ++j) {
+            if (pathv[i][j].boundsFast().intersects(area)) {
+                CurveRef ref;
+                ref.path = i;
+                ref.curve = j;
+                curves.push_back(ref);
+            }
+        }
+    }
+}
+
+std::vector<Geom::PVIntersection> Inkscape::SnapPathIndex::intersect(Geom::Path const &constraint,
+                                                                     Geom::PathVector const &pathv,
+                                                                     SnapPathIndex const *index)
+{
+    std::vector<Geom::PVIntersection> result;
+    std::vector<CurveRef> curves;
+    std::vector<unsigned> scratch;
+    for (unsigned j = 0; j < constraint.size(); ++j) {
+        // Only the curves overlapping this piece of the constraint can intersect it
+        findCurves(pathv, index, constraint[j].boundsFast(), curves, scratch);
+        for (std::vector<CurveRef>::const_iterator c = curves.begin(); c != curves.end(); ++c) {
+            std::vector<Geom::CurveIntersection> cx = constraint[j].intersect(pathv[c->path][c->curve]);
+            for (std::vector<Geom::CurveIntersection>::const_iterator x = cx.begin(); x != cx.end(); ++x) {
+                Geom::PathVectorTime a(0, j, x->first);
+                Geom::PathVectorTime b(c->path, c->curve, x->second);
+                // Like Geom::Path::intersect(), report intersections at the nodes only once
+                a.normalizeForward(constraint.size());
+                b.normalizeForward(pathv[c->path].size());
+                result.push_back(Geom::PVIntersection(a, b, x->point()));
+            }
+        }
+    }
+    std::sort(result.begin(), result.end(), by_target_path);
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,76 @@
+#ifndef SEEN_SNAP_PATH_INDEX_H
+#define SEEN_SNAP_PATH_INDEX_H
+
+/**
+ *    \file src/snap-path-index.h
+ *    \brief SnapPathIndex class.
+ *
+ *    Copyright (C) 2016 Authors
+ *
+ *    Released under GNU GPL, read the file 'COPYING' for more information.
+ */
+
+#include <vector>
+#include <2geom/pathvector.h>
+#include <2geom/rect.h>
+
+#include "util/bounding-box-tree.h"
+
+namespace Inkscape
+{
+
+/**
+ * Bounding box tree over the curves of a path vector, so that snapping to a large path only has
+ * to examine the curves near the snap point or the constraint.
+ *
+ * The queries take the index as a pointer and search the path vector linearly when it is NULL,
+ * with the same results.
+ */
+class SnapPathIndex
+{
+public:
+    /// Position of a curve within a path vector
+    struct CurveRef {
+        unsigned path;
+        unsigned curve;
+    };
+
+    void build(Geom::PathVector const &pathv);
+
+    /**
+     * Finds the curves of a path vector whose bounding box intersects the given area. The curves
+     * are returned in path order.
+     */
+    static void findCurves(Geom::PathVector const &pathv,
+                           SnapPathIndex const *index,
+                           Geom::Rect const &area,
+                           std::vector<CurveRef> &curves,
+                           std::vector<unsigned> &scratch);
+
+    /**
+     * Finds the intersections of a constraint with a path vector, in the order in which
+     * Geom::PathVector::intersect() returns them: by subpath of the path vector, then along the
+     * constraint. Intersections at nodes are reported only once.
+     */
+    static std::vector<Geom::PVIntersection> intersect(Geom::Path const &constraint,
+                                                       Geom::PathVector const &pathv,
+                                                       SnapPathIndex const *index);
+
+private:
+    Inkscape::Util::BoundingBoxTree<CurveRef> _curves;
+};
+
+} // end of namespace Inkscape
+
+#endif
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -46,6 +46,8 @@
 #include "ui/tools-switch.h"
 #include "ui/tools/node-tool.h"
 #include "ui/tools/tool-base.h"
+#include "debug/logger.h"
+#include "debug/simple-event.h"
 
 #include <algorithm>
 
@@ -112,6 +114,7 @@ void SPLPEItem::set(unsigned int key, gchar const* value) {
         case SP_ATTR_INKSCAPE_PATH_EFFECT:
             {
                 this->current_path_effect = NULL;
+                this->_lpe_stages.clear();
 
                 // Disable the path effects while populating the LPE list
                  sp_lpe_item_enable_path_effects(this, false);
@@ -206,8 +209,27 @@ Inkscape::XML::Node* SPLPEItem::write(Inkscape::XML::Document *xml_doc, Inkscape
     return repr;
 }
 
+namespace {
+
+class PathEffectEvent : public Inkscape::Debug::SimpleEvent<Inkscape::Debug::Event::OTHER> {
+public:
+    PathEffectEvent(Inkscape::LivePathEffect::Effect const *lpe, bool cached, gint64 microseconds)
+    : SimpleEvent<Inkscape::Debug::Event::OTHER>(Inkscape::Util::share_static_string("path-effect"))
+    {
+        _addProperty("effect", Inkscape::LivePathEffect::LPETypeConverter.get_key(lpe->effectType()).c_str());
+        _addProperty("cached", cached ? "true" : "false");
+        _addProperty("microseconds", long(microseconds));
+    }
+};
+
+}
+
 /**
  * returns true when LPE was successful.
+ *
+ * The output of each cacheable effect is kept, and reused as long as the effect gets the same
+ * input path and its parameters hash the same, so that editing one effect of a stack (or the
+ * parameters of the last ones) only reruns the effects from there on.
  */
 bool SPLPEItem::performPathEffect(SPCurve *curve) {
     if (!this) {
@@ -219,6 +241,14 @@ bool SPLPEItem::performPathEffect(SPCurve *curve) {
     }
 
     if (this->hasPathEffect() && this->pathEffectsEnabled()) {
+        // Groups run the stack once per child, with doBeforeEffect called only once for all of them
+        bool const use_cache = !SP_IS_GROUP(this);
+        if (!use_cache || curve->get_pathvector() != _lpe_original) {
+            _lpe_stages.clear();
+            _lpe_original = use_cache ? curve->get_pathvector() : Geom::PathVector();
+        }
+
+        unsigned stage = 0;
         for (PathEffectList::iterator it = this->path_effect_list->begin(); it != this->path_effect_list->end(); ++it)
         {
             LivePathEffectObject *lpeobj = (*it)->lpeobject;
@@ -227,6 +257,7 @@ bool SPLPEItem::performPathEffect(SPCurve *curve) {
                  * For example, this happens when copy pasting an object with LPE applied. Probably because the object is pasted while the effect is not yet pasted to defs, and cannot be found.
                  */
                 g_warning("SPLPEItem::performPathEffect - NULL lpeobj in list!");
+                _lpe_stages.resize(stage);
                 return false;
             }
             Inkscape::LivePathEffect::Effect *lpe = lpeobj->get_lpe();
@@ -235,6 +266,7 @@ bool SPLPEItem::performPathEffect(SPCurve *curve) {
                  * Not sure, but I think this can happen when an unknown effect type is specified...
                  */
                 g_warning("SPLPEItem::performPathEffect - lpeobj with invalid lpe in the stack!");
+                _lpe_stages.resize(stage);
                 return false;
             }
 
@@ -242,9 +274,28 @@ bool SPLPEItem::performPathEffect(SPCurve *curve) {
                 if (lpe->acceptsNumClicks() > 0 && !lpe->isReady()) {
                     // if the effect expects mouse input before being applied and the input is not finished
                     // yet, we don't alter the path
+                    _lpe_stages.resize(stage);
                     return false;
                 }
 
+                gint64 const start = g_get_monotonic_time();
+
+                // An effect shared with other items keeps state about the last one it ran on
+                // (its helper paths, its knots), so it is only skipped when it is not shared.
+                bool const cacheable = use_cache && lpe->isCacheable() && lpeobj->hrefcount <= 1;
+                guint64 const params = cacheable ? lpe->hashParams() : 0;
+                if (cacheable && stage < _lpe_stages.size() && _lpe_stages[stage].effect == lpe
+                    && _lpe_stages[stage].params == params && _lpe_stages[stage].input == curve->get_pathvector())
+                {
+                    curve->set_pathvector(_lpe_stages[stage].output);
+                    ++stage;
+                    Inkscape::Debug::Logger::write<PathEffectEvent>(lpe, true, g_get_monotonic_time() - start);
+                    continue;
+                }
+                // everything after a recomputed stage has a new input
+                _lpe_stages.resize(stage);
+                Geom::PathVector const input = cacheable ? curve->get_pathvector() : Geom::PathVector();
+
                 // Groups have their doBeforeEffect called elsewhere
                 if (!SP_IS_GROUP(this)) {
                     lpe->doBeforeEffect_impl(this);
@@ -259,13 +310,28 @@ bool SPLPEItem::performPathEffect(SPCurve *curve) {
                         SP_ACTIVE_DESKTOP->messageStack()->flash( Inkscape::WARNING_MESSAGE,
                                         _("An exception occurred during execution of the Path Effect.") );
                     }
+                    _lpe_stages.resize(stage);
                     return false;
                 }
                 if (!SP_IS_GROUP(this)) {
                     lpe->doAfterEffect(this);
                 }
+
+                if (use_cache) {
+                    PathEffectStage result;
+                    result.effect = cacheable ? lpe : NULL;
+                    result.params = params;
+                    result.input = input;
+                    if (cacheable) {
+                        result.output = curve->get_pathvector();
+                    }
+                    _lpe_stages.push_back(result);
+                    ++stage;
+                }
+                Inkscape::Debug::Logger::write<PathEffectEvent>(lpe, false, g_get_monotonic_time() - start);
             }
         }
+        _lpe_stages.resize(stage);
     }
 
     return true;
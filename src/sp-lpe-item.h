@@ -16,6 +16,8 @@
 
 #include <list>
 #include <string>
+#include <vector>
+#include <2geom/pathvector.h>
 #include "sp-item.h"
 
 #define SP_LPE_ITEM(obj) (dynamic_cast<SPLPEItem*>((SPObject*)obj))
@@ -97,6 +99,18 @@ public:
     bool forkPathEffectsIfNecessary(unsigned int nr_of_allowed_users = 1);
 
     void editNextParamOncanvas(SPDesktop *dt);
+
+private:
+    /// Result of one effect of the stack, kept to skip it while its input does not change.
+    struct PathEffectStage {
+        Inkscape::LivePathEffect::Effect const *effect; ///< NULL if the effect is not cacheable
+        guint64 params;
+        Geom::PathVector input;
+        Geom::PathVector output;
+    };
+
+    std::vector<PathEffectStage> _lpe_stages;
+    Geom::PathVector _lpe_original; ///< path the stages were computed from
 };
 
 void sp_lpe_item_update_patheffect (SPLPEItem *lpeitem, bool wholetree, bool write); // careful, class already has method with *very* similar name!
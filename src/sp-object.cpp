@@ -40,6 +40,7 @@
 #include "util/share.h"
 #include "util/format.h"
 #include "util/longest-common-suffix.h"
+#include "libcroco/cr-sel-eng.h"
 
 using std::memcpy;
 using std::strchr;
@@ -971,12 +972,46 @@ void SPObject::readAttr(gchar const *key)
     }
 }
 
+/**
+ * Reads the style of an object again after the style sheet rules matching it may have changed,
+ * and if descendants is true, the styles of its descendants.
+ */
+static void sp_object_reread_style(SPObject *object, bool descendants)
+{
+    if (object->style) {
+        object->style->readFromObject(object);
+        object->requestDisplayUpdate(SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_STYLE_MODIFIED_FLAG);
+    }
+    if (descendants) {
+        for (SPObject *child = object->firstChild(); child; child = child->getNext()) {
+            sp_object_reread_style(child, true);
+        }
+    }
+}
+
 void SPObject::repr_attr_changed(Inkscape::XML::Node * /*repr*/, gchar const *key, gchar const * /*oldval*/, gchar const * /*newval*/, bool is_interactive, gpointer data)
 {
     SPObject *object = SP_OBJECT(data);
 
     object->readAttr(key);
 
+    // Style sheet rules can select on these, without any style property having changed. Through
+    // combinators, they also select the descendants and following siblings.
+    CRStyleSheet *sheet = NULL;
+    if ((!strcmp(key, "class") || !strcmp(key, "id")) && object->style && object->document) {
+        sheet = cr_cascade_get_sheet(object->document->style_cascade, ORIGIN_AUTHOR);
+    }
+    if (sheet) {
+        guint combinators = cr_sel_eng_get_combinators(sheet);
+        bool descendants = combinators & ((1 << COMB_WS) | (1 << COMB_GT));
+        sp_object_reread_style(object, descendants);
+        if (combinators & (1 << COMB_PLUS)) {
+            for (SPObject *sibling = object->getNext(); sibling; sibling = sibling->getNext()) {
+                sp_object_reread_style(sibling, descendants);
+            }
+        }
+    }
+
     // manual changes to extension attributes require the normal
     // attributes, which depend on them, to be updated immediately
     if (is_interactive) {
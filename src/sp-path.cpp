@@ -303,6 +303,7 @@ Geom::Affine SPPath::set_transform(Geom::Affine const &transform) {
         }
     } else {
         _curve->transform(transform);
+        _curve_change = CURVE_REPLACED;
     }
 
     // Adjust stroke
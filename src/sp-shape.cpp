@@ -62,6 +62,7 @@ SPShape::SPShape() : SPLPEItem() {
 
     this->_curve = NULL;
     this->_curve_before_lpe = NULL;
+    this->_curve_change = CURVE_REPLACED;
 }
 
 SPShape::~SPShape() {
@@ -166,9 +167,17 @@ void SPShape::update(SPCtx* ctx, guint flags) {
             Inkscape::DrawingShape *sh = dynamic_cast<Inkscape::DrawingShape *>(v->arenaitem);
 
             if (flags & SP_OBJECT_MODIFIED_FLAG) {
-                sh->setPath(this->_curve);
+                if (_curve_change == CURVE_PARTIAL) {
+                    sh->setPath(this->_curve, _curve_changed);
+                } else {
+                    sh->setPath(this->_curve);
+                }
             }
         }
+        if (flags & SP_OBJECT_MODIFIED_FLAG) {
+            _curve_change = CURVE_UNCHANGED;
+            _curve_changed = Geom::OptRect();
+        }
     }
 
     if (this->hasMarkers ()) {
@@ -998,10 +1007,31 @@ void SPShape::setCurve(SPCurve *new_curve, unsigned int owner)
             _curve = new_curve->copy();
         }
     }
+    _curve_change = CURVE_REPLACED;
 
     this->requestDisplayUpdate(SP_OBJECT_MODIFIED_FLAG);
 }
 
+/**
+ * Same as setCurve, for a curve that differs from the current one only within
+ * the changed rectangle (in user units), or not at all if it is empty.
+ * The views then only redraw that area.
+ */
+void SPShape::setCurve(SPCurve *new_curve, unsigned int owner, Geom::OptRect const &changed)
+{
+    CurveChange change = _curve_change;
+    setCurve(new_curve, owner);
+    if (!new_curve || change == CURVE_REPLACED) {
+        return;
+    }
+    if (change == CURVE_UNCHANGED) {
+        _curve_changed = changed;
+    } else {
+        _curve_changed.unionWith(changed);
+    }
+    _curve_change = CURVE_PARTIAL;
+}
+
 /**
  * Sets _curve_before_lpe to refer to the curve.
  */
@@ -1063,6 +1093,7 @@ void SPShape::setCurveInsync(SPCurve *new_curve, unsigned int owner)
             _curve = new_curve->copy();
         }
     }
+    _curve_change = CURVE_REPLACED;
 }
 
 void SPShape::snappoints(std::vector<Inkscape::SnapCandidatePoint> &p, Inkscape::SnapPreferences const *snapprefs) const {
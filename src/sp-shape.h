@@ -16,6 +16,7 @@
  */
 
 #include <2geom/forward.h>
+#include <2geom/rect.h>
 #include <cstddef>
 #include <sigc++/connection.h>
 
@@ -42,6 +43,7 @@ public:
     SPCurve * getCurve () const;
     SPCurve * getCurveBeforeLPE () const;
     void setCurve (SPCurve *curve, unsigned int owner);
+    void setCurve (SPCurve *curve, unsigned int owner, Geom::OptRect const &changed);
     void setCurveInsync (SPCurve *curve, unsigned int owner);
     void setCurveBeforeLPE (SPCurve *curve);
     int hasMarkers () const;
@@ -51,6 +53,16 @@ public: // temporarily public, until SPPath is properly classed, etc.
     SPCurve *_curve_before_lpe;
     SPCurve *_curve;
 
+protected:
+    /// How _curve changed since it was last passed to the views.
+    enum CurveChange {
+        CURVE_UNCHANGED,
+        CURVE_PARTIAL, ///< only within _curve_changed
+        CURVE_REPLACED
+    };
+    CurveChange _curve_change;
+    Geom::OptRect _curve_changed;
+
 public:
     SPMarker *_marker[SP_MARKER_LOC_QTY];
     sigc::connection _release_connect [SP_MARKER_LOC_QTY];
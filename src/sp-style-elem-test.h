@@ -2,10 +2,13 @@
 #define SEEN_SP_STYLE_ELEM_TEST_H
 
 #include <cxxtest/TestSuite.h>
+#include <cstring>
 
 #include "test-helpers.h"
 
+#include "document.h"
 #include "sp-style-elem.h"
+#include "style.h"
 #include "xml/repr.h"
 
 class SPStyleElemTest : public CxxTest::TestSuite
@@ -149,6 +152,106 @@ public:
         Inkscape::GC::release(repr);
     }
 
+    void testSelectors()
+    {
+        char const *docString =
+            "<svg xmlns=\"http://www.w3.org/2000/svg\">\n"
+            "<style type=\"text/css\">\n"
+            "  rect { stroke-width: 2 }\n"
+            "  .thick, .wide { stroke-width: 5 }\n"
+            "  g > rect.thin { stroke-width: 1 }\n"
+            "  #special { stroke-width: 7 }\n"
+            "  .thick.wide { stroke-width: 9 }\n"
+            "</style>\n"
+            "<rect id=\"R1\"/>\n"
+            "<rect id=\"R2\" class=\"thin\"/>\n"
+            "<rect id=\"R3\" class=\" wide\"/>\n"
+            "<circle id=\"special\" class=\"thin\"/>\n"
+            "<g><rect id=\"R4\" class=\"thin\"/><rect id=\"R5\" class=\"thick  wide\"/></g>\n"
+            "</svg>\n";
+        SPDocument *doc = SPDocument::createNewDocFromMem(docString, strlen(docString), false);
+        TS_ASSERT( doc != NULL );
+        if ( !doc ) {
+            return;
+        }
+
+        struct Case { char const *id; float width; } const cases[] = {
+            { "R1", 2 }, { "R2", 2 }, { "R3", 5 }, { "special", 7 }, { "R4", 1 }, { "R5", 9 }
+        };
+        for (unsigned i = 0; i < G_N_ELEMENTS(cases); ++i) {
+            SPObject *obj = doc->getObjectById(cases[i].id);
+            TS_ASSERT( obj && obj->style );
+            if ( obj && obj->style ) {
+                TS_ASSERT_EQUALS( obj->style->stroke_width.computed, cases[i].width );
+            }
+        }
+
+        // The style follows changes of class and id
+        SPObject *obj = doc->getObjectById("R1");
+        if ( obj ) {
+            obj->getRepr()->setAttribute("class", "thick");
+            TS_ASSERT_EQUALS( obj->style->stroke_width.computed, 5 );
+            obj->getRepr()->setAttribute("id", "special");
+            TS_ASSERT_EQUALS( obj->style->stroke_width.computed, 7 );
+            obj->getRepr()->setAttribute("class", NULL);
+            obj->getRepr()->setAttribute("id", "R1");
+            TS_ASSERT_EQUALS( obj->style->stroke_width.computed, 2 );
+        }
+
+        doc->doUnref();
+    }
+
+    // Through combinators, a change of class or id also changes the styles of other objects
+    void testCombinators()
+    {
+        char const *docString =
+            "<svg xmlns=\"http://www.w3.org/2000/svg\">\n"
+            "<style type=\"text/css\">\n"
+            "  rect, path { stroke-width: 2 }\n"
+            "  .a rect { stroke-width: 3 }\n"
+            "  #x > path { stroke-width: 4 }\n"
+            "  circle.b + rect { stroke-width: 5 }\n"
+            "</style>\n"
+            "<g id=\"G\"><g><rect id=\"R\"/></g><path id=\"P\"/></g>\n"
+            "<circle id=\"C\"/><rect id=\"S\"/>\n"
+            "</svg>\n";
+        SPDocument *doc = SPDocument::createNewDocFromMem(docString, strlen(docString), false);
+        TS_ASSERT( doc != NULL );
+        if ( !doc ) {
+            return;
+        }
+
+        SPObject *g = doc->getObjectById("G");
+        SPObject *r = doc->getObjectById("R");
+        SPObject *p = doc->getObjectById("P");
+        SPObject *c = doc->getObjectById("C");
+        SPObject *s = doc->getObjectById("S");
+        TS_ASSERT( g && r && p && c && s );
+        if ( g && r && p && c && s ) {
+            TS_ASSERT_EQUALS( r->style->stroke_width.computed, 2 );
+            TS_ASSERT_EQUALS( p->style->stroke_width.computed, 2 );
+            TS_ASSERT_EQUALS( s->style->stroke_width.computed, 2 );
+
+            g->getRepr()->setAttribute("class", "a");
+            TS_ASSERT_EQUALS( r->style->stroke_width.computed, 3 );
+            TS_ASSERT_EQUALS( p->style->stroke_width.computed, 2 );
+            g->getRepr()->setAttribute("id", "x");
+            TS_ASSERT_EQUALS( r->style->stroke_width.computed, 3 );
+            TS_ASSERT_EQUALS( p->style->stroke_width.computed, 4 );
+            g->getRepr()->setAttribute("class", NULL);
+            g->getRepr()->setAttribute("id", "G");
+            TS_ASSERT_EQUALS( r->style->stroke_width.computed, 2 );
+            TS_ASSERT_EQUALS( p->style->stroke_width.computed, 2 );
+
+            c->getRepr()->setAttribute("class", "b");
+            TS_ASSERT_EQUALS( s->style->stroke_width.computed, 5 );
+            c->getRepr()->setAttribute("class", NULL);
+            TS_ASSERT_EQUALS( s->style->stroke_width.computed, 2 );
+        }
+
+        doc->doUnref();
+    }
+
 };
 
 
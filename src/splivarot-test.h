@@ -0,0 +1,246 @@
+#ifndef SEEN_SPLIVAROT_TEST_H
+#define SEEN_SPLIVAROT_TEST_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <set>
+#include <utility>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+
+#include "livarot/Shape.h"
+#include "splivarot.h"
+
+class SplivarotTest : public CxxTest::TestSuite {
+private:
+    typedef void (*Builder)(std::vector<Shape *> &, std::set<int> &);
+
+    /**
+     * A random coordinate between lo and hi, on livarot's rounding grid, which no other
+     * rectangle uses yet. Livarot can drop shapes whose edges overlap exactly, depending on the
+     * order in which they are combined; with distinct coordinates, the area of the result does
+     * not depend on the order. The coordinate is never the centre of a unit cell.
+     */
+    static double line(std::set<int> &lines, int lo, int hi) {
+        int v;
+        do {
+            v = 512 * lo + std::rand() % (512 * (hi - lo));
+        } while (v % 512 == 256 || lines.count(v));
+        lines.insert(v);
+        return v / 512.0;
+    }
+
+    /// Adds a polygon for the rectangle; one with no width or height gives an empty shape.
+    static void addRect(std::vector<Shape *> &shapes, double x0, double y0, double x1, double y1) {
+        Shape polygon;
+        polygon.AddPoint(Geom::Point(x0, y0));
+        polygon.AddPoint(Geom::Point(x1, y0));
+        polygon.AddPoint(Geom::Point(x1, y1));
+        polygon.AddPoint(Geom::Point(x0, y1));
+        for (int i = 0; i < 4; ++i) {
+            polygon.AddEdge(i, (i + 1) % 4);
+        }
+        Shape *shape = new Shape;
+        shape->ConvertToShape(&polygon, fill_nonZero);
+        shapes.push_back(shape);
+    }
+
+    /// Rectangles up to 20 units wide and high, in the square from lo to hi.
+    static void randomRects(std::vector<Shape *> &shapes, std::set<int> &lines, int count, int lo, int hi) {
+        for (int i = 0; i < count; ++i) {
+            double x0 = line(lines, lo, hi - 1);
+            double y0 = line(lines, lo, hi - 1);
+            double x1 = line(lines, int(x0) + 1, std::min(hi, int(x0) + 20));
+            double y1 = line(lines, int(y0) + 1, std::min(hi, int(y0) + 20));
+            addRect(shapes, x0, y0, x1, y1);
+        }
+    }
+
+    /// Rectangles of random sizes, all around the centre of the 64 units square.
+    static void centredRects(std::vector<Shape *> &shapes, std::set<int> &lines, int count) {
+        for (int i = 0; i < count; ++i) {
+            addRect(shapes, line(lines, 12, 31), line(lines, 12, 31), line(lines, 33, 52), line(lines, 33, 52));
+        }
+    }
+
+    static void overlapping(std::vector<Shape *> &shapes, std::set<int> &lines) {
+        randomRects(shapes, lines, 40, 0, 64);
+    }
+
+    static void centred(std::vector<Shape *> &shapes, std::set<int> &lines) {
+        centredRects(shapes, lines, 40);
+    }
+
+    /// Squares on a grid, far enough apart not to touch.
+    static void disjoint(std::vector<Shape *> &shapes, std::set<int> &lines) {
+        for (int y = 0; y < 5; ++y) {
+            for (int x = 0; x < 7; ++x) {
+                addRect(shapes, line(lines, 8 * x, 8 * x + 1), line(lines, 8 * y, 8 * y + 1),
+                        line(lines, 8 * x + 5, 8 * x + 6), line(lines, 8 * y + 5, 8 * y + 6));
+            }
+        }
+    }
+
+    /// Two clusters of overlapping rectangles, apart from each other.
+    static void clusters(std::vector<Shape *> &shapes, std::set<int> &lines) {
+        randomRects(shapes, lines, 10, 0, 30);
+        randomRects(shapes, lines, 10, 34, 64);
+    }
+
+    /// Overlapping rectangles with empty ones in between, also first and last.
+    static void someEmpty(std::vector<Shape *> &shapes, std::set<int> &lines) {
+        addRect(shapes, 10, 10, 10, 30);
+        for (int i = 0; i < 8; ++i) {
+            centredRects(shapes, lines, 2);
+            addRect(shapes, 5, 20, 25, 20);
+        }
+    }
+
+    static void allEmpty(std::vector<Shape *> &shapes, std::set<int> &) {
+        for (int i = 0; i < 5; ++i) {
+            addRect(shapes, i, 0, i, 10);
+        }
+    }
+
+    static void single(std::vector<Shape *> &shapes, std::set<int> &lines) {
+        centredRects(shapes, lines, 1);
+    }
+
+    static void many(std::vector<Shape *> &shapes, std::set<int> &lines) {
+        randomRects(shapes, lines, 1000, 0, 64);
+    }
+
+    static std::vector<Shape *> build(Builder builder, unsigned seed) {
+        std::vector<Shape *> shapes;
+        std::set<int> lines;
+        std::srand(seed);
+        builder(shapes, lines);
+        return shapes;
+    }
+
+    /// The sequential fold that sp_selected_path_boolop() does for all operations but
+    /// union and intersection.
+    static Shape *fold(std::vector<Shape *> const &shapes, bool_op bop) {
+        Shape *a = shapes[0];
+        for (unsigned i = 1; i < shapes.size(); ++i) {
+            Shape *b = shapes[i];
+            bool zeroA = !a->hasEdges();
+            bool zeroB = !b->hasEdges();
+            if (zeroA || zeroB) {
+                if ((bop == bool_op_union && zeroA) || (bop == bool_op_inters && zeroB)) {
+                    std::swap(a, b);
+                }
+            } else {
+                Shape *result = new Shape;
+                result->Booleen(b, a, bop);
+                std::swap(a, result);
+                delete result;
+            }
+            delete b;
+        }
+        return a;
+    }
+
+    /// The winding number of the edges around p, from their crossings with a ray going right.
+    static int winding(Shape &s, Geom::Point const &p) {
+        int w = 0;
+        for (int i = 0; i < s.numberOfEdges(); ++i) {
+            Geom::Point const a = s.getPoint(s.getEdge(i).st).x;
+            Geom::Point const b = s.getPoint(s.getEdge(i).en).x;
+            if ((a[Geom::Y] <= p[Geom::Y]) != (b[Geom::Y] <= p[Geom::Y])) {
+                double const x = a[Geom::X] + (p[Geom::Y] - a[Geom::Y]) * (b[Geom::X] - a[Geom::X]) / (b[Geom::Y] - a[Geom::Y]);
+                if (x > p[Geom::X]) {
+                    w += (b[Geom::Y] > a[Geom::Y]) ? 1 : -1;
+                }
+            }
+        }
+        return w;
+    }
+
+    /// The shapes are combined in another order, which changes the numbering and may split the
+    /// edges elsewhere, so the shapes are not identical, but they cover the same unit cells.
+    static void assertSameArea(Shape &a, Shape &b) {
+        TS_ASSERT_EQUALS(a.hasEdges(), b.hasEdges());
+        for (int y = 0; y < 64; ++y) {
+            for (int x = 0; x < 64; ++x) {
+                Geom::Point const p(x + 0.5, y + 0.5);
+                TS_ASSERT_EQUALS(winding(a, p) != 0, winding(b, p) != 0);
+            }
+        }
+    }
+
+    static void assertSameAsFold(Builder builder, unsigned seed, bool_op bop) {
+        for (int threads = 1; threads <= 3; threads += 2) {
+            Shape *folded = fold(build(builder, seed), bop);
+            Shape *tree = sp_shapes_boolop(build(builder, seed), bop, threads);
+            assertSameArea(*folded, *tree);
+            delete folded;
+            delete tree;
+        }
+    }
+
+public:
+    SplivarotTest() {}
+    virtual ~SplivarotTest() {}
+
+    static SplivarotTest *createSuite() { return new SplivarotTest(); }
+    static void destroySuite( SplivarotTest *suite ) { delete suite; }
+
+    void testOverlapping()
+    {
+        assertSameAsFold(overlapping, 1, bool_op_union);
+        assertSameAsFold(overlapping, 2, bool_op_inters);
+        assertSameAsFold(centred, 3, bool_op_union);
+        assertSameAsFold(centred, 4, bool_op_inters);
+    }
+
+    void testDisjoint()
+    {
+        assertSameAsFold(disjoint, 5, bool_op_union);
+        assertSameAsFold(disjoint, 6, bool_op_inters);
+        assertSameAsFold(clusters, 7, bool_op_union);
+        assertSameAsFold(clusters, 8, bool_op_inters);
+    }
+
+    void testEmpty()
+    {
+        assertSameAsFold(someEmpty, 9, bool_op_union);
+        assertSameAsFold(someEmpty, 10, bool_op_inters);
+        assertSameAsFold(allEmpty, 11, bool_op_union);
+        assertSameAsFold(allEmpty, 12, bool_op_inters);
+        assertSameAsFold(single, 13, bool_op_union);
+    }
+
+    void testManyShapes()
+    {
+        std::vector<Shape *> shapes = build(many, 14);
+        TS_TRACE("Benchmarking union of many shapes...");
+        clock_t begin = clock();
+        Shape *folded = fold(shapes, bool_op_union);
+        clock_t end = clock();
+        std::cout << "Took " << double(end - begin) / double(CLOCKS_PER_SEC) << " seconds to fold 1000 rectangles\n";
+        shapes = build(many, 14);
+        begin = clock();
+        Shape *tree = sp_shapes_boolop(shapes, bool_op_union, 4);
+        end = clock();
+        std::cout << "Took " << double(end - begin) / double(CLOCKS_PER_SEC) << " seconds to unite 1000 rectangles in a tree\n";
+        assertSameArea(*folded, *tree);
+        delete folded;
+        delete tree;
+    }
+};
+
+#endif // SEEN_SPLIVAROT_TEST_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
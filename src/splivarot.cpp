@@ -16,10 +16,15 @@
 # include <config.h>
 #endif
 
+#include <algorithm>
 #include <cstring>
 #include <string>
+#include <utility>
 #include <vector>
 #include <glib.h>
+#if HAVE_OPENMP
+# include <omp.h>
+#endif
 #include "xml/repr.h"
 #include "svg/svg.h"
 #include "sp-path.h"
@@ -47,6 +52,7 @@
 #include "xml/repr.h"
 #include "xml/repr-sorting.h"
 #include <2geom/pathvector.h>
+#include <2geom/rect.h>
 #include <2geom/svg-path-writer.h>
 #include "helper/geom.h"
 
@@ -322,6 +328,189 @@ Geom::PathVector pathliv_to_pathvector(Path *pathliv){
 }
 
 
+// Shapes whose bounding boxes are further apart than this cannot touch, even after livarot
+// has rounded their coordinates.
+static double const BOOLOP_APART_MARGIN = 0.1;
+
+namespace {
+
+struct BoolopOperand {
+    Shape *shape;
+    Geom::OptRect bbox; ///< empty if the shape has no edges
+};
+
+Geom::OptRect boolop_shape_bbox(Shape *shape)
+{
+    if (!shape->hasEdges()) {
+        return Geom::OptRect();
+    }
+    shape->CalcBBox();
+    return Geom::Rect(Geom::Point(shape->leftX, shape->topY), Geom::Point(shape->rightX, shape->bottomY));
+}
+
+bool boolop_apart(Geom::OptRect const &a, Geom::OptRect const &b)
+{
+    if (!a || !b) {
+        return true;
+    }
+    Geom::Rect grown(*a);
+    grown.expandBy(BOOLOP_APART_MARGIN);
+    return !grown.intersects(*b);
+}
+
+/**
+ * Adds the points and edges of src to dest. When the shapes are apart, this is their union.
+ */
+void boolop_append_shape(Shape *dest, Shape *src)
+{
+    int const offset = dest->numberOfPoints();
+    for (int i = 0; i < src->numberOfPoints(); i++) {
+        dest->AddPoint(src->getPoint(i).x);
+    }
+    bool const back = dest->hasBackData() && src->hasBackData();
+    for (int i = 0; i < src->numberOfEdges(); i++) {
+        int e = dest->AddEdge(src->getEdge(i).st + offset, src->getEdge(i).en + offset);
+        if (back && e >= 0) {
+            dest->ebData[e] = src->ebData[i];
+        }
+    }
+    // in the order Booleen() would have left them
+    dest->SortPoints();
+    dest->ForceToPolygon();
+}
+
+/**
+ * Combines the second operand into the first one, with a union or intersection, and deletes
+ * the second one's shape.
+ */
+void boolop_combine(BoolopOperand &a, BoolopOperand &b, bool_op bop)
+{
+    bool zeroA = !a.shape->hasEdges();
+    bool zeroB = !b.shape->hasEdges();
+    if (zeroA || zeroB) {
+        /* Due to quantization of the input shape coordinates, we may end up with A or B being empty.
+         * If this is a union operation, we just use the non-empty shape as the result:
+         *   A=0  =>  (0 or B) == B
+         *   B=0  =>  (A or 0) == A
+         * If this is an intersection operation, we just use the empty shape as the result:
+         *   A=0  =>  (0 and B) == 0 == A
+         *   B=0  =>  (A and 0) == 0 == B
+         *
+         * The result is stored in A, so we swap A and B where necessary.
+         */
+        if ((bop == bool_op_union && zeroA) || (bop == bool_op_inters && zeroB)) {
+            std::swap(a, b);
+        }
+    } else if (boolop_apart(a.bbox, b.bbox)) {
+        if (bop == bool_op_union) {
+            boolop_append_shape(a.shape, b.shape);
+            a.bbox.unionWith(b.bbox);
+        } else {
+            a.shape->Reset(0, 0);
+            a.bbox = Geom::OptRect();
+        }
+    } else {
+        Shape *result = new Shape;
+        result->Booleen(b.shape, a.shape, bop);
+        delete a.shape;
+        a.shape = result;
+        a.bbox = boolop_shape_bbox(result);
+    }
+    delete b.shape;
+    b.shape = NULL;
+}
+
+/// Interleaves the bits of x and y.
+guint32 boolop_morton_code(guint32 x, guint32 y)
+{
+    guint32 code = 0;
+    for (unsigned bit = 0; bit < 16; bit++) {
+        code |= ((x >> bit) & 1) << (2 * bit);
+        code |= ((y >> bit) & 1) << (2 * bit + 1);
+    }
+    return code;
+}
+
+}
+
+/**
+ * Unites or intersects all the shapes and returns the result; deletes the shapes.
+ *
+ * Folding the shapes one by one into the result sweeps the whole result so far at every step.
+ * Instead, shapes close to each other are combined pairwise, in a balanced tree of which every
+ * level is done in parallel. Shapes whose bounding boxes are apart are merged (union) or
+ * dropped (intersection) without a sweep. The result covers the same region as the fold, but
+ * its points can differ within livarot's rounding.
+ */
+Shape *
+sp_shapes_boolop(std::vector<Shape *> const &shapes, bool_op bop, int num_threads)
+{
+    g_assert(bop == bool_op_union || bop == bool_op_inters);
+    g_assert(!shapes.empty());
+
+    int const count = shapes.size();
+    std::vector<BoolopOperand> operands(count);
+    Geom::OptRect total;
+    for (int i = 0; i < count; i++) {
+        operands[i].shape = shapes[i];
+        operands[i].bbox = boolop_shape_bbox(shapes[i]);
+        total.unionWith(operands[i].bbox);
+    }
+
+    if (bop == bool_op_inters) {
+        Geom::OptRect common = operands[0].bbox;
+        for (int i = 1; i < count && common; i++) {
+            common->expandBy(BOOLOP_APART_MARGIN);
+            common.intersectWith(operands[i].bbox);
+        }
+        if (!common) {
+            // nothing is inside all of them
+            for (int i = 1; i < count; i++) {
+                delete operands[i].shape;
+            }
+            operands[0].shape->Reset(0, 0);
+            return operands[0].shape;
+        }
+    }
+
+    // order the shapes along a Z-order curve through the centres of their bounding boxes,
+    // so that the pairs combined first are close together
+    if (total && count > 2) {
+        std::vector<std::pair<guint32, int> > keys(count);
+        Geom::Point const scale(65535.0 / std::max(total->width(), 1e-6),
+                                65535.0 / std::max(total->height(), 1e-6));
+        for (int i = 0; i < count; i++) {
+            guint32 code = 0;
+            if (operands[i].bbox) {
+                Geom::Point c = operands[i].bbox->midpoint() - total->min();
+                code = boolop_morton_code(guint32(c[Geom::X] * scale[Geom::X]),
+                                          guint32(c[Geom::Y] * scale[Geom::Y]));
+            }
+            keys[i] = std::make_pair(code, i);
+        }
+        std::sort(keys.begin(), keys.end());
+        std::vector<BoolopOperand> sorted(count);
+        for (int i = 0; i < count; i++) {
+            sorted[i] = operands[keys[i].second];
+        }
+        operands.swap(sorted);
+    }
+
+    for (int step = 1; step < count; step *= 2) {
+        int const pairs = (count + 2 * step - 1) / (2 * step);
+#if HAVE_OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+#endif
+        for (int p = 0; p < pairs; p++) {
+            int const i = 2 * step * p;
+            if (i + step < count) {
+                boolop_combine(operands[i], operands[i + step], bop);
+            }
+        }
+    }
+    return operands[0].shape;
+}
+
 // boolean operations on the desktop
 // take the source paths from the file, do the operation, delete the originals and add the results
 void
@@ -455,7 +644,31 @@ sp_selected_path_boolop(Inkscape::Selection *selection, SPDesktop *desktop, bool
     Path::cut_position  *toCut=NULL;
     int                  nbToCut=0;
 
-    if ( bop == bool_op_inters || bop == bool_op_union || bop == bool_op_diff || bop == bool_op_symdiff ) {
+    if ( bop == bool_op_inters || bop == bool_op_union ) {
+        // get the polygons of each path, with the winding rule specified, and combine them all
+#if HAVE_OPENMP
+        Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+        int numOfThreads = prefs->getIntLimited("/options/threading/numthreads", omp_get_num_procs(), 1, 256);
+#else
+        int numOfThreads = 1;
+#endif
+        std::vector<Shape *> shapes(nbOriginaux);
+#if HAVE_OPENMP
+#pragma omp parallel for num_threads(numOfThreads) schedule(dynamic)
+#endif
+        for (int i = 0; i < nbOriginaux; i++) {
+            Shape *polygon = new Shape;
+            shapes[i] = new Shape;
+            originaux[i]->ConvertWithBackData(0.1);
+            originaux[i]->Fill(polygon, i);
+            shapes[i]->ConvertToShape(polygon, origWind[i]);
+            delete polygon;
+        }
+
+        delete theShape;
+        theShape = sp_shapes_boolop(shapes, bop, numOfThreads);
+
+    } else if ( bop == bool_op_diff || bop == bool_op_symdiff ) {
         // true boolean op
         // get the polygons of each path, with the winding rule specified, and apply the operation iteratively
         originaux[0]->ConvertWithBackData(0.1);
@@ -474,14 +687,9 @@ sp_selected_path_boolop(Inkscape::Selection *selection, SPDesktop *desktop, bool
             theShapeB->ConvertToShape(theShape, origWind[curOrig]);
 
             /* Due to quantization of the input shape coordinates, we may end up with A or B being empty.
-             * If this is a union or symdiff operation, we just use the non-empty shape as the result:
-             *   A=0  =>  (0 or B) == B
-             *   B=0  =>  (A or 0) == A
+             * If this is a symdiff operation, we just use the non-empty shape as the result:
              *   A=0  =>  (0 xor B) == B
              *   B=0  =>  (A xor 0) == A
-             * If this is an intersection operation, we just use the empty shape as the result:
-             *   A=0  =>  (0 and B) == 0 == A
-             *   B=0  =>  (A and 0) == 0 == B
              * If this a difference operation, and the upper shape (A) is empty, we keep B.
              * If the lower shape (B) is empty, we still keep B, as it's empty:
              *   A=0  =>  (B - 0) == B
@@ -494,8 +702,7 @@ sp_selected_path_boolop(Inkscape::Selection *selection, SPDesktop *desktop, bool
             bool zeroB = theShapeB->numberOfEdges() == 0;
             if (zeroA || zeroB) {
             	// We might need to do a swap. Apply the above rules depending on operation type.
-            	bool resultIsB =   ((bop == bool_op_union || bop == bool_op_symdiff) && zeroA)
-            		        || ((bop == bool_op_inters) && zeroB)
+            	bool resultIsB =   (bop == bool_op_symdiff && zeroA)
             			||  (bop == bool_op_diff);
                 if (resultIsB) {
                 	// Swap A and B to use B as the result
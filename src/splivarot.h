@@ -7,10 +7,12 @@
  * public domain
  */
 
+#include <vector>
 #include <2geom/forward.h>
 #include <2geom/path.h>
 #include "livarot/Path.h"
 
+class Shape;
 class SPCurve;
 class SPDesktop;
 class SPItem;
@@ -66,6 +68,8 @@ SPCurve *curve_for_item(SPItem *item);
 SPCurve *curve_for_item_before_LPE(SPItem *item);
 boost::optional<Path::cut_position> get_nearest_position_on_Path(Path *path, Geom::Point p, unsigned seg = 0);
 Geom::Point get_point_on_Path(Path *path, int piece, double t);
+// unites or intersects the shapes, and deletes them
+Shape *sp_shapes_boolop(std::vector<Shape *> const &shapes, bool_op bop, int num_threads);
 Geom::PathVector sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::PathVector const &pathvb, bool_op bop, FillRule fra, FillRule frb);
 
 #endif
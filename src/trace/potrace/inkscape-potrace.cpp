@@ -14,8 +14,17 @@
  *
  */
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
 #include "inkscape-potrace.h"
 
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#include "preferences.h"
+#endif
+
 #include <glibmm/i18n.h>
 #include <gtkmm/main.h>
 #include <iomanip>
@@ -62,6 +71,77 @@ ustring twohex( int value )
 {
     return ustring::format(std::hex, std::setfill(L'0'), std::setw(2), value);
 }
+
+/**
+ * One scan of a multi-scan trace.  The scans are traced concurrently
+ * and reported in order afterwards.
+ */
+struct TraceLevel
+{
+    TraceLevel() : floor(0.0), state(NULL), seconds(0.0) {}
+
+    double floor; // the brightness floor the scan was traced with
+    potrace_state_t *state; // turned into path data once all the scans are traced
+    double seconds;
+};
+
+/**
+ * Traces the scans of a multi-scan trace, on as many threads as the
+ * /options/threading/numthreads preference allows.  traceScan(i, params) traces
+ * scan i.  Only the calling thread, which runs the GUI, keeps the progress
+ * callback of params; once it has no scan left to trace it keeps calling it
+ * until the other threads are done, so the GUI stays responsive and Stop works.
+ */
+template <typename TraceScan>
+void traceScans(potrace_param_t const *params, int count, TraceScan &traceScan)
+{
+    int threads = 1;
+#ifdef HAVE_OPENMP
+    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+    threads = prefs->getIntLimited("/options/threading/numthreads", omp_get_num_procs(), 1, 256);
+#endif
+    if (threads < 2 || count < 2) {
+        for (int i = 0 ; i < count ; i++) {
+            traceScan(i, params);
+        }
+        return;
+    }
+
+#ifdef HAVE_OPENMP
+    potrace_param_t quiet = *params;
+    quiet.progress.callback = NULL;
+    int next = 0;
+    int done = 0;
+
+#pragma omp parallel num_threads(threads)
+    {
+        bool gui = omp_get_thread_num() == 0;
+        for (;;) {
+            int i;
+#pragma omp critical(potrace_scans)
+            i = next++;
+            if (i >= count) {
+                break;
+            }
+            traceScan(i, gui ? params : &quiet);
+#pragma omp critical(potrace_scans)
+            done++;
+        }
+        while (gui) {
+            int left;
+#pragma omp critical(potrace_scans)
+            left = count - done;
+            if (!left) {
+                break;
+            }
+            if (params->progress.callback) {
+                params->progress.callback(0.0, params->progress.data);
+            }
+            g_usleep(20000);
+        }
+    }
+#endif
+}
 } // namespace
 
 
@@ -312,6 +392,56 @@ static IndexedMap *filterIndexed(PotraceTracingEngine &engine, GdkPixbuf * pixbu
 }
 
 
+/**
+ * The bitmap filter() gives for a brightness scan, made from a gray map
+ * that is only read, so that it can be shared by all the scans.
+ */
+static potrace_bitmap_t *brightnessBitmap(GrayMap *gm, double brightnessFloor,
+                                          double brightnessThreshold, bool invert)
+{
+    potrace_bitmap_t *bitmap = bm_new(gm->width, gm->height);
+    if (!bitmap)
+        return NULL;
+    bm_clear(bitmap, 0);
+
+    double floor =  3.0 * ( brightnessFloor * 256.0 );
+    double cutoff =  3.0 * ( brightnessThreshold * 256.0 );
+    for (int y=0 ; y<gm->height ; y++)
+        {
+        for (int x=0 ; x<gm->width ; x++)
+            {
+            double brightness = (double)gm->getPixel(gm, x, y);
+            bool black = (brightness >= floor && brightness < cutoff);
+            BM_UPUT(bitmap, x, y, black != invert);
+            }
+        }
+
+    return bitmap;
+}
+
+
+/**
+ * The bitmap of one color of a quantized image, with the colors before it
+ * if the scans are stacked.
+ */
+static potrace_bitmap_t *indexBitmap(IndexedMap *iMap, int colorIndex, bool stack)
+{
+    potrace_bitmap_t *bitmap = bm_new(iMap->width, iMap->height);
+    if (!bitmap)
+        return NULL;
+    bm_clear(bitmap, 0);
+
+    for (int row=0 ; row<iMap->height ; row++) {
+        for (int col=0 ; col<iMap->width ; col++) {
+            int indx = (int) iMap->getPixel(iMap, col, row);
+            BM_UPUT(bitmap, col, row, stack ? indx <= colorIndex : indx == colorIndex);
+        }
+    }
+
+    return bitmap;
+}
+
+
 
 
 Glib::RefPtr<Gdk::Pixbuf> 
@@ -359,6 +489,8 @@ std::string PotraceTracingEngine::grayMapToPath(GrayMap *grayMap, long *nodeCoun
     }
 
     potrace_bitmap_t *potraceBitmap = bm_new(grayMap->width, grayMap->height);
+    if (!potraceBitmap)
+        return "";
     bm_clear(potraceBitmap, 0);
 
     //##Read the data out of the GrayMap
@@ -378,13 +510,44 @@ std::string PotraceTracingEngine::grayMapToPath(GrayMap *grayMap, long *nodeCoun
     fclose(f);
     */
 
+    return bitmapToPath(potraceBitmap, potraceParams, nodeCount);
+}
+
+
+std::string PotraceTracingEngine::bitmapToPath(potrace_bitmap_t *potraceBitmap,
+                                               potrace_param_t const *params, long *nodeCount)
+{
+    return stateToPath(traceBitmap(potraceBitmap, params), nodeCount);
+}
+
+
+potrace_state_t *PotraceTracingEngine::traceBitmap(potrace_bitmap_t *potraceBitmap,
+                                                   potrace_param_t const *params)
+{
+    if (!potraceBitmap)
+        return NULL;
+
+    if (!g_atomic_int_get(&keepGoing))
+    {
+        bm_free(potraceBitmap);
+        return NULL;
+    }
+
     /* trace a bitmap*/
-    potrace_state_t *potraceState = potrace_trace(potraceParams,
-                                                  potraceBitmap);
+    potrace_state_t *potraceState = potrace_trace(params, potraceBitmap);
 
     //## Free the Potrace bitmap
     bm_free(potraceBitmap);
 
+    return potraceState;
+}
+
+
+std::string PotraceTracingEngine::stateToPath(potrace_state_t *potraceState, long *nodeCount)
+{
+    if (!potraceState)
+        return "";
+
     if (!keepGoing)
         {
         g_warning("aborted");
@@ -468,7 +631,62 @@ std::vector<TracingEngineResult> PotraceTracingEngine::traceGrayMap(GrayMap *gra
 }
 
 /**
- *  Called for multiple-scanning algorithms
+ *  Traces one brightness scan, and times it
+ */
+static void traceBrightnessLevel(PotraceTracingEngine &engine, potrace_param_t const *params,
+                                 GrayMap *gm, double threshold, bool invert, TraceLevel &level)
+{
+    GTimer *timer = g_timer_new();
+    level.state = engine.traceBitmap(brightnessBitmap(gm, level.floor, threshold, invert), params);
+    level.seconds = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+}
+
+namespace {
+struct BrightnessScan
+{
+    BrightnessScan(PotraceTracingEngine &engine, GrayMap *gm, std::vector<double> const &thresholds,
+                   bool invert, std::vector<TraceLevel> &levels) :
+        engine(engine), gm(gm), thresholds(thresholds), invert(invert), levels(levels) {}
+
+    void operator()(int i, potrace_param_t const *params)
+    {
+        traceBrightnessLevel(engine, params, gm, thresholds[i], invert, levels[i]);
+    }
+
+    PotraceTracingEngine &engine;
+    GrayMap *gm;
+    std::vector<double> const &thresholds;
+    bool invert;
+    std::vector<TraceLevel> &levels;
+};
+
+struct IndexScan
+{
+    IndexScan(PotraceTracingEngine &engine, IndexedMap *iMap, bool stack,
+              std::vector<TraceLevel> &levels) :
+        engine(engine), iMap(iMap), stack(stack), levels(levels) {}
+
+    void operator()(int colorIndex, potrace_param_t const *params)
+    {
+        // Make a bitmap for the color index, and trace it
+        GTimer *timer = g_timer_new();
+        levels[colorIndex].state = engine.traceBitmap(indexBitmap(iMap, colorIndex, stack), params);
+        levels[colorIndex].seconds = g_timer_elapsed(timer, NULL);
+        g_timer_destroy(timer);
+    }
+
+    PotraceTracingEngine &engine;
+    IndexedMap *iMap;
+    bool stack;
+    std::vector<TraceLevel> &levels;
+};
+} // namespace
+
+
+/**
+ *  Called for multiple-scanning algorithms.  The scans share the gray map of the
+ *  image and are traced concurrently.
  */
 std::vector<TracingEngineResult> PotraceTracingEngine::traceBrightnessMulti(GdkPixbuf * thePixbuf)
 {
@@ -479,23 +697,44 @@ std::vector<TracingEngineResult> PotraceTracingEngine::traceBrightnessMulti(GdkP
         double high    = 0.9; //top of range
         double delta   = (high - low ) / ((double)multiScanNrColors);
 
-        brightnessFloor = 0.0; //Set bottom to black
+        std::vector<double> thresholds;
+        for ( double threshold = low ; threshold <= high ; threshold += delta) {
+            thresholds.push_back(threshold);
+        }
+
+        GrayMap *grayMap = gdkPixbufToGrayMap(thePixbuf);
+        if ( grayMap ) {
+            int count = thresholds.size();
+            std::vector<TraceLevel> levels(count);
 
-        int traceCount = 0;
+            // Unless the scans are stacked, each one starts where the last non-empty one
+            // ended.  Assume that none is empty here, the others are traced again below.
+            for (int i = 1 ; i < count ; i++) {
+                levels[i].floor = multiScanStack ? 0.0 : thresholds[i - 1];
+            }
 
-        for ( brightnessThreshold = low ;
-              brightnessThreshold <= high ;
-              brightnessThreshold += delta) {
-            GrayMap *grayMap = filter(*this, thePixbuf);
-            if ( grayMap ) {
-                long nodeCount = 0L;
-                std::string d = grayMapToPath(grayMap, &nodeCount);
+            BrightnessScan scan(*this, grayMap, thresholds, invert, levels);
+            traceScans(potraceParams, count, scan);
 
-                grayMap->destroy(grayMap);
+            double floor = 0.0; //Set bottom to black
+            int traceCount = 0;
 
+            // The path data is written here, on the GUI thread, as PathString reads the preferences
+            for (int i = 0 ; i < count ; i++) {
+                TraceLevel &level = levels[i];
+                if (level.floor != floor) {
+                    if (level.state) {
+                        potrace_state_free(level.state);
+                    }
+                    level.floor = floor;
+                    traceBrightnessLevel(*this, potraceParams, grayMap, thresholds[i], invert, level);
+                }
+
+                long nodeCount = 0L;
+                std::string d = stateToPath(level.state, &nodeCount);
                 if ( !d.empty() ) {
                     //### get style info
-                    int grayVal = (int)(256.0 * brightnessThreshold);
+                    int grayVal = (int)(256.0 * thresholds[i]);
                     ustring style = ustring::compose("fill-opacity:1.0;fill:#%1%2%3", twohex(grayVal), twohex(grayVal), twohex(grayVal) );
 
                     //g_message("### GOT '%s' \n", style.c_str());
@@ -503,16 +742,19 @@ std::vector<TracingEngineResult> PotraceTracingEngine::traceBrightnessMulti(GdkP
                     results.push_back(result);
 
                     if (!multiScanStack) {
-                        brightnessFloor = brightnessThreshold;
+                        floor = thresholds[i];
                     }
 
                     SPDesktop *desktop = SP_ACTIVE_DESKTOP;
                     if (desktop) {
-                        ustring msg = ustring::compose(_("Trace: %1.  %2 nodes"), traceCount++, nodeCount);
+                        ustring msg = ustring::compose(_("Trace: %1.  %2 nodes, %3 s"), traceCount++, nodeCount,
+                                                       ustring::format(std::fixed, std::setprecision(2), level.seconds));
                         desktop->getMessageStack()->flash(Inkscape::NORMAL_MESSAGE, msg);
                     }
                 }
             }
+
+            grayMap->destroy(grayMap);
         }
 
         //# Remove the bottom-most scan, if requested
@@ -526,7 +768,7 @@ std::vector<TracingEngineResult> PotraceTracingEngine::traceBrightnessMulti(GdkP
 
 
 /**
- *  Quantization
+ *  Quantization.  The colors share the quantized image and are traced concurrently.
  */
 std::vector<TracingEngineResult> PotraceTracingEngine::traceQuant(GdkPixbuf * thePixbuf)
 {
@@ -535,31 +777,17 @@ std::vector<TracingEngineResult> PotraceTracingEngine::traceQuant(GdkPixbuf * th
     if (thePixbuf) {
         IndexedMap *iMap = filterIndexed(*this, thePixbuf);
         if ( iMap ) {
-            //Create and clear a gray map
-            GrayMap *gm = GrayMapCreate(iMap->width, iMap->height);
-            for (int row=0 ; row<gm->height ; row++) {
-                for (int col=0 ; col<gm->width ; col++) {
-                    gm->setPixel(gm, col, row, GRAYMAP_WHITE);
-                }
-            }
+            int count = iMap->nrColors;
+            std::vector<TraceLevel> levels(count);
 
-            for (int colorIndex=0 ; colorIndex<iMap->nrColors ; colorIndex++) {
-                // Make a gray map for each color index
-                for (int row=0 ; row<iMap->height ; row++) {
-                    for (int col=0 ; col<iMap->width ; col++) {
-                        int indx = (int) iMap->getPixel(iMap, col, row);
-                        if (indx == colorIndex) {
-                            gm->setPixel(gm, col, row, GRAYMAP_BLACK); //black
-                        } else if (!multiScanStack) {
-                            gm->setPixel(gm, col, row, GRAYMAP_WHITE); //white
-                        }
-                    }
-                }
+            IndexScan scan(*this, iMap, multiScanStack, levels);
+            traceScans(potraceParams, count, scan);
 
-                //## Now we have a traceable graymap
+            // The path data is written here, on the GUI thread, as PathString reads the preferences
+            for (int colorIndex=0 ; colorIndex<count ; colorIndex++) {
+                TraceLevel &level = levels[colorIndex];
                 long nodeCount = 0L;
-                std::string d = grayMapToPath(gm, &nodeCount);
-
+                std::string d = stateToPath(level.state, &nodeCount);
                 if ( !d.empty() ) {
                     //### get style info
                     RGB rgb = iMap->clut[colorIndex];
@@ -571,13 +799,13 @@ std::vector<TracingEngineResult> PotraceTracingEngine::traceQuant(GdkPixbuf * th
 
                     SPDesktop *desktop = SP_ACTIVE_DESKTOP;
                     if (desktop) {
-                        ustring msg = ustring::compose(_("Trace: %1.  %2 nodes"), colorIndex, nodeCount);
+                        ustring msg = ustring::compose(_("Trace: %1.  %2 nodes, %3 s"), colorIndex, nodeCount,
+                                                       ustring::format(std::fixed, std::setprecision(2), level.seconds));
                         desktop->getMessageStack()->flash(Inkscape::NORMAL_MESSAGE, msg);
                     }
                 }
             }// for colorIndex
 
-            gm->destroy(gm);
             iMap->destroy(iMap);
         }
 
@@ -628,7 +856,7 @@ PotraceTracingEngine::trace(Glib::RefPtr<Gdk::Pixbuf> pixbuf)
 void PotraceTracingEngine::abort()
 {
     //g_message("PotraceTracingEngine::abort()\n");
-    keepGoing = 0;
+    g_atomic_int_set(&keepGoing, 0);
 }
 
 
@@ -239,6 +239,21 @@ class PotraceTracingEngine : public TracingEngine
 
     std::vector<TracingEngineResult>traceGrayMap(GrayMap *grayMap);
 
+    /**
+     * Traces a bitmap, which is freed.  Several bitmaps can be traced at
+     * once if the progress callback of params does not touch the GUI.
+     */
+    potrace_state_t *traceBitmap(potrace_bitmap_t *bitmap, potrace_param_t const *params);
+
+    /**
+     * Writes the path data of a trace, which is freed.  Only call it from
+     * the GUI thread: the path format is read from the preferences.
+     */
+    std::string stateToPath(potrace_state_t *state, long *nodeCount);
+
+    std::string bitmapToPath(potrace_bitmap_t *bitmap, potrace_param_t const *params,
+                             long *nodeCount);
+
 
     private:
 
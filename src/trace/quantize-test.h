@@ -0,0 +1,155 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <glib.h>
+#include "trace/quantize.h"
+
+class QuantizeTest : public CxxTest::TestSuite {
+private:
+    static int dist(RGB a, RGB b) {
+        return (a.r - b.r) * (a.r - b.r) + (a.g - b.g) * (a.g - b.g) + (a.b - b.b) * (a.b - b.b);
+    }
+
+    /// Pixels picked at random from some colors.
+    static RgbMap *randomMap(int width, int height, std::vector<RGB> const &colors) {
+        RgbMap *map = RgbMapCreate(width, height);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                map->setPixelRGB(map, x, y, colors[std::rand() % colors.size()]);
+            }
+        }
+        return map;
+    }
+
+    static std::vector<RGB> randomColors(int count, int spread) {
+        std::vector<RGB> colors(count);
+        for (int i = 0; i < count; ++i) {
+            colors[i].r = std::rand() % spread;
+            colors[i].g = std::rand() % spread;
+            colors[i].b = std::rand() % spread;
+        }
+        return colors;
+    }
+
+    /// A gradient with some noise, which has many colors like a scan.
+    static RgbMap *scanMap(int width, int height) {
+        RgbMap *map = RgbMapCreate(width, height);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                map->setPixel(map, x, y, (x * 255 / width + std::rand() % 8) & 0xff,
+                              (y * 255 / height + std::rand() % 8) & 0xff, ((x + y) / 8 + std::rand() % 8) & 0xff);
+            }
+        }
+        return map;
+    }
+
+public:
+    QuantizeTest() {}
+    virtual ~QuantizeTest() {}
+
+    static QuantizeTest *createSuite() { return new QuantizeTest(); }
+    static void destroySuite( QuantizeTest *suite ) { delete suite; }
+
+    // With no more colors than asked for, the image is unchanged.
+    void testFewColors()
+    {
+        std::srand(1);
+        std::vector<RGB> colors = randomColors(5, 256);
+        RgbMap *map = randomMap(40, 30, colors);
+        IndexedMap *quantized = rgbMapQuantize(map, 8);
+        TS_ASSERT(quantized != NULL);
+        if (quantized) {
+            TS_ASSERT(quantized->nrColors <= 5);
+            for (int y = 0; y < map->height; ++y) {
+                for (int x = 0; x < map->width; ++x) {
+                    TS_ASSERT_EQUALS(dist(quantized->getPixelValue(quantized, x, y), map->getPixel(map, x, y)), 0);
+                }
+            }
+            quantized->destroy(quantized);
+        }
+        map->destroy(map);
+    }
+
+    // Every pixel gets the first of the closest palette colors.
+    void testClosest()
+    {
+        std::srand(2);
+        for (int i = 0; i < 20; ++i) {
+            std::vector<RGB> colors = randomColors(10 + i * 20, 1 + i * 12);
+            RgbMap *map = randomMap(50, 40, colors);
+            int ncolor = 2 + i * 3;
+            IndexedMap *quantized = rgbMapQuantize(map, ncolor);
+            TS_ASSERT(quantized != NULL);
+            if (!quantized) {
+                continue;
+            }
+            TS_ASSERT(quantized->nrColors <= ncolor);
+            std::vector<RGB> palette = rgbMapPalette(map, ncolor);
+            TS_ASSERT_EQUALS((int)palette.size(), quantized->nrColors);
+            IndexedMap *indexed = rgbMapIndex(map, palette);
+            for (int y = 0; y < map->height; ++y) {
+                for (int x = 0; x < map->width; ++x) {
+                    RGB rgb = map->getPixel(map, x, y);
+                    int index = quantized->getPixel(quantized, x, y);
+                    int best = 0;
+                    for (int k = 1; k < quantized->nrColors; ++k) {
+                        if (dist(quantized->clut[k], rgb) < dist(quantized->clut[best], rgb)) {
+                            best = k;
+                        }
+                    }
+                    TS_ASSERT_EQUALS(index, best);
+                    TS_ASSERT_EQUALS(indexed->getPixel(indexed, x, y), (unsigned)index);
+                }
+            }
+            indexed->destroy(indexed);
+            quantized->destroy(quantized);
+            map->destroy(map);
+        }
+    }
+
+    // A scan sized image keeps to the number of colors asked for.
+    void testLargeImage()
+    {
+        int const sizes[4] = { 300, 1000, 3000, 7000 };
+        unsigned const count = g_getenv("INKSCAPE_BENCHMARK_QUANTIZE") ? G_N_ELEMENTS(sizes) : 1;
+        TS_TRACE("Benchmarking quantization...");
+        GTimer *timer = g_timer_new();
+        for (unsigned i = 0; i < count; ++i) {
+            std::srand(3);
+            RgbMap *map = scanMap(sizes[i], sizes[i]);
+            for (int ncolor = 8; ncolor <= 256; ncolor *= 32) {
+                g_timer_start(timer);
+                std::vector<RGB> palette = rgbMapPalette(map, ncolor);
+                double elapsed = g_timer_elapsed(timer, NULL);
+                std::cout << "Took " << elapsed << " seconds to build a palette of " << ncolor << " colors for "
+                          << sizes[i] << "x" << sizes[i] << " pixels\n";
+
+                g_timer_start(timer);
+                IndexedMap *quantized = rgbMapIndex(map, palette);
+                elapsed = g_timer_elapsed(timer, NULL);
+                std::cout << "Took " << elapsed << " seconds to index " << sizes[i] << "x" << sizes[i] << " pixels\n";
+
+                TS_ASSERT(!palette.empty() && (int)palette.size() <= ncolor);
+                TS_ASSERT(quantized != NULL);
+                if (quantized) {
+                    quantized->destroy(quantized);
+                }
+            }
+            map->destroy(map);
+        }
+        g_timer_destroy(timer);
+    }
+};
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -9,10 +9,22 @@
  * Released under GNU GPL, read the file 'COPYING' for more information
  */
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
 #include <cassert>
+#include <climits>
 #include <cstdio>
 #include <stdlib.h>
+#include <algorithm>
 #include <new>
+#include <vector>
+
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#include "preferences.h"
+#endif
 
 #include "pool.h"
 #include "imagemap.h"
@@ -78,9 +90,13 @@ struct Ocnode_def
   - ranges have no intersection, and a fork node has to be created (like in
     the given example).
 
-- a tree for an image is built dividing the image in 2 parts and merging
-  the trees obtained recursively for the two parts. a tree for a one pixel
-  part is a leaf like one of those which were given above.
+- a tree for an image is the result of merging the trees of all its
+  pixels. it only depends on the distinct colors of the image and on their
+  number of pixels, so it is built directly from the list of those colors,
+  sorted in the order of the tree: the root of a part of the list is at the
+  longest prefix its colors have in common, and the part is split between
+  children according to the bits that follow. a single color is a leaf like
+  those which were given above, weighted by its number of pixels.
 
 - last, this tree is reduced a specified number of leaves, deleting first
   leaves with minimal impact i.e. [ weight * 2^(2*parentwidth) ] value :
@@ -114,6 +130,10 @@ struct Ocnode_def
 - very last, color indexes are attributed to leaves; associated colors are
   averages, computed from weight and color components sums.
 
+- pixels are then given the index of the closest color of the palette. it
+  is searched once for each distinct color of the image, and only among
+  the palette colors whose red component is close enough to be a match.
+
 -- improvements to the usual octree method:
 
 - since this algorithm shall often be used to perform quantization using a
@@ -125,8 +145,8 @@ struct Ocnode_def
   depth of 8 for each pixel (at full precision), unless it is really
   required.
 
-- tree merging also fastens the overall tree building, and intermediate
-  processing could be done.
+- building the tree from the sorted colors takes a linear time, and
+  the tree has one leaf per color instead of one per pixel.
 
 - a huge optimization against the stupid removal algorithm (i.e. find a best
   match over the whole tree, remove it and do it again) was implemented:
@@ -141,6 +161,13 @@ struct Ocnode_def
 - pool allocation is used to allocate nodes (increased performance on large
   images).
 
+- on large images, colors are counted in a table of all the 2^24 colors
+  instead of being sorted, and when there are many colors, pixels look up
+  their index in such a table.
+
+- the closest palette colors, and the indexes of the pixels, are computed
+  by several threads when OpenMP is available.
+
 */
 
 inline RGB operator>>(RGB rgb, int s)
@@ -222,123 +249,23 @@ void octreePrint(Ocnode *node)
 #endif
 
 /**
- * builds a single <rgb> color leaf at location <ref>
+ * builds a single <rgb> color leaf accounting for <weight> pixels at
+ * location <ref>
  */
-static void ocnodeLeaf(pool<Ocnode> *pool, Ocnode **ref, RGB rgb)
+static void ocnodeLeaf(pool<Ocnode> *pool, Ocnode **ref, RGB rgb, unsigned long weight)
 {
     assert(ref);
     Ocnode *node = ocnodeNew(pool);
     node->width = 0;
     node->rgb = rgb;
-    node->rs = rgb.r; node->gs = rgb.g; node->bs = rgb.b;
-    node->weight = 1;
+    node->rs = rgb.r * weight; node->gs = rgb.g * weight; node->bs = rgb.b * weight;
+    node->weight = weight;
     node->nleaf = 1;
     node->mi = 0;
     node->ref = ref;
     *ref = node;
 }
 
-/**
- *  merge nodes <node1> and <node2> at location <ref> with parent <parent>
- */
-static int octreeMerge(pool<Ocnode> *pool, Ocnode *parent, Ocnode **ref, Ocnode *node1, Ocnode *node2)
-{
-    assert(ref);
-    if (!node1 && !node2) return 0;
-    assert(node1 != node2);
-    if (parent && !*ref) parent->nchild++;
-    if (!node1)
-        {
-        *ref = node2; node2->ref = ref; node2->parent = parent;
-        return node2->nleaf;
-        }
-    if (!node2)
-        {
-        *ref = node1; node1->ref = ref; node1->parent = parent;
-        return node1->nleaf;
-        }
-    int dwitdth = node1->width - node2->width;
-    if (dwitdth > 0 && node1->rgb == node2->rgb >> dwitdth)
-        {
-        //place node2 below node1
-        { *ref = node1; node1->ref = ref; node1->parent = parent; }
-        int i = childIndex(node2->rgb >> (dwitdth - 1));
-        node1->rs += node2->rs; node1->gs += node2->gs; node1->bs += node2->bs;
-        node1->weight += node2->weight;
-	node1->mi = 0;
-        if (node1->child[i]) node1->nleaf -= node1->child[i]->nleaf;
-        node1->nleaf +=
-          octreeMerge(pool, node1, &node1->child[i], node1->child[i], node2);
-        return node1->nleaf;
-        }
-    else if (dwitdth < 0 && node2->rgb == node1->rgb >> (-dwitdth))
-        {
-        //place node1 below node2
-        { *ref = node2; node2->ref = ref; node2->parent = parent; }
-        int i = childIndex(node1->rgb >> (-dwitdth - 1));
-        node2->rs += node1->rs; node2->gs += node1->gs; node2->bs += node1->bs;
-        node2->weight += node1->weight;
-	node2->mi = 0;
-        if (node2->child[i]) node2->nleaf -= node2->child[i]->nleaf;
-        node2->nleaf +=
-          octreeMerge(pool, node2, &node2->child[i], node2->child[i], node1);
-        return node2->nleaf;
-        }
-    else
-        {
-        //nodes have either no intersection or the same root
-        Ocnode *newnode;
-        newnode = ocnodeNew(pool);
-        newnode->rs = node1->rs + node2->rs;
-        newnode->gs = node1->gs + node2->gs;
-        newnode->bs = node1->bs + node2->bs;
-        newnode->weight = node1->weight + node2->weight;
-        { *ref = newnode; newnode->ref = ref; newnode->parent = parent; }
-        if (dwitdth == 0 && node1->rgb == node2->rgb)
-            {
-            //merge the nodes in <newnode>
-            newnode->width = node1->width; // == node2->width
-            newnode->rgb = node1->rgb;     // == node2->rgb
-            newnode->nchild = 0;
-            newnode->nleaf = 0;
-            if (node1->nchild == 0 && node2->nchild == 0)
-                newnode->nleaf = 1;
-            else
-                for (int i = 0; i < 8; i++)
-		  if (node1->child[i] || node2->child[i])
-                    newnode->nleaf +=
-		      octreeMerge(pool, newnode, &newnode->child[i],
-				  node1->child[i], node2->child[i]);
-            ocnodeFree(pool, node1); ocnodeFree(pool, node2);
-            return newnode->nleaf;
-            }
-        else
-            {
-            //use <newnode> as a fork node with children <node1> and <node2>
-            int newwidth =
-              node1->width > node2->width ? node1->width : node2->width;
-            RGB rgb1 = node1->rgb >> (newwidth - node1->width);
-            RGB rgb2 = node2->rgb >> (newwidth - node2->width);
-            //according to the previous tests <rgb1> != <rgb2> before the loop
-            while (!(rgb1 == rgb2))
-              { rgb1 = rgb1 >> 1; rgb2 = rgb2 >> 1; newwidth++; };
-            newnode->width = newwidth;
-            newnode->rgb = rgb1;  // == rgb2
-            newnode->nchild = 2;
-            newnode->nleaf = node1->nleaf + node2->nleaf;
-            int i1 = childIndex(node1->rgb >> (newwidth - node1->width - 1));
-            int i2 = childIndex(node2->rgb >> (newwidth - node2->width - 1));
-            node1->parent = newnode;
-            node1->ref = &newnode->child[i1];
-            newnode->child[i1] = node1;
-            node2->parent = newnode;
-            node2->ref = &newnode->child[i2];
-            newnode->child[i2] = node2;
-            return newnode->nleaf;
-            }
-        }
-}
-
 /**
  * upatade mi value for leaves
  */
@@ -436,47 +363,169 @@ static void octreePrune(pool<Ocnode> *pool, Ocnode **ref, int ncolor)
 }
 
 /**
- * build an octree associated to the area of a color map <rgbmap>,
- * included in the specified (x1,y1)--(x2,y2) rectangle.
+ * a color of a color map, packed as a key, and its number of pixels
+ */
+struct ColorCount
+{
+    unsigned int key;
+    unsigned long weight;
+};
+
+/**
+ * the bits of a color component, spread to every third bit
+ */
+static unsigned int spreadBits(unsigned int v)
+{
+    unsigned int spread = 0;
+    for (int i = 0; i < 8; i++)
+        spread |= ((v >> i) & 1) << (3 * i);
+    return spread;
+}
+
+/**
+ * packs a color as a key whose bits are interleaved the way childIndex()
+ * combines them: colors sorted by key are in the order of the octree, and
+ * colors close in the list are close in the tree.
+ */
+class ColorKeys
+{
+public:
+    ColorKeys()
+    {
+        for (unsigned int v = 0; v < 256; v++)
+            _spread[v] = spreadBits(v);
+    }
+    unsigned int key(RGB rgb) const
+    {
+        return (_spread[rgb.r] << 2) | (_spread[rgb.g] << 1) | _spread[rgb.b];
+    }
+    static RGB color(unsigned int key)
+    {
+        RGB rgb;
+        rgb.r = rgb.g = rgb.b = 0;
+        for (int i = 0; i < 8; i++)
+            {
+            rgb.r |= ((key >> (3 * i + 2)) & 1) << i;
+            rgb.g |= ((key >> (3 * i + 1)) & 1) << i;
+            rgb.b |= ((key >> (3 * i)) & 1) << i;
+            }
+        return rgb;
+    }
+private:
+    unsigned int _spread[256];
+};
+
+/**
+ * from this number of pixels on, colors are counted in a table of all the
+ * 2^24 colors instead of being sorted
  */
-static void octreeBuildArea(pool<Ocnode> *pool, RgbMap *rgbmap, Ocnode **ref,
-                            int x1, int y1, int x2, int y2, int ncolor)
+static const long DENSE_PIXELS = 1L << 22;
+
+/**
+ * from this number of colors on, pixels find their color index in a table
+ * of all the 2^24 colors instead of searching the color list
+ */
+static const size_t DENSE_COLORS = 1 << 12;
+
+/**
+ * list the distinct colors of a color map <rgbmap>, in increasing order
+ */
+static void colorHistogram(RgbMap *rgbmap, std::vector<ColorCount> &colors)
 {
-    int dx = x2 - x1, dy = y2 - y1;
-    int xm = x1 + dx/2, ym = y1 + dy/2;
-    Ocnode *ref1 = NULL;
-    Ocnode *ref2 = NULL;
-    if (dx == 1 && dy == 1)
-        ocnodeLeaf(pool, ref, rgbmap->getPixel(rgbmap, x1, y1));
-    else if (dx > dy)
+    ColorKeys keys;
+    colors.clear();
+    if ((long)rgbmap->width * rgbmap->height >= DENSE_PIXELS)
         {
-	octreeBuildArea(pool, rgbmap, &ref1, x1, y1, xm, y2, ncolor);
-	octreeBuildArea(pool, rgbmap, &ref2, xm, y1, x2, y2, ncolor);
-	octreeMerge(pool, NULL, ref, ref1, ref2);
-	}
+        std::vector<unsigned int> counts(1 << 24, 0);
+        for (int y = 0; y < rgbmap->height; y++)
+            for (int x = 0; x < rgbmap->width; x++)
+                counts[keys.key(rgbmap->getPixel(rgbmap, x, y))]++;
+        for (unsigned int c = 0; c < counts.size(); c++)
+            if (counts[c])
+                {
+                ColorCount cc = { c, counts[c] };
+                colors.push_back(cc);
+                }
+        }
     else
         {
-	octreeBuildArea(pool, rgbmap, &ref1, x1, y1, x2, ym, ncolor);
-	octreeBuildArea(pool, rgbmap, &ref2, x1, ym, x2, y2, ncolor);
-	octreeMerge(pool, NULL, ref, ref1, ref2);
-	}
+        std::vector<unsigned int> packed;
+        packed.reserve((long)rgbmap->width * rgbmap->height);
+        for (int y = 0; y < rgbmap->height; y++)
+            for (int x = 0; x < rgbmap->width; x++)
+                packed.push_back(keys.key(rgbmap->getPixel(rgbmap, x, y)));
+        std::sort(packed.begin(), packed.end());
+        for (size_t i = 0; i < packed.size(); i++)
+            {
+            if (colors.empty() || colors.back().key != packed[i])
+                {
+                ColorCount cc = { packed[i], 0 };
+                colors.push_back(cc);
+                }
+            colors.back().weight++;
+            }
+        }
+}
+
+/**
+ * build an octree associated to the colors <begin> to <end> (excluded) of
+ * a color list sorted by key, at location <ref> with parent <parent>.
+ */
+static void octreeBuildColors(pool<Ocnode> *pool, std::vector<ColorCount> const &colors,
+                              Ocnode *parent, Ocnode **ref, size_t begin, size_t end)
+{
+    if (end - begin == 1)
+        {
+        ocnodeLeaf(pool, ref, ColorKeys::color(colors[begin].key), colors[begin].weight);
+        (*ref)->parent = parent;
+        return;
+        }
 
-    //octreePrune(ref, 2*ncolor);
-    //affects result quality for almost same performance :/
+    //the colors have the prefix of the first and the last ones in common
+    unsigned int first = colors[begin].key;
+    unsigned int last = colors[end - 1].key;
+    int width = 1;
+    while ((first >> (3 * width)) != (last >> (3 * width)))
+        width++;
+
+    Ocnode *node = ocnodeNew(pool);
+    node->width = width;
+    node->rgb = ColorKeys::color(first) >> width;
+    node->rs = node->gs = node->bs = 0;
+    node->weight = 0;
+    node->nleaf = 0;
+    { *ref = node; node->ref = ref; node->parent = parent; }
+
+    //one child for each value of the following bits
+    size_t start = begin;
+    while (start < end)
+        {
+        unsigned int i = (colors[start].key >> (3 * (width - 1))) & 7;
+        size_t stop = start + 1;
+        while (stop < end && ((colors[stop].key >> (3 * (width - 1))) & 7) == i)
+            stop++;
+        octreeBuildColors(pool, colors, node, &node->child[i], start, stop);
+        Ocnode *child = node->child[i];
+        node->rs += child->rs; node->gs += child->gs; node->bs += child->bs;
+        node->weight += child->weight;
+        node->nleaf += child->nleaf;
+        node->nchild++;
+        start = stop;
+        }
 }
 
 /**
- * build an octree associated to the <rgbmap> color map,
+ * build an octree associated to the <colors> color list,
  * pruned to <ncolor> colors.
  */
-static Ocnode *octreeBuild(pool<Ocnode> *pool, RgbMap *rgbmap, int ncolor)
+static Ocnode *octreeBuild(pool<Ocnode> *pool, std::vector<ColorCount> const &colors, int ncolor)
 {
+    if (colors.empty())
+        return NULL;
+
     //create the octree
     Ocnode *node = NULL;
-    octreeBuildArea(pool,
-                    rgbmap, &node,
-                    0, 0, rgbmap->width, rgbmap->height, ncolor
-                    );
+    octreeBuildColors(pool, colors, NULL, &node, 0, colors.size());
 
     //prune the octree
     octreePrune(pool, &node, ncolor);
@@ -516,22 +565,6 @@ static int distRGB(RGB rgb1, RGB rgb2)
     + (rgb1.b - rgb2.b) * (rgb1.b - rgb2.b);
 }
 
-/**
- * find the index of closest color in a palette
- */
-static int findRGB(RGB *rgbpal, int ncolor, RGB rgb)
-{
-    //assert(ncolor > 0);
-    //assert(rgbpal);
-    int index = -1, dist = 0;
-    for (int k = 0; k < ncolor; k++)
-        {
-        int d = distRGB(rgbpal[k], rgb);
-        if (index == -1 || d < dist) { dist = d; index = k; }
-        }
-    return index;
-}
-
 /**
  * (qsort) compare two colors for brightness
  */
@@ -542,55 +575,205 @@ static int compRGB(const void *a, const void *b)
 }
 
 /**
- * quantize an RGB image to a reduced number of colors.
+ * compute the palette of the <colors> color list.
  */
-IndexedMap *rgbMapQuantize(RgbMap *rgbmap, int ncolor)
+static void colorsPalette(std::vector<ColorCount> const &colors, int ncolor,
+                          std::vector<RGB> &palette)
 {
-    assert(rgbmap);
-    assert(ncolor > 0);
-
-    IndexedMap *newmap = 0;
+    palette.clear();
 
     pool<Ocnode> pool;
 
     Ocnode *tree = 0;
     try {
-        tree = octreeBuild(&pool, rgbmap, ncolor);
+        tree = octreeBuild(&pool, colors, ncolor);
     }
     catch (std::bad_alloc &ex) {
         //should do smthg else?
     }
 
     if ( tree ) {
-        RGB *rgbpal = new RGB[ncolor];
+        palette.resize(ncolor);
         int indexes = 0;
-        octreeIndex(tree, rgbpal, &indexes);
+        octreeIndex(tree, &palette[0], &indexes);
+        palette.resize(indexes);
 
         octreeDelete(&pool, tree);
 
         // stacking with increasing contrasts
-        qsort((void *)rgbpal, indexes, sizeof(RGB), compRGB);
-
-        // make the new map
-        newmap = IndexedMapCreate(rgbmap->width, rgbmap->height);
-        if (newmap) {
-            // fill in the color lookup table
-            for (int i = 0; i < indexes; i++) {
-                newmap->clut[i] = rgbpal[i];
+        qsort((void *)&palette[0], indexes, sizeof(RGB), compRGB);
+    }
+}
+
+/**
+ * (sort) compare two palette indexes for the red component of their color
+ */
+struct RedLess
+{
+    RedLess(std::vector<RGB> const &palette) : _palette(palette) {}
+    bool operator()(int a, int b) const
+    {
+        return _palette[a].r < _palette[b].r;
+    }
+    bool operator()(int a, unsigned char r) const
+    {
+        return _palette[a].r < r;
+    }
+    std::vector<RGB> const &_palette;
+};
+
+/**
+ * find the index of closest color in a palette; when several are as
+ * close, the first one.
+ *
+ * the palette indexes are sorted by red component in <byRed>: the search
+ * starts at the red component of <rgb>, and goes in both directions until
+ * the red difference alone is larger than the best distance found.
+ */
+static int findRGB(std::vector<RGB> const &rgbpal, std::vector<int> const &byRed, RGB rgb)
+{
+    int index = -1, dist = INT_MAX;
+    int start = std::lower_bound(byRed.begin(), byRed.end(), rgb.r, RedLess(rgbpal)) - byRed.begin();
+    for (int k = start; k < (int)byRed.size(); k++)
+        {
+        int dr = rgbpal[byRed[k]].r - rgb.r;
+        if (dr * dr > dist) break;
+        int d = distRGB(rgbpal[byRed[k]], rgb);
+        if (d < dist || (d == dist && byRed[k] < index)) { dist = d; index = byRed[k]; }
+        }
+    for (int k = start - 1; k >= 0; k--)
+        {
+        int dr = rgb.r - rgbpal[byRed[k]].r;
+        if (dr * dr > dist) break;
+        int d = distRGB(rgbpal[byRed[k]], rgb);
+        if (d < dist || (d == dist && byRed[k] < index)) { dist = d; index = byRed[k]; }
+        }
+    return index;
+}
+
+/**
+ * (lower_bound) compare a color of the list to a color key
+ */
+static bool colorLess(ColorCount const &cc, unsigned int key)
+{
+    return cc.key < key;
+}
+
+/**
+ * make the indexed map of <rgbmap>, whose distinct colors are <colors>,
+ * with the closest colors of <palette>.
+ */
+static IndexedMap *colorsIndex(RgbMap *rgbmap, std::vector<ColorCount> const &colors,
+                               std::vector<RGB> const &palette)
+{
+    IndexedMap *newmap = IndexedMapCreate(rgbmap->width, rgbmap->height);
+    if (!newmap)
+        return NULL;
+
+    // fill in the color lookup table
+    for (unsigned i = 0; i < palette.size(); i++) {
+        newmap->clut[i] = palette[i];
+    }
+    newmap->nrColors = palette.size();
+
+#ifdef HAVE_OPENMP
+    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+    int numOfThreads = prefs->getIntLimited("/options/threading/numthreads", omp_get_num_procs(), 1, 256);
+    if (numOfThreads){} // inform compiler we are using it.
+#endif
+
+    // find the closest palette color once for each color of the image
+    std::vector<int> byRed(palette.size());
+    for (unsigned i = 0; i < palette.size(); i++) {
+        byRed[i] = i;
+    }
+    std::stable_sort(byRed.begin(), byRed.end(), RedLess(palette));
+
+    int ncolors = colors.size();
+    std::vector<unsigned char> closest(ncolors);
+#ifdef HAVE_OPENMP
+#pragma omp parallel for num_threads(numOfThreads)
+#endif
+    for (int i = 0; i < ncolors; i++) {
+        closest[i] = findRGB(palette, byRed, ColorKeys::color(colors[i].key));
+    }
+
+    // fill in new map pixels
+    ColorKeys keys;
+    if (colors.size() >= DENSE_COLORS) {
+        std::vector<unsigned char> table(1 << 24, 0);
+        for (int i = 0; i < ncolors; i++) {
+            table[colors[i].key] = closest[i];
+        }
+#ifdef HAVE_OPENMP
+#pragma omp parallel for num_threads(numOfThreads)
+#endif
+        for (int y = 0; y < rgbmap->height; y++) {
+            for (int x = 0; x < rgbmap->width; x++) {
+                newmap->setPixel(newmap, x, y, table[keys.key(rgbmap->getPixel(rgbmap, x, y))]);
             }
-            newmap->nrColors = indexes;
-
-            // fill in new map pixels
-            for (int y = 0; y < rgbmap->height; y++) {
-                for (int x = 0; x < rgbmap->width; x++) {
-                    RGB rgb = rgbmap->getPixel(rgbmap, x, y);
-                    int index = findRGB(rgbpal, ncolor, rgb);
-                    newmap->setPixel(newmap, x, y, index);
-                }
+        }
+    } else {
+#ifdef HAVE_OPENMP
+#pragma omp parallel for num_threads(numOfThreads)
+#endif
+        for (int y = 0; y < rgbmap->height; y++) {
+            for (int x = 0; x < rgbmap->width; x++) {
+                unsigned int key = keys.key(rgbmap->getPixel(rgbmap, x, y));
+                int i = std::lower_bound(colors.begin(), colors.end(), key, colorLess) - colors.begin();
+                newmap->setPixel(newmap, x, y, closest[i]);
             }
         }
-        delete[] rgbpal;
     }
 
     return newmap;
 }
+
+/**
+ * compute the palette used to quantize an RGB image.
+ */
+std::vector<RGB> rgbMapPalette(RgbMap *rgbmap, int ncolor)
+{
+    assert(rgbmap);
+    assert(ncolor > 0);
+
+    std::vector<ColorCount> colors;
+    colorHistogram(rgbmap, colors);
+
+    std::vector<RGB> palette;
+    colorsPalette(colors, ncolor, palette);
+    return palette;
+}
+
+/**
+ * give the pixels of an RGB image the index of the closest palette color.
+ */
+IndexedMap *rgbMapIndex(RgbMap *rgbmap, std::vector<RGB> const &palette)
+{
+    assert(rgbmap);
+    assert(!palette.empty() && palette.size() <= 256);
+
+    std::vector<ColorCount> colors;
+    colorHistogram(rgbmap, colors);
+
+    return colorsIndex(rgbmap, colors, palette);
+}
+
+/**
+ * quantize an RGB image to a reduced number of colors.
+ */
+IndexedMap *rgbMapQuantize(RgbMap *rgbmap, int ncolor)
+{
+    assert(rgbmap);
+    assert(ncolor > 0);
+
+    std::vector<ColorCount> colors;
+    colorHistogram(rgbmap, colors);
+
+    std::vector<RGB> palette;
+    colorsPalette(colors, ncolor, palette);
+    if (palette.empty())
+        return NULL;
+
+    return colorsIndex(rgbmap, colors, palette);
+}
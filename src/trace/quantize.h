@@ -12,6 +12,7 @@
 #ifndef __QUANTIZE_H__
 #define __QUANTIZE_H__
 
+#include <vector>
 #include "imagemap.h"
 
 /**
@@ -19,4 +20,14 @@
  */
 IndexedMap *rgbMapQuantize(RgbMap *rgbmap, int nrColors);
 
+/**
+ * The colors rgbMapQuantize() reduces an RGB image to, sorted by brightness.
+ */
+std::vector<RGB> rgbMapPalette(RgbMap *rgbmap, int nrColors);
+
+/**
+ * Map an RGB image to the closest colors of a palette of at most 256 colors.
+ */
+IndexedMap *rgbMapIndex(RgbMap *rgbmap, std::vector<RGB> const &palette);
+
 #endif /* __QUANTIZE_H__ */
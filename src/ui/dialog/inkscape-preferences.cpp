@@ -1421,6 +1421,9 @@ void InkscapePreferences::initPageRendering()
     _rendering_cache_size.init("/options/renderingcache/size", 0.0, 4096.0, 1.0, 32.0, 64.0, true, false);
     _page_rendering.add_line( false, _("Rendering _cache size:"), _rendering_cache_size, C_("mebibyte (2^20 bytes) abbreviation","MiB"), _("Set the amount of memory per document which can be used to store rendered parts of the drawing for later reuse; set to zero to disable caching"), false);
 
+    _rendering_glyph_cache_size.init("/options/renderingcache/glyphs", 0.0, 1024.0, 1.0, 4.0, 16.0, true, false);
+    _page_rendering.add_line( false, _("_Glyph cache size:"), _rendering_glyph_cache_size, C_("mebibyte (2^20 bytes) abbreviation","MiB"), _("Set the amount of memory which can be used to store glyph outlines and small rendered glyphs for drawing text; set to zero to disable caching"), false);
+
     /* blur quality */
     _blur_quality_best.init ( _("Best quality (slowest)"), "/options/blurquality/value",
                                   BLUR_QUALITY_BEST, false, 0);
@@ -1444,6 +1447,9 @@ void InkscapePreferences::initPageRendering()
                            _("Lower quality (some artifacts), but display is faster"));
     _page_rendering.add_line( true, "", _blur_quality_worst, "",
                            _("Lowest quality (considerable artifacts), but display is fastest"));
+    _blur_quality_box.init ( _("Approximate lower quality blurs by box blurs"), "/options/blurquality/boxblur", false);
+    _page_rendering.add_line( true, "", _blur_quality_box, "",
+                           _("Use three box blurs instead of a gaussian blur for the lower and lowest qualities; faster, but less exact"));
 
     /* filter quality */
     _filter_quality_best.init ( _("Best quality (slowest)"), "/options/filterquality/value",
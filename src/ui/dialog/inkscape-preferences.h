@@ -292,6 +292,7 @@ protected:
     UI::Widget::PrefRadioButton _blur_quality_normal;
     UI::Widget::PrefRadioButton _blur_quality_worse;
     UI::Widget::PrefRadioButton _blur_quality_worst;
+    UI::Widget::PrefCheckButton _blur_quality_box;
     UI::Widget::PrefRadioButton _filter_quality_best;
     UI::Widget::PrefRadioButton _filter_quality_better;
     UI::Widget::PrefRadioButton _filter_quality_normal;
@@ -302,6 +303,7 @@ protected:
     UI::Widget::PrefCombo       _switcher_style;
     UI::Widget::PrefCheckButton _rendering_image_outline;
     UI::Widget::PrefSpinButton  _rendering_cache_size;
+    UI::Widget::PrefSpinButton  _rendering_glyph_cache_size;
     UI::Widget::PrefSpinButton  _filter_multi_threaded;
 
     UI::Widget::PrefCheckButton _trans_scale_stroke;
@@ -13,6 +13,7 @@
 #include "live_effects/lpe-powerstroke.h"
 #include "live_effects/lpe-bspline.h"
 #include "live_effects/lpe-fillet-chamfer.h"
+#include <algorithm>
 #include <string>
 #include <sstream>
 #include <deque>
@@ -108,6 +109,11 @@ private:
 };
 
 void build_segment(Geom::PathBuilder &, Node *, Node *);
+void build_subpath(Geom::PathBuilder &, NodeList &);
+void build_segments(Geom::PathBuilder &, NodeList::iterator, unsigned);
+void store_positions(NodeList &, std::vector<Geom::Point> &);
+void patch_segments(Geom::Path &, Geom::Path &, NodeList::iterator, unsigned, unsigned,
+    Geom::Affine const &, Geom::OptRect &);
 PathManipulator::PathManipulator(MultiPathManipulator &mpm, SPPath *path,
         Geom::Affine const &et, guint32 outline_color, Glib::ustring lpe_key)
     : PointManipulator(mpm._path_data.node_data.desktop, *mpm._path_data.node_data.selection)
@@ -115,6 +121,7 @@ PathManipulator::PathManipulator(MultiPathManipulator &mpm, SPPath *path,
     , _multi_path_manipulator(mpm)
     , _path(path)
     , _spcurve(new SPCurve())
+    , _geometry_valid(false)
     , _dragpoint(new CurveDragPoint(*this))
     , /* XML Tree being used here directly while it shouldn't be*/_observer(new PathManipulatorObserver(this, path->getRepr()))
     , _edit_transform(et)
@@ -972,6 +979,7 @@ void PathManipulator::setControlsTransform(Geom::Affine const &tnew)
 {
     Geom::Affine delta = _i2d_transform.inverse() * _edit_transform.inverse() * tnew * _i2d_transform;
     _edit_transform = tnew;
+    _geometry_valid = false;
     for (SubpathList::iterator i = _subpaths.begin(); i != _subpaths.end(); ++i) {
         for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j) {
             j->transform(delta);
@@ -1131,6 +1139,7 @@ void PathManipulator::_externalChange(unsigned type)
         _i2d_transform = _path->i2dt_affine();
         _d2i_transform = _i2d_transform.inverse();
         i2d_change *= _i2d_transform;
+        _geometry_valid = false;
         for (SubpathList::iterator i = _subpaths.begin(); i != _subpaths.end(); ++i) {
             for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j) {
                 j->transform(i2d_change);
@@ -1161,6 +1170,7 @@ void PathManipulator::_createControlPointsFromGeometry()
         }
     }
     _spcurve->set_pathvector(pathv);
+    _geometry_valid = false;
 
     pathv *= (_edit_transform * _i2d_transform);
 
@@ -1338,35 +1348,46 @@ Geom::Point PathManipulator::_bsplineHandleReposition(Handle *h,double pos){
  */
 void PathManipulator::_createGeometryFromControlPoints(bool alert_LPE)
 {
-    Geom::PathBuilder builder;
     //Refresh if is bspline some times -think on path change selection, this value get lost
     _recalculateIsBSpline();
     for (std::list<SubpathPtr>::iterator spi = _subpaths.begin(); spi != _subpaths.end(); ) {
-        SubpathPtr subpath = *spi;
-        if (subpath->empty()) {
+        if ((*spi)->empty()) {
             _subpaths.erase(spi++);
-            continue;
+        } else {
+            ++spi;
         }
-        NodeList::iterator prev = subpath->begin();
-        builder.moveTo(prev->position());
-        for (NodeList::iterator i = ++subpath->begin(); i != subpath->end(); ++i) {
-            build_segment(builder, prev.ptr(), i.ptr());
-            prev = i;
+    }
+
+    Geom::Affine d2i = (_edit_transform * _i2d_transform).inverse();
+    // When dragging a few nodes of a long path, only the segments next to them need
+    // to be rebuilt; the rest of the path built last time is kept.
+    bool incremental = _geometry_valid && _edit_pathv.size() == _subpaths.size()
+        && _spcurve->get_pathvector().size() == _subpaths.size();
+    Geom::OptRect changed; // in desktop coordinates
+    if (incremental) {
+        Geom::PathVector pathv = _spcurve->get_pathvector();
+        unsigned index = 0;
+        for (SubpathList::iterator i = _subpaths.begin(); i != _subpaths.end(); ++i, ++index) {
+            _updateSubpathGeometry(**i, index, pathv, d2i, changed);
         }
-        if (subpath->closed()) {
-            // Here we link the last and first node if the path is closed.
-            // If the last segment is Bezier, we add it.
-            if (!prev->front()->isDegenerate() || !subpath->begin()->back()->isDegenerate()) {
-                build_segment(builder, prev.ptr(), subpath->begin().ptr());
-            }
-            // if that segment is linear, we just call closePath().
-            builder.closePath();
+        if (changed) {
+            _spcurve->set_pathvector(pathv);
         }
-        ++spi;
+    } else {
+        Geom::PathBuilder builder;
+        _built_positions.resize(_subpaths.size());
+        unsigned index = 0;
+        for (SubpathList::iterator i = _subpaths.begin(); i != _subpaths.end(); ++i, ++index) {
+            build_subpath(builder, **i);
+            store_positions(**i, _built_positions[index]);
+        }
+        builder.flush();
+        _edit_pathv = builder.peek();
+        _spcurve->set_pathvector(_edit_pathv * d2i);
+        _geometry_valid = true;
     }
-    builder.flush();
-    Geom::PathVector pathv = builder.peek() * (_edit_transform * _i2d_transform).inverse();
-    _spcurve->set_pathvector(pathv);
+
+    Geom::PathVector const &pathv = _spcurve->get_pathvector();
     if (alert_LPE) {
         /// \todo note that _path can be an Inkscape::LivePathEffect::Effect* too, kind of confusing, rework member naming?
         if (SP_IS_LPE_ITEM(_path) && _path->hasPathEffect()) {
@@ -1387,10 +1408,155 @@ void PathManipulator::_createGeometryFromControlPoints(bool alert_LPE)
         }
     }
 
-    if (_live_outline)
-        _updateOutline();
-    if (_live_objects)
-        _setGeometry();
+    if (incremental) {
+        Geom::OptRect changed_item;
+        if (changed) {
+            changed_item = *changed * d2i;
+        }
+        if (_live_outline)
+            _updateOutline(changed);
+        if (_live_objects)
+            _setGeometry(changed_item);
+    } else {
+        if (_live_outline)
+            _updateOutline();
+        if (_live_objects)
+            _setGeometry();
+    }
+}
+
+/** Rebuild the segments of a subpath next to the nodes that moved since it was last built,
+ * and patch them into _edit_pathv and the item coordinate path pathv.
+ * The area where the desktop coordinate path changed is added to changed. */
+void PathManipulator::_updateSubpathGeometry(Subpath &subpath, unsigned index,
+    Geom::PathVector &pathv, Geom::Affine const &d2i, Geom::OptRect &changed)
+{
+    std::vector<Geom::Point> &positions = _built_positions[index];
+    Geom::Path &edit_path = _edit_pathv[index];
+    Geom::Path &path = pathv[index];
+    bool closed = subpath.closed();
+    unsigned n = subpath.size();
+    // Segment k goes from node k to node k+1. The last two segments of a closed subpath
+    // are only changed by rebuilding it whole, because closing the path can merge them.
+    // The end nodes of an open subpath also rebuild it whole: the fill closes it with a
+    // line between them, so the area that changes reaches back to the other end.
+    bool rebuild = positions.size() != 3 * n || edit_path.closed() != closed;
+
+    try {
+        // run of segments [first, end) to rebuild, starting at node first_node
+        unsigned first = 0, end = 0, k = 0;
+        NodeList::iterator first_node, prev;
+        for (NodeList::iterator i = subpath.begin(); !rebuild && i != subpath.end(); ++i, ++k) {
+            Geom::Point *p = &positions[3 * k];
+            if (p[0] != i->position() || p[1] != i->front()->position()
+                || p[2] != i->back()->position())
+            {
+                p[0] = i->position();
+                p[1] = i->front()->position();
+                p[2] = i->back()->position();
+                if (n == 1 || k == 0 || k + 1 == n || (closed && k + 2 == n)) {
+                    rebuild = true;
+                    break;
+                }
+                unsigned lo = k > 0 ? k - 1 : 0;
+                unsigned hi = std::min(k + 1, n - 1);
+                if (end > first && lo <= end) {
+                    end = hi;
+                } else {
+                    if (end > first) {
+                        patch_segments(edit_path, path, first_node, first, end - first, d2i, changed);
+                    }
+                    first = lo;
+                    end = hi;
+                    first_node = k > 0 ? prev : i;
+                }
+            }
+            prev = i;
+        }
+        if (!rebuild && end > first) {
+            patch_segments(edit_path, path, first_node, first, end - first, d2i, changed);
+        }
+    } catch (Geom::ContinuityError &) {
+        rebuild = true;
+    }
+
+    if (rebuild) {
+        Geom::PathBuilder builder;
+        build_subpath(builder, subpath);
+        builder.flush();
+        changed.unionWith(edit_path.boundsFast());
+        edit_path = builder.peek().front();
+        changed.unionWith(edit_path.boundsFast());
+        path = edit_path * d2i;
+        store_positions(subpath, positions);
+    }
+}
+
+/** Replace count segments of a built subpath, starting with segment index, by ones
+ * rebuilt from the nodes starting at first_node. edit_path is in desktop coordinates,
+ * path is the same in item coordinates. The area where edit_path changed is added to changed.
+ * @relates PathManipulator */
+void patch_segments(Geom::Path &edit_path, Geom::Path &path, NodeList::iterator first_node,
+    unsigned index, unsigned count, Geom::Affine const &d2i, Geom::OptRect &changed)
+{
+    Geom::PathBuilder builder;
+    build_segments(builder, first_node, count);
+    builder.flush();
+    Geom::Path const &piece = builder.peek().front();
+
+    for (unsigned k = index; k < index + count; ++k) {
+        changed.unionWith(edit_path[k].boundsFast());
+    }
+    changed.unionWith(piece.boundsFast());
+    edit_path.replace(edit_path.begin() + index, edit_path.begin() + index + count, piece);
+    path.replace(path.begin() + index, path.begin() + index + count, piece * d2i);
+}
+
+/** Build the geometric representation of a subpath.
+ * @relates PathManipulator */
+void build_subpath(Geom::PathBuilder &builder, NodeList &subpath)
+{
+    NodeList::iterator prev = subpath.begin();
+    builder.moveTo(prev->position());
+    for (NodeList::iterator i = ++subpath.begin(); i != subpath.end(); ++i) {
+        build_segment(builder, prev.ptr(), i.ptr());
+        prev = i;
+    }
+    if (subpath.closed()) {
+        // Here we link the last and first node if the path is closed.
+        // If the last segment is Bezier, we add it.
+        if (!prev->front()->isDegenerate() || !subpath.begin()->back()->isDegenerate()) {
+            build_segment(builder, prev.ptr(), subpath.begin().ptr());
+        }
+        // if that segment is linear, we just call closePath().
+        builder.closePath();
+    }
+}
+
+/** Build count consecutive segments as an open path, starting at the given node.
+ * @relates PathManipulator */
+void build_segments(Geom::PathBuilder &builder, NodeList::iterator first, unsigned count)
+{
+    NodeList::iterator prev = first;
+    builder.moveTo(first->position());
+    for (unsigned k = 0; k < count; ++k) {
+        NodeList::iterator i = prev;
+        ++i;
+        build_segment(builder, prev.ptr(), i.ptr());
+        prev = i;
+    }
+}
+
+/** Store the positions of the nodes and handles of a subpath, to detect later changes.
+ * @relates PathManipulator */
+void store_positions(NodeList &subpath, std::vector<Geom::Point> &positions)
+{
+    positions.clear();
+    for (NodeList::iterator i = subpath.begin(); i != subpath.end(); ++i) {
+        positions.push_back(i->position());
+        positions.push_back(i->front()->position());
+        positions.push_back(i->back()->position());
+    }
 }
 
 /** Build one segment of the geometric representation.
@@ -1467,10 +1633,26 @@ void PathManipulator::_updateOutline()
     _hc->unref();
 }
 
+/** Update the path outline after the path changed only within the given area,
+ * in desktop coordinates. */
+void PathManipulator::_updateOutline(Geom::OptRect const &changed)
+{
+    if (!_show_outline || _show_path_direction) {
+        _updateOutline();
+        return;
+    }
+
+    SPCurve *_hc = new SPCurve(_edit_pathv);
+    sp_canvas_bpath_set_bpath_partial(SP_CANVAS_BPATH(_outline), _hc, changed);
+    sp_canvas_item_show(_outline);
+    _hc->unref();
+}
+
 /** Retrieve the geometry of the edited object from the object tree */
 void PathManipulator::_getGeometry()
 {
     using namespace Inkscape::LivePathEffect;
+    _geometry_valid = false;
     if (!_lpe_key.empty()) {
         Effect *lpe = LIVEPATHEFFECT(_path)->get_lpe();
         if (lpe) {
@@ -1513,6 +1695,20 @@ void PathManipulator::_setGeometry()
     }
 }
 
+/** Set the geometry of the edited object after it changed only within the given area,
+ * in item coordinates. */
+void PathManipulator::_setGeometry(Geom::OptRect const &changed)
+{
+    //XML Tree being used here directly while it shouldn't be.
+    if (empty() || !_lpe_key.empty() || _path->hasPathEffect()
+        || _path->getRepr()->attribute("inkscape:original-d"))
+    {
+        _setGeometry();
+        return;
+    }
+    _path->setCurve(_spcurve, false, changed);
+}
+
 /** Figure out in what attribute to store the nodetype string. */
 Glib::ustring PathManipulator::_nodetypesKey()
 {
@@ -13,6 +13,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <2geom/pathvector.h>
 #include <2geom/affine.h>
 #include <boost/shared_ptr.hpp>
@@ -115,12 +116,16 @@ private:
     Geom::Point _bsplineHandleReposition(Handle *h, bool check_other = true);
     Geom::Point _bsplineHandleReposition(Handle *h, double pos);
     void _createGeometryFromControlPoints(bool alert_LPE = false);
+    void _updateSubpathGeometry(Subpath &subpath, unsigned index, Geom::PathVector &pathv,
+        Geom::Affine const &d2i, Geom::OptRect &changed);
     unsigned _deleteStretch(NodeList::iterator first, NodeList::iterator last, bool keep_shape);
     std::string _createTypeString();
     void _updateOutline();
+    void _updateOutline(Geom::OptRect const &changed);
     //void _setOutline(Geom::PathVector const &);
     void _getGeometry();
     void _setGeometry();
+    void _setGeometry(Geom::OptRect const &changed);
     Glib::ustring _nodetypesKey();
     Inkscape::XML::Node *_getXMLNode();
 
@@ -144,6 +149,11 @@ private:
     MultiPathManipulator &_multi_path_manipulator;
     SPPath *_path; ///< can be an SPPath or an Inkscape::LivePathEffect::Effect  !!!
     SPCurve *_spcurve; // in item coordinates
+    Geom::PathVector _edit_pathv; ///< the same path in desktop coordinates, as built from nodes
+    /// Positions of each node and its handles, per subpath, when _edit_pathv was built.
+    /// Used to find the segments that need rebuilding after nodes move.
+    std::vector<std::vector<Geom::Point> > _built_positions;
+    bool _geometry_valid; ///< whether the above match _spcurve and the current transforms
     SPCanvasItem *_outline;
     CurveDragPoint *_dragpoint; // an invisible control point hovering over curve
     PathManipulatorObserver *_observer;
@@ -207,6 +207,12 @@ void NodeTool::setup() {
     data.node_data.node_group = create_control_group(this->desktop);
     data.node_data.handle_group = create_control_group(this->desktop);
 
+    // Editing a large path shows a knot for each of thousands of nodes and handles; index them
+    // so that redraws and picking only look at the knots nearby.
+    sp_canvas_group_set_indexed(data.node_data.node_group, true);
+    sp_canvas_group_set_indexed(data.node_data.handle_group, true);
+    sp_canvas_group_set_indexed(data.node_data.handle_line_group, true);
+
     Inkscape::Selection *selection = this->desktop->getSelection();
 
     this->_selection_changed_connection.disconnect();
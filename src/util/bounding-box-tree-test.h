@@ -0,0 +1,82 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cstdlib>
+#include <vector>
+#include "util/bounding-box-tree.h"
+
+class BoundingBoxTreeTest : public CxxTest::TestSuite {
+public:
+    BoundingBoxTreeTest() {}
+    virtual ~BoundingBoxTreeTest() {}
+
+// createSuite and destroySuite get us per-suite setup and teardown
+// without us having to worry about static initialization order, etc.
+    static BoundingBoxTreeTest *createSuite() { return new BoundingBoxTreeTest(); }
+    static void destroySuite( BoundingBoxTreeTest *suite ) { delete suite; }
+
+    void testEmpty()
+    {
+        Inkscape::Util::BoundingBoxTree<int> tree;
+        tree.build();
+        std::vector<unsigned> found;
+        tree.intersecting(Geom::Rect(0, 0, 10, 10), found);
+        TS_ASSERT(found.empty());
+    }
+
+    void testMatchesLinearSearch()
+    {
+        std::vector<Geom::OptRect> boxes;
+        Inkscape::Util::BoundingBoxTree<int> tree;
+        srand(1);
+        for (int i = 0; i < 2000; ++i) {
+            double x = rand() % 1000, y = rand() % 1000;
+            Geom::OptRect box;
+            if (i % 13) {
+                box = Geom::Rect(x, y, x + rand() % 30, y + rand() % 30);
+            }
+            boxes.push_back(box);
+            tree.add(i, box);
+        }
+        tree.build();
+        _checkQueries(tree, boxes);
+
+        // refit after moving some of the entries
+        for (unsigned i = 0; i < boxes.size(); i += 7) {
+            double x = rand() % 1000, y = rand() % 1000;
+            boxes[i] = Geom::Rect(x, y, x + 5, y + 5);
+            tree.setBounds(i, boxes[i]);
+        }
+        _checkQueries(tree, boxes);
+    }
+
+private:
+    void _checkQueries(Inkscape::Util::BoundingBoxTree<int> const &tree,
+                       std::vector<Geom::OptRect> const &boxes)
+    {
+        for (int q = 0; q < 100; ++q) {
+            double x = rand() % 1000, y = rand() % 1000;
+            Geom::Rect area(x, y, x + 60, y + 40);
+            std::vector<unsigned> found;
+            tree.intersecting(area, found);
+
+            std::vector<unsigned> expected;
+            for (unsigned i = 0; i < boxes.size(); ++i) {
+                if (boxes[i] && boxes[i]->intersects(area)) {
+                    expected.push_back(i);
+                }
+            }
+            TS_ASSERT(found == expected);
+        }
+    }
+};
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,187 @@
+/**
+ * @file
+ * Bounding volume hierarchy for rectangle queries over many objects.
+ *//*
+ * Copyright (C) 2016 Authors
+ * Released under GNU GPL, read the file 'COPYING' for more information
+ */
+
+#ifndef SEEN_INKSCAPE_UTIL_BOUNDING_BOX_TREE_H
+#define SEEN_INKSCAPE_UTIL_BOUNDING_BOX_TREE_H
+
+#include <algorithm>
+#include <vector>
+#include <2geom/rect.h>
+
+namespace Inkscape {
+namespace Util {
+
+/**
+ * Bounding volume hierarchy over values with rectangular bounds.
+ *
+ * Entries are numbered in the order they were added, and queries return the numbers
+ * of matching entries in ascending order, so callers can keep e.g. z-order. Changing
+ * the bounds of an entry with setBounds() refits the boxes on its path to the root
+ * instead of rebuilding the whole tree. Entries with empty bounds are never returned.
+ */
+template <typename T>
+class BoundingBoxTree {
+public:
+    BoundingBoxTree() {}
+
+    void clear() {
+        _entries.clear();
+        _order.clear();
+        _leaf_of.clear();
+        _nodes.clear();
+    }
+    /// Add an entry. build() must be called before the next query.
+    void add(T const &value, Geom::OptRect const &bounds) {
+        Entry e;
+        e.value = value;
+        e.bounds = bounds;
+        _entries.push_back(e);
+    }
+    unsigned size() const { return _entries.size(); }
+    bool empty() const { return _entries.empty(); }
+    T const &value(unsigned i) const { return _entries[i].value; }
+    Geom::OptRect const &bounds(unsigned i) const { return _entries[i].bounds; }
+
+    /// Build the tree from all added entries.
+    void build() {
+        _nodes.clear();
+        _order.resize(_entries.size());
+        _leaf_of.resize(_entries.size());
+        for (unsigned i = 0; i < _order.size(); ++i) {
+            _order[i] = i;
+        }
+        if (!_entries.empty()) {
+            _nodes.reserve(2 * _entries.size() / LEAF_SIZE + 1);
+            _build(-1, 0, _order.size());
+        }
+    }
+
+    /// Change the bounds of an entry and refit the boxes of its ancestors.
+    void setBounds(unsigned i, Geom::OptRect const &bounds) {
+        _entries[i].bounds = bounds;
+        if (_nodes.empty()) return;
+        for (int n = _leaf_of[i]; n >= 0; n = _nodes[n].parent) {
+            Node &node = _nodes[n];
+            node.bounds = Geom::OptRect();
+            if (node.left < 0) {
+                for (unsigned k = node.first; k < node.first + node.count; ++k) {
+                    node.bounds.unionWith(_entries[_order[k]].bounds);
+                }
+            } else {
+                node.bounds.unionWith(_nodes[node.left].bounds);
+                node.bounds.unionWith(_nodes[node.right].bounds);
+            }
+        }
+    }
+
+    /// Append the numbers of entries whose bounds intersect area, in ascending order.
+    void intersecting(Geom::Rect const &area, std::vector<unsigned> &result) const {
+        if (_nodes.empty()) return;
+        unsigned start = result.size();
+        std::vector<int> stack;
+        stack.push_back(0);
+        while (!stack.empty()) {
+            Node const &node = _nodes[stack.back()];
+            stack.pop_back();
+            if (!node.bounds || !node.bounds->intersects(area)) continue;
+            if (node.left < 0) {
+                for (unsigned k = node.first; k < node.first + node.count; ++k) {
+                    Geom::OptRect const &b = _entries[_order[k]].bounds;
+                    if (b && b->intersects(area)) {
+                        result.push_back(_order[k]);
+                    }
+                }
+            } else {
+                stack.push_back(node.right);
+                stack.push_back(node.left);
+            }
+        }
+        std::sort(result.begin() + start, result.end());
+    }
+
+private:
+    static const unsigned LEAF_SIZE = 4;
+
+    struct Entry {
+        T value;
+        Geom::OptRect bounds;
+    };
+    struct Node {
+        Geom::OptRect bounds;
+        int parent;
+        int left;  ///< -1 for leaves
+        int right;
+        unsigned first; ///< range of _order covered by a leaf
+        unsigned count;
+    };
+    struct MidpointLess {
+        MidpointLess(std::vector<Entry> const &e, Geom::Dim2 d) : entries(e), dim(d) {}
+        bool operator()(unsigned a, unsigned b) const {
+            return mid(a) < mid(b);
+        }
+        double mid(unsigned i) const {
+            Geom::OptRect const &r = entries[i].bounds;
+            return r ? (*r)[dim].middle() : 0.0;
+        }
+        std::vector<Entry> const &entries;
+        Geom::Dim2 dim;
+    };
+
+    int _build(int parent, unsigned first, unsigned last) {
+        int n = _nodes.size();
+        Node node;
+        node.parent = parent;
+        node.left = node.right = -1;
+        node.first = first;
+        node.count = last - first;
+        for (unsigned k = first; k < last; ++k) {
+            node.bounds.unionWith(_entries[_order[k]].bounds);
+        }
+        _nodes.push_back(node);
+
+        if (last - first <= LEAF_SIZE || !node.bounds) {
+            for (unsigned k = first; k < last; ++k) {
+                _leaf_of[_order[k]] = n;
+            }
+            return n;
+        }
+
+        // split at the median along the longer side
+        Geom::Dim2 dim = node.bounds->width() > node.bounds->height() ? Geom::X : Geom::Y;
+        unsigned mid = first + (last - first) / 2;
+        std::nth_element(_order.begin() + first, _order.begin() + mid, _order.begin() + last,
+                         MidpointLess(_entries, dim));
+        int left = _build(n, first, mid);
+        int right = _build(n, mid, last);
+        // _nodes may have been reallocated
+        _nodes[n].left = left;
+        _nodes[n].right = right;
+        return n;
+    }
+
+    std::vector<Entry> _entries;
+    std::vector<unsigned> _order;  ///< entry numbers, grouped by leaf
+    std::vector<int> _leaf_of;     ///< leaf node containing each entry
+    std::vector<Node> _nodes;      ///< node 0 is the root
+};
+
+} // namespace Util
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_UTIL_BOUNDING_BOX_TREE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,111 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cstring>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "repr.h"
+
+class XmlReprIoTest : public CxxTest::TestSuite
+{
+    /// Reads the text through a temporary file, so that it takes the streaming loader.
+    static Inkscape::XML::Document *readFile(char const *text)
+    {
+        gchar *path = g_build_filename(g_get_tmp_dir(), "repr-io-test.svg", NULL);
+        g_file_set_contents(path, text, -1, NULL);
+        Inkscape::XML::Document *doc = sp_repr_read_file(path, SP_SVG_NS_URI);
+        g_unlink(path);
+        g_free(path);
+        return doc;
+    }
+
+    /// The file loader has to give the same tree as the one that parses the whole buffer first.
+    static void assertSameAsMemory(char const *text)
+    {
+        Inkscape::XML::Document *file = readFile(text);
+        Inkscape::XML::Document *mem = sp_repr_read_mem(text, strlen(text), SP_SVG_NS_URI);
+        TS_ASSERT(file != NULL);
+        TS_ASSERT(mem != NULL);
+        if (file && mem) {
+            TS_ASSERT_EQUALS(sp_repr_save_buf(file), sp_repr_save_buf(mem));
+        }
+        if (file) {
+            Inkscape::GC::release(file);
+        }
+        if (mem) {
+            Inkscape::GC::release(mem);
+        }
+    }
+
+public:
+
+    XmlReprIoTest()
+    {
+        Inkscape::GC::init();
+    }
+    virtual ~XmlReprIoTest() {}
+
+// createSuite and destroySuite get us per-suite setup and teardown
+// without us having to worry about static initialization order, etc.
+    static XmlReprIoTest *createSuite() { return new XmlReprIoTest(); }
+    static void destroySuite( XmlReprIoTest *suite ) { delete suite; }
+
+    void testNamespaces()
+    {
+        assertSameAsMemory(
+            "<?xml version=\"1.0\"?>\n"
+            "<!-- before -->\n"
+            "<?xml-stylesheet href=\"a.css\"?>\n"
+            "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\"\n"
+            "     xmlns:ink=\"http://www.inkscape.org/namespaces/inkscape\" ink:version=\"0.92\">\n"
+            "  <g id=\"g1\" ink:label=\"A &amp; B\" ink:groupmode=\"layer\">\n"
+            "    <use xlink:href=\"#r\" x=\"&#49;0\"/>\n"
+            "    <rect id=\"r\" width=\"10\" height=\"\"/>\n"
+            "    <foo:bar xmlns:foo=\"http://example.org/foo\" foo:baz=\"1\"/>\n"
+            "  </g>\n"
+            "</svg>\n"
+            "<!-- after -->\n");
+    }
+
+    void testText()
+    {
+        assertSameAsMemory(
+            "<svg xmlns=\"http://www.w3.org/2000/svg\">\n"
+            "  <text>a &lt; b<tspan>  c  </tspan>   <tspan> </tspan></text>\n"
+            "  <text xml:space=\"preserve\"> <tspan>  </tspan><tspan xml:space=\"default\"> </tspan>x</text>\n"
+            "  <style><![CDATA[ rect { fill: red } ]]>\n"
+            "    <![CDATA[   ]]></style>\n"
+            "  <desc>one <!-- c --> two<?pi data?>three</desc>\n"
+            "</svg>\n");
+    }
+
+    void testNoNamespace()
+    {
+        assertSameAsMemory("<svg><g><path d=\"M 0,0 L 1,1\"/></g></svg>");
+
+        Inkscape::XML::Document *doc = readFile("<svg><g/></svg>");
+        TS_ASSERT(doc != NULL);
+        if (doc) {
+            TS_ASSERT(!strcmp(doc->root()->name(), "svg:svg"));
+            TS_ASSERT(!strcmp(doc->root()->firstChild()->name(), "svg:g"));
+            Inkscape::GC::release(doc);
+        }
+    }
+
+    void testNoRoot()
+    {
+        TS_ASSERT(readFile("<!-- nothing -->") == NULL);
+        TS_ASSERT(readFile("") == NULL);
+    }
+};
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
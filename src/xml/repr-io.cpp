@@ -14,11 +14,13 @@
 # include <config.h>
 #endif
 
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <stdexcept>
 
 #include <libxml/parser.h>
+#include <libxml/parserInternals.h>
 
 #include "xml/repr.h"
 #include "xml/attribute-record.h"
@@ -31,6 +33,10 @@
 #include "io/stringstream.h"
 #include "io/gzipstream.h"
 
+#include "debug/heap.h"
+#include "debug/logger.h"
+#include "debug/simple-event.h"
+
 #include "extension/extension.h"
 
 #include "attribute-rel-util.h"
@@ -39,6 +45,7 @@
 
 #include <glibmm/miscutils.h>
 #include <map>
+#include <vector>
 
 using Inkscape::IO::Writer;
 using Inkscape::Util::List;
@@ -51,8 +58,9 @@ using Inkscape::XML::calc_abs_doc_base;
 using Inkscape::XML::rebase_href_attrs;
 
 Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns);
+static void sp_repr_finish_read (Node *root, const gchar *default_ns);
 static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
-static gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *name, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
+static gint sp_repr_qualified_name (gchar *p, gint len, const xmlChar *href, const xmlChar *ns_prefix, const xmlChar *name, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
 static void sp_repr_write_stream_root_element(Node *repr, Writer &out,
                                               bool add_whitespace, gchar const *default_ns,
                                               int inlineattrs, int indent,
@@ -105,6 +113,7 @@ public:
     int setFile( char const * filename, bool load_entities );
 
     xmlDocPtr readXml();
+    Document *readRepr(const gchar *default_ns);
 
     static int readCb( void * context, char * buffer, int len );
     static int closeCb( void * context );
@@ -113,6 +122,8 @@ public:
     int read( char * buffer, int len );
     int close();
 private:
+    int parseOptions() const;
+
     const char* filename;
     char* encoding;
     FILE* fp;
@@ -149,17 +160,7 @@ int XmlSource::setFile(char const *filename, bool load_entities=false)
                 gzin = new Inkscape::IO::GzipInputStream(*instr);
 
                 memset( firstFew, 0, sizeof(firstFew) );
-                some = 0;
-                int single = 0;
-                while ( some < 4 && single >= 0 )
-                {
-                    single = gzin->get();
-                    if ( single >= 0 ) {
-                        firstFew[some++] = 0x0ff & single;
-                    } else {
-                        break;
-                    }
-                }
+                some = gzin->read( reinterpret_cast<char *>(firstFew), 4 );
             }
 
             int encSkip = 0;
@@ -192,8 +193,7 @@ int XmlSource::setFile(char const *filename, bool load_entities=false)
         while(true) {
             int len = this->read(buffer, 4096);
             if(len <= 0) break;
-            buffer[len] = 0;
-            this->cachedData += buffer;
+            this->cachedData.append(buffer, len);
         }
         delete[] buffer;
 
@@ -220,7 +220,7 @@ int XmlSource::setFile(char const *filename, bool load_entities=false)
     return retVal;
 }
 
-xmlDocPtr XmlSource::readXml()
+int XmlSource::parseOptions() const
 {
     int parse_options = XML_PARSE_HUGE | XML_PARSE_RECOVER;
 
@@ -231,8 +231,13 @@ xmlDocPtr XmlSource::readXml()
     // Allow NOENT only if we're filtering out SYSTEM and PUBLIC entities
     if (LoadEntities)     parse_options |= XML_PARSE_NOENT;
 
+    return parse_options;
+}
+
+xmlDocPtr XmlSource::readXml()
+{
     return xmlReadIO( readCb, closeCb, this,
-                      filename, getEncoding(), parse_options);
+                      filename, getEncoding(), parseOptions());
 }
 
 int XmlSource::readCb( void * context, char * buffer, int len )
@@ -277,16 +282,7 @@ int XmlSource::read( char *buffer, int len )
         firstFewLen -= some;
         got = some;
     } else if ( gzin ) {
-        int single = 0;
-        while ( (static_cast<int>(got) < len) && (single >= 0) )
-        {
-            single = gzin->get();
-            if ( single >= 0 ) {
-                buffer[got++] = 0x0ff & single;
-            } else {
-                break;
-            }
-        }
+        got = gzin->read( buffer, len );
     } else {
         got = fread( buffer, 1, len, fp );
     }
@@ -322,6 +318,308 @@ int XmlSource::close()
     return 0;
 }
 
+namespace {
+
+typedef Inkscape::Debug::SimpleEvent<Inkscape::Debug::Event::XML> XmlEvent;
+
+class ReadFileEvent : public XmlEvent {
+public:
+    ReadFileEvent(char const *filename, double seconds, long elements, long peak_heap)
+    : XmlEvent(Inkscape::Util::share_static_string("read-file"))
+    {
+        _addProperty("filename", filename);
+        gchar *value = g_strdup_printf("%.3f", seconds);
+        _addProperty("seconds", value);
+        g_free(value);
+        _addProperty("elements", elements);
+        _addProperty("peak-heap", peak_heap);
+    }
+};
+
+std::size_t heap_bytes_used()
+{
+    std::size_t used = 0;
+    for (unsigned i = 0; i < Inkscape::Debug::heap_count(); ++i) {
+        Inkscape::Debug::Heap *heap = Inkscape::Debug::get_heap(i);
+        if (heap && (heap->features() & Inkscape::Debug::Heap::USED_AVAILABLE)) {
+            used += heap->stats().bytes_used;
+        }
+    }
+    return used;
+}
+
+/**
+ * Builds the repr tree directly from the SAX2 events of the parser, so that the file never
+ * exists as a libxml2 tree next to the repr tree.  The result is the same as that of
+ * sp_repr_do_read() on the parsed tree.
+ *
+ * The DTD is still read into a libxml2 document, as the parser needs it for entities.
+ */
+class ReprSaxBuilder
+{
+public:
+    ReprSaxBuilder(const gchar *default_ns);
+
+    xmlSAXHandler *handler() { return &_handler; }
+
+    /// Parses the document and frees the parser context.
+    Document *parse(xmlParserCtxtPtr ctxt);
+
+    long elementCount() const { return _element_count; }
+    std::size_t peakHeap() const { return _peak_heap; }
+
+private:
+    struct Frame {
+        Frame(Node *n, bool p) : node(n), preserve(p) {}
+        Node *node;
+        bool preserve; ///< whether xml:space="preserve" applies
+    };
+
+    static ReprSaxBuilder *_get(void *ctx) {
+        return static_cast<ReprSaxBuilder *>(static_cast<xmlParserCtxtPtr>(ctx)->_private);
+    }
+
+    static void _startElement(void *ctx, const xmlChar *localname, const xmlChar *prefix,
+                              const xmlChar *uri, int nb_namespaces, const xmlChar **namespaces,
+                              int nb_attributes, int nb_defaulted, const xmlChar **attributes);
+    static void _endElement(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *uri);
+    static void _characters(void *ctx, const xmlChar *ch, int len);
+    static void _cdataBlock(void *ctx, const xmlChar *value, int len);
+    static void _comment(void *ctx, const xmlChar *value);
+    static void _processingInstruction(void *ctx, const xmlChar *target, const xmlChar *data);
+
+    void _addText(const xmlChar *ch, int len, bool cdata);
+    void _flushText();
+    void _append(Node *repr);
+
+    xmlSAXHandler _handler;
+    const gchar *_default_ns;
+    std::map<std::string, std::string> _prefix_map;
+    Document *_doc;
+    Node *_root;
+    int _root_count;
+    std::vector<Frame> _stack;
+    std::string _text;
+    bool _text_cdata;
+    long _element_count;
+    std::size_t _peak_heap;
+};
+
+ReprSaxBuilder::ReprSaxBuilder(const gchar *default_ns)
+    : _default_ns(default_ns),
+      _doc(NULL),
+      _root(NULL),
+      _root_count(0),
+      _text_cdata(false),
+      _element_count(0),
+      _peak_heap(0)
+{
+    // the default handlers keep the DTD and entities in ctxt->myDoc
+    xmlSAXVersion(&_handler, 2);
+    _handler.startElementNs = _startElement;
+    _handler.endElementNs = _endElement;
+    _handler.characters = _characters;
+    _handler.ignorableWhitespace = _characters;
+    _handler.cdataBlock = _cdataBlock;
+    _handler.comment = _comment;
+    _handler.processingInstruction = _processingInstruction;
+}
+
+Document *ReprSaxBuilder::parse(xmlParserCtxtPtr ctxt)
+{
+    _peak_heap = heap_bytes_used();
+    _doc = new Inkscape::XML::SimpleDocument();
+
+    // entity contents are parsed with a new context, which inherits _private
+    ctxt->_private = this;
+    xmlParseDocument(ctxt);
+    _flushText();
+    _stack.clear();
+
+    if (ctxt->myDoc) {
+        xmlFreeDoc(ctxt->myDoc);
+        ctxt->myDoc = NULL;
+    }
+    xmlFreeParserCtxt(ctxt);
+    _peak_heap = std::max(_peak_heap, heap_bytes_used());
+
+    if (!_root_count) {
+        Inkscape::GC::release(_doc);
+        return NULL;
+    }
+    if (_root_count == 1) {
+        sp_repr_finish_read(_root, _default_ns);
+    }
+    return _doc;
+}
+
+void ReprSaxBuilder::_append(Node *repr)
+{
+    if (_stack.empty()) {
+        _doc->appendChild(repr);
+    } else {
+        _stack.back().node->appendChild(repr);
+    }
+    Inkscape::GC::release(repr);
+}
+
+void ReprSaxBuilder::_startElement(void *ctx, const xmlChar *localname, const xmlChar *prefix,
+                                   const xmlChar *uri, int /*nb_namespaces*/, const xmlChar ** /*namespaces*/,
+                                   int nb_attributes, int /*nb_defaulted*/, const xmlChar **attributes)
+{
+    xmlParserCtxtPtr ctxt = static_cast<xmlParserCtxtPtr>(ctx);
+    ReprSaxBuilder *self = _get(ctx);
+    gchar c[256];
+
+    self->_flushText();
+
+    sp_repr_qualified_name (c, 256, uri, prefix, localname, self->_default_ns, self->_prefix_map);
+    Node *repr = self->_doc->createElement(c);
+
+    bool preserve = !self->_stack.empty() && self->_stack.back().preserve;
+    std::string value;
+    for (int i = 0; i < nb_attributes; ++i) {
+        // localname, prefix, URI, value, end
+        const xmlChar **attribute = attributes + 5 * i;
+        sp_repr_qualified_name (c, 256, attribute[2], attribute[1], attribute[0], self->_default_ns, self->_prefix_map);
+        const xmlChar *begin = attribute[3];
+        const xmlChar *end = attribute[4];
+        xmlChar *decoded = NULL;
+        if (!ctxt->replaceEntities && std::find(begin, end, '&') != end) {
+            // without entity substitution, the parser leaves references in attribute values
+            // to be resolved when the value is stored, as xmlSAX2AttributeNs() does
+            decoded = xmlStringLenDecodeEntities(ctxt, begin, end - begin, XML_SUBSTITUTE_REF, 0, 0, 0);
+        }
+        if (decoded) {
+            value = reinterpret_cast<const char *>(decoded);
+            xmlFree(decoded);
+        } else {
+            value.assign(reinterpret_cast<const char *>(begin), end - begin);
+        }
+        repr->setAttribute(c, value.c_str());
+        // the same rules as xmlNodeGetSpacePreserve()
+        if (!strcmp(c, "xml:space")) {
+            if (value == "preserve") {
+                preserve = true;
+            } else if (value == "default") {
+                preserve = false;
+            }
+        }
+    }
+
+    if (self->_stack.empty()) {
+        self->_root = repr;
+        ++self->_root_count;
+    }
+    self->_append(repr);
+    self->_stack.push_back(Frame(repr, preserve));
+
+    if (++self->_element_count % 4096 == 0) {
+        self->_peak_heap = std::max(self->_peak_heap, heap_bytes_used());
+    }
+}
+
+void ReprSaxBuilder::_endElement(void *ctx, const xmlChar * /*localname*/, const xmlChar * /*prefix*/, const xmlChar * /*uri*/)
+{
+    ReprSaxBuilder *self = _get(ctx);
+    self->_flushText();
+    if (!self->_stack.empty()) {
+        self->_stack.pop_back();
+    }
+}
+
+void ReprSaxBuilder::_characters(void *ctx, const xmlChar *ch, int len)
+{
+    _get(ctx)->_addText(ch, len, false);
+}
+
+void ReprSaxBuilder::_cdataBlock(void *ctx, const xmlChar *value, int len)
+{
+    _get(ctx)->_addText(value, len, true);
+}
+
+void ReprSaxBuilder::_comment(void *ctx, const xmlChar *value)
+{
+    ReprSaxBuilder *self = _get(ctx);
+    self->_flushText();
+    self->_append(self->_doc->createComment(reinterpret_cast<const gchar *>(value)));
+}
+
+void ReprSaxBuilder::_processingInstruction(void *ctx, const xmlChar *target, const xmlChar *data)
+{
+    ReprSaxBuilder *self = _get(ctx);
+    self->_flushText();
+    self->_append(self->_doc->createPI(reinterpret_cast<const gchar *>(target),
+                                       reinterpret_cast<const gchar *>(data)));
+}
+
+/**
+ * The parser may report a text node in several pieces, which are collected until the next
+ * non-text event.
+ */
+void ReprSaxBuilder::_addText(const xmlChar *ch, int len, bool cdata)
+{
+    if (_stack.empty()) {
+        return; // the document has no text children
+    }
+    if (cdata != _text_cdata) {
+        _flushText();
+        _text_cdata = cdata;
+    }
+    _text.append(reinterpret_cast<const char *>(ch), len);
+}
+
+void ReprSaxBuilder::_flushText()
+{
+    if (_text.empty()) {
+        return;
+    }
+    if (!_stack.back().preserve) {
+        std::string::const_iterator p = _text.begin();
+        while (p != _text.end() && g_ascii_isspace(*p)) {
+            ++p;
+        }
+        if (p == _text.end()) {
+            _text.clear();
+            return; // we do not preserve all-whitespace nodes unless we are asked to
+        }
+    }
+    // We keep track of original node type so that CDATA sections are preserved on output.
+    _append(_doc->createTextNode(_text.c_str(), _text_cdata));
+    _text.clear();
+}
+
+}
+
+Document *XmlSource::readRepr(const gchar *default_ns)
+{
+    GTimer *timer = g_timer_new();
+    ReprSaxBuilder builder(default_ns);
+    Document *rdoc = NULL;
+
+    // the parser reads the source in small blocks and releases them once parsed
+    xmlParserCtxtPtr ctxt = xmlCreateIOParserCtxt(builder.handler(), NULL, readCb, closeCb, this,
+                                                  XML_CHAR_ENCODING_NONE);
+    if (ctxt) {
+        xmlCtxtUseOptions(ctxt, parseOptions());
+        if (getEncoding()) {
+            xmlCharEncodingHandlerPtr encoder = xmlFindCharEncodingHandler(getEncoding());
+            if (encoder) {
+                xmlSwitchToEncoding(ctxt, encoder);
+            }
+        }
+        if (filename && ctxt->input && !ctxt->input->filename) {
+            ctxt->input->filename = reinterpret_cast<char *>(xmlStrdup(reinterpret_cast<const xmlChar *>(filename)));
+        }
+        rdoc = builder.parse(ctxt);
+    }
+
+    Inkscape::Debug::Logger::write<ReadFileEvent>(filename, g_timer_elapsed(timer, NULL),
+                                                  builder.elementCount(), (long)builder.peakHeap());
+    g_timer_destroy(timer);
+    return rdoc;
+}
+
 /**
  * Reads XML from a file, including WMF files, and returns the Document.
  * The default namespace can also be specified, if desired.
@@ -363,19 +661,19 @@ Document *sp_repr_read_file (const gchar * filename, const gchar *default_ns)
     }
 #endif // !HAVE_LIBWMF
 
-    if ( !doc ) {
+    if ( doc ) {
+        rdoc = sp_repr_do_read( doc, default_ns );
+    } else {
         XmlSource src;
 
         if ( (src.setFile(filename) == 0) ) {
-            doc = src.readXml();
-            rdoc = sp_repr_do_read( doc, default_ns );
+            rdoc = src.readRepr( default_ns );
             // For some reason, failed ns loading results in this
             // We try a system check version of load with NOENT for adobe
             if(rdoc && strcmp(rdoc->root()->name(), "ns:svg") == 0) {
-                xmlFreeDoc( doc );
+                Inkscape::GC::release(rdoc);
                 src.setFile(filename, true);
-                doc = src.readXml();
-                rdoc = sp_repr_do_read( doc, default_ns );
+                rdoc = src.readRepr( default_ns );
             }
         }
     }
@@ -512,45 +810,48 @@ Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns)
     }
 
     if (root != NULL) {
-        /* promote elements of some XML documents that don't use namespaces
-         * into their default namespace */
-        if ( default_ns && !strchr(root->name(), ':') ) {
-            if ( !strcmp(default_ns, SP_SVG_NS_URI) ) {
-                promote_to_namespace(root, "svg");
-            }
-            if ( !strcmp(default_ns, INKSCAPE_EXTENSION_URI) ) {
-                promote_to_namespace(root, INKSCAPE_EXTENSION_NS_NC);
-            }
-        }
+        sp_repr_finish_read(root, default_ns);
+    }
 
+    return rdoc;
+}
 
-        // Clean unnecessary attributes and style properties from SVG documents. (Controlled by
-        // preferences.)  Note: internal Inkscape svg files will also be cleaned (filters.svg,
-        // icons.svg). How can one tell if a file is internal?
-        if ( !strcmp(root->name(), "svg:svg" ) ) {
-            Inkscape::Preferences *prefs = Inkscape::Preferences::get();
-            bool clean = prefs->getBool("/options/svgoutput/check_on_reading");
-            if( clean ) {
-                sp_attribute_clean_tree( root );
-            }
+/**
+ * Adjusts the root element of a document read from XML.
+ */
+static void sp_repr_finish_read (Node *root, const gchar *default_ns)
+{
+    /* promote elements of some XML documents that don't use namespaces
+     * into their default namespace */
+    if ( default_ns && !strchr(root->name(), ':') ) {
+        if ( !strcmp(default_ns, SP_SVG_NS_URI) ) {
+            promote_to_namespace(root, "svg");
+        }
+        if ( !strcmp(default_ns, INKSCAPE_EXTENSION_URI) ) {
+            promote_to_namespace(root, INKSCAPE_EXTENSION_NS_NC);
         }
     }
 
-    return rdoc;
+
+    // Clean unnecessary attributes and style properties from SVG documents. (Controlled by
+    // preferences.)  Note: internal Inkscape svg files will also be cleaned (filters.svg,
+    // icons.svg). How can one tell if a file is internal?
+    if ( !strcmp(root->name(), "svg:svg" ) ) {
+        Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+        bool clean = prefs->getBool("/options/svgoutput/check_on_reading");
+        if( clean ) {
+            sp_attribute_clean_tree( root );
+        }
+    }
 }
 
-gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *name, const gchar */*default_ns*/, std::map<std::string, std::string> &prefix_map)
+gint sp_repr_qualified_name (gchar *p, gint len, const xmlChar *href, const xmlChar *ns_prefix, const xmlChar *name, const gchar */*default_ns*/, std::map<std::string, std::string> &prefix_map)
 {
     const xmlChar *prefix;
-    if (ns){
-        if (ns->href ) {
-            prefix = reinterpret_cast<const xmlChar*>( sp_xml_ns_uri_prefix(reinterpret_cast<const gchar*>(ns->href),
-                                                                            reinterpret_cast<const char*>(ns->prefix)) );
-            prefix_map[reinterpret_cast<const char*>(prefix)] = reinterpret_cast<const char*>(ns->href);
-        }
-        else {
-            prefix = NULL;
-        }
+    if (href) {
+        prefix = reinterpret_cast<const xmlChar*>( sp_xml_ns_uri_prefix(reinterpret_cast<const gchar*>(href),
+                                                                        reinterpret_cast<const char*>(ns_prefix)) );
+        prefix_map[reinterpret_cast<const char*>(prefix)] = reinterpret_cast<const char*>(href);
     }
     else {
         prefix = NULL;
@@ -603,13 +904,15 @@ static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gc
         return NULL;
     }
 
-    sp_repr_qualified_name (c, 256, node->ns, node->name, default_ns, prefix_map);
+    sp_repr_qualified_name (c, 256, node->ns ? node->ns->href : NULL, node->ns ? node->ns->prefix : NULL,
+                            node->name, default_ns, prefix_map);
     Node *repr = xml_doc->createElement(c);
     /* TODO remember node->ns->prefix if node->ns != NULL */
 
     for (prop = node->properties; prop != NULL; prop = prop->next) {
         if (prop->children) {
-            sp_repr_qualified_name (c, 256, prop->ns, prop->name, default_ns, prefix_map);
+            sp_repr_qualified_name (c, 256, prop->ns ? prop->ns->href : NULL, prop->ns ? prop->ns->prefix : NULL,
+                                    prop->name, default_ns, prefix_map);
             repr->setAttribute(c, reinterpret_cast<gchar*>(prop->children->content));
             /* TODO remember prop->ns->prefix if prop->ns != NULL */
         }
@@ -763,15 +1066,24 @@ bool sp_repr_save_file(Document *doc, gchar const *const filename, gchar const *
 static void repr_quote_write (Writer &out, const gchar * val)
 {
     if (val) {
+        // runs of characters which need no quoting are written in one go
+        gchar const *run = val;
         for (; *val != '\0'; val++) {
+            gchar const *entity = NULL;
             switch (*val) {
-                case '"': out.writeString( "&quot;" ); break;
-                case '&': out.writeString( "&amp;" ); break;
-                case '<': out.writeString( "&lt;" ); break;
-                case '>': out.writeString( "&gt;" ); break;
-                default: out.writeChar( *val ); break;
+                case '"': entity = "&quot;"; break;
+                case '&': entity = "&amp;"; break;
+                case '<': entity = "&lt;"; break;
+                case '>': entity = "&gt;"; break;
+                default: break;
+            }
+            if (entity) {
+                out.write( run, val - run );
+                out.writeString( entity );
+                run = val + 1;
             }
         }
+        out.write( run, val - run );
     }
 }
 
@@ -791,9 +1103,7 @@ static void repr_write_comment( Writer &out, const gchar * val, bool addWhitespa
     out.writeString("<!--");
     // WARNING out.printf() and out.writeString() are *NOT* non-ASCII friendly.
     if (val) {
-        for (const gchar* cur = val; *cur; cur++ ) {
-            out.writeChar(*cur);
-        }
+        out.write(val, strlen(val));
     } else {
         out.writeString(" ");
     }
@@ -0,0 +1,173 @@
+#include <cxxtest/TestSuite.h>
+
+#include <cstring>
+#include <glib.h>
+
+#include "document.h"
+#include "repr.h"
+#include "sp-object.h"
+#include "sp-path.h"
+
+class XmlReprUtilTest : public CxxTest::TestSuite
+{
+    static Inkscape::XML::Document *read(char const *text)
+    {
+        return sp_repr_read_mem(text, strlen(text), SP_SVG_NS_URI);
+    }
+
+    static Inkscape::XML::Node *byId(Inkscape::XML::Node *repr, char const *id)
+    {
+        char const *value = repr->attribute("id");
+        if (value && !strcmp(value, id)) {
+            return repr;
+        }
+        for (Inkscape::XML::Node *child = repr->firstChild(); child; child = child->next()) {
+            Inkscape::XML::Node *found = byId(child, id);
+            if (found) {
+                return found;
+            }
+        }
+        return NULL;
+    }
+
+public:
+
+    XmlReprUtilTest()
+    {
+        Inkscape::GC::init();
+    }
+    virtual ~XmlReprUtilTest() {}
+
+// createSuite and destroySuite get us per-suite setup and teardown
+// without us having to worry about static initialization order, etc.
+    static XmlReprUtilTest *createSuite() { return new XmlReprUtilTest(); }
+    static void destroySuite( XmlReprUtilTest *suite ) { delete suite; }
+
+    void testUpdateFrom()
+    {
+        Inkscape::XML::Document *doc = read(
+            "<svg xmlns=\"http://www.w3.org/2000/svg\" id=\"svg\">"
+            "<g id=\"a\"><rect id=\"r1\" x=\"1\"/><rect id=\"r2\"/></g>"
+            "<path id=\"p\" d=\"M 0,0\"/>"
+            "<text id=\"t\">hello</text>"
+            "<g><circle r=\"1\"/></g>"
+            "</svg>");
+        Inkscape::XML::Document *result = read(
+            "<svg xmlns=\"http://www.w3.org/2000/svg\" id=\"svg\" width=\"10\">"
+            "<path id=\"p\" d=\"M 1,1\"/>"
+            "<g id=\"a\"><rect id=\"r2\" y=\"2\"/><ellipse/></g>"
+            "<text id=\"t\">bye</text>"
+            "<g><circle r=\"2\"/></g>"
+            "<rect id=\"r1\"/>"
+            "</svg>");
+        TS_ASSERT(doc != NULL);
+        TS_ASSERT(result != NULL);
+        if (!doc || !result) {
+            return;
+        }
+
+        Inkscape::XML::Node *root = doc->root();
+        Inkscape::XML::Node *a = byId(root, "a");
+        Inkscape::XML::Node *r1 = byId(root, "r1");
+        Inkscape::XML::Node *r2 = byId(root, "r2");
+        Inkscape::XML::Node *p = byId(root, "p");
+        Inkscape::XML::Node *t = byId(root, "t");
+        Inkscape::XML::Node *text = t->firstChild();
+        Inkscape::XML::Node *circle = p->next()->next()->firstChild();
+
+        sp_repr_update_from(root, result->root());
+        TS_ASSERT_EQUALS(sp_repr_save_buf(doc), sp_repr_save_buf(result));
+
+        // Moved or modified nodes are the same ones, only a node that changed parent is new
+        TS_ASSERT_EQUALS(root->firstChild(), p);
+        TS_ASSERT_EQUALS(byId(root, "a"), a);
+        TS_ASSERT_EQUALS(byId(root, "r2"), r2);
+        TS_ASSERT_EQUALS(byId(root, "t"), t);
+        TS_ASSERT_EQUALS(t->firstChild(), text);
+        TS_ASSERT_EQUALS(t->next()->firstChild(), circle);
+        TS_ASSERT(byId(root, "r1") != r1);
+        TS_ASSERT_EQUALS(r1->parent(), static_cast<Inkscape::XML::Node *>(NULL));
+
+        Inkscape::GC::release(doc);
+        Inkscape::GC::release(result);
+    }
+
+    void testUpdateFromEmpty()
+    {
+        char const *full = "<svg xmlns=\"http://www.w3.org/2000/svg\"><g id=\"a\"/>text<g/></svg>";
+        char const *empty = "<svg xmlns=\"http://www.w3.org/2000/svg\"/>";
+        for (int i = 0; i < 2; ++i) {
+            Inkscape::XML::Document *doc = read(i ? empty : full);
+            Inkscape::XML::Document *result = read(i ? full : empty);
+            TS_ASSERT(doc != NULL);
+            TS_ASSERT(result != NULL);
+            if (doc && result) {
+                sp_repr_update_from(doc->root(), result->root());
+                TS_ASSERT_EQUALS(sp_repr_save_buf(doc), sp_repr_save_buf(result));
+            }
+            if (doc) {
+                Inkscape::GC::release(doc);
+            }
+            if (result) {
+                Inkscape::GC::release(result);
+            }
+        }
+    }
+
+    // The objects built for the copies get the ids they were written with, even when the old
+    // node with that id is of another kind or sits later in the document.
+    void testUpdateDocument()
+    {
+        char const *before =
+            "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\""
+            " xmlns:sodipodi=\"http://sodipodi.sourceforge.net/DTD/sodipodi-0.dtd\" id=\"svg\">"
+            "<sodipodi:namedview id=\"nv\"/>"
+            "<g id=\"g1\"/>"
+            "<rect id=\"r1\" width=\"10\" height=\"10\"/>"
+            "<rect id=\"r2\" width=\"20\" height=\"20\"/>"
+            "<use id=\"u\" xlink:href=\"#r1\"/>"
+            "</svg>";
+        char const *after =
+            "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\""
+            " xmlns:sodipodi=\"http://sodipodi.sourceforge.net/DTD/sodipodi-0.dtd\" id=\"svg\">"
+            "<sodipodi:namedview id=\"nv\"/>"
+            "<g id=\"g1\"><rect id=\"r2\" width=\"20\" height=\"20\"/></g>"
+            "<path id=\"r1\" d=\"M 0,0 10,0 10,10 Z\"/>"
+            "<g id=\"wrap\"><use id=\"u\" xlink:href=\"#r1\"/></g>"
+            "</svg>";
+        SPDocument *doc = SPDocument::createNewDocFromMem(before, strlen(before), false);
+        Inkscape::XML::Document *result = read(after);
+        TS_ASSERT(doc != NULL);
+        TS_ASSERT(result != NULL);
+        if (!doc || !result) {
+            return;
+        }
+
+        SPObject *g1 = doc->getObjectById("g1");
+        sp_repr_update_from(doc->getReprRoot(), result->root());
+        doc->ensureUpToDate();
+
+        TS_ASSERT_EQUALS(doc->getObjectById("g1"), g1);
+        SPObject *r1 = doc->getObjectById("r1");
+        SPObject *r2 = doc->getObjectById("r2");
+        SPObject *u = doc->getObjectById("u");
+        SPObject *wrap = doc->getObjectById("wrap");
+        TS_ASSERT(dynamic_cast<SPPath *>(r1) != NULL);
+        TS_ASSERT(r2 != NULL && r2->parent == g1);
+        TS_ASSERT(u != NULL && wrap != NULL && u->parent == wrap);
+
+        Inkscape::GC::release(result);
+        doc->doUnref();
+    }
+};
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
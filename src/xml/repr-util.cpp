@@ -28,12 +28,18 @@
 #endif
 
 
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
 #include <glib.h>
 #include <2geom/point.h>
 #include "svg/stringstream.h"
 #include "svg/css-ostringstream.h"
 #include "svg/svg-length.h"
 
+#include "xml/attribute-record.h"
 #include "xml/repr.h"
 #include "xml/repr-sorting.h"
 
@@ -342,6 +348,163 @@ Inkscape::XML::Node *sp_repr_lookup_child(Inkscape::XML::Node *repr,
     return NULL;
 }
 
+static bool sp_repr_same_kind(Inkscape::XML::Node const *a, Inkscape::XML::Node const *b)
+{
+    return a->type() == b->type() && a->code() == b->code();
+}
+
+typedef std::map<Inkscape::XML::Node const *, Inkscape::XML::Node *> ReprMatches;
+
+static void sp_repr_collect_ids(Inkscape::XML::Node const *repr, std::set<std::string> &ids)
+{
+    for (Inkscape::XML::Node const *child = repr->firstChild(); child; child = child->next()) {
+        gchar const *id = child->attribute("id");
+        if (id) {
+            ids.insert(id);
+        }
+        sp_repr_collect_ids(child, ids);
+    }
+}
+
+/*
+ * Pairs the children of repr with those of src, recursively, and removes the children of repr
+ * left without a pair.  Nothing is inserted yet, so by the time the copies are added the ids
+ * of the removed nodes are free again and the copies are built with the ids they came with.
+ */
+static void sp_repr_match_children(Inkscape::XML::Node *repr, Inkscape::XML::Node const *src,
+                                   std::set<std::string> const &src_ids, ReprMatches &matches)
+{
+    using Inkscape::XML::Node;
+
+    std::vector<Node *> old;
+    std::map<std::string, unsigned> by_id;
+    for (Node *child = repr->firstChild(); child; child = child->next()) {
+        gchar const *id = child->attribute("id");
+        if (id) {
+            by_id.insert(std::make_pair(std::string(id), old.size()));
+        }
+        old.push_back(child);
+    }
+
+    // The unpaired old children keep their order, and the next one is where a child
+    // without a match by id would go.
+    std::vector<bool> paired(old.size(), false);
+    unsigned next = 0;
+    for (Node const *child = src->firstChild(); child; child = child->next()) {
+        while (next < old.size() && paired[next]) {
+            ++next;
+        }
+        gchar const *id = child->attribute("id");
+        unsigned match = old.size();
+        if (id) {
+            std::map<std::string, unsigned>::iterator found = by_id.find(id);
+            if (found != by_id.end() && !paired[found->second]
+                && sp_repr_same_kind(old[found->second], child))
+            {
+                match = found->second;
+            }
+        }
+        if (match == old.size() && next < old.size() && sp_repr_same_kind(old[next], child)) {
+            gchar const *next_id = old[next]->attribute("id");
+            if ((!next_id || !src_ids.count(next_id)) && (!id || !by_id.count(id))) {
+                match = next;
+            }
+        }
+        if (match < old.size()) {
+            paired[match] = true;
+            matches[child] = old[match];
+        }
+    }
+
+    for (unsigned i = 0; i < old.size(); ++i) {
+        if (!paired[i]) {
+            repr->removeChild(old[i]);
+        }
+    }
+    for (Node const *child = src->firstChild(); child; child = child->next()) {
+        ReprMatches::iterator found = matches.find(child);
+        if (found != matches.end()) {
+            sp_repr_match_children(found->second, child, src_ids, matches);
+        }
+    }
+}
+
+static void sp_repr_merge(Inkscape::XML::Node *repr, Inkscape::XML::Node const *src,
+                          ReprMatches const &matches)
+{
+    using Inkscape::Util::List;
+    using Inkscape::XML::AttributeRecord;
+    using Inkscape::XML::Node;
+
+    if (g_strcmp0(repr->content(), src->content())) {
+        repr->setContent(src->content());
+    }
+
+    std::vector<GQuark> removed;
+    for (List<AttributeRecord const> iter = repr->attributeList(); iter; ++iter) {
+        if (!src->attribute(g_quark_to_string(iter->key))) {
+            removed.push_back(iter->key);
+        }
+    }
+    for (std::vector<GQuark>::const_iterator it = removed.begin(); it != removed.end(); ++it) {
+        repr->setAttribute(g_quark_to_string(*it), NULL);
+    }
+    for (List<AttributeRecord const> iter = src->attributeList(); iter; ++iter) {
+        gchar const *name = g_quark_to_string(iter->key);
+        if (g_strcmp0(repr->attribute(name), iter->value)) {
+            repr->setAttribute(name, iter->value);
+        }
+    }
+
+    // Only paired children are left, in their old order; the children up to and including
+    // ref are in place.
+    Node *ref = NULL;
+    for (Node const *child = src->firstChild(); child; child = child->next()) {
+        ReprMatches::const_iterator found = matches.find(child);
+        if (found != matches.end()) {
+            Node *match = found->second;
+            if (match != (ref ? ref->next() : repr->firstChild())) {
+                repr->changeOrder(match, ref);
+            }
+            sp_repr_merge(match, child, matches);
+            ref = match;
+        } else {
+            Node *copy = child->duplicate(repr->document());
+            repr->addChild(copy, ref);
+            Inkscape::GC::release(copy);
+            ref = copy;
+        }
+    }
+}
+
+/**
+ * Make a node equal to another one, changing as little as possible.
+ *
+ * Attributes and content are only set where they differ.  Children are paired by id first,
+ * then by position when both have the same name and neither id is used elsewhere; paired
+ * children are moved into place and updated recursively, the others are removed or
+ * duplicated from @c src.  All the removals are done before the first copy is inserted, so
+ * a node that keeps its id but changes name or parent is built with that id, not a new one.
+ * Nodes that did not change keep their identity, so the objects built on them survive and
+ * the undo log only records the actual differences.
+ *
+ * @param repr The node to update; it must have the same name as @c src
+ * @param src The node to copy from, which may belong to another document
+ * @relatesalso Inkscape::XML::Node
+ */
+void sp_repr_update_from(Inkscape::XML::Node *repr, Inkscape::XML::Node const *src)
+{
+    g_return_if_fail(repr != NULL);
+    g_return_if_fail(src != NULL);
+    g_return_if_fail(sp_repr_same_kind(repr, src));
+
+    std::set<std::string> src_ids;
+    sp_repr_collect_ids(src, src_ids);
+    ReprMatches matches;
+    sp_repr_match_children(repr, src, src_ids, matches);
+    sp_repr_merge(repr, src, matches);
+}
+
 Inkscape::XML::Node const *sp_repr_lookup_name( Inkscape::XML::Node const *repr, gchar const *name, gint maxdepth )
 {
     Inkscape::XML::Node const *found = 0;
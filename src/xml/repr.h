@@ -155,6 +155,8 @@ Inkscape::XML::Node *sp_repr_lookup_child(Inkscape::XML::Node *repr,
                                           char const *value);
 
 
+void sp_repr_update_from(Inkscape::XML::Node *repr, Inkscape::XML::Node const *src);
+
 inline Inkscape::XML::Node *sp_repr_document_first_child(Inkscape::XML::Document const *doc) {
     return const_cast<Inkscape::XML::Node *>(doc->firstChild());
 }